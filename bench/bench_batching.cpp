@@ -0,0 +1,198 @@
+// Micro-batching benchmark: short clips transcribed one whisper_full each against
+// ClipBatcher packing concurrent clips into shared runs.
+//
+// Usage: bench_batching <model.bin> [clip.wav ...] [--clips N] [--window-ms W] [--max-seconds S]
+//   Without clips, N (default 16) synthetic 2-8 second clips are generated. whisper
+//   transcribes them as noise, which is fine for throughput: the encoder cost does not
+//   depend on content. Pass real recordings to also compare the text per clip.
+
+#include "999-ExternalServices/ClipBatcher.h"
+#include "999-ExternalServices/DecodeProfile.h"
+#include "999-ExternalServices/Audio/WavReader.h"
+#include "999-ExternalServices/Audio/Resampler.h"
+#include "whisper.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int SAMPLE_RATE = 16000;
+
+static std::vector<float> syntheticClip(size_t index) {
+    // 2..8 seconds of a few harmonics with a slow envelope, so it is not silence to the model
+    const double seconds = 2.0 + static_cast<double>(index * 37 % 61) / 10.0;
+    std::vector<float> clip(static_cast<size_t>(seconds * SAMPLE_RATE));
+    const double base = 110.0 + 20.0 * (index % 7);
+    for (size_t i = 0; i < clip.size(); ++i) {
+        double t = static_cast<double>(i) / SAMPLE_RATE;
+        double envelope = 0.5 + 0.5 * std::sin(2.0 * M_PI * 3.0 * t);
+        double tone = std::sin(2.0 * M_PI * base * t) + 0.5 * std::sin(2.0 * M_PI * 2.0 * base * t);
+        clip[i] = static_cast<float>(0.2 * envelope * tone);
+    }
+    return clip;
+}
+
+static bool loadClip(const std::string& path, std::vector<float>& clip) {
+    WavReader reader;
+    if (!reader.open(path)) {
+        std::cerr << path << ": " << reader.getLastError() << std::endl;
+        return false;
+    }
+    reader.decodeMono(clip);
+    return Resampler::toWhisperRate(clip, static_cast<int>(reader.format().sample_rate));
+}
+
+// Same decoding setup as whisper_service
+static bool runWhisper(whisper_context* context, const std::vector<float>& audio, size_t clip_count,
+                       std::vector<TranscriptSegment>& segments, std::string& error) {
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.translate = false;
+    params.language = "en";
+    params.n_threads = std::min(4, (int)std::thread::hardware_concurrency());
+    DecodeProfile::forAudio(static_cast<double>(audio.size()) / SAMPLE_RATE, clip_count).apply(params);
+
+    if (whisper_full(context, params, audio.data(), audio.size()) != 0) {
+        error = "whisper_full failed";
+        return false;
+    }
+    for (int i = 0; i < whisper_full_n_segments(context); ++i) {
+        TranscriptSegment segment;
+        segment.text = whisper_full_get_segment_text(context, i);
+        segment.start_seconds = whisper_full_get_segment_t0(context, i) * 0.01;
+        segment.end_seconds = whisper_full_get_segment_t1(context, i) * 0.01;
+        segments.push_back(std::move(segment));
+    }
+    return true;
+}
+
+static std::string joinText(const std::vector<TranscriptSegment>& segments) {
+    std::string text;
+    for (const auto& segment : segments) {
+        text += segment.text;
+    }
+    text.erase(0, text.find_first_not_of(" \t\n\r"));
+    text.erase(text.find_last_not_of(" \t\n\r") + 1);
+    return text;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <model.bin> [clip.wav ...] [--clips N] [--window-ms W] [--max-seconds S]" << std::endl;
+        return 1;
+    }
+
+    ClipBatcherOptions options;
+    size_t synthetic_clips = 16;
+    std::vector<std::vector<float>> clips;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--clips" && i + 1 < argc) {
+            synthetic_clips = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--window-ms" && i + 1 < argc) {
+            options.window_ms = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-seconds" && i + 1 < argc) {
+            options.max_packed_seconds = std::clamp(std::atof(argv[++i]), 1.0, 30.0);
+        } else {
+            std::vector<float> clip;
+            if (!loadClip(arg, clip)) {
+                return 1;
+            }
+            clips.push_back(std::move(clip));
+        }
+    }
+    if (clips.empty()) {
+        for (size_t i = 0; i < synthetic_clips; ++i) {
+            clips.push_back(syntheticClip(i));
+        }
+    }
+
+    double audio_seconds = 0.0;
+    for (const auto& clip : clips) {
+        audio_seconds += static_cast<double>(clip.size()) / SAMPLE_RATE;
+    }
+
+    whisper_context* context = whisper_init_from_file_with_params(argv[1], whisper_context_default_params());
+    if (!context) {
+        std::cerr << "Failed to load model " << argv[1] << std::endl;
+        return 1;
+    }
+
+    std::printf("%zu clips, %.1f s of audio, window %d ms, max packed %.1f s\n\n",
+                clips.size(), audio_seconds, options.window_ms, options.max_packed_seconds);
+
+    // Warm-up so neither mode pays for first-touch allocations
+    {
+        std::vector<TranscriptSegment> segments;
+        std::string error;
+        runWhisper(context, clips[0], 1, segments, error);
+    }
+
+    // One whisper_full per clip
+    std::vector<std::string> sequential_text(clips.size());
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < clips.size(); ++i) {
+        std::vector<TranscriptSegment> segments;
+        std::string error;
+        runWhisper(context, clips[i], 1, segments, error);
+        sequential_text[i] = joinText(segments);
+    }
+    double sequential_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // All clips arrive at once, as from concurrent daemon connections
+    std::mutex inference_mutex;
+    size_t runs = 0;
+    ClipBatcher batcher(options, [&](const std::vector<float>& audio, size_t clip_count, int, const std::function<bool()>&,
+                                     const TranscriptListener&, std::vector<TranscriptSegment>& segments, std::string& error) {
+        std::lock_guard<std::mutex> lock(inference_mutex);
+        ++runs;
+        return runWhisper(context, audio, clip_count, segments, error);
+    });
+
+    std::vector<std::string> batched_text(clips.size());
+    std::vector<size_t> batch_sizes(clips.size());
+    std::vector<std::thread> submitters;
+    const std::function<bool()> never_abort;
+    // Every request is in flight before the first clip arrives, as the daemon counts them
+    std::vector<std::unique_ptr<ClipBatcher::InFlight>> in_flight;
+    for (size_t i = 0; i < clips.size(); ++i) {
+        in_flight.push_back(std::make_unique<ClipBatcher::InFlight>(batcher));
+    }
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < clips.size(); ++i) {
+        submitters.emplace_back([&, i]() {
+            ClipBatchResult result = batcher.transcribe(clips[i], 0, never_abort);
+            batched_text[i] = joinText(result.segments);
+            batch_sizes[i] = result.batch_size;
+            in_flight[i].reset();
+        });
+    }
+    for (auto& submitter : submitters) {
+        submitter.join();
+    }
+    double batched_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("  %-26s %9.0f ms %7.2f clips/s %7.1fx realtime\n", "one whisper_full per clip",
+                sequential_ms, clips.size() / (sequential_ms / 1000.0), audio_seconds / (sequential_ms / 1000.0));
+    std::printf("  %-26s %9.0f ms %7.2f clips/s %7.1fx realtime   %zu runs, %.2fx speedup\n", "ClipBatcher",
+                batched_ms, clips.size() / (batched_ms / 1000.0), audio_seconds / (batched_ms / 1000.0),
+                runs, sequential_ms / batched_ms);
+
+    std::cout << "\nPer clip (batch size | sequential text | batched text):" << std::endl;
+    for (size_t i = 0; i < clips.size(); ++i) {
+        std::printf("  %2zu  %zu | %s | %s\n", i, batch_sizes[i], sequential_text[i].c_str(), batched_text[i].c_str());
+    }
+
+    whisper_free(context);
+    return 0;
+}
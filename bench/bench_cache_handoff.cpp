@@ -0,0 +1,163 @@
+// Identical recordings transcribed by several sessions at once while some of them give up:
+// TranscriptionCache runs one inference per recording, and when the session that owns it
+// is cancelled a waiting session takes the claim over. Every round starts the owner, lets
+// the others join its inference, then cancels the first --cancel callers one after the
+// other. Reports how many inferences ran per round and how long the survivors waited;
+// exits 1 if a caller that was not cancelled got an error (e.g. the owner's cancellation).
+//
+// Usage: bench_cache_handoff [--rounds <n>] [--callers <n>] [--cancel <n>] [--seconds <audio s>]
+//                            [--synthetic "base-ms=300,per-second-ms=20"]
+
+#include "999-ExternalServices/WhisperCliService.h"
+#include "999-ExternalServices/SyntheticTranscriptionBackend.h"
+#include "999-ExternalServices/TranscriptionCache.h"
+#include "999-ExternalServices/TranscriptionScheduler.h"
+#include "999-ExternalServices/CancellationToken.h"
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static constexpr int SAMPLE_RATE = 16000;
+
+// A mono 16-bit WAV whose samples differ per round, so every round is a cache miss
+static void writeWav(const std::string& path, double seconds, int round) {
+    std::vector<int16_t> samples(static_cast<size_t>(seconds * SAMPLE_RATE));
+    for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<int16_t>((i * 31 + round * 7919) % 2000 - 1000);
+    }
+    uint32_t data_size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    uint32_t riff_size = 36 + data_size;
+    uint32_t fmt_size = 16;
+    uint16_t audio_format = 1;
+    uint16_t channels = 1;
+    uint32_t sample_rate = SAMPLE_RATE;
+    uint32_t byte_rate = SAMPLE_RATE * sizeof(int16_t);
+    uint16_t block_align = sizeof(int16_t);
+    uint16_t bits = 16;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write("RIFF", 4).write(reinterpret_cast<const char*>(&riff_size), 4).write("WAVE", 4);
+    file.write("fmt ", 4).write(reinterpret_cast<const char*>(&fmt_size), 4);
+    file.write(reinterpret_cast<const char*>(&audio_format), 2).write(reinterpret_cast<const char*>(&channels), 2);
+    file.write(reinterpret_cast<const char*>(&sample_rate), 4).write(reinterpret_cast<const char*>(&byte_rate), 4);
+    file.write(reinterpret_cast<const char*>(&block_align), 2).write(reinterpret_cast<const char*>(&bits), 2);
+    file.write("data", 4).write(reinterpret_cast<const char*>(&data_size), 4);
+    file.write(reinterpret_cast<const char*>(samples.data()), data_size);
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = 20;
+    size_t callers = 4;
+    size_t cancel = 1;
+    double seconds = 10.0;
+    std::string synthetic_spec = "distribution=fixed,base-ms=300,per-second-ms=20";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--rounds" && has_value) {
+            rounds = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--callers" && has_value) {
+            callers = std::max(2ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--cancel" && has_value) {
+            cancel = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--seconds" && has_value) {
+            seconds = std::max(0.5, std::atof(argv[++i]));
+        } else if (arg == "--synthetic" && has_value) {
+            synthetic_spec = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--rounds <n>] [--callers <n>] [--cancel <n>] [--seconds <audio s>] "
+                      << "[--synthetic <spec>]" << std::endl;
+            return 1;
+        }
+    }
+    cancel = std::min(cancel, callers - 1);
+
+    SyntheticBackendOptions options;
+    std::string error;
+    if (!SyntheticBackendOptions::parse(synthetic_spec, options, error)) {
+        std::cerr << "--synthetic: " << error << std::endl;
+        return 1;
+    }
+    auto backend = std::make_shared<SyntheticTranscriptionBackend>(options);
+    WhisperCliService::setDefaultBackend(backend);
+    TranscriptionScheduler::getInstance().configure(callers, TranscriptionScheduler::DEFAULT_MAX_QUEUED,
+                                                    TranscriptionScheduler::DEFAULT_MAX_QUEUED_PER_SESSION);
+
+    const std::string wav_path = "/tmp/bench_cache_handoff_" + std::to_string(getpid()) + ".wav";
+    const auto join_delay = std::chrono::milliseconds(20);
+    const auto cancel_interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>((options.base_ms + options.per_second_ms * seconds) / 3.0));
+
+    size_t wrong_errors = 0;
+    double survivor_wait_ms = 0.0;
+    size_t survivors = 0;
+    uint64_t requests_before = 0;
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << rounds << " rounds, " << callers << " callers of the same " << seconds << " s recording, first "
+              << cancel << " cancelled " << std::chrono::duration<double, std::milli>(cancel_interval).count()
+              << " ms apart" << std::endl;
+    for (size_t round = 0; round < rounds; ++round) {
+        writeWav(wav_path, seconds, static_cast<int>(round));
+
+        std::vector<std::shared_ptr<CancellationToken>> tokens;
+        std::vector<std::string> results(callers);
+        std::vector<double> waited_ms(callers, 0.0);
+        std::vector<std::thread> threads;
+        for (size_t c = 0; c < callers; ++c) {
+            tokens.push_back(CancellationToken::create());
+            threads.emplace_back([&, c]() {
+                WhisperCliService service;
+                service.initialize("whisper_service", "model.bin");
+                service.setQueueContext("session-" + std::to_string(c), nullptr);
+                service.setCancellationToken(tokens[c]);
+                auto start = Clock::now();
+                results[c] = service.transcribeFile(wav_path);
+                waited_ms[c] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+            });
+            // The first caller owns the claim, the others join it
+            std::this_thread::sleep_for(join_delay);
+        }
+        for (size_t c = 0; c < cancel; ++c) {
+            std::this_thread::sleep_for(cancel_interval);
+            tokens[c]->cancel();
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        for (size_t c = cancel; c < callers; ++c) {
+            if (results[c].rfind("ERROR:", 0) == 0) {
+                ++wrong_errors;
+                std::cout << "round " << round << ": caller " << c << " was not cancelled but got \"" << results[c]
+                          << "\"" << std::endl;
+            }
+            survivor_wait_ms += waited_ms[c];
+            ++survivors;
+        }
+        uint64_t requests = backend->getStats().requests;
+        if (round == 0 || round + 1 == rounds) {
+            std::cout << "round " << round << ": " << (requests - requests_before) << " inference(s) started" << std::endl;
+        }
+        requests_before = requests;
+    }
+    std::remove(wav_path.c_str());
+
+    TranscriptionCacheStats cache = TranscriptionCache::getInstance().getStats();
+    SyntheticBackendStats synthetic = backend->getStats();
+    std::cout << "inferences " << synthetic.requests << " (" << synthetic.cancelled << " cancelled), cache misses "
+              << cache.misses << ", coalesced " << cache.coalesced << ", abandoned " << cache.abandoned << std::endl;
+    std::cout << "survivors waited " << (survivors ? survivor_wait_ms / survivors : 0.0) << " ms on average, "
+              << wrong_errors << " of " << survivors << " got an error" << std::endl;
+    return wrong_errors == 0 ? 0 : 1;
+}
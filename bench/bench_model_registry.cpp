@@ -0,0 +1,163 @@
+// WhisperModelRegistry under a mixed-model load: how often a request finds its model
+// loaded, what a load costs the request that triggers it, and whether the registry stays
+// within its memory budget. Every lease runs one whisper_full over a second of silence,
+// so states are exercised the way WhisperAi's workers use them.
+//
+// Usage: bench_model_registry model.bin... [--budget-mb <mb>] [--ttl-seconds <s>]
+//                             [--requests <n>] [--threads <n>] [--skew <s>]
+//   Requests pick model i with weight 1 / (i + 1)^skew (default 1: the first model is the
+//   most popular). With a budget below the sum of the models, the unpopular ones are
+//   unloaded and reloaded; compare hit rates and latencies across budgets.
+
+#include "000-Server/Whisper/WhisperModelRegistry.h"
+#include "whisper.h"
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> model_paths;
+    WhisperModelRegistryOptions options;
+    options.idle_ttl_seconds = 0;
+    size_t requests = 200;
+    size_t threads = 4;
+    double skew = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--budget-mb" && has_value) {
+            options.memory_budget_mb = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--ttl-seconds" && has_value) {
+            options.idle_ttl_seconds = std::atoi(argv[++i]);
+        } else if (arg == "--requests" && has_value) {
+            requests = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && has_value) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--skew" && has_value) {
+            skew = std::atof(argv[++i]);
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        } else {
+            model_paths.push_back(arg);
+        }
+    }
+    if (model_paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " model.bin... [--budget-mb <mb>] [--ttl-seconds <s>] "
+                  << "[--requests <n>] [--threads <n>] [--skew <s>]" << std::endl;
+        return 1;
+    }
+
+    WhisperModelRegistry registry;
+    registry.configure(options);
+    std::vector<std::string> names;
+    std::vector<double> weights;
+    for (size_t i = 0; i < model_paths.size(); ++i) {
+        std::string name = std::to_string(i) + ":" + std::filesystem::path(model_paths[i]).stem().string();
+        std::string error;
+        if (!registry.registerModel(name, model_paths[i], false, error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        names.push_back(name);
+        weights.push_back(1.0 / std::pow(static_cast<double>(i + 1), skew));
+    }
+    registry.start();
+
+    const std::vector<float> silence(16000, 0.0f);
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failures{0};
+    std::atomic<uint64_t> peak_resident{0};
+    std::mutex latency_mutex;
+    std::vector<double> acquire_ms;
+
+    auto run = [&](size_t worker) {
+        std::mt19937 random(static_cast<unsigned>(worker) * 7919 + 1);
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+        for (size_t i = next++; i < requests; i = next++) {
+            auto start = Clock::now();
+            std::string error;
+            WhisperModelRegistry::Lease lease = registry.acquire(names[pick(random)], error);
+            double waited_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+            uint64_t resident = registry.residentBytes();
+            for (uint64_t peak = peak_resident; resident > peak && !peak_resident.compare_exchange_weak(peak, resident);) {
+            }
+            if (!lease) {
+                ++failures;
+                continue;
+            }
+
+            whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+            params.print_progress = false;
+            params.n_threads = 1;
+            params.language = "en";
+            if (whisper_full_with_state(lease.context(), lease.state(), params, silence.data(), silence.size()) != 0) {
+                ++failures;
+            }
+            std::lock_guard<std::mutex> lock(latency_mutex);
+            acquire_ms.push_back(waited_ms);
+        }
+    };
+
+    auto bench_start = Clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back(run, t);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double wall_ms = std::chrono::duration<double, std::milli>(Clock::now() - bench_start).count();
+    registry.stop();
+
+    std::cout << std::setw(28) << std::left << "model" << std::right << std::setw(10) << "status"
+              << std::setw(8) << "hits" << std::setw(8) << "loads" << std::setw(8) << "evict"
+              << std::setw(10) << "hit %" << std::setw(12) << "weights MB" << std::setw(10) << "state MB"
+              << std::setw(8) << "states" << std::setw(10) << "load ms" << "\n";
+    uint64_t total_hits = 0, total_loads = 0;
+    for (const WhisperModelStats& model : registry.getStats()) {
+        uint64_t leases = model.hits + model.loads;
+        total_hits += model.hits;
+        total_loads += model.loads;
+        std::cout << std::setw(28) << std::left << model.name << std::right << std::setw(10) << model.status
+                  << std::setw(8) << model.hits << std::setw(8) << model.loads << std::setw(8) << model.evictions
+                  << std::setw(10) << std::fixed << std::setprecision(1) << (leases ? 100.0 * model.hits / leases : 0.0)
+                  << std::setw(12) << model.weights_bytes / (1024.0 * 1024.0)
+                  << std::setw(10) << model.state_bytes / (1024.0 * 1024.0)
+                  << std::setw(8) << model.states << std::setw(10) << model.last_load_ms << "\n";
+    }
+
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "\n" << requests << " requests on " << threads << " threads in " << std::setprecision(0) << wall_ms
+              << " ms, " << failures.load() << " failed, hit rate " << std::setprecision(1)
+              << (total_hits + total_loads ? 100.0 * total_hits / (total_hits + total_loads) : 0.0) << "%\n"
+              << "acquire ms: p50 " << std::setprecision(2) << percentile(acquire_ms, 0.50)
+              << ", p95 " << percentile(acquire_ms, 0.95) << ", max " << percentile(acquire_ms, 1.0) << "\n"
+              << "peak accounted " << std::setprecision(1) << peak_resident.load() / (1024.0 * 1024.0) << " MB"
+              << (options.memory_budget_mb ? " of a " + std::to_string(options.memory_budget_mb) + " MB budget" : std::string())
+              << ", peak process RSS " << usage.ru_maxrss / 1024.0 << " MB" << std::endl;
+    return failures.load() == 0 ? 0 : 1;
+}
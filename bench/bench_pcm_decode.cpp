@@ -0,0 +1,208 @@
+// PCM decode microbenchmark: the original per-sample WAV loading loops against
+// bulk reads + PcmDecoder kernels on a 10-minute stereo file.
+//
+// Usage: bench_pcm_decode [file.wav]
+//   Without an argument a 10-minute 48kHz stereo 16-bit WAV is synthesized in /tmp.
+
+#include "999-ExternalServices/Audio/PcmDecoder.h"
+#include "999-ExternalServices/Audio/WavReader.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static constexpr int REPETITIONS = 5;
+static constexpr size_t WAV_HEADER_SIZE = 44;
+
+struct WavInfo {
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    size_t data_bytes = 0;
+};
+
+static bool readHeader(const std::string& path, WavInfo& info) {
+    std::ifstream file(path, std::ios::binary);
+    char header[WAV_HEADER_SIZE];
+    if (!file.read(header, WAV_HEADER_SIZE) || std::memcmp(header, "RIFF", 4) != 0) {
+        return false;
+    }
+    std::memcpy(&info.channels, header + 22, sizeof(info.channels));
+    std::memcpy(&info.sample_rate, header + 24, sizeof(info.sample_rate));
+    file.seekg(0, std::ios::end);
+    info.data_bytes = static_cast<size_t>(file.tellg()) - WAV_HEADER_SIZE;
+    return info.channels > 0;
+}
+
+static void writeTestFile(const std::string& path, uint32_t sample_rate, uint16_t channels, int seconds) {
+    const size_t frames = static_cast<size_t>(sample_rate) * seconds;
+    std::vector<int16_t> samples(frames * channels);
+    for (size_t i = 0; i < frames; ++i) {
+        for (uint16_t ch = 0; ch < channels; ++ch) {
+            double phase = 2.0 * M_PI * (220.0 * (ch + 1)) * i / sample_rate;
+            samples[i * channels + ch] = static_cast<int16_t>(12000.0 * std::sin(phase) + (i * 7919 % 512) - 256);
+        }
+    }
+
+    uint32_t data_size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    uint32_t riff_size = 36 + data_size;
+    uint32_t fmt_size = 16;
+    uint16_t audio_format = 1;
+    uint32_t byte_rate = sample_rate * channels * 2;
+    uint16_t block_align = channels * 2;
+    uint16_t bits = 16;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write("RIFF", 4);
+    out.write(reinterpret_cast<const char*>(&riff_size), 4);
+    out.write("WAVEfmt ", 8);
+    out.write(reinterpret_cast<const char*>(&fmt_size), 4);
+    out.write(reinterpret_cast<const char*>(&audio_format), 2);
+    out.write(reinterpret_cast<const char*>(&channels), 2);
+    out.write(reinterpret_cast<const char*>(&sample_rate), 4);
+    out.write(reinterpret_cast<const char*>(&byte_rate), 4);
+    out.write(reinterpret_cast<const char*>(&block_align), 2);
+    out.write(reinterpret_cast<const char*>(&bits), 2);
+    out.write("data", 4);
+    out.write(reinterpret_cast<const char*>(&data_size), 4);
+    out.write(reinterpret_cast<const char*>(samples.data()), data_size);
+}
+
+// whisper_service_main.cpp before PcmDecoder: one read + push_back per sample, divide per sample
+static void legacyServiceLoad(const std::string& path, uint16_t channels, std::vector<float>& out) {
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(WAV_HEADER_SIZE);
+    std::vector<int16_t> raw_data;
+    int16_t sample;
+    while (file.read(reinterpret_cast<char*>(&sample), sizeof(sample))) {
+        raw_data.push_back(sample);
+    }
+    out.clear();
+    out.reserve(raw_data.size() / channels);
+    for (size_t i = 0; i < raw_data.size(); i += channels) {
+        float sample_sum = 0.0f;
+        for (uint16_t ch = 0; ch < channels && i + ch < raw_data.size(); ++ch) {
+            sample_sum += static_cast<float>(raw_data[i + ch]) / 32768.0f;
+        }
+        out.push_back(sample_sum / channels);
+    }
+}
+
+// WhisperAi::loadAudioFile conversion loop (its read was already bulk)
+static void legacyConvert(const std::vector<int16_t>& raw, uint16_t channels, std::vector<float>& out) {
+    size_t frames = raw.size() / channels;
+    out.resize(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        float sample = 0.0f;
+        for (int ch = 0; ch < channels; ++ch) {
+            sample += static_cast<float>(raw[i * channels + ch]);
+        }
+        out[i] = (sample / channels) / 32768.0f;
+    }
+}
+
+static void bulkLoad(const std::string& path, const WavInfo& info, PcmDecoder::Isa isa, std::vector<float>& out) {
+    std::ifstream file(path, std::ios::binary);
+    file.seekg(WAV_HEADER_SIZE);
+    std::vector<int16_t> raw(info.data_bytes / sizeof(int16_t));
+    file.read(reinterpret_cast<char*>(raw.data()), raw.size() * sizeof(int16_t));
+    size_t frames = raw.size() / info.channels;
+    out.resize(frames);
+    PcmDecoder::int16ToMono(raw.data(), frames, info.channels, out.data(), isa);
+}
+
+static double bestOfMs(const std::function<void()>& body) {
+    double best = 1e300;
+    for (int r = 0; r < REPETITIONS; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+static float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    if (a.size() != b.size()) {
+        return INFINITY;
+    }
+    float diff = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, std::fabs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+static void report(const char* name, double ms, size_t bytes, double baseline_ms, float diff) {
+    std::printf("  %-28s %9.2f ms %9.1f MB/s %7.2fx   max|diff| %.2g\n",
+                name, ms, bytes / (ms / 1000.0) / 1e6, baseline_ms / ms, diff);
+}
+
+int main(int argc, char* argv[]) {
+    std::string path = argc > 1 ? argv[1] : "/tmp/bench_pcm_decode_10min_stereo.wav";
+    if (argc <= 1) {
+        std::cout << "Writing 10-minute 48kHz stereo test file to " << path << std::endl;
+        writeTestFile(path, 48000, 2, 600);
+    }
+
+    WavInfo info;
+    if (!readHeader(path, info)) {
+        std::cerr << "Not a WAV file: " << path << std::endl;
+        return 1;
+    }
+    std::printf("%s: %u Hz, %u channel(s), %.1f MB, best of %d, detected kernel: %s\n\n",
+                path.c_str(), info.sample_rate, info.channels, info.data_bytes / 1e6, REPETITIONS,
+                PcmDecoder::isaName(PcmDecoder::detectIsa()));
+
+    const PcmDecoder::Isa kernels[] = {PcmDecoder::Isa::Scalar, PcmDecoder::Isa::Sse2, PcmDecoder::Isa::Avx2};
+
+    // File -> mono float, including I/O (page cache warm after the first repetition)
+    std::vector<float> reference;
+    std::vector<float> output;
+    std::cout << "Load (read + decode):" << std::endl;
+    double legacy_load_ms = bestOfMs([&] { legacyServiceLoad(path, info.channels, reference); });
+    report("per-sample read (old)", legacy_load_ms, info.data_bytes, legacy_load_ms, 0.0f);
+    for (PcmDecoder::Isa isa : kernels) {
+        if (!PcmDecoder::isSupported(isa)) {
+            continue;
+        }
+        double ms = bestOfMs([&] { bulkLoad(path, info, isa, output); });
+        std::string name = std::string("bulk read + ") + PcmDecoder::isaName(isa);
+        report(name.c_str(), ms, info.data_bytes, legacy_load_ms, maxDifference(reference, output));
+    }
+    double mapped_ms = bestOfMs([&] {
+        WavReader reader;
+        if (reader.open(path)) {
+            reader.decodeMono(output);
+        }
+    });
+    report("WavReader (mmap, zero-copy)", mapped_ms, info.data_bytes, legacy_load_ms, maxDifference(reference, output));
+
+    // In-memory conversion only
+    std::vector<int16_t> raw(info.data_bytes / sizeof(int16_t));
+    {
+        std::ifstream file(path, std::ios::binary);
+        file.seekg(WAV_HEADER_SIZE);
+        file.read(reinterpret_cast<char*>(raw.data()), raw.size() * sizeof(int16_t));
+    }
+    size_t frames = raw.size() / info.channels;
+
+    std::cout << "\nDecode only (int16 -> mono float):" << std::endl;
+    double legacy_convert_ms = bestOfMs([&] { legacyConvert(raw, info.channels, reference); });
+    report("divide loop (old)", legacy_convert_ms, info.data_bytes, legacy_convert_ms, 0.0f);
+    for (PcmDecoder::Isa isa : kernels) {
+        if (!PcmDecoder::isSupported(isa)) {
+            continue;
+        }
+        output.assign(frames, 0.0f);
+        double ms = bestOfMs([&] { PcmDecoder::int16ToMono(raw.data(), frames, info.channels, output.data(), isa); });
+        report(PcmDecoder::isaName(isa), ms, info.data_bytes, legacy_convert_ms, maxDifference(reference, output));
+    }
+
+    return 0;
+}
@@ -0,0 +1,453 @@
+// The transcription pipeline under thousands of simultaneous recordings, without a model:
+// each recording is uploaded (a WAV decoded into a SharedAudioBuffer), handed to
+// WhisperCliService::transcribeAudioAsync, looked up in TranscriptionCache, queued on
+// TranscriptionScheduler and transcribed on its workers by
+// SyntheticTranscriptionBackend; live segments and the result come back through a pool
+// standing in for WServer::post, throttled like VoiceRecorder's live transcript. The
+// run is deterministic per recording: same options, same durations, latencies and failures.
+//
+// Usage: bench_pipeline_load [--recordings <n>] [--sessions <n>] [--arrivals-per-second <r>]
+//                            [--audio-seconds <min>:<max>] [--cancel-rate <f>] [--workers <n>]
+//                            [--scheduler-queue <n>] [--per-session <n>] [--wt-threads <n>]
+//                            [--synthetic <spec> | --model <model.bin>]
+//   --arrivals-per-second 0 (the default) uploads everything at once. --synthetic takes the
+//   wt_config.xml whisper-synthetic spec, e.g. "distribution=lognormal,base-ms=150,per-second-ms=60,failure-rate=0.02".
+//   --model decodes with WhisperAi in-process instead, to check the synthetic figures against a real model.
+//   Compare rejection counts, queue waits and push delays across queue and worker sizes.
+
+#include "999-ExternalServices/WhisperCliService.h"
+#include "999-ExternalServices/SyntheticTranscriptionBackend.h"
+#include "999-ExternalServices/TranscriptionScheduler.h"
+#include "999-ExternalServices/CancellationToken.h"
+#include "999-ExternalServices/SharedAudioBuffer.h"
+#include "000-Server/Whisper/WhisperAi.h"
+#include "000-Server/Whisper/WhisperAiBackend.h"
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Same spacing as VoiceRecorder's LIVE_UPDATE_INTERVAL_MS
+static constexpr int LIVE_UPDATE_INTERVAL_MS = 250;
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, static_cast<size_t>(p * values.size()))];
+}
+
+static double msSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+/**
+ * @brief Fixed pool running posted functions in order, measuring how long each waited (WServer::post)
+ */
+class PushQueue {
+public:
+    explicit PushQueue(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back([this]() { run(); });
+        }
+    }
+
+    ~PushQueue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    void post(std::function<void()> function) {
+        // Notified under the lock: the last result may let main() destroy the queue as soon as it runs
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back({Clock::now(), std::move(function)});
+        peak_depth_ = std::max(peak_depth_, queue_.size());
+        cv_.notify_one();
+    }
+
+    std::vector<double> delays() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return delays_ms_;
+    }
+
+    size_t peakDepth() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return peak_depth_;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            auto [posted, function] = std::move(queue_.front());
+            queue_.pop_front();
+            delays_ms_.push_back(msSince(posted));
+            lock.unlock();
+            function();
+            lock.lock();
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::pair<Clock::time_point, std::function<void()>>> queue_;
+    std::vector<std::thread> threads_;
+    std::vector<double> delays_ms_;
+    size_t peak_depth_ = 0;
+    bool stopping_ = false;
+};
+
+/**
+ * @brief Cancels tokens at their due time, like users leaving the page while their recording waits
+ */
+class Canceller {
+public:
+    Canceller() : thread_([this]() { run(); }) {}
+
+    ~Canceller() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    void cancelAt(Clock::time_point due, std::shared_ptr<CancellationToken> token) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            due_.emplace(due, std::move(token));
+        }
+        cv_.notify_all();
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            if (due_.empty()) {
+                cv_.wait(lock);
+            } else if (cv_.wait_until(lock, due_.begin()->first) == std::cv_status::timeout) {
+                while (!due_.empty() && due_.begin()->first <= Clock::now()) {
+                    auto token = std::move(due_.begin()->second);
+                    due_.erase(due_.begin());
+                    lock.unlock();
+                    token->cancel();
+                    lock.lock();
+                }
+            }
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::multimap<Clock::time_point, std::shared_ptr<CancellationToken>> due_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+/**
+ * @brief A 16 kHz 16-bit mono WAV of quiet noise in a memfd, different for every recording
+ */
+static std::shared_ptr<SharedAudioBuffer> uploadRecording(size_t index, double seconds, std::string& error) {
+    const uint32_t samples = static_cast<uint32_t>(seconds * SharedAudioBuffer::SAMPLE_RATE);
+    const uint32_t data_bytes = samples * 2;
+    std::vector<unsigned char> wav(44 + data_bytes);
+    auto put32 = [&](size_t at, uint32_t value) { std::memcpy(&wav[at], &value, 4); };
+    auto put16 = [&](size_t at, uint16_t value) { std::memcpy(&wav[at], &value, 2); };
+    std::memcpy(&wav[0], "RIFF", 4);
+    put32(4, 36 + data_bytes);
+    std::memcpy(&wav[8], "WAVEfmt ", 8);
+    put32(16, 16);
+    put16(20, 1);
+    put16(22, 1);
+    put32(24, SharedAudioBuffer::SAMPLE_RATE);
+    put32(28, SharedAudioBuffer::SAMPLE_RATE * 2);
+    put16(32, 2);
+    put16(34, 16);
+    std::memcpy(&wav[36], "data", 4);
+    put32(40, data_bytes);
+    uint32_t state = static_cast<uint32_t>(index) * 2654435761u + 1;
+    for (uint32_t i = 0; i < samples; ++i) {
+        state = state * 1664525u + 1013904223u;
+        put16(44 + 2 * i, static_cast<uint16_t>(static_cast<int16_t>((state >> 16) % 201) - 100));
+    }
+
+    int fd = memfd_create("bench_upload", MFD_CLOEXEC);
+    if (fd < 0 || write(fd, wav.data(), wav.size()) != static_cast<ssize_t>(wav.size())) {
+        error = std::string("memfd: ") + std::strerror(errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return nullptr;
+    }
+    auto audio = SharedAudioBuffer::fromUploadDescriptor(fd, "load/rec-" + std::to_string(index) + ".wav", error);
+    close(fd);
+    return audio;
+}
+
+int main(int argc, char** argv) {
+    size_t recordings = 2000;
+    size_t sessions = 500;
+    double arrivals_per_second = 0.0;
+    double min_seconds = 3.0, max_seconds = 30.0;
+    double cancel_rate = 0.0;
+    size_t workers = 4;
+    size_t scheduler_queue = TranscriptionScheduler::DEFAULT_MAX_QUEUED;
+    size_t per_session = TranscriptionScheduler::DEFAULT_MAX_QUEUED_PER_SESSION;
+    size_t wt_threads = 10;
+    SyntheticBackendOptions synthetic;
+    std::string model_path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        std::string error;
+        if (arg == "--recordings" && has_value) {
+            recordings = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--sessions" && has_value) {
+            sessions = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--arrivals-per-second" && has_value) {
+            arrivals_per_second = std::atof(argv[++i]);
+        } else if (arg == "--audio-seconds" && has_value) {
+            std::string range = argv[++i];
+            min_seconds = std::max(0.1, std::atof(range.c_str()));
+            size_t colon = range.find(':');
+            max_seconds = colon == std::string::npos ? min_seconds : std::max(min_seconds, std::atof(range.c_str() + colon + 1));
+        } else if (arg == "--cancel-rate" && has_value) {
+            cancel_rate = std::atof(argv[++i]);
+        } else if (arg == "--workers" && has_value) {
+            workers = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--scheduler-queue" && has_value) {
+            scheduler_queue = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--per-session" && has_value) {
+            per_session = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--wt-threads" && has_value) {
+            wt_threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--synthetic" && has_value) {
+            if (!SyntheticBackendOptions::parse(argv[++i], synthetic, error)) {
+                std::cerr << "--synthetic: " << error << std::endl;
+                return 1;
+            }
+        } else if (arg == "--model" && has_value) {
+            model_path = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--recordings <n>] [--sessions <n>] [--arrivals-per-second <r>] "
+                      << "[--audio-seconds <min>:<max>] [--cancel-rate <f>] [--workers <n>] "
+                      << "[--scheduler-queue <n>] [--per-session <n>] [--wt-threads <n>] "
+                      << "[--synthetic <spec> | --model <model.bin>]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::shared_ptr<SyntheticTranscriptionBackend> synthetic_backend;
+    std::shared_ptr<TranscriptionBackend> backend;
+    if (model_path.empty()) {
+        backend = synthetic_backend = std::make_shared<SyntheticTranscriptionBackend>(synthetic);
+    } else {
+        if (!WhisperAi::getInstance().initialize(workers, 0, model_path)) {
+            std::cerr << "Cannot load " << model_path << ": " << WhisperAi::getInstance().getLastError() << std::endl;
+            return 1;
+        }
+        backend = std::make_shared<WhisperAiBackend>();
+    }
+    WhisperCliService::setDefaultBackend(backend);
+    TranscriptionScheduler::getInstance().configure(workers, scheduler_queue, per_session);
+
+    // Per-recording draws come from the recording's index, so they do not depend on thread timing
+    std::vector<double> durations(recordings);
+    std::vector<double> cancel_after_ms(recordings, -1.0);
+    std::mt19937_64 random(synthetic.seed);
+    std::uniform_real_distribution<double> seconds(min_seconds, max_seconds);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    double total_audio_seconds = 0.0;
+    for (size_t i = 0; i < recordings; ++i) {
+        durations[i] = seconds(random);
+        total_audio_seconds += durations[i];
+        if (unit(random) < cancel_rate) {
+            // Somewhere between the upload and a little past the median latency
+            cancel_after_ms[i] = unit(random) * 1.5 * (synthetic.base_ms + synthetic.per_second_ms * durations[i]);
+        }
+    }
+
+    std::mutex results_mutex;
+    std::condition_variable done_cv;
+    size_t pending = 0;
+    size_t ok = 0, failed = 0, cancelled = 0, scheduler_rejected = 0, upload_failed = 0;
+    std::vector<double> latency_ms, queue_wait_ms, upload_ms;
+    std::atomic<uint64_t> live_pushes{0};
+    std::atomic<uint64_t> segments_seen{0};
+
+    PushQueue push(wt_threads);
+    Canceller canceller;
+    std::atomic<size_t> next_upload{0};
+    const auto bench_start = Clock::now();
+
+    // Wt's request threads take the uploads; each starts its recording's transcription and returns
+    auto upload = [&]() {
+        for (size_t i = next_upload++; i < recordings; i = next_upload++) {
+            if (arrivals_per_second > 0.0) {
+                std::this_thread::sleep_until(bench_start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double>(i / arrivals_per_second)));
+            }
+            const auto arrived = Clock::now();
+            std::string error;
+            std::shared_ptr<SharedAudioBuffer> audio = uploadRecording(i, durations[i], error);
+            double decode_ms = msSince(arrived);
+            if (!audio) {
+                std::lock_guard<std::mutex> lock(results_mutex);
+                ++upload_failed;
+                continue;
+            }
+
+            struct Live {
+                std::mutex mutex;
+                Clock::time_point last_push;
+                bool started = false;
+            };
+            auto live = std::make_shared<Live>();
+            auto token = CancellationToken::create();
+
+            WhisperCliService service;
+            service.initialize(WhisperCliService::defaultExecutablePath(), WhisperCliService::defaultModelPath());
+            service.setQueueContext("session-" + std::to_string(i % sessions), [&, live, arrived](size_t position) {
+                std::lock_guard<std::mutex> lock(live->mutex);
+                if (position == 0 && !live->started) {
+                    live->started = true;
+                    std::lock_guard<std::mutex> results_lock(results_mutex);
+                    queue_wait_ms.push_back(msSince(arrived));
+                }
+            });
+            service.setCancellationToken(token);
+            TranscriptListener listener;
+            listener.on_segment = [&, live](const TranscriptSegment&) {
+                ++segments_seen;
+                std::lock_guard<std::mutex> lock(live->mutex);
+                auto now = Clock::now();
+                if (now - live->last_push >= std::chrono::milliseconds(LIVE_UPDATE_INTERVAL_MS)) {
+                    live->last_push = now;
+                    push.post([&live_pushes]() { ++live_pushes; });
+                }
+            };
+            service.setTranscriptListener(listener);
+
+            {
+                std::lock_guard<std::mutex> lock(results_mutex);
+                ++pending;
+                upload_ms.push_back(decode_ms);
+            }
+            bool queued = service.transcribeAudioAsync(audio, [&, arrived](const std::string& result) {
+                push.post([&, arrived, result]() {
+                    std::lock_guard<std::mutex> lock(results_mutex);
+                    if (result.rfind("ERROR: Server busy", 0) == 0) {
+                        ++scheduler_rejected;
+                    } else if (result == "ERROR: Cancelled") {
+                        ++cancelled;
+                    } else if (result.rfind("ERROR:", 0) == 0) {
+                        ++failed;
+                    } else {
+                        ++ok;
+                        latency_ms.push_back(msSince(arrived));
+                    }
+                    if (--pending == 0) {
+                        done_cv.notify_all();
+                    }
+                });
+            });
+            if (!queued) {
+                std::lock_guard<std::mutex> lock(results_mutex);
+                ++scheduler_rejected;
+                if (--pending == 0) {
+                    done_cv.notify_all();
+                }
+                continue;
+            }
+            if (cancel_after_ms[i] >= 0.0) {
+                canceller.cancelAt(arrived + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::milli>(cancel_after_ms[i])), token);
+            }
+        }
+    };
+
+    std::vector<std::thread> uploaders;
+    for (size_t t = 0; t < wt_threads; ++t) {
+        uploaders.emplace_back(upload);
+    }
+    for (auto& uploader : uploaders) {
+        uploader.join();
+    }
+    {
+        std::unique_lock<std::mutex> lock(results_mutex);
+        done_cv.wait(lock, [&]() { return pending == 0; });
+    }
+    double wall_ms = msSince(bench_start);
+
+    SyntheticBackendStats simulated = synthetic_backend ? synthetic_backend->getStats() : SyntheticBackendStats();
+    TranscriptionSchedulerStats scheduler = TranscriptionScheduler::getInstance().getStats();
+    std::vector<double> push_delays = push.delays();
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::lock_guard<std::mutex> lock(results_mutex);
+    std::cout << std::fixed << std::setprecision(1)
+              << recordings << " recordings (" << total_audio_seconds / 3600.0 << " h of audio) from " << sessions
+              << " sessions, " << (arrivals_per_second > 0.0 ? std::to_string(arrivals_per_second) + "/s" : std::string("all at once"))
+              << "; " << workers << " scheduler workers, scheduler queue " << scheduler_queue << " (" << per_session << " per session)\n"
+              << "backend: " << (synthetic_backend ? synthetic.describe() : backend->backendName() + " " + model_path) << "\n\n"
+              << "transcribed   " << ok << "\n"
+              << "failed        " << failed << "\n"
+              << "cancelled     " << cancelled << " (" << scheduler.cancelled << " left the scheduler queue)\n"
+              << "busy          " << scheduler_rejected << " scheduler queue full\n"
+              << "upload failed " << upload_failed << "\n\n"
+              << std::setprecision(0)
+              << "wall " << wall_ms << " ms, " << std::setprecision(1) << ok * 1000.0 / wall_ms << " transcripts/s\n"
+              << std::setprecision(0)
+              << "upload ms:     p50 " << percentile(upload_ms, 0.50) << ", p99 " << percentile(upload_ms, 0.99) << "\n"
+              << "queue wait ms: p50 " << percentile(queue_wait_ms, 0.50) << ", p95 " << percentile(queue_wait_ms, 0.95)
+              << ", p99 " << percentile(queue_wait_ms, 0.99) << ", max " << percentile(queue_wait_ms, 1.0) << "\n"
+              << "latency ms:    p50 " << percentile(latency_ms, 0.50) << ", p95 " << percentile(latency_ms, 0.95)
+              << ", p99 " << percentile(latency_ms, 0.99) << ", max " << percentile(latency_ms, 1.0) << "\n"
+              << std::setprecision(2)
+              << "push delay ms: p50 " << percentile(push_delays, 0.50) << ", p99 " << percentile(push_delays, 0.99)
+              << ", max " << percentile(push_delays, 1.0) << "; " << live_pushes.load() << " live pushes for "
+              << segments_seen.load() << " segments, peak push queue " << push.peakDepth() << "\n"
+              << std::setprecision(1)
+              << "scheduler: " << scheduler.completed << " completed, " << scheduler.rejected << " rejected\n";
+    if (synthetic_backend) {
+        std::cout << "synthetic: " << simulated.failures << " failures drawn, " << simulated.cancelled
+                  << " cancelled while decoding, peak " << simulated.peak_in_flight << " decoding at once, "
+                  << simulated.simulated_ms / wall_ms << "x the simulated decode time in parallel, burned CPU "
+                  << simulated.burned_cpu_ms / 1000.0 << " s\n";
+    }
+    std::cout << "peak process RSS " << usage.ru_maxrss / 1024.0 << " MB" << std::endl;
+    return upload_failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+// Upload-complete handler latency: the original saveAudioFile (stream copy + exists()
+// on the Wt event thread) against RecordingStorage::store (rename, or a copy queued on
+// the I/O pool). Reports what the handler itself waits for and, separately, how long the
+// background copy takes to land.
+//
+// Usage: bench_recording_storage [spool_dir archive_dir] [size_mb...]
+//   Without directories it runs /tmp -> /tmp (same file system) and, when /dev/shm is a
+//   different file system, /dev/shm -> /tmp (what a tmpfs spool directory costs).
+
+#include "999-ExternalServices/RecordingStorage.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static constexpr int REPETITIONS = 7;
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+static void writeSpoolFile(const std::string& path, size_t bytes) {
+    std::vector<char> block(1024 * 1024);
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>(i * 7919);
+    }
+    std::ofstream out(path, std::ios::binary);
+    for (size_t written = 0; written < bytes; written += block.size()) {
+        out.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), bytes - written)));
+    }
+}
+
+// VoiceRecorder::saveAudioFile as it was, minus the logging
+static bool legacySave(const std::string& temp_path, const std::string& permanent_path) {
+    std::ifstream src(temp_path, std::ios::binary);
+    std::ofstream dst(permanent_path, std::ios::binary);
+    if (!src.is_open() || !dst.is_open()) {
+        return false;
+    }
+    dst << src.rdbuf();
+    src.close();
+    dst.close();
+    return std::filesystem::exists(permanent_path);
+}
+
+static void runScenario(const std::string& spool_dir, const std::string& archive_dir, const std::vector<size_t>& sizes_mb) {
+    std::filesystem::create_directories(archive_dir);
+    struct stat spool_info, archive_info;
+    stat(spool_dir.c_str(), &spool_info);
+    stat(archive_dir.c_str(), &archive_info);
+    bool same_fs = spool_info.st_dev == archive_info.st_dev;
+
+    std::cout << "\n" << spool_dir << " -> " << archive_dir << (same_fs ? " (same file system)" : " (different file systems)") << "\n";
+    std::cout << std::setw(8) << "size" << std::setw(16) << "legacy ms" << std::setw(16) << "handler ms"
+              << std::setw(18) << "background ms" << std::setw(18) << "method" << "\n";
+
+    const std::string spool = spool_dir + "/bench_recording_spool.wav";
+    const std::string archived = archive_dir + "/bench_recording_archived.wav";
+
+    for (size_t mb : sizes_mb) {
+        std::vector<double> legacy_ms, handler_ms, background_ms;
+        RecordingStorageMethod method = RecordingStorageMethod::Failed;
+
+        for (int rep = 0; rep < REPETITIONS; ++rep) {
+            // Before: the handler copies, then Wt deletes the spool file
+            writeSpoolFile(spool, mb * 1024 * 1024);
+            std::remove(archived.c_str());
+            auto start = Clock::now();
+            legacySave(spool, archived);
+            legacy_ms.push_back(millisecondsSince(start));
+            std::remove(spool.c_str());
+
+            // After: the handler keeps a descriptor for the decoder and hands the file over
+            writeSpoolFile(spool, mb * 1024 * 1024);
+            std::remove(archived.c_str());
+            std::promise<RecordingStorageResult> done;
+            start = Clock::now();
+            int fd = open(spool.c_str(), O_RDONLY | O_CLOEXEC);
+            RecordingStorage::store(spool, archived, [&done](const RecordingStorageResult& result) {
+                done.set_value(result);
+            });
+            handler_ms.push_back(millisecondsSince(start));
+            RecordingStorageResult result = done.get_future().get();
+            background_ms.push_back(millisecondsSince(start));
+            method = result.method;
+            close(fd);
+        }
+
+        std::cout << std::setw(6) << mb << "MB" << std::fixed << std::setprecision(3)
+                  << std::setw(16) << median(legacy_ms) << std::setw(16) << median(handler_ms)
+                  << std::setw(18) << median(background_ms)
+                  << std::setw(18) << RecordingStorage::methodName(method) << "\n";
+    }
+    std::remove(archived.c_str());
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> dirs;
+    std::vector<size_t> sizes_mb;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (!arg.empty() && std::all_of(arg.begin(), arg.end(), ::isdigit)) {
+            sizes_mb.push_back(std::stoul(arg));
+        } else {
+            dirs.push_back(arg);
+        }
+    }
+    if (sizes_mb.empty()) {
+        sizes_mb = {1, 6, 30, 120};  // ~1 minute of 16kHz mono up to 10 minutes of 48kHz stereo
+    }
+
+    std::cout << "Median of " << REPETITIONS << " runs; handler = time spent in the uploaded() handler, "
+              << "background = until the archive file is complete" << std::endl;
+
+    if (dirs.size() >= 2) {
+        runScenario(dirs[0], dirs[1], sizes_mb);
+        return 0;
+    }
+    runScenario("/tmp", "/tmp/bench_recording_archive", sizes_mb);
+
+    struct stat shm_info, tmp_info;
+    if (stat("/dev/shm", &shm_info) == 0 && stat("/tmp", &tmp_info) == 0 && shm_info.st_dev != tmp_info.st_dev) {
+        runScenario("/dev/shm", "/tmp/bench_recording_archive", sizes_mb);
+    }
+    return 0;
+}
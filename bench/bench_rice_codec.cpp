@@ -0,0 +1,125 @@
+// Upload size and decode cost: recordings as the recorder used to send them (16kHz mono
+// 16-bit WAV) against RiceCodec, the recorder's lossless encoding. Every file is checked
+// to round-trip bit-exactly.
+//
+// Usage: bench_rice_codec file.wav...
+//   Files are converted the way the recorder does (mono, 16kHz, clamped and truncated to
+//   int16) before encoding. The bench_corpus target produces a set of clips.
+
+#include "999-ExternalServices/Audio/RiceCodec.h"
+#include "999-ExternalServices/Audio/PcmDecoder.h"
+#include "999-ExternalServices/Audio/WavReader.h"
+#include "999-ExternalServices/Audio/Resampler.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static constexpr int REPETITIONS = 5;
+static constexpr size_t WAV_HEADER_SIZE = 44;
+static constexpr size_t MAX_REQUEST_BYTES = 1024 * 1024;  // max-request-size in wt_config.xml
+
+using Clock = std::chrono::steady_clock;
+
+static double millisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Same quantization as the recorder's encodeWAV / encodeRice (JavaScript numbers are doubles)
+static std::vector<int16_t> toRecorderPcm(const std::vector<float>& samples) {
+    std::vector<int16_t> pcm(samples.size());
+    for (size_t i = 0; i < samples.size(); ++i) {
+        double sample = std::max(-1.0, std::min(1.0, static_cast<double>(samples[i])));
+        pcm[i] = static_cast<int16_t>(sample < 0 ? sample * 0x8000 : sample * 0x7FFF);
+    }
+    return pcm;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " file.wav..." << std::endl;
+        return 1;
+    }
+
+    std::cout << std::setw(36) << std::left << "file" << std::right << std::setw(10) << "seconds"
+              << std::setw(12) << "wav bytes" << std::setw(12) << "wrc bytes" << std::setw(8) << "ratio"
+              << std::setw(12) << "encode ms" << std::setw(12) << "decode ms" << std::setw(14) << "decode x rt" << "\n";
+
+    size_t total_wav = 0, total_wrc = 0, total_samples = 0;
+    double total_decode_ms = 0.0;
+    bool all_exact = true;
+
+    for (int i = 1; i < argc; ++i) {
+        WavReader reader;
+        if (!reader.open(argv[i])) {
+            std::cerr << reader.getLastError() << std::endl;
+            continue;
+        }
+        std::vector<float> samples;
+        reader.decodeMono(samples);
+        Resampler::toWhisperRate(samples, static_cast<int>(reader.format().sample_rate));
+        std::vector<int16_t> pcm = toRecorderPcm(samples);
+
+        auto start = Clock::now();
+        std::vector<unsigned char> encoded = RiceCodec::encode(pcm.data(), pcm.size(), Resampler::WHISPER_SAMPLE_RATE);
+        double encode_ms = millisecondsSince(start);
+
+        // What the server does with an upload: decode, then convert to float for whisper
+        std::vector<double> decode_ms;
+        std::vector<int16_t> decoded;
+        std::vector<float> mono;
+        bool exact = true;
+        for (int rep = 0; rep < REPETITIONS; ++rep) {
+            uint32_t sample_rate = 0;
+            std::string error;
+            start = Clock::now();
+            if (!RiceCodec::decode(encoded.data(), encoded.size(), decoded, sample_rate, error)) {
+                std::cerr << argv[i] << ": " << error << std::endl;
+                exact = false;
+                break;
+            }
+            mono.resize(decoded.size());
+            PcmDecoder::int16ToMono(decoded.data(), decoded.size(), 1, mono.data());
+            decode_ms.push_back(millisecondsSince(start));
+            exact = exact && decoded == pcm && sample_rate == Resampler::WHISPER_SAMPLE_RATE;
+        }
+        if (!exact || decode_ms.empty()) {
+            std::cerr << argv[i] << ": round trip is NOT lossless" << std::endl;
+            all_exact = false;
+            continue;
+        }
+        std::sort(decode_ms.begin(), decode_ms.end());
+        double median_ms = decode_ms[decode_ms.size() / 2];
+        double seconds = static_cast<double>(pcm.size()) / Resampler::WHISPER_SAMPLE_RATE;
+        size_t wav_bytes = WAV_HEADER_SIZE + pcm.size() * sizeof(int16_t);
+
+        std::string name = argv[i];
+        name = name.substr(name.find_last_of('/') + 1);
+        std::cout << std::setw(36) << std::left << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(10) << seconds << std::setw(12) << wav_bytes << std::setw(12) << encoded.size()
+                  << std::setprecision(3) << std::setw(8) << static_cast<double>(encoded.size()) / wav_bytes
+                  << std::setw(12) << encode_ms << std::setw(12) << median_ms
+                  << std::setprecision(0) << std::setw(14) << seconds * 1000.0 / median_ms << "\n";
+
+        total_wav += wav_bytes;
+        total_wrc += encoded.size();
+        total_samples += pcm.size();
+        total_decode_ms += median_ms;
+    }
+
+    if (total_wav == 0) {
+        return 1;
+    }
+    double ratio = static_cast<double>(total_wrc) / total_wav;
+    double wav_bytes_per_second = Resampler::WHISPER_SAMPLE_RATE * sizeof(int16_t);
+    std::cout << "\nTotal: " << total_wav << " -> " << total_wrc << " bytes (ratio " << std::setprecision(3) << ratio
+              << "), decode " << std::setprecision(1)
+              << (total_samples * sizeof(int16_t)) / (total_decode_ms * 1000.0) << " MB/s of PCM\n"
+              << "Longest recording under max-request-size: WAV " << std::setprecision(0)
+              << MAX_REQUEST_BYTES / wav_bytes_per_second << "s, RiceCodec ~"
+              << MAX_REQUEST_BYTES / (wav_bytes_per_second * ratio) << "s at this ratio\n"
+              << (all_exact ? "All files round-trip bit-exactly" : "SOME FILES FAILED TO ROUND-TRIP") << std::endl;
+    return all_exact ? 0 : 1;
+}
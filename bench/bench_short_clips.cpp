@@ -0,0 +1,268 @@
+// Short-clip profile benchmark: full 1500-frame encoder context against reduced
+// audio_ctx + single_segment, scored by word error rate against reference transcripts.
+//
+// Usage: bench_short_clips <model.bin> <clip.wav ...> [--margins 64,128,256] [--max-wer-increase P]
+//   Each clip.wav is scored against clip.txt next to it. Clips without one are scored
+//   against the full profile's own output, which measures agreement rather than accuracy.
+//   Results are grouped by clip length; the suggested DecodeProfileOptions are the largest
+//   short_clip_seconds (bucket bound) whose WER stays within P percentage points (default
+//   0.5) of the full profile in every bucket below it.
+
+#include "999-ExternalServices/DecodeProfile.h"
+#include "999-ExternalServices/Audio/WavReader.h"
+#include "999-ExternalServices/Audio/Resampler.h"
+#include "whisper.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int SAMPLE_RATE = 16000;
+static const double BUCKET_BOUNDS[] = {3.0, 6.0, 10.0, 15.0, 30.0};
+static constexpr size_t BUCKETS = sizeof(BUCKET_BOUNDS) / sizeof(BUCKET_BOUNDS[0]);
+
+struct Clip {
+    std::string path;
+    std::vector<float> samples;
+    double seconds = 0.0;
+    size_t bucket = 0;
+    std::vector<std::string> reference;
+    bool has_reference = false;
+};
+
+// Errors and reference words summed over a bucket, plus time spent in whisper_full
+struct Score {
+    size_t errors = 0;
+    size_t words = 0;
+    double ms = 0.0;
+    size_t clips = 0;
+
+    double wer() const { return words ? 100.0 * errors / words : 0.0; }
+};
+
+// Lowercase words without punctuation, so "Hello," and "hello" match
+static std::vector<std::string> normalizeWords(const std::string& text) {
+    std::vector<std::string> words;
+    std::string word;
+    for (char c : text + " ") {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || c == '\'') {
+            word += static_cast<char>(std::tolower(u));
+        } else if (std::isspace(u) && !word.empty()) {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    return words;
+}
+
+// Word-level Levenshtein distance (substitutions + insertions + deletions)
+static size_t wordErrors(const std::vector<std::string>& reference, const std::vector<std::string>& hypothesis) {
+    std::vector<size_t> previous(hypothesis.size() + 1), current(hypothesis.size() + 1);
+    for (size_t j = 0; j <= hypothesis.size(); ++j) {
+        previous[j] = j;
+    }
+    for (size_t i = 1; i <= reference.size(); ++i) {
+        current[0] = i;
+        for (size_t j = 1; j <= hypothesis.size(); ++j) {
+            size_t substitution = previous[j - 1] + (reference[i - 1] == hypothesis[j - 1] ? 0 : 1);
+            current[j] = std::min({substitution, previous[j] + 1, current[j - 1] + 1});
+        }
+        std::swap(previous, current);
+    }
+    return previous[hypothesis.size()];
+}
+
+static bool loadClip(const std::string& path, Clip& clip) {
+    WavReader reader;
+    if (!reader.open(path)) {
+        std::cerr << path << ": " << reader.getLastError() << std::endl;
+        return false;
+    }
+    reader.decodeMono(clip.samples);
+    if (!Resampler::toWhisperRate(clip.samples, static_cast<int>(reader.format().sample_rate))) {
+        std::cerr << path << ": unsupported sample rate" << std::endl;
+        return false;
+    }
+    clip.path = path;
+    clip.seconds = static_cast<double>(clip.samples.size()) / SAMPLE_RATE;
+    while (clip.bucket + 1 < BUCKETS && clip.seconds >= BUCKET_BOUNDS[clip.bucket]) {
+        ++clip.bucket;
+    }
+
+    std::string reference_path = path.substr(0, path.find_last_of('.')) + ".txt";
+    std::ifstream reference(reference_path);
+    if (reference) {
+        std::stringstream text;
+        text << reference.rdbuf();
+        clip.reference = normalizeWords(text.str());
+        clip.has_reference = true;
+    }
+    return true;
+}
+
+// Same decoding setup as whisper_service, with the profile under test
+static std::string transcribe(whisper_context* context, const Clip& clip, const DecodeProfile& profile, double& ms) {
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_realtime = false;
+    params.print_progress = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.translate = false;
+    params.language = "en";
+    params.n_threads = std::min(4, (int)std::thread::hardware_concurrency());
+    profile.apply(params);
+
+    auto start = std::chrono::steady_clock::now();
+    int result = whisper_full(context, params, clip.samples.data(), clip.samples.size());
+    ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (result != 0) {
+        std::cerr << clip.path << ": whisper_full failed (" << result << ")" << std::endl;
+        return "";
+    }
+
+    std::string text;
+    for (int i = 0; i < whisper_full_n_segments(context); ++i) {
+        text += whisper_full_get_segment_text(context, i);
+    }
+    return text;
+}
+
+static void printRow(const char* label, const Score* scores) {
+    std::printf("  %-14s", label);
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        if (scores[b].clips == 0) {
+            std::printf(" %17s", "-");
+        } else {
+            std::printf(" %6.2f%% %7.0fms", scores[b].wer(), scores[b].ms / scores[b].clips);
+        }
+    }
+    std::printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <model.bin> <clip.wav ...> [--margins 64,128,256] [--max-wer-increase P]" << std::endl;
+        return 1;
+    }
+
+    std::vector<int> margins = {64, 128, 256};
+    double max_wer_increase = 0.5;
+    std::vector<Clip> clips;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--margins" && i + 1 < argc) {
+            margins.clear();
+            std::stringstream list(argv[++i]);
+            std::string margin;
+            while (std::getline(list, margin, ',')) {
+                margins.push_back(std::max(0, std::atoi(margin.c_str())));
+            }
+        } else if (arg == "--max-wer-increase" && i + 1 < argc) {
+            max_wer_increase = std::atof(argv[++i]);
+        } else {
+            Clip clip;
+            if (!loadClip(arg, clip)) {
+                return 1;
+            }
+            clips.push_back(std::move(clip));
+        }
+    }
+    if (clips.empty() || margins.empty()) {
+        std::cerr << "Need at least one clip and one margin" << std::endl;
+        return 1;
+    }
+
+    whisper_context* context = whisper_init_from_file_with_params(argv[1], whisper_context_default_params());
+    if (!context) {
+        std::cerr << "Failed to load model " << argv[1] << std::endl;
+        return 1;
+    }
+
+    size_t with_reference = 0;
+    for (const Clip& clip : clips) {
+        with_reference += clip.has_reference ? 1 : 0;
+    }
+    std::printf("%zu clips, %zu with reference transcripts\n\n", clips.size(), with_reference);
+
+    // Warm-up so the first measured run does not pay for first-touch allocations
+    double warmup_ms = 0.0;
+    transcribe(context, clips[0], DecodeProfile(), warmup_ms);
+
+    // Full profile first: its output is the reference for clips without a .txt
+    Score full[BUCKETS];
+    std::vector<std::vector<std::string>> references(clips.size());
+    for (size_t i = 0; i < clips.size(); ++i) {
+        double ms = 0.0;
+        std::vector<std::string> words = normalizeWords(transcribe(context, clips[i], DecodeProfile(), ms));
+        references[i] = clips[i].has_reference ? clips[i].reference : words;
+        Score& score = full[clips[i].bucket];
+        score.errors += wordErrors(references[i], words);
+        score.words += references[i].size();
+        score.ms += ms;
+        ++score.clips;
+    }
+
+    // Short profile forced on every clip, once per margin
+    std::vector<std::vector<Score>> reduced(margins.size(), std::vector<Score>(BUCKETS));
+    for (size_t m = 0; m < margins.size(); ++m) {
+        DecodeProfileOptions options;
+        options.short_clip_seconds = 30.0;
+        options.audio_ctx_margin = margins[m];
+        for (size_t i = 0; i < clips.size(); ++i) {
+            double ms = 0.0;
+            DecodeProfile profile = DecodeProfile::forAudio(clips[i].seconds, 1, options);
+            std::vector<std::string> words = normalizeWords(transcribe(context, clips[i], profile, ms));
+            Score& score = reduced[m][clips[i].bucket];
+            score.errors += wordErrors(references[i], words);
+            score.words += references[i].size();
+            score.ms += ms;
+            ++score.clips;
+        }
+    }
+
+    std::printf("  %-14s", "WER / avg ms");
+    double lower = 0.0;
+    for (size_t b = 0; b < BUCKETS; ++b) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "%.0f-%.0fs", lower, BUCKET_BOUNDS[b]);
+        std::printf(" %17s", label);
+        lower = BUCKET_BOUNDS[b];
+    }
+    std::printf("\n");
+    printRow("full", full);
+    for (size_t m = 0; m < margins.size(); ++m) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "ctx+%d", margins[m]);
+        printRow(label, reduced[m].data());
+    }
+
+    // Largest threshold at which the short profile costs no more than the allowed WER
+    std::printf("\nSuggested thresholds (WER within %.2f points of full):\n", max_wer_increase);
+    for (size_t m = 0; m < margins.size(); ++m) {
+        double threshold = 0.0;
+        double speedup_ms = 0.0;
+        for (size_t b = 0; b < BUCKETS; ++b) {
+            if (full[b].clips == 0) {
+                continue;
+            }
+            if (reduced[m][b].wer() > full[b].wer() + max_wer_increase) {
+                break;
+            }
+            threshold = BUCKET_BOUNDS[b];
+            speedup_ms += full[b].ms - reduced[m][b].ms;
+        }
+        std::printf("  margin %4d: short_clip_seconds = %4.0f  (saves %.0f ms over the clips below it)\n",
+                    margins[m], threshold, speedup_ms);
+    }
+
+    whisper_free(context);
+    return 0;
+}
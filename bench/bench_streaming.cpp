@@ -0,0 +1,207 @@
+// Live transcription over a long recording: streams minutes of audio through
+// StreamingTranscriber in the 0.5s chunks VoiceRecorder posts, faster than real time,
+// and reports per minute of audio how many passes ran, how long they took and how much
+// uncommitted audio the transcriber held. A pass should cost the same in minute 10 as in
+// minute 1; the run fails (exit status 1) if the held audio ever grows past two windows,
+// which is what an unbounded tail (e.g. silence whisper finds no segment in) looks like.
+//
+// Usage: bench_streaming <model.bin> [--minutes <n>] [--speed <x real time>] [--signal silence|tone]
+//                        [--service <whisper_service>]
+
+#include "999-ExternalServices/StreamingTranscriber.h"
+#include <nlohmann/json.hpp>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef WHISPER_SERVICE_EXECUTABLE
+#define WHISPER_SERVICE_EXECUTABLE "./whisper_service"
+#endif
+
+using Clock = std::chrono::steady_clock;
+using json = nlohmann::json;
+
+static constexpr size_t CHUNK_SAMPLES = StreamingTranscriber::SAMPLE_RATE / 2;
+static constexpr size_t CHUNKS_PER_MINUTE = 120;
+
+struct MinuteStats {
+    size_t passes = 0;
+    double pass_ms = 0.0;           // Summed time between consecutive updates
+    size_t peak_buffered = 0;       // Samples
+};
+
+// Start whisper_service --daemon and wait for its ready line
+static pid_t startDaemon(const std::string& service_path, const std::string& model_path,
+                         const std::string& socket_path, std::string& error) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        error = "pipe failed";
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        execl(service_path.c_str(), service_path.c_str(), "--daemon", socket_path.c_str(), model_path.c_str(),
+              static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(pipe_fds[1]);
+    std::string line;
+    char c;
+    while (read(pipe_fds[0], &c, 1) == 1 && c != '\n') {
+        line += c;
+    }
+    close(pipe_fds[0]);
+    json ready = json::parse(line, nullptr, false);
+    if (pid < 0 || ready.is_discarded() || !ready.value("success", false)) {
+        error = "daemon failed to start: " + line;
+        if (pid > 0) {
+            kill(pid, SIGTERM);
+            waitpid(pid, nullptr, 0);
+        }
+        return -1;
+    }
+    return pid;
+}
+
+int main(int argc, char** argv) {
+    std::string model_path;
+    std::string service_path = WHISPER_SERVICE_EXECUTABLE;
+    std::string signal = "silence";
+    size_t minutes = 10;
+    double speed = 20.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--minutes" && has_value) {
+            minutes = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--speed" && has_value) {
+            speed = std::max(0.1, std::atof(argv[++i]));
+        } else if (arg == "--signal" && has_value) {
+            signal = argv[++i];
+        } else if (arg == "--service" && has_value) {
+            service_path = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        } else {
+            model_path = arg;
+        }
+    }
+    if (model_path.empty() || (signal != "silence" && signal != "tone")) {
+        std::cerr << "Usage: " << argv[0] << " <model.bin> [--minutes <n>] [--speed <x real time>] "
+                  << "[--signal silence|tone] [--service <whisper_service>]" << std::endl;
+        return 1;
+    }
+
+    std::string socket_path = "/tmp/bench_streaming_" + std::to_string(getpid()) + ".sock";
+    std::string error;
+    pid_t daemon_pid = startDaemon(service_path, model_path, socket_path, error);
+    if (daemon_pid < 0) {
+        std::cerr << error << std::endl;
+        return 1;
+    }
+
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+    std::vector<MinuteStats> per_minute(minutes + 1);
+    size_t current_minute = 0;
+    size_t failed_passes = 0;
+    Clock::time_point last_update = Clock::now();
+
+    auto transcriber = StreamingTranscriber::create(
+        service_path, model_path, socket_path, "bench",
+        [&](const StreamingUpdate& update) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto now = Clock::now();
+            MinuteStats& stats = per_minute[std::min(current_minute, minutes)];
+            ++stats.passes;
+            stats.pass_ms += std::chrono::duration<double, std::milli>(now - last_update).count();
+            last_update = now;
+            failed_passes += update.error.empty() ? 0 : 1;
+            if (update.final) {
+                done = true;
+                done_cv.notify_all();
+            }
+        });
+
+    // Silence, or a 440 Hz tone that is never quiet long enough to end a segment
+    std::vector<int16_t> chunk(CHUNK_SAMPLES, 0);
+    const auto chunk_interval = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(0.5 / speed));
+    size_t peak_buffered = 0;
+    auto next_chunk = Clock::now();
+    for (size_t i = 0; i < minutes * CHUNKS_PER_MINUTE; ++i) {
+        if (signal == "tone") {
+            for (size_t s = 0; s < chunk.size(); ++s) {
+                double t = static_cast<double>(i * CHUNK_SAMPLES + s) / StreamingTranscriber::SAMPLE_RATE;
+                chunk[s] = static_cast<int16_t>(3000.0 * std::sin(2.0 * M_PI * 440.0 * t));
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current_minute = i / CHUNKS_PER_MINUTE;
+        }
+        transcriber->appendSamples(chunk.data(), chunk.size());
+        size_t buffered = transcriber->bufferedSamples();
+        peak_buffered = std::max(peak_buffered, buffered);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            MinuteStats& stats = per_minute[current_minute];
+            stats.peak_buffered = std::max(stats.peak_buffered, buffered);
+        }
+        next_chunk += chunk_interval;
+        std::this_thread::sleep_until(next_chunk);
+    }
+
+    auto finish_start = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_minute = minutes;
+    }
+    transcriber->finish();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&done] { return done; });
+    }
+    double final_ms = std::chrono::duration<double, std::milli>(Clock::now() - finish_start).count();
+
+    kill(daemon_pid, SIGTERM);
+    waitpid(daemon_pid, nullptr, 0);
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << minutes << " min of " << signal << " at " << speed << "x real time" << std::endl;
+    std::cout << std::setw(8) << "minute" << std::setw(8) << "passes" << std::setw(14) << "ms/update"
+              << std::setw(14) << "peak held s" << std::endl;
+    for (size_t m = 0; m < minutes; ++m) {
+        const MinuteStats& stats = per_minute[m];
+        std::cout << std::setw(8) << (m + 1) << std::setw(8) << stats.passes << std::setw(14)
+                  << (stats.passes ? stats.pass_ms / stats.passes : 0.0) << std::setw(14)
+                  << static_cast<double>(stats.peak_buffered) / StreamingTranscriber::SAMPLE_RATE << std::endl;
+    }
+    std::cout << "final pass " << final_ms << " ms, " << failed_passes << " failed passes" << std::endl;
+
+    size_t limit = 2 * StreamingTranscriber::MAX_WINDOW_SAMPLES;
+    if (peak_buffered > limit) {
+        std::cout << "FAIL: held " << static_cast<double>(peak_buffered) / StreamingTranscriber::SAMPLE_RATE
+                  << " s of uncommitted audio (limit " << static_cast<double>(limit) / StreamingTranscriber::SAMPLE_RATE
+                  << " s)" << std::endl;
+        return 1;
+    }
+    return failed_passes == 0 ? 0 : 1;
+}
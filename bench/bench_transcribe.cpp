@@ -0,0 +1,862 @@
+// End-to-end transcription benchmark: a directory of WAV files through each backend
+// (in-process WhisperAi, one whisper_service process per file, whisper_service daemon,
+// WhisperWorkerPool with one worker per concurrent request) for every thread count x
+// concurrency level x chunking strategy, reported as JSON.
+//
+// Usage:
+//   bench_transcribe --generate-corpus <dir>
+//       Writes a small synthetic corpus (2-45 s, 16/44.1/48 kHz, mono and stereo).
+//   bench_transcribe <model.bin> <corpus_dir> [--backends whisper_ai,cli,daemon,pool]
+//                    [--threads 1,2,4] [--concurrency 1,2,4] [--chunking off,pauses,fixed] [--vad]
+//                    [--service <whisper_service>] [--output results.json] [--baseline previous.json]
+//                    [--tolerance <percent>]
+//
+// Each configuration runs in a forked child so model loads, caches and peak RSS do not
+// leak between runs. Per configuration the report has the real-time factor (audio
+// seconds per wall second, like whisper_service's own), p50/p95/p99 request latency,
+// p50/p95 time to the first segment (every backend streams segments as they decode),
+// model load time and the peak RSS of the benchmark process and of the whisper_service
+// processes it started. With --baseline, configurations whose real-time factor dropped
+// or whose p95 grew by more than --tolerance percent (default 10) are listed and the
+// exit status is 2.
+//
+// --chunking splits recordings longer than AudioChunker's min_audio_seconds into windows
+// spread over the idle states (whisper_ai) or workers (pool); cli and daemon only run
+// "off". Every chunked configuration reports its speed-up over the same configuration
+// with chunking off. One long recording with --concurrency 4 shows the gain for a single
+// user; a corpus of many files mostly shows the stitching overhead.
+
+#include "000-Server/Whisper/WhisperAi.h"
+#include "999-ExternalServices/WhisperDaemonClient.h"
+#include "999-ExternalServices/WhisperDaemonProtocol.h"
+#include "999-ExternalServices/WhisperWorkerPool.h"
+#include "999-ExternalServices/AudioChunker.h"
+#include "999-ExternalServices/Audio/WavReader.h"
+#include "999-ExternalServices/Audio/Resampler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#ifndef WHISPER_SERVICE_EXECUTABLE
+#define WHISPER_SERVICE_EXECUTABLE "./whisper_service"
+#endif
+
+struct CorpusFile {
+    std::string path;
+    double seconds = 0.0;
+};
+
+struct BenchConfig {
+    std::string backend;
+    int threads = 1;
+    int concurrency = 1;
+    std::string chunking = "off";   // ChunkingOptions strategy name
+};
+
+struct BenchSettings {
+    std::string model_path;
+    std::string service_path = WHISPER_SERVICE_EXECUTABLE;
+    bool vad = false;
+};
+
+// ---------------------------------------------------------------------------
+// Corpus generation
+// ---------------------------------------------------------------------------
+
+static void writeWav(const std::string& path, const std::vector<int16_t>& samples, uint32_t sample_rate, uint16_t channels) {
+    uint32_t data_size = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    uint32_t riff_size = 36 + data_size;
+    uint32_t fmt_size = 16;
+    uint16_t audio_format = 1;
+    uint32_t byte_rate = sample_rate * channels * 2;
+    uint16_t block_align = channels * 2;
+    uint16_t bits = 16;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write("RIFF", 4);
+    out.write(reinterpret_cast<const char*>(&riff_size), 4);
+    out.write("WAVEfmt ", 8);
+    out.write(reinterpret_cast<const char*>(&fmt_size), 4);
+    out.write(reinterpret_cast<const char*>(&audio_format), 2);
+    out.write(reinterpret_cast<const char*>(&channels), 2);
+    out.write(reinterpret_cast<const char*>(&sample_rate), 4);
+    out.write(reinterpret_cast<const char*>(&byte_rate), 4);
+    out.write(reinterpret_cast<const char*>(&block_align), 2);
+    out.write(reinterpret_cast<const char*>(&bits), 2);
+    out.write("data", 4);
+    out.write(reinterpret_cast<const char*>(&data_size), 4);
+    out.write(reinterpret_cast<const char*>(samples.data()), data_size);
+}
+
+// Vowel-like babble: harmonics of a drifting pitch shaped by formant peaks, ~4 syllables
+// per second with pauses between words. Not intelligible, but it has the spectral and
+// loudness structure of speech, so VAD and the decoder do real work on it.
+static std::vector<int16_t> syntheticSpeech(double seconds, uint32_t sample_rate, uint16_t channels, uint32_t seed) {
+    static const double FORMANTS[][3] = {
+        {730, 1090, 2440}, {270, 2290, 3010}, {300, 870, 2240}, {530, 1840, 2480}, {570, 840, 2410}
+    };
+    const size_t frames = static_cast<size_t>(seconds * sample_rate);
+    std::vector<int16_t> samples(frames * channels);
+
+    uint32_t state = seed * 2654435761u + 1;
+    auto random = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<double>(state >> 8) / 16777216.0;
+    };
+
+    const size_t syllable = sample_rate / 4;
+    double phase = 0.0;
+    size_t vowel = 0;
+    double pitch = 120.0;
+    bool pause = false;
+    for (size_t i = 0; i < frames; ++i) {
+        size_t position = i % syllable;
+        if (position == 0) {
+            vowel = static_cast<size_t>(random() * 5) % 5;
+            pitch = 100.0 + 80.0 * random();
+            pause = random() < 0.15;
+        }
+        double envelope = pause ? 0.0 : std::sin(M_PI * position / syllable);
+        phase += 2.0 * M_PI * pitch * (1.0 + 0.05 * std::sin(2.0 * M_PI * 3.0 * i / sample_rate)) / sample_rate;
+
+        double value = 0.0;
+        for (int harmonic = 1; harmonic * pitch < 4000.0; ++harmonic) {
+            double frequency = harmonic * pitch;
+            double gain = 0.0;
+            for (double formant : FORMANTS[vowel]) {
+                gain += std::exp(-std::pow((frequency - formant) / 120.0, 2.0));
+            }
+            value += gain / harmonic * std::sin(harmonic * phase);
+        }
+        value = 0.25 * envelope * value + 0.005 * (random() - 0.5);
+
+        for (uint16_t ch = 0; ch < channels; ++ch) {
+            double sample = std::clamp(value * (ch == 0 ? 1.0 : 0.9), -1.0, 1.0);
+            samples[i * channels + ch] = static_cast<int16_t>(sample * 32767.0);
+        }
+    }
+    return samples;
+}
+
+static int generateCorpus(const std::string& directory) {
+    struct Entry { double seconds; uint32_t rate; uint16_t channels; };
+    static const Entry ENTRIES[] = {
+        {2, 16000, 1}, {3, 48000, 1}, {5, 16000, 1}, {8, 44100, 2},
+        {12, 16000, 1}, {20, 48000, 2}, {30, 16000, 1}, {45, 16000, 1}
+    };
+
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec) {
+        std::cerr << "Cannot create " << directory << ": " << ec.message() << std::endl;
+        return 1;
+    }
+
+    uint32_t seed = 1;
+    for (const Entry& entry : ENTRIES) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "clip_%02.0fs_%uhz_%uch.wav", entry.seconds, entry.rate, entry.channels);
+        std::string path = (std::filesystem::path(directory) / name).string();
+        writeWav(path, syntheticSpeech(entry.seconds, entry.rate, entry.channels, seed++), entry.rate, entry.channels);
+        std::cerr << "wrote " << path << std::endl;
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Backends: each transcribes one file and returns false on failure
+// ---------------------------------------------------------------------------
+
+// Run a process to completion and capture its stdout; on_line sees each line as it is written
+static bool runProcess(const std::vector<std::string>& args, std::string& output,
+                       const std::function<void(const std::string&)>& on_line = nullptr) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(pipe_fds[1], STDOUT_FILENO);
+        close(pipe_fds[0]);
+        close(pipe_fds[1]);
+        std::vector<char*> argv;
+        for (const std::string& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(pipe_fds[1]);
+    char buffer[4096];
+    ssize_t n;
+    size_t line_start = 0;
+    while ((n = read(pipe_fds[0], buffer, sizeof(buffer))) > 0) {
+        output.append(buffer, static_cast<size_t>(n));
+        for (size_t newline; on_line && (newline = output.find('\n', line_start)) != std::string::npos;) {
+            on_line(output.substr(line_start, newline - line_start));
+            line_start = newline + 1;
+        }
+    }
+    close(pipe_fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+class Backend {
+public:
+    virtual ~Backend() = default;
+    // Load the model (timed by the caller as model load)
+    virtual bool start(std::string& error) = 0;
+    // Called from `concurrency` threads at once; worker is the calling thread's index.
+    // Segments are reported to the listener as the backend delivers them.
+    virtual bool transcribe(size_t worker, const CorpusFile& file, const TranscriptListener& listener) = 0;
+    virtual void stop() {}
+    // Load time reported by the backend itself, < 0 when the caller's timing is used
+    virtual double reportedLoadMs() const { return -1.0; }
+};
+
+class WhisperAiBackend : public Backend {
+public:
+    WhisperAiBackend(const BenchConfig& config, const BenchSettings& settings) : config_(config), settings_(settings) {}
+
+    bool start(std::string& error) override {
+        WhisperAi& whisper = WhisperAi::getInstance();
+        whisper.setVadEnabled(settings_.vad);
+        if (!whisper.initialize(config_.concurrency, config_.threads, settings_.model_path)) {
+            error = whisper.getLastError();
+            return false;
+        }
+        // Warm-up on raw samples, which bypass the transcript cache
+        whisper.transcribeAudioData(std::vector<float>(16000, 0.0f));
+        return true;
+    }
+
+    bool transcribe(size_t, const CorpusFile& file, const TranscriptListener& listener) override {
+        return WhisperAi::getInstance().transcribeFileAsync(file.path, nullptr, listener).get().rfind("ERROR:", 0) != 0;
+    }
+
+private:
+    BenchConfig config_;
+    BenchSettings settings_;
+};
+
+// One whisper_service process per file, as WhisperCliService does without a daemon
+class CliBackend : public Backend {
+public:
+    CliBackend(const BenchConfig& config, const BenchSettings& settings) : config_(config), settings_(settings) {}
+
+    bool start(std::string& error) override {
+        if (access(settings_.service_path.c_str(), X_OK) != 0) {
+            error = "whisper_service not found: " + settings_.service_path;
+            return false;
+        }
+        return true;
+    }
+
+    bool transcribe(size_t, const CorpusFile& file, const TranscriptListener& listener) override {
+        std::vector<std::string> args = {settings_.service_path, settings_.model_path, file.path,
+                                         "--threads", std::to_string(config_.threads), "--stream"};
+        if (settings_.vad) {
+            args.push_back("--vad");
+        }
+        // Event lines first, the response last
+        std::string output;
+        json response;
+        bool ran = runProcess(args, output, [&listener, &response](const std::string& line) {
+            json message = json::parse(line, nullptr, false);
+            if (!WhisperDaemonProtocol::dispatchEvent(message, &listener)) {
+                response = message;
+            }
+        });
+        if (!ran || response.is_discarded() || !response.value("success", false)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        load_ms_total_ += response["initialization"].value("load_ms", 0.0);
+        ++loads_;
+        return true;
+    }
+
+    // Every request loads the model, report the average
+    double reportedLoadMs() const override {
+        std::lock_guard<std::mutex> lock(load_mutex_);
+        return loads_ ? load_ms_total_ / loads_ : 0.0;
+    }
+
+private:
+    BenchConfig config_;
+    BenchSettings settings_;
+    mutable std::mutex load_mutex_;
+    double load_ms_total_ = 0.0;
+    size_t loads_ = 0;
+};
+
+// A whisper_service --daemon started for this run, one connection per concurrent worker
+class DaemonBackend : public Backend {
+public:
+    DaemonBackend(const BenchConfig& config, const BenchSettings& settings)
+        : config_(config), settings_(settings), pid_(-1), load_ms_(0.0)
+        , socket_path_("/tmp/bench_transcribe_" + std::to_string(getpid()) + ".sock") {}
+
+    ~DaemonBackend() override { stop(); }
+
+    bool start(std::string& error) override {
+        int pipe_fds[2];
+        if (pipe(pipe_fds) != 0) {
+            error = "pipe failed";
+            return false;
+        }
+        pid_ = fork();
+        if (pid_ == 0) {
+            dup2(pipe_fds[1], STDOUT_FILENO);
+            close(pipe_fds[0]);
+            close(pipe_fds[1]);
+            std::string threads = std::to_string(config_.threads);
+            execl(settings_.service_path.c_str(), settings_.service_path.c_str(), "--daemon", socket_path_.c_str(),
+                  settings_.model_path.c_str(), "--threads", threads.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        close(pipe_fds[1]);
+
+        // The daemon prints one JSON line once it listens (or fails to start)
+        std::string line;
+        char c;
+        while (read(pipe_fds[0], &c, 1) == 1 && c != '\n') {
+            line += c;
+        }
+        close(pipe_fds[0]);
+        json ready = json::parse(line, nullptr, false);
+        if (pid_ < 0 || ready.is_discarded() || !ready.value("success", false)) {
+            error = "daemon failed to start: " + line;
+            return false;
+        }
+        load_ms_ = ready["initialization"].value("load_ms", 0.0);
+
+        for (int i = 0; i < config_.concurrency; ++i) {
+            clients_.push_back(std::make_unique<WhisperDaemonClient>(socket_path_, settings_.service_path, settings_.model_path));
+        }
+
+        // Warm-up with a second of silence as inline PCM, which the daemon never caches
+        std::vector<int16_t> silence(16000, 0);
+        json response;
+        return clients_[0]->request({{"op", "transcribe"}, {"pcm", "s16le"}}, response, error,
+                                    silence.data(), silence.size() * sizeof(int16_t));
+    }
+
+    bool transcribe(size_t worker, const CorpusFile& file, const TranscriptListener& listener) override {
+        json request = {{"op", "transcribe"}, {"audio_file", file.path}, {"vad", settings_.vad}, {"stream", true}};
+        json response;
+        std::string error;
+        return clients_[worker]->request(request, response, error, nullptr, 0, nullptr, -1, &listener) &&
+               response.value("success", false);
+    }
+
+    void stop() override {
+        clients_.clear();
+        if (pid_ > 0) {
+            kill(pid_, SIGTERM);
+            waitpid(pid_, nullptr, 0);
+            pid_ = -1;
+        }
+    }
+
+    double reportedLoadMs() const override { return load_ms_; }
+
+private:
+    BenchConfig config_;
+    BenchSettings settings_;
+    pid_t pid_;
+    double load_ms_;
+    std::string socket_path_;
+    std::vector<std::unique_ptr<WhisperDaemonClient>> clients_;
+};
+
+// WhisperWorkerPool with one worker per concurrent request, as the server runs it
+class PoolBackend : public Backend {
+public:
+    PoolBackend(const BenchConfig& config, const BenchSettings& settings) : config_(config), settings_(settings) {}
+
+    ~PoolBackend() override { stop(); }
+
+    bool start(std::string& error) override {
+        WhisperWorkerPoolOptions options;
+        options.workers = static_cast<size_t>(config_.concurrency);
+        WhisperWorkerPool& pool = WhisperWorkerPool::getInstance();
+        if (!pool.start(settings_.service_path, settings_.model_path, options)) {
+            error = "worker pool failed to start with " + settings_.service_path;
+            return false;
+        }
+        // Timed as model load: until every worker has its model
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.startup_timeout_ms);
+        while (pool.getStats().idle < options.workers) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                error = "workers did not start";
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        std::vector<int16_t> silence(16000, 0);
+        json response;
+        return pool.request({{"op", "transcribe"}, {"pcm", "s16le"}, {"threads", config_.threads}}, response, error,
+                            silence.data(), silence.size() * sizeof(int16_t));
+    }
+
+    bool transcribe(size_t, const CorpusFile& file, const TranscriptListener& listener) override {
+        AudioChunker chunker;
+        if (config_.concurrency > 1 && chunker.shouldSplit(static_cast<size_t>(file.seconds * Resampler::WHISPER_SAMPLE_RATE))) {
+            return transcribeChunked(chunker, file, listener);
+        }
+        json request = {{"op", "transcribe"}, {"audio_file", file.path}, {"vad", settings_.vad},
+                        {"threads", config_.threads}, {"stream", true}};
+        json response;
+        std::string error;
+        return WhisperWorkerPool::getInstance().request(request, response, error, nullptr, 0, nullptr, -1, &listener) &&
+               response.value("success", false);
+    }
+
+    void stop() override { WhisperWorkerPool::getInstance().stop(); }
+
+private:
+    // What WhisperCliService does with a long upload: windows on every idle worker
+    bool transcribeChunked(const AudioChunker& chunker, const CorpusFile& file, const TranscriptListener& listener) {
+        WavReader reader;
+        std::vector<float> samples;
+        if (!reader.open(file.path)) {
+            return false;
+        }
+        reader.decodeMono(samples);
+        Resampler::toWhisperRate(samples, static_cast<int>(reader.format().sample_rate));
+
+        std::vector<AudioWindow> windows = chunker.plan(samples.data(), samples.size());
+        TranscriptStitcher stitcher(windows, Resampler::WHISPER_SAMPLE_RATE, listener);
+        WhisperWorkerPool& pool = WhisperWorkerPool::getInstance();
+        return AudioChunker::runParallel(windows.size(), std::max<size_t>(1, pool.getStats().idle), [&](size_t index) {
+            json request = {{"op", "transcribe"}, {"audio_file", file.path}, {"vad", settings_.vad},
+                            {"threads", config_.threads}, {"window", {windows[index].start, windows[index].end}}};
+            json response;
+            std::string error;
+            if (!pool.request(request, response, error) || !response.value("success", false)) {
+                return false;
+            }
+            std::vector<TranscriptSegment> segments;
+            for (const json& segment : response["segments"]) {
+                segments.push_back({segment.value("start_time", 0.0), segment.value("end_time", 0.0),
+                                    segment.value("text", "")});
+            }
+            stitcher.addWindow(index, segments);
+            return true;
+        });
+    }
+
+    BenchConfig config_;
+    BenchSettings settings_;
+};
+
+// ---------------------------------------------------------------------------
+// Running one configuration (inside a forked child)
+// ---------------------------------------------------------------------------
+
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+    return values[std::min(values.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static json runConfig(const BenchConfig& config, const BenchSettings& settings, const std::vector<CorpusFile>& corpus) {
+    json result = {{"backend", config.backend}, {"threads", config.threads}, {"concurrency", config.concurrency},
+                   {"chunking", config.chunking}};
+
+    ChunkingOptions chunking;
+    ChunkingOptions::parseStrategy(config.chunking, chunking.strategy);
+    AudioChunker::setDefaultOptions(chunking);
+
+    std::unique_ptr<Backend> backend;
+    if (config.backend == "whisper_ai") {
+        backend = std::make_unique<WhisperAiBackend>(config, settings);
+    } else if (config.backend == "cli") {
+        backend = std::make_unique<CliBackend>(config, settings);
+    } else if (config.backend == "pool") {
+        backend = std::make_unique<PoolBackend>(config, settings);
+    } else {
+        backend = std::make_unique<DaemonBackend>(config, settings);
+    }
+
+    std::string error;
+    auto load_start = std::chrono::steady_clock::now();
+    if (!backend->start(error)) {
+        result["error"] = error;
+        return result;
+    }
+    double start_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+
+    // Workers take the next file until the corpus is done
+    std::vector<double> latencies(corpus.size(), 0.0);
+    std::vector<double> first_segments(corpus.size(), -1.0);   // < 0: no segment (silence)
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failures{0};
+    std::vector<std::thread> workers;
+    auto wall_start = std::chrono::steady_clock::now();
+    for (int w = 0; w < config.concurrency; ++w) {
+        workers.emplace_back([&, w]() {
+            for (size_t i = next++; i < corpus.size(); i = next++) {
+                auto start = std::chrono::steady_clock::now();
+                TranscriptListener listener;
+                listener.on_segment = [&first_segments, i, start](const TranscriptSegment&) {
+                    if (first_segments[i] < 0.0) {
+                        first_segments[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    }
+                };
+                if (!backend->transcribe(static_cast<size_t>(w), corpus[i], listener)) {
+                    ++failures;
+                }
+                latencies[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall_start).count();
+    double reported_load_ms = backend->reportedLoadMs();
+    backend->stop();
+
+    double audio_seconds = 0.0;
+    for (const CorpusFile& file : corpus) {
+        audio_seconds += file.seconds;
+    }
+
+    double latency_sum = 0.0;
+    for (double latency : latencies) {
+        latency_sum += latency;
+    }
+    std::vector<double> first_segment_ms;
+    for (double first : first_segments) {
+        if (first >= 0.0) {
+            first_segment_ms.push_back(first);
+        }
+    }
+
+    result["files"] = corpus.size();
+    result["failures"] = failures.load();
+    result["audio_seconds"] = audio_seconds;
+    result["wall_ms"] = wall_ms;
+    result["real_time_factor"] = audio_seconds / (wall_ms / 1000.0);
+    result["model_load_ms"] = reported_load_ms >= 0.0 ? reported_load_ms : start_ms;
+    result["latency_ms"] = {
+        {"mean", latency_sum / std::max<size_t>(1, latencies.size())},
+        {"p50", percentile(latencies, 50)},
+        {"p95", percentile(latencies, 95)},
+        {"p99", percentile(latencies, 99)},
+        {"max", percentile(latencies, 100)}
+    };
+    result["first_segment_ms"] = {
+        {"p50", percentile(first_segment_ms, 50)},
+        {"p95", percentile(first_segment_ms, 95)}
+    };
+    ChunkingStats chunk_stats = AudioChunker::getStats();
+    if (chunk_stats.recordings > 0) {
+        result["chunks"] = {
+            {"recordings", chunk_stats.recordings},
+            {"windows", chunk_stats.windows},
+            {"pause_cuts", chunk_stats.pause_cuts},
+            {"forced_cuts", chunk_stats.forced_cuts},
+            {"deduplicated_words", chunk_stats.deduplicated_words}
+        };
+    }
+
+    // Service processes have all been reaped by now
+    rusage self{}, children{};
+    getrusage(RUSAGE_SELF, &self);
+    getrusage(RUSAGE_CHILDREN, &children);
+    result["peak_rss_kb"] = self.ru_maxrss;
+    result["peak_rss_children_kb"] = children.ru_maxrss;
+    return result;
+}
+
+// Fork, run the configuration in the child and collect its JSON
+static json runIsolated(const BenchConfig& config, const BenchSettings& settings, const std::vector<CorpusFile>& corpus) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+        return {{"backend", config.backend}, {"error", "pipe failed"}};
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(pipe_fds[0]);
+        // WhisperAi and the services log to stdout, keep it for the report
+        int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        std::string report = runConfig(config, settings, corpus).dump();
+        ssize_t written = write(pipe_fds[1], report.data(), report.size());
+        _exit(written == static_cast<ssize_t>(report.size()) ? 0 : 1);
+    }
+    close(pipe_fds[1]);
+
+    std::string report;
+    char buffer[4096];
+    ssize_t n;
+    while ((n = read(pipe_fds[0], buffer, sizeof(buffer))) > 0) {
+        report.append(buffer, static_cast<size_t>(n));
+    }
+    close(pipe_fds[0]);
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+
+    json result = json::parse(report, nullptr, false);
+    if (result.is_discarded()) {
+        result = {{"backend", config.backend}, {"threads", config.threads}, {"concurrency", config.concurrency},
+                  {"chunking", config.chunking}, {"error", "benchmark child exited with status " + std::to_string(status)}};
+    }
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+
+static std::vector<int> parseIntList(const std::string& list) {
+    std::vector<int> values;
+    std::stringstream stream(list);
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        values.push_back(std::max(1, std::atoi(value.c_str())));
+    }
+    return values;
+}
+
+static std::vector<std::string> parseList(const std::string& list) {
+    std::vector<std::string> values;
+    std::stringstream stream(list);
+    std::string value;
+    while (std::getline(stream, value, ',')) {
+        values.push_back(value);
+    }
+    return values;
+}
+
+// Configurations slower than the baseline by more than tolerance_percent
+static json findRegressions(const json& results, const json& baseline, double tolerance_percent) {
+    json regressions = json::array();
+    const double factor = tolerance_percent / 100.0;
+    for (const json& current : results) {
+        for (const json& previous : baseline) {
+            if (previous.value("backend", "") != current.value("backend", "") ||
+                previous.value("threads", 0) != current.value("threads", 0) ||
+                previous.value("concurrency", 0) != current.value("concurrency", 0) ||
+                previous.value("chunking", "off") != current.value("chunking", "off") ||
+                !previous.contains("latency_ms") || !current.contains("latency_ms") ||
+                previous.value("failures", 0) != 0) {
+                continue;
+            }
+            double rtf = current["real_time_factor"], previous_rtf = previous["real_time_factor"];
+            double p95 = current["latency_ms"]["p95"], previous_p95 = previous["latency_ms"]["p95"];
+            if (rtf < previous_rtf * (1.0 - factor) || p95 > previous_p95 * (1.0 + factor)) {
+                regressions.push_back({
+                    {"backend", current["backend"]}, {"threads", current["threads"]},
+                    {"concurrency", current["concurrency"]}, {"chunking", current["chunking"]},
+                    {"real_time_factor", {previous_rtf, rtf}}, {"p95_ms", {previous_p95, p95}}
+                });
+            }
+        }
+    }
+    return regressions;
+}
+
+// Chunked configurations against the same backend, threads and concurrency with chunking off
+static void addSpeedups(json& results) {
+    for (json& chunked : results) {
+        if (chunked.value("chunking", "off") == "off" || !chunked.contains("latency_ms")) {
+            continue;
+        }
+        for (const json& whole : results) {
+            if (whole.value("chunking", "off") != "off" || !whole.contains("latency_ms") ||
+                whole["backend"] != chunked["backend"] || whole["threads"] != chunked["threads"] ||
+                whole["concurrency"] != chunked["concurrency"]) {
+                continue;
+            }
+            double rtf = chunked["real_time_factor"], whole_rtf = whole["real_time_factor"];
+            double p50 = chunked["latency_ms"]["p50"], whole_p50 = whole["latency_ms"]["p50"];
+            double first = chunked["first_segment_ms"]["p50"], whole_first = whole["first_segment_ms"]["p50"];
+            chunked["speedup"] = {
+                {"real_time_factor", whole_rtf > 0.0 ? rtf / whole_rtf : 0.0},
+                {"latency_p50", p50 > 0.0 ? whole_p50 / p50 : 0.0},
+                {"first_segment_p50", first > 0.0 ? whole_first / first : 0.0}
+            };
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::string(argv[1]) == "--generate-corpus") {
+        return generateCorpus(argv[2]);
+    }
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " --generate-corpus <dir>\n"
+                  << "       " << argv[0] << " <model.bin> <corpus_dir> [--backends whisper_ai,cli,daemon,pool]"
+                     " [--threads 1,2,4] [--concurrency 1,2,4] [--chunking off,pauses,fixed] [--vad] [--service <path>]"
+                     " [--output <file>] [--baseline <file>] [--tolerance <percent>]" << std::endl;
+        return 1;
+    }
+
+    BenchSettings settings;
+    settings.model_path = argv[1];
+    std::string corpus_dir = argv[2];
+    std::vector<std::string> backends = {"whisper_ai", "cli", "daemon", "pool"};
+    std::vector<int> thread_counts = {1, 2, 4};
+    std::vector<int> concurrency_levels = {1, 2, 4};
+    std::vector<std::string> chunkings = {"off"};
+    std::string output_path;
+    std::string baseline_path;
+    double tolerance = 10.0;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--backends" && has_value) {
+            backends = parseList(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            thread_counts = parseIntList(argv[++i]);
+        } else if (arg == "--concurrency" && has_value) {
+            concurrency_levels = parseIntList(argv[++i]);
+        } else if (arg == "--chunking" && has_value) {
+            chunkings = parseList(argv[++i]);
+        } else if (arg == "--service" && has_value) {
+            settings.service_path = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            output_path = argv[++i];
+        } else if (arg == "--baseline" && has_value) {
+            baseline_path = argv[++i];
+        } else if (arg == "--tolerance" && has_value) {
+            tolerance = std::atof(argv[++i]);
+        } else if (arg == "--vad") {
+            settings.vad = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    for (const std::string& backend : backends) {
+        if (backend != "whisper_ai" && backend != "cli" && backend != "daemon" && backend != "pool") {
+            std::cerr << "Unknown backend: " << backend << std::endl;
+            return 1;
+        }
+    }
+    for (const std::string& chunking : chunkings) {
+        ChunkStrategy strategy;
+        if (!ChunkingOptions::parseStrategy(chunking, strategy)) {
+            std::cerr << "Unknown chunking strategy: " << chunking << std::endl;
+            return 1;
+        }
+    }
+
+    // Absolute paths: the daemon resolves them in its own working directory
+    std::vector<CorpusFile> corpus;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(corpus_dir, ec)) {
+        WavReader reader;
+        if (entry.path().extension() == ".wav" && reader.open(entry.path().string())) {
+            corpus.push_back({std::filesystem::absolute(entry.path()).string(), reader.durationSeconds()});
+        }
+    }
+    std::sort(corpus.begin(), corpus.end(), [](const CorpusFile& a, const CorpusFile& b) { return a.path < b.path; });
+    if (corpus.empty()) {
+        std::cerr << "No readable WAV files in " << corpus_dir << " (try --generate-corpus)" << std::endl;
+        return 1;
+    }
+
+    json results = json::array();
+    for (const std::string& backend : backends) {
+        for (int threads : thread_counts) {
+            for (int concurrency : concurrency_levels) {
+                for (const std::string& chunking : chunkings) {
+                    // Only the in-process states and the worker pool decode windows in parallel
+                    if (chunking != "off" && backend != "whisper_ai" && backend != "pool") {
+                        continue;
+                    }
+                    json result = runIsolated({backend, threads, concurrency, chunking}, settings, corpus);
+                    if (result.contains("error")) {
+                        std::cerr << backend << " threads=" << threads << " concurrency=" << concurrency
+                                  << " chunking=" << chunking << ": " << result["error"].get<std::string>() << std::endl;
+                    } else {
+                        std::fprintf(stderr, "%-10s threads=%d concurrency=%d chunking=%-6s  %6.2fx realtime  p50 %7.0f ms  p95 %7.0f ms  rss %ld MB  %zu failed\n",
+                                     backend.c_str(), threads, concurrency, chunking.c_str(), result["real_time_factor"].get<double>(),
+                                     result["latency_ms"]["p50"].get<double>(), result["latency_ms"]["p95"].get<double>(),
+                                     std::max(result["peak_rss_kb"].get<long>(), result["peak_rss_children_kb"].get<long>()) / 1024,
+                                     result["failures"].get<size_t>());
+                    }
+                    results.push_back(result);
+                }
+            }
+        }
+    }
+    addSpeedups(results);
+    for (const json& result : results) {
+        if (result.contains("speedup")) {
+            std::fprintf(stderr, "%-10s threads=%d concurrency=%d chunking=%-6s  speed-up %.2fx realtime factor, %.2fx p50 latency\n",
+                         result["backend"].get<std::string>().c_str(), result["threads"].get<int>(),
+                         result["concurrency"].get<int>(), result["chunking"].get<std::string>().c_str(),
+                         result["speedup"]["real_time_factor"].get<double>(), result["speedup"]["latency_p50"].get<double>());
+        }
+    }
+
+    json report = {
+        {"model", settings.model_path},
+        {"corpus", corpus_dir},
+        {"files", corpus.size()},
+        {"hardware_concurrency", std::thread::hardware_concurrency()},
+        {"vad", settings.vad},
+        {"results", results}
+    };
+
+    int exit_code = 0;
+    if (!baseline_path.empty()) {
+        std::ifstream baseline_file(baseline_path);
+        json baseline = json::parse(baseline_file, nullptr, false);
+        if (baseline.is_discarded() || !baseline.contains("results")) {
+            std::cerr << "Cannot read baseline " << baseline_path << std::endl;
+            return 1;
+        }
+        report["regressions"] = findRegressions(results, baseline["results"], tolerance);
+        if (!report["regressions"].empty()) {
+            std::cerr << report["regressions"].size() << " configuration(s) regressed by more than "
+                      << tolerance << "%" << std::endl;
+            exit_code = 2;
+        }
+    }
+
+    if (output_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream(output_path) << report.dump(2) << std::endl;
+    }
+    return exit_code;
+}
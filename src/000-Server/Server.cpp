@@ -2,9 +2,25 @@
 
 #include "000-Server/Server.h"
 #include "001-App/App.h"
+#include "000-Server/TranscriptionStatsResource.h"
+#include "999-ExternalServices/TranscriptionCache.h"
+#include "999-ExternalServices/ThreadBudget.h"
+#include "999-ExternalServices/WhisperCliService.h"
+#include "999-ExternalServices/WhisperDaemonClient.h"
+#include "999-ExternalServices/WhisperDaemonProtocol.h"
+#include "999-ExternalServices/WhisperModelFile.h"
+#include "999-ExternalServices/WhisperWorkerPool.h"
+#include "999-ExternalServices/TranscriptionScheduler.h"
+#include "999-ExternalServices/AudioChunker.h"
+#include "999-ExternalServices/SyntheticTranscriptionBackend.h"
 #include <Wt/WSslInfo.h>
+#include <tinyxml2.h>
 #include <csignal>
 #include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
+#include <filesystem>
 
 #include <Wt/Auth/AuthService.h>
 #include <Wt/Auth/HashFunction.h>
@@ -34,6 +50,23 @@ Server::Server(int argc, char **argv)
     // Each VoiceRecorder instance will call the service as needed
     std::cout << "Server configured - Whisper transcription will use external service" << std::endl;
     
+    // Transcripts of recordings already seen survive restarts, outside the docroot so Wt never serves them
+    TranscriptionCache::getInstance().setDiskDirectory(transcriptionCacheDirectory());
+    
+    // Inference gets the cores Wt's worker pool does not need
+    ThreadBudget::getInstance().reserveForWt(configuredWtThreads());
+    
+    // Pipeline counters as JSON, for tooling on the same machine only
+    std::string stats_access = "off";
+    readConfigurationProperty("transcription-stats", stats_access);
+    if (stats_access == "localhost") {
+        addResource(std::make_shared<TranscriptionStatsResource>(), "/stats/transcription");
+    } else if (stats_access != "off") {
+        std::cerr << "Unknown transcription-stats \"" << stats_access << "\", not serving /stats/transcription" << std::endl;
+    }
+    
+    preloadWhisperModel();
+    
     // std::cout << "Application arguments:" << std::endl;
     // for (int i = 0; i < argc; ++i) {
     //     std::cout << "argv[" << i << "]: " << argv[i] << std::endl;
@@ -115,6 +148,7 @@ int Server::run()
             
             std::cerr << "Shutdown (signal = " << sig << ")" << std::endl;
             stop();
+            WhisperWorkerPool::getInstance().stop();
 
             if (sig == SIGHUP)
                 restart(argc_, argv_, environ);
@@ -129,6 +163,201 @@ int Server::run()
     return 0;
 }
 
+std::string Server::configurationFile() const
+{
+    // The file setServerConfiguration() handed to Wt: -c / --config, else the built-in path
+    for (int i = 1; i < argc_; ++i) {
+        std::string arg = argv_[i];
+        if ((arg == "-c" || arg == "--config") && i + 1 < argc_) {
+            return argv_[i + 1];
+        }
+        if (arg.rfind("--config=", 0) == 0) {
+            return arg.substr(9);
+        }
+    }
+    return WTHTTP_CONFIGURATION;
+}
+
+int Server::configuredWtThreads() const
+{
+    // Wt's own default when wt_config.xml does not say
+    int threads = 10;
+    tinyxml2::XMLDocument config;
+    if (config.LoadFile(configurationFile().c_str()) != tinyxml2::XML_SUCCESS) {
+        return threads;
+    }
+    tinyxml2::XMLElement* settings = config.FirstChildElement("server");
+    settings = settings ? settings->FirstChildElement("application-settings") : nullptr;
+    tinyxml2::XMLElement* num_threads = settings ? settings->FirstChildElement("num-threads") : nullptr;
+    if (num_threads) {
+        num_threads->QueryIntText(&threads);
+    }
+    return threads;
+}
+
+std::string Server::transcriptionCacheDirectory()
+{
+    // A relative setting is taken from the app root (the working directory unless --approot says otherwise)
+    std::string setting = "transcription-cache";
+    readConfigurationProperty("transcription-cache-dir", setting);
+    std::string directory = (std::filesystem::path(appRoot()) / setting).string();
+
+    // Every file below the docroot can be downloaded
+    std::error_code ec;
+    std::filesystem::path cache = std::filesystem::weakly_canonical(directory, ec);
+    std::filesystem::path doc_root = std::filesystem::weakly_canonical(docRoot(), ec);
+    if (!ec && std::mismatch(doc_root.begin(), doc_root.end(), cache.begin(), cache.end()).first == doc_root.end()) {
+        std::cerr << "Warning: transcription cache " << cache << " is inside the docroot, "
+                  << "point transcription-cache-dir elsewhere" << std::endl;
+    }
+    return directory;
+}
+
+void Server::preloadWhisperModel()
+{
+    std::string executable_path = WhisperCliService::defaultExecutablePath();
+    std::string model_path = WhisperCliService::defaultModelPath();
+    readConfigurationProperty("whisper-service", executable_path);
+    readConfigurationProperty("whisper-model", model_path);
+    WhisperCliService::setDefaultPaths(executable_path, model_path);
+    configureChunking();
+    if (configureTranscriptionBackend()) {
+        return;
+    }
+
+    // A missing or truncated model is reported now instead of on the first transcription
+    auto start = std::chrono::steady_clock::now();
+    WhisperModelFile model_file;
+    if (!model_file.open(model_path)) {
+        std::cerr << "Whisper model check failed: " << model_file.getLastError() << std::endl;
+        return;
+    }
+    // Pull the file into the page cache; the daemon and any later worker map the same pages
+    model_file.prefetch();
+
+    if (startWhisperWorkers(executable_path, model_path)) {
+        return;
+    }
+
+    // Spawning the daemon loads the model once for every session
+    WhisperDaemonClient daemon(WhisperDaemonProtocol::defaultSocketPath(), executable_path, model_path);
+    json response;
+    std::string error;
+    if (!daemon.request(json{{"op", "ping"}}, response, error)) {
+        std::cerr << "Whisper daemon did not start: " << error
+                  << " (transcriptions fall back to " << executable_path << " per clip)" << std::endl;
+        return;
+    }
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    json init = response.value("initialization", json::object());
+    std::cout << "Whisper model ready in " << elapsed_ms << " ms: " << model_path
+              << " (" << model_file.size() / (1024 * 1024) << " MiB, "
+              << model_file.residentBytes() / (1024 * 1024) << " MiB in page cache, daemon load "
+              << init.value("load_ms", 0) << " ms, daemon RSS "
+              << init.value("rss_kb", 0) / 1024 << " MiB)" << std::endl;
+}
+
+void Server::configureChunking()
+{
+    // whisper-chunking: "pauses" (cut long recordings in VAD pauses), "fixed" or "off"
+    ChunkingOptions options = AudioChunker::defaultOptions();
+    std::string strategy = ChunkingOptions::strategyName(options.strategy);
+    std::string window_seconds = std::to_string(static_cast<int>(options.window_seconds));
+    readConfigurationProperty("whisper-chunking", strategy);
+    readConfigurationProperty("whisper-chunk-seconds", window_seconds);
+
+    if (!ChunkingOptions::parseStrategy(strategy, options.strategy)) {
+        std::cerr << "Unknown whisper-chunking \"" << strategy << "\", using "
+                  << ChunkingOptions::strategyName(options.strategy) << std::endl;
+    }
+    // Longer than one encoder window only costs a second encoder pass per window
+    double seconds = std::atof(window_seconds.c_str());
+    if (seconds >= 2.0 * options.overlap_seconds + 5.0 && seconds <= 30.0) {
+        options.window_seconds = seconds;
+    }
+    AudioChunker::setDefaultOptions(options);
+    std::cout << "Long recordings: " << options.cacheTag() << std::endl;
+}
+
+// whisper-workers: a count, "auto" (one per THREADS_PER_POOL_WORKER transcription cores) or 0 for the single daemon
+static int whisperWorkerCount(const std::string& workers_setting)
+{
+    static constexpr int THREADS_PER_POOL_WORKER = 4;
+    if (workers_setting == "auto") {
+        ThreadBudgetStats budget = ThreadBudget::getInstance().getStats();
+        return std::max(1, (budget.total_cores - budget.reserved_cores) / THREADS_PER_POOL_WORKER);
+    }
+    return std::atoi(workers_setting.c_str());
+}
+
+bool Server::configureTranscriptionBackend()
+{
+    // whisper-backend: "whisper_service" (daemon, worker pool or CLI) or "synthetic" for load tests without a model
+    std::string backend = "whisper_service";
+    readConfigurationProperty("whisper-backend", backend);
+    if (backend != "synthetic") {
+        if (backend != "whisper_service") {
+            std::cerr << "Unknown whisper-backend \"" << backend << "\", using whisper_service" << std::endl;
+        }
+        return false;
+    }
+
+    SyntheticBackendOptions options;
+    std::string spec;
+    std::string error;
+    readConfigurationProperty("whisper-synthetic", spec);
+    if (!SyntheticBackendOptions::parse(spec, options, error)) {
+        std::cerr << "Invalid whisper-synthetic: " << error << ", using " << options.describe() << std::endl;
+    }
+    WhisperCliService::setDefaultBackend(std::make_shared<SyntheticTranscriptionBackend>(options));
+
+    // As many scheduler slots as the worker pool would have had, so queueing behaves the same
+    std::string workers_setting = "1";
+    readConfigurationProperty("whisper-workers", workers_setting);
+    size_t workers = static_cast<size_t>(std::max(1, whisperWorkerCount(workers_setting)));
+    TranscriptionScheduler::getInstance().configure(workers, TranscriptionScheduler::DEFAULT_MAX_QUEUED,
+                                                    TranscriptionScheduler::DEFAULT_MAX_QUEUED_PER_SESSION);
+    std::cout << "Transcriptions use the synthetic backend on " << workers << " scheduler worker(s): "
+              << options.describe() << std::endl;
+    return true;
+}
+
+bool Server::startWhisperWorkers(const std::string& executable_path, const std::string& model_path)
+{
+    std::string workers_setting = "0";
+    std::string max_rss_setting = "0";
+    readConfigurationProperty("whisper-workers", workers_setting);
+    readConfigurationProperty("whisper-workers-max-rss-mb", max_rss_setting);
+
+    int workers = whisperWorkerCount(workers_setting);
+    if (workers <= 0) {
+        return false;
+    }
+
+    WhisperWorkerPoolOptions options;
+    options.workers = static_cast<size_t>(workers);
+    options.max_total_rss_mb = static_cast<size_t>(std::max(0, std::atoi(max_rss_setting.c_str())));
+    WhisperWorkerPool& pool = WhisperWorkerPool::getInstance();
+    if (!pool.start(executable_path, model_path, options)) {
+        std::cerr << "Whisper worker pool did not start, using the shared daemon" << std::endl;
+        return false;
+    }
+    // One scheduler slot per worker; ThreadBudget splits the cores between them
+    TranscriptionScheduler::getInstance().configure(options.workers, TranscriptionScheduler::DEFAULT_MAX_QUEUED,
+                                                    TranscriptionScheduler::DEFAULT_MAX_QUEUED_PER_SESSION);
+
+    auto start = std::chrono::steady_clock::now();
+    bool ready = pool.waitUntilReady(options.startup_timeout_ms);
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Whisper worker pool: " << options.workers << " worker(s), "
+              << (ready ? "first ready in " + std::to_string(elapsed_ms) + " ms" : std::string("none ready yet"))
+              << std::endl;
+    return true;
+}
+
 void Server::configureAuth()
 {
     authService.setAuthTokensEnabled(true, "logincookie");
@@ -17,4 +17,18 @@ class Server : public Wt::WServer
         char **argv_;
 
         void configureAuth();
+        // wt_config.xml the server was started with
+        std::string configurationFile() const;
+        // num-threads of the Wt worker pool from that file
+        int configuredWtThreads() const;
+        // transcription-cache-dir from wt_config.xml, by default transcription-cache/ in the app root
+        std::string transcriptionCacheDirectory();
+        // Check the whisper model and start the daemon with it before the first recording
+        void preloadWhisperModel();
+        // Start WhisperWorkerPool when wt_config.xml asks for workers; false keeps the single daemon
+        bool startWhisperWorkers(const std::string& executable_path, const std::string& model_path);
+        // AudioChunker defaults from wt_config.xml (whisper-chunking, whisper-chunk-seconds)
+        void configureChunking();
+        // whisper-backend from wt_config.xml; true if transcriptions go to a synthetic backend, so no model is needed
+        bool configureTranscriptionBackend();
 };
\ No newline at end of file
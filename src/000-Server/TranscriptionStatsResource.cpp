@@ -0,0 +1,159 @@
+#include "000-Server/TranscriptionStatsResource.h"
+#include "999-ExternalServices/ThreadBudget.h"
+#include "999-ExternalServices/TranscriptionScheduler.h"
+#include "999-ExternalServices/TranscriptionCache.h"
+#include "999-ExternalServices/CancellationToken.h"
+#include "999-ExternalServices/BackgroundExecutor.h"
+#include "999-ExternalServices/RecordingStorage.h"
+#include "999-ExternalServices/WhisperWorkerPool.h"
+#include "999-ExternalServices/AudioChunker.h"
+#include "999-ExternalServices/WhisperCliService.h"
+#include "999-ExternalServices/SyntheticTranscriptionBackend.h"
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+TranscriptionStatsResource::TranscriptionStatsResource()
+    : Wt::WResource()
+{
+}
+
+TranscriptionStatsResource::~TranscriptionStatsResource()
+{
+    beingDeleted();
+}
+
+// Only loopback clients; through a reverse proxy this relies on Wt's trusted-proxy settings
+static bool isLocalClient(const std::string& address)
+{
+    return address.rfind("127.", 0) == 0 || address == "::1" || address.rfind("::ffff:127.", 0) == 0;
+}
+
+void TranscriptionStatsResource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    if (!isLocalClient(request.clientAddress())) {
+        response.setStatus(403);
+        return;
+    }
+    
+    ThreadBudgetStats threads = ThreadBudget::getInstance().getStats();
+    TranscriptionSchedulerStats scheduler = TranscriptionScheduler::getInstance().getStats();
+    TranscriptionCacheStats cache = TranscriptionCache::getInstance().getStats();
+    CancellationStats cancellation = CancellationToken::getStats();
+    BackgroundExecutorStats executor = BackgroundExecutor::getInstance().getStats();
+    BackgroundExecutorStats io_executor = BackgroundExecutor::getIoInstance().getStats();
+    RecordingStorageStats storage = RecordingStorage::getStats();
+    WhisperWorkerPoolStats pool = WhisperWorkerPool::getInstance().getStats();
+    ChunkingStats chunking = AudioChunker::getStats();
+    std::shared_ptr<TranscriptionBackend> backend = WhisperCliService::defaultBackend();
+
+    json stats;
+    stats["thread_budget"] = {
+        {"total_cores", threads.total_cores},
+        {"reserved_cores", threads.reserved_cores},
+        {"max_threads_per_job", threads.max_threads_per_job},
+        {"active_jobs", threads.active_jobs},
+        {"allocated_threads", threads.allocated_threads},
+        {"last_grant", threads.last_grant},
+        {"grants", threads.grants},
+        {"oversubscribed_grants", threads.oversubscribed_grants}
+    };
+    stats["executor"] = {
+        {"threads", executor.threads},
+        {"queued", executor.queued},
+        {"running", executor.running},
+        {"completed", executor.completed},
+        {"rejected", executor.rejected},
+        {"failed", executor.failed}
+    };
+    stats["io_executor"] = {
+        {"threads", io_executor.threads},
+        {"queued", io_executor.queued},
+        {"running", io_executor.running},
+        {"completed", io_executor.completed},
+        {"rejected", io_executor.rejected},
+        {"failed", io_executor.failed}
+    };
+    stats["storage"] = {
+        {"renamed", storage.renamed},
+        {"copied", storage.copied},
+        {"sendfile_fallbacks", storage.sendfile_fallbacks},
+        {"read_write_fallbacks", storage.read_write_fallbacks},
+        {"failed", storage.failed},
+        {"bytes_copied", storage.bytes_copied},
+        {"copy_ms_total", storage.copy_ms_total}
+    };
+    stats["worker_pool"] = {
+        {"running", pool.running},
+        {"workers", pool.workers},
+        {"idle", pool.idle},
+        {"busy", pool.busy},
+        {"starting", pool.starting},
+        {"stopped", pool.stopped},
+        {"rss_held_back", pool.rss_held_back},
+        {"total_rss_kb", pool.total_rss_kb},
+        {"max_total_rss_kb", pool.max_total_rss_kb},
+        {"jobs_completed", pool.jobs_completed},
+        {"jobs_failed", pool.jobs_failed},
+        {"spawned", pool.spawned},
+        {"crashes", pool.crashes},
+        {"heartbeat_failures", pool.heartbeat_failures},
+        {"rss_recycles", pool.rss_recycles},
+        {"cancel_kills", pool.cancel_kills}
+    };
+    stats["chunking"] = {
+        {"strategy", ChunkingOptions::strategyName(AudioChunker::defaultOptions().strategy)},
+        {"recordings", chunking.recordings},
+        {"windows", chunking.windows},
+        {"pause_cuts", chunking.pause_cuts},
+        {"forced_cuts", chunking.forced_cuts},
+        {"deduplicated_words", chunking.deduplicated_words}
+    };
+    stats["backend"] = {
+        {"name", backend ? backend->backendName() : std::string("whisper_service")}
+    };
+    if (auto synthetic = std::dynamic_pointer_cast<SyntheticTranscriptionBackend>(backend)) {
+        SyntheticBackendStats simulated = synthetic->getStats();
+        stats["backend"]["options"] = synthetic->options().describe();
+        stats["backend"]["requests"] = simulated.requests;
+        stats["backend"]["failures"] = simulated.failures;
+        stats["backend"]["cancelled"] = simulated.cancelled;
+        stats["backend"]["in_flight"] = simulated.in_flight;
+        stats["backend"]["peak_in_flight"] = simulated.peak_in_flight;
+        stats["backend"]["simulated_ms"] = simulated.simulated_ms;
+        stats["backend"]["burned_cpu_ms"] = simulated.burned_cpu_ms;
+    }
+    stats["scheduler"] = {
+        {"queued", scheduler.queued},
+        {"running", scheduler.running},
+        {"completed", scheduler.completed},
+        {"rejected", scheduler.rejected},
+        {"cancelled", scheduler.cancelled},
+        {"aborted", scheduler.aborted},
+        {"cpu_ms_per_audio_second", scheduler.cpu_ms_per_audio_second}
+    };
+    stats["cache"] = {
+        {"memory_hits", cache.memory_hits},
+        {"disk_hits", cache.disk_hits},
+        {"misses", cache.misses},
+        {"coalesced", cache.coalesced},
+        {"abandoned", cache.abandoned},
+        {"evictions", cache.evictions},
+        {"memory_entries", cache.memory_entries},
+        {"memory_bytes", cache.memory_bytes},
+        {"disk_entries", cache.disk_entries},
+        {"disk_bytes", cache.disk_bytes}
+    };
+    stats["cancellation"] = {
+        {"dropped_queued", cancellation.dropped_queued},
+        {"aborted_running", cancellation.aborted_running},
+        {"saved_audio_seconds", cancellation.saved_audio_seconds},
+        {"saved_cpu_ms", cancellation.saved_cpu_ms}
+    };
+
+    response.setMimeType("application/json");
+    response.addHeader("Cache-Control", "no-store");
+    response.out() << stats.dump();
+}
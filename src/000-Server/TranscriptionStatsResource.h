@@ -0,0 +1,19 @@
+#pragma once
+#include <Wt/WResource.h>
+
+/*
+ * Read-only JSON snapshot of the transcription pipeline, served at /stats/transcription:
+ * the ThreadBudget split, TranscriptionScheduler queue, TranscriptionCache hit counts
+ * and the work CancellationToken saved. Meant for tuning and dashboards; it only
+ * exposes counters, no file names or transcripts. Mounted only when wt_config.xml sets
+ * transcription-stats to localhost, and answers loopback clients only.
+ */
+class TranscriptionStatsResource : public Wt::WResource
+{
+public:
+    TranscriptionStatsResource();
+    ~TranscriptionStatsResource() override;
+
+protected:
+    void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+};
@@ -1,5 +1,14 @@
 #include "WhisperAi.h"
 #include "whisper.h"
+#include "999-ExternalServices/Audio/VoiceActivityDetector.h"
+#include "999-ExternalServices/Audio/WavReader.h"
+#include "999-ExternalServices/Audio/Resampler.h"
+#include "999-ExternalServices/TranscriptionCache.h"
+#include "999-ExternalServices/CancellationToken.h"
+#include "999-ExternalServices/DecodeProfile.h"
+#include "999-ExternalServices/AudioChunker.h"
+#include "999-ExternalServices/ThreadBudget.h"
+#include "999-ExternalServices/WhisperModelFile.h"
 #include <iostream>
 #include <fstream>
 #include <cstdio>
@@ -13,6 +22,7 @@
 #include <future>
 #include <queue>
 #include <atomic>
+#include <filesystem>
 
 // Helper function to get current timestamp
 std::string getCurrentTimestamp() {
@@ -27,6 +37,71 @@ std::string getCurrentTimestamp() {
     return ss.str();
 }
 
+// A task's failure goes back with its own result, not through the shared last_error_
+static std::string taskError(const std::string& error) {
+    std::cerr << "WhisperAi Error: " << error << std::endl;
+    return "ERROR: " + error;
+}
+
+static bool isTaskError(const std::string& result) {
+    return result.rfind("ERROR:", 0) == 0;
+}
+
+// n_threads of the calling worker's last inference, for recordTaskCost()
+static thread_local int last_inference_threads = 1;
+
+// whisper abort_callback / encoder_begin_callback: stop inference once the task's token is cancelled
+static bool abortRequested(void* user_data) {
+    return static_cast<const CancellationToken*>(user_data)->isCancelled();
+}
+
+static bool encoderMayBegin(struct whisper_context*, struct whisper_state*, void* user_data) {
+    return !abortRequested(user_data);
+}
+
+// whisper new_segment_callback / progress_callback: hand the task's listener what was just decoded
+static void newSegmentDecoded(struct whisper_context*, struct whisper_state* state, int n_new, void* user_data) {
+    const TranscriptListener& listener = *static_cast<const TranscriptListener*>(user_data);
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = std::max(0, n_segments - n_new); i < n_segments; ++i) {
+        const char* text = whisper_full_get_segment_text_from_state(state, i);
+        if (text) {
+            TranscriptSegment segment;
+            segment.text = text;
+            segment.start_seconds = whisper_full_get_segment_t0_from_state(state, i) * 0.01;
+            segment.end_seconds = whisper_full_get_segment_t1_from_state(state, i) * 0.01;
+            listener.on_segment(segment);
+        }
+    }
+}
+
+static void decodeProgress(struct whisper_context*, struct whisper_state*, int progress, void* user_data) {
+    static_cast<const TranscriptListener*>(user_data)->on_progress(progress);
+}
+
+struct WhisperAi::ChunkJob {
+    const std::vector<float>& audio;        // The parent task's, which waits for every window
+    std::string model;                      // Helpers lease a state of the parent's model
+    std::vector<AudioWindow> windows;
+    std::shared_ptr<CancellationToken> cancel_token;
+    TranscriptStitcher stitcher;
+    std::atomic<size_t> next_window{0};
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    size_t finished = 0;
+    std::string error;                      // First window that failed, under mutex
+    
+    ChunkJob(const std::vector<float>& samples, const std::string& model_name, std::vector<AudioWindow> planned,
+             std::shared_ptr<CancellationToken> token, const TranscriptListener& listener)
+        : audio(samples), model(model_name), windows(std::move(planned)), cancel_token(std::move(token)),
+          stitcher(windows, 16000, listener) {}
+    
+    // Nothing left for a helper that starts now
+    bool exhausted() const {
+        return next_window >= windows.size() || (cancel_token && cancel_token->isCancelled());
+    }
+};
+
 // Singleton implementation
 WhisperAi& WhisperAi::getInstance() {
     static WhisperAi instance;
@@ -34,30 +109,31 @@ WhisperAi& WhisperAi::getInstance() {
 }
 
 WhisperAi::WhisperAi() 
-    : context_(nullptr), shutdown_(false), worker_running_(false) {
+    : initialized_(false), pool_size_(0), threads_per_state_(1), shutdown_(false), worker_running_(false), busy_workers_(0), vad_enabled_(true), cpu_ms_per_audio_second_(0.0) {
     std::cout << getCurrentTimestamp() << "WhisperAi singleton instance created" << std::endl;
 }
 
 WhisperAi::~WhisperAi() {
     std::cout << getCurrentTimestamp() << "WhisperAi singleton destructor called" << std::endl;
     
-    // Stop worker thread first
-    stopWorkerThread();
+    // Stop worker threads first: every lease is back once they are joined
+    stopWorkerThreads();
     
-    // Clean up context
+    // The registry frees the states and contexts of every loaded model when it goes
+    models_.stop();
     std::lock_guard<std::mutex> lock(context_mutex_);
-    if (context_) {
-        whisper_free(context_);
-        context_ = nullptr;
-        std::cout << getCurrentTimestamp() << "WhisperAi singleton destroyed and context freed" << std::endl;
+    if (initialized_) {
+        initialized_ = false;
+        std::cout << getCurrentTimestamp() << "WhisperAi singleton destroyed, " << models_.residentBytes() / (1024 * 1024)
+                  << " MB of models to free" << std::endl;
     }
 }
 
-bool WhisperAi::initialize() {
+bool WhisperAi::initialize(size_t pool_size, int threads_per_state, const std::string& model_override) {
     std::lock_guard<std::mutex> lock(context_mutex_);
     
     // Check if already initialized
-    if (context_ != nullptr) {
+    if (initialized_) {
         std::cout << getCurrentTimestamp() << "Whisper already initialized (singleton), reusing existing context" << std::endl;
         return true;
     }
@@ -65,76 +141,115 @@ bool WhisperAi::initialize() {
     std::cout << getCurrentTimestamp() << "Initializing Whisper singleton..." << std::endl;
     
 
-    std::string model_path;
-    std::string full_path = "/apps/cv/models/ggml-base.en.bin";
-    if (std::ifstream(full_path).good()) {
-        model_path = full_path;
-        std::cout << getCurrentTimestamp() << "Found Whisper model: " << full_path << std::endl;
-    }
-    
-    if (model_path.empty()) {
-        setError("Model file ggml-base.en.bin not found in any models/ directory. "
-                 "Please download from https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-base.en.bin");
+    std::string model_path = model_override.empty() ? WhisperModelFile::DEFAULT_PATH : model_override;
+    std::string error;
+    if (!models_.registerModel(DEFAULT_MODEL, model_path, true, error)) {
+        if (model_override.empty() && !std::filesystem::exists(model_path)) {
+            setError("Model file ggml-base.en.bin not found in any models/ directory. "
+                     "Please download from https://huggingface.co/ggerganov/whisper.cpp/resolve/main/ggml-base.en.bin");
+        } else {
+            setError(error);
+        }
         return false;
     }
+    std::cout << getCurrentTimestamp() << "Found Whisper model: " << model_path << std::endl;
 
-    // Initialize whisper context with optimized parameters
-    struct whisper_context_params cparams = whisper_context_default_params();
-    cparams.use_gpu = false; // Disable GPU for stability and consistency
-    
-    context_ = whisper_init_from_file_with_params(model_path.c_str(), cparams);
+    int hardware_threads = std::max(1, (int)std::thread::hardware_concurrency());
+    if (pool_size == 0) {
+        pool_size = std::max(1, hardware_threads / 4);
+    }
     
-    if (!context_) {
-        setError("Failed to initialize whisper context from model: " + model_path);
+    // The default model is pinned: loaded now with a state per worker, and never unloaded
+    if (!models_.preload(DEFAULT_MODEL, pool_size, error)) {
+        setError(error);
         return false;
     }
+    for (const WhisperModelStats& model : models_.getStats()) {
+        if (model.name == DEFAULT_MODEL) {
+            std::cout << getCurrentTimestamp() << "Loaded " << model.weights_bytes << " byte model in "
+                      << static_cast<long>(model.last_load_ms) << " ms through mmap, " << model.states
+                      << " state(s)" << std::endl;
+        }
+    }
+    pool_size_ = pool_size;
+    
+    // 0: each inference asks ThreadBudget for a share of the cores running jobs leave free
+    threads_per_state_ = std::max(0, threads_per_state);
+    initialized_ = true;
     
     std::cout << getCurrentTimestamp() << "Whisper singleton initialized successfully with model: " << model_path << std::endl;
-    std::cout << getCurrentTimestamp() << "Available threads: " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << getCurrentTimestamp() << "Available threads: " << hardware_threads 
+              << ", worker pool: " << pool_size_ << " x "
+              << (threads_per_state_ > 0 ? std::to_string(threads_per_state_) : std::string("budgeted")) << " thread(s)" << std::endl;
+    
+    // Filter banks for 44.1k/48k/22.05k/8k uploads
+    Resampler::prewarm();
     
-    // Start the worker thread
-    startWorkerThread();
+    // Workers lease states as tasks need them; idle models are unloaded in the background
+    startWorkerThreads();
+    models_.start();
     
     return true;
 }
 
-std::string WhisperAi::transcribeFile(const std::string& audio_file_path) {
-    std::lock_guard<std::mutex> lock(context_mutex_);
-    
-    if (context_ == nullptr) {
-        setError("Whisper not initialized");
-        return "";
+bool WhisperAi::registerModel(const std::string& name, const std::string& model_path) {
+    std::string error;
+    if (!models_.registerModel(name, model_path, name == DEFAULT_MODEL, error)) {
+        setError(error);
+        return false;
     }
-    
-    // Browser now provides WAV files in the correct format (16kHz, mono, 16-bit PCM)
-    std::cout << getCurrentTimestamp() << "Loading audio file: " << audio_file_path << std::endl;
-    
-    // Load audio data directly
-    std::vector<float> audio_data;
-    if (!loadAudioFile(audio_file_path, audio_data)) {
-        return "";
+    return true;
+}
+
+void WhisperAi::setModelCacheOptions(const WhisperModelRegistryOptions& options) {
+    models_.configure(options);
+}
+
+std::vector<WhisperModelStats> WhisperAi::getModelStats() const {
+    return models_.getStats();
+}
+
+std::string WhisperAi::transcribeFile(const std::string& audio_file_path, const std::string& model) {
+    if (!isInitialized()) {
+        return taskError("Whisper not initialized");
     }
     
-    // Call internal method that doesn't acquire mutex
-    return transcribeAudioDataInternal(audio_data);
+    // States are leased by the workers, so synchronous calls go through the same queue
+    return transcribeFileAsync(audio_file_path, nullptr, TranscriptListener(), model).get();
 }
 
-std::string WhisperAi::transcribeAudioData(const std::vector<float>& audio_data) {
-    std::lock_guard<std::mutex> lock(context_mutex_);
-    return transcribeAudioDataInternal(audio_data);
+std::string WhisperAi::transcribeAudioData(const std::vector<float>& audio_data, const std::string& model) {
+    if (!isInitialized()) {
+        return taskError("Whisper not initialized");
+    }
+    
+    return transcribeAudioDataAsync(audio_data, nullptr, TranscriptListener(), model).get();
 }
 
-std::string WhisperAi::transcribeAudioDataInternal(const std::vector<float>& audio_data) {
-    // Assumes mutex is already locked by caller
-    if (context_ == nullptr) {
-        setError("Whisper not initialized");
-        return "";
+std::string WhisperAi::transcribeAudioDataInternal(const WhisperModelRegistry::Lease& model, const std::vector<float>& original_audio,
+                                                   const CancellationToken* cancel_token,
+                                                   const TranscriptListener& task_listener,
+                                                   std::vector<TranscriptSegment>* segments) {
+    // state is leased by the calling worker, the shared context is only read
+    whisper_context* context = model.context();
+    whisper_state* state = model.state();
+    if (context == nullptr || state == nullptr) {
+        return taskError("Whisper not initialized");
     }
     
-    if (audio_data.empty()) {
-        setError("Audio data is empty");
-        return "";
+    if (original_audio.empty()) {
+        return taskError("Audio data is empty");
+    }
+    
+    // Drop leading/trailing silence and long pauses; only live segments need their times mapped back
+    const bool use_vad = vad_enabled_;
+    VadResult vad;
+    if (use_vad) {
+        vad = VoiceActivityDetector().process(original_audio);
+        std::cout << getCurrentTimestamp() << "VAD dropped " << vad.dropped_samples << " of "
+                  << original_audio.size() << " samples" << std::endl;
     }
+    const std::vector<float>& audio_data = use_vad ? vad.samples : original_audio;
     
     // Set up whisper parameters with performance optimizations
     std::cout << getCurrentTimestamp() << "Starting transcription of " << audio_data.size() << " audio samples" << std::endl;
@@ -152,7 +267,12 @@ std::string WhisperAi::transcribeAudioDataInternal(const std::vector<float>& aud
     wparams.duration_ms      = 0;
     
     // Key performance settings
-    wparams.n_threads        = std::min(4, (int)std::thread::hardware_concurrency());
+    ThreadLease lease;
+    if (threads_per_state_ == 0) {
+        lease = ThreadBudget::getInstance().acquire();
+    }
+    wparams.n_threads        = threads_per_state_ > 0 ? threads_per_state_ : lease.threads();
+    last_inference_threads   = wparams.n_threads;
     wparams.speed_up         = false;  // Disable speed up for better accuracy
     wparams.temperature      = 0.0f;   // Deterministic output
     wparams.temperature_inc  = 0.0f;
@@ -163,22 +283,72 @@ std::string WhisperAi::transcribeAudioDataInternal(const std::vector<float>& aud
     // Set language to English (en) for ggml-base.en.bin model
     wparams.language = "en";
     
+    // Short clips only need the encoder context they actually fill
+    DecodeProfile profile = DecodeProfile::forAudio(audio_data.size() / 16000.0);
+    profile.apply(wparams);
+    if (profile.short_clip) {
+        std::cout << getCurrentTimestamp() << "Short clip profile, audio_ctx " << profile.audio_ctx << std::endl;
+    }
+    
+    // Let a cancelled task stop between graph nodes instead of running to the end
+    if (cancel_token) {
+        wparams.abort_callback = abortRequested;
+        wparams.abort_callback_user_data = const_cast<CancellationToken*>(cancel_token);
+        wparams.encoder_begin_callback = encoderMayBegin;
+        wparams.encoder_begin_callback_user_data = const_cast<CancellationToken*>(cancel_token);
+    }
+    
+    // Segments as they are decoded, timed against the audio before VAD
+    TranscriptListener listener;
+    if (task_listener.on_segment) {
+        listener.on_segment = [&task_listener, &vad, use_vad](const TranscriptSegment& segment) {
+            TranscriptSegment mapped = segment;
+            if (use_vad) {
+                mapped.start_seconds = vad.time_map.toOriginalSeconds(segment.start_seconds, 16000);
+                mapped.end_seconds = vad.time_map.toOriginalSeconds(segment.end_seconds, 16000);
+            }
+            task_listener.on_segment(mapped);
+        };
+        wparams.new_segment_callback = newSegmentDecoded;
+        wparams.new_segment_callback_user_data = &listener;
+    }
+    if (task_listener.on_progress) {
+        listener.on_progress = task_listener.on_progress;
+        wparams.progress_callback = decodeProgress;
+        wparams.progress_callback_user_data = &listener;
+    }
+    
     // Run inference
-    int result = whisper_full(context_, wparams, audio_data.data(), audio_data.size());
+    int result = whisper_full_with_state(context, state, wparams, audio_data.data(), audio_data.size());
+    
+    if (cancel_token && cancel_token->isCancelled()) {
+        std::cout << getCurrentTimestamp() << "Transcription aborted, result no longer wanted" << std::endl;
+        return "ERROR: Cancelled";
+    }
     
     if (result != 0) {
-        setError("Whisper transcription failed with error code: " + std::to_string(result));
-        return "";
+        return taskError("Whisper transcription failed with error code: " + std::to_string(result));
     }
     
     // Extract transcribed text
     std::string transcription;
-    const int n_segments = whisper_full_n_segments(context_);
+    const int n_segments = whisper_full_n_segments_from_state(state);
     
     for (int i = 0; i < n_segments; ++i) {
-        const char* text = whisper_full_get_segment_text(context_, i);
+        const char* text = whisper_full_get_segment_text_from_state(state, i);
         if (text) {
             transcription += text;
+            if (segments) {
+                TranscriptSegment segment;
+                segment.text = text;
+                segment.start_seconds = whisper_full_get_segment_t0_from_state(state, i) * 0.01;
+                segment.end_seconds = whisper_full_get_segment_t1_from_state(state, i) * 0.01;
+                if (use_vad) {
+                    segment.start_seconds = vad.time_map.toOriginalSeconds(segment.start_seconds, 16000);
+                    segment.end_seconds = vad.time_map.toOriginalSeconds(segment.end_seconds, 16000);
+                }
+                segments->push_back(std::move(segment));
+            }
         }
     }
     
@@ -195,92 +365,47 @@ std::string WhisperAi::transcribeAudioDataInternal(const std::vector<float>& aud
     return transcription;
 }
 
-bool WhisperAi::loadAudioFile(const std::string& file_path, std::vector<float>& audio_data) {
-    std::ifstream file(file_path, std::ios::binary);
-    if (!file.is_open()) {
-        setError("Cannot open audio file: " + file_path);
-        return false;
-    }
-    
-    // Read WAV header (more robust implementation)
-    char header[44];
-    file.read(header, 44);
-    
-    if (std::string(header, 4) != "RIFF" || std::string(header + 8, 4) != "WAVE") {
-        setError("Invalid WAV file format: " + file_path);
-        return false;
+std::string WhisperAi::cacheKey(const std::string& audio_file_path, const std::string& model) const {
+    std::string model_id = models_.modelId(model);
+    WavReader reader;
+    if (model_id.empty() || !reader.open(audio_file_path)) {
+        return ""; // The worker reports unreadable files and unknown models
     }
     
-    // Extract key parameters from WAV header
-    uint32_t sample_rate = *reinterpret_cast<uint32_t*>(header + 24);
-    uint16_t channels = *reinterpret_cast<uint16_t*>(header + 22);
-    uint16_t bits_per_sample = *reinterpret_cast<uint16_t*>(header + 34);
-    
-    std::cout << getCurrentTimestamp() << "WAV file info: " << sample_rate << "Hz, " << channels << " channel(s), " 
-              << bits_per_sample << " bits" << std::endl;
-    
-    // Check if audio format is supported
-    if (bits_per_sample != 16) {
-        setError("Unsupported bits per sample: " + std::to_string(bits_per_sample) + ". Expected 16-bit PCM.");
+    // Everything besides the samples that changes the transcript
+    std::string params = "engine=whisper_ai;model=" + model_id + ";lang=en;vad=" + (vad_enabled_ ? "1" : "0") +
+                         ";profile=" + DecodeProfileOptions().cacheTag() + ";chunks=" + AudioChunker::defaultOptions().cacheTag();
+    return TranscriptionCache::makeKey(reader, params);
+}
+
+bool WhisperAi::loadAudioFile(const std::string& file_path, std::vector<float>& audio_data, std::string& error) {
+    // Map the file and walk its RIFF chunks (LIST/fact chunks are skipped, not read as audio)
+    WavReader reader;
+    if (!reader.open(file_path)) {
+        error = reader.getLastError();
         return false;
     }
     
-    if (sample_rate != 16000) {
-        std::cout << "Info: Sample rate is " << sample_rate << "Hz. Converting to 16kHz for optimal Whisper performance." << std::endl;
-    } else {
-        std::cout << getCurrentTimestamp() << "Perfect! Audio is already in optimal format for Whisper (16kHz, mono, 16-bit)" << std::endl;
-    }
+    const WavFormat& format = reader.format();
+    std::cout << getCurrentTimestamp() << "WAV file info: " << format.sample_rate << "Hz, " << format.channels << " channel(s), " 
+              << format.bits_per_sample << " bits" << std::endl;
     
-    // Find data chunk
-    file.seekg(36, std::ios::beg);
-    char chunk_header[8];
-    file.read(chunk_header, 8);
+    std::cout << getCurrentTimestamp() << "Loading " << reader.frames() << " samples (" 
+              << reader.durationSeconds() << " seconds)" << std::endl;
     
-    // Skip to data if we're not already there
-    while (std::string(chunk_header, 4) != "data" && file.good()) {
-        uint32_t chunk_size = *reinterpret_cast<uint32_t*>(chunk_header + 4);
-        file.seekg(chunk_size, std::ios::cur);
-        file.read(chunk_header, 8);
+    // Convert to float32, normalize and average the channels straight from the mapped file
+    reader.decodeMono(audio_data);
+    if (format.channels > 1) {
+        std::cout << "Converted " << format.channels << " channels to mono" << std::endl;
     }
     
-    if (std::string(chunk_header, 4) != "data") {
-        setError("No data chunk found in WAV file");
-        return false;
-    }
-    
-    uint32_t data_size = *reinterpret_cast<uint32_t*>(chunk_header + 4);
-    uint32_t num_samples = data_size / (bits_per_sample / 8) / channels;
-    
-    std::cout << getCurrentTimestamp() << "Loading " << num_samples << " samples (" 
-              << (float)num_samples / sample_rate << " seconds)" << std::endl;
-    
-    // Optimize memory allocation
-    audio_data.clear();
-    audio_data.reserve(num_samples);
-    
-    // Read audio data efficiently
-    std::vector<int16_t> raw_data(num_samples * channels);
-    file.read(reinterpret_cast<char*>(raw_data.data()), data_size);
-    file.close();
-    
-    // Convert to float32 and normalize - optimize for channels
-    if (channels == 1) {
-        // Mono - direct conversion
-        audio_data.resize(num_samples);
-        for (size_t i = 0; i < num_samples; ++i) {
-            audio_data[i] = static_cast<float>(raw_data[i]) / 32768.0f;
-        }
-    } else {
-        // Multi-channel - convert to mono by averaging
-        audio_data.resize(num_samples);
-        for (size_t i = 0; i < num_samples; ++i) {
-            float sample = 0.0f;
-            for (int ch = 0; ch < channels; ++ch) {
-                sample += static_cast<float>(raw_data[i * channels + ch]);
-            }
-            audio_data[i] = (sample / channels) / 32768.0f;
+    if (format.sample_rate != 16000) {
+        if (!Resampler::toWhisperRate(audio_data, static_cast<int>(format.sample_rate))) {
+            error = "Invalid sample rate: " + std::to_string(format.sample_rate);
+            return false;
         }
-        std::cout << "Converted " << channels << " channels to mono" << std::endl;
+        std::cout << getCurrentTimestamp() << "Resampled " << format.sample_rate << "Hz to 16kHz: "
+                  << audio_data.size() << " samples" << std::endl;
     }
     
     std::cout << getCurrentTimestamp() << "Audio loaded successfully: " << audio_data.size() << " samples" << std::endl;
@@ -288,23 +413,51 @@ bool WhisperAi::loadAudioFile(const std::string& file_path, std::vector<float>&
 }
 
 void WhisperAi::setError(const std::string& error) {
+    std::lock_guard<std::mutex> lock(error_mutex_);
     last_error_ = error;
     std::cerr << "WhisperAi Error: " << error << std::endl;
 }
 
 bool WhisperAi::isInitialized() const {
     std::lock_guard<std::mutex> lock(context_mutex_);
-    return context_ != nullptr;
+    return initialized_;
 }
 
 std::string WhisperAi::getLastError() const {
-    std::lock_guard<std::mutex> lock(context_mutex_);
+    std::lock_guard<std::mutex> lock(error_mutex_);
     return last_error_;
 }
 
 // New async methods implementation
-std::future<std::string> WhisperAi::transcribeFileAsync(const std::string& audio_file_path) {
+std::future<std::string> WhisperAi::transcribeFileAsync(const std::string& audio_file_path,
+                                                        std::shared_ptr<CancellationToken> cancel_token,
+                                                        TranscriptListener listener,
+                                                        const std::string& model) {
+    const std::string model_name = model.empty() ? DEFAULT_MODEL : model;
+    
+    // Same audio already transcribed or being transcribed: no new task
+    std::string cache_key = cacheKey(audio_file_path, model_name);
+    if (!cache_key.empty()) {
+        std::shared_future<std::string> pending;
+        if (!TranscriptionCache::getInstance().acquire(cache_key, pending)) {
+            std::cout << getCurrentTimestamp() << "Transcription of " << audio_file_path 
+                      << " served by the cache (key " << cache_key << ")" << std::endl;
+            return std::async(std::launch::deferred, [this, pending, audio_file_path, cancel_token, listener, model]() {
+                try {
+                    return pending.get();
+                } catch (const TranscriptionCache::Abandoned&) {
+                    // The task we joined was cancelled: claim the audio for ourselves
+                    return transcribeFileAsync(audio_file_path, cancel_token, listener, model).get();
+                }
+            });
+        }
+    }
+    
     TranscriptionTask task(TranscriptionTask::FILE, audio_file_path);
+    task.cache_key = cache_key;
+    task.model = model_name;
+    task.cancel_token = std::move(cancel_token);
+    task.listener = std::move(listener);
     auto future = task.result_promise.get_future();
     
     {
@@ -318,8 +471,14 @@ std::future<std::string> WhisperAi::transcribeFileAsync(const std::string& audio
     return future;
 }
 
-std::future<std::string> WhisperAi::transcribeAudioDataAsync(std::vector<float> audio_data) {
+std::future<std::string> WhisperAi::transcribeAudioDataAsync(std::vector<float> audio_data,
+                                                             std::shared_ptr<CancellationToken> cancel_token,
+                                                             TranscriptListener listener,
+                                                             const std::string& model) {
     TranscriptionTask task(TranscriptionTask::AUDIO_DATA, std::move(audio_data));
+    task.model = model.empty() ? DEFAULT_MODEL : model;
+    task.cancel_token = std::move(cancel_token);
+    task.listener = std::move(listener);
     auto future = task.result_promise.get_future();
     
     {
@@ -338,33 +497,55 @@ size_t WhisperAi::getQueueSize() const {
     return task_queue_.size();
 }
 
+size_t WhisperAi::getPoolSize() const {
+    std::lock_guard<std::mutex> lock(context_mutex_);
+    return pool_size_;
+}
+
+size_t WhisperAi::getBusyWorkers() const {
+    return busy_workers_.load();
+}
+
+void WhisperAi::setVadEnabled(bool enabled) {
+    vad_enabled_ = enabled;
+}
+
+bool WhisperAi::isVadEnabled() const {
+    return vad_enabled_;
+}
+
 // Worker thread management
-void WhisperAi::startWorkerThread() {
+void WhisperAi::startWorkerThreads() {
     if (worker_running_.exchange(true)) {
-        std::cout << getCurrentTimestamp() << "Worker thread already running" << std::endl;
+        std::cout << getCurrentTimestamp() << "Worker threads already running" << std::endl;
         return;
     }
     
     shutdown_ = false;
-    worker_thread_ = std::thread(&WhisperAi::workerLoop, this);
-    std::cout << getCurrentTimestamp() << "Worker thread started" << std::endl;
+    for (size_t i = 0; i < pool_size_; ++i) {
+        worker_threads_.emplace_back(&WhisperAi::workerLoop, this, i);
+    }
+    std::cout << getCurrentTimestamp() << worker_threads_.size() << " worker thread(s) started" << std::endl;
 }
 
-void WhisperAi::stopWorkerThread() {
+void WhisperAi::stopWorkerThreads() {
     if (!worker_running_.exchange(false)) {
         return; // Already stopped
     }
     
-    std::cout << getCurrentTimestamp() << "Stopping worker thread..." << std::endl;
+    std::cout << getCurrentTimestamp() << "Stopping worker threads..." << std::endl;
     
     // Signal shutdown
     shutdown_ = true;
     queue_cv_.notify_all();
     
-    // Wait for thread to finish
-    if (worker_thread_.joinable()) {
-        worker_thread_.join();
+    // Wait for every worker to finish its current task
+    for (auto& worker : worker_threads_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
     }
+    worker_threads_.clear();
     
     // Clear any remaining tasks
     std::lock_guard<std::mutex> lock(queue_mutex_);
@@ -374,16 +555,16 @@ void WhisperAi::stopWorkerThread() {
         task_queue_.pop();
     }
     
-    std::cout << getCurrentTimestamp() << "Worker thread stopped" << std::endl;
+    std::cout << getCurrentTimestamp() << "Worker threads stopped" << std::endl;
 }
 
-void WhisperAi::workerLoop() {
-    std::cout << getCurrentTimestamp() << "Worker thread loop started" << std::endl;
+void WhisperAi::workerLoop(size_t worker_index) {
+    std::cout << getCurrentTimestamp() << "Worker " << worker_index << " loop started" << std::endl;
     
     while (!shutdown_) {
         TranscriptionTask task(TranscriptionTask::FILE, ""); // Temporary initialization
         
-        // Wait for work or shutdown signal
+        // Wait for work or shutdown signal - the first idle worker takes the task
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
             queue_cv_.wait(lock, [this] { return !task_queue_.empty() || shutdown_; });
@@ -400,47 +581,187 @@ void WhisperAi::workerLoop() {
             }
         }
         
+        // Nobody wants the result anymore: skip it without loading the audio
+        if (task.cancel_token && task.cancel_token->isCancelled()) {
+            std::cout << getCurrentTimestamp() << "Worker " << worker_index << " dropping cancelled task: " << task.task_id << std::endl;
+            recordTaskCost(task, 0.0, false);
+            if (!task.cache_key.empty()) {
+                TranscriptionCache::getInstance().abandon(task.cache_key);
+            }
+            task.result_promise.set_value("ERROR: Cancelled");
+            continue;
+        }
+        
         // Process the task
+        busy_workers_++;
         try {
-            std::cout << getCurrentTimestamp() << "Processing transcription task: " << task.task_id << std::endl;
+            std::cout << getCurrentTimestamp() << "Worker " << worker_index << " processing transcription task: " << task.task_id << std::endl;
             
+            auto task_start = std::chrono::steady_clock::now();
             std::string result = processTask(task);
+            recordTaskCost(task, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - task_start).count(), true);
+            if (!task.cache_key.empty() && task.cancel_token && task.cancel_token->isCancelled()) {
+                // Aborted part way: another caller of the same audio may still want a transcript
+                TranscriptionCache::getInstance().abandon(task.cache_key);
+            } else if (!task.cache_key.empty()) {
+                TranscriptionCache::getInstance().complete(task.cache_key, result);
+            }
             task.result_promise.set_value(result);
             
-            std::cout << getCurrentTimestamp() << "Completed transcription task: " << task.task_id << std::endl;
+            std::cout << getCurrentTimestamp() << "Worker " << worker_index << " completed transcription task: " << task.task_id << std::endl;
         } catch (const std::exception& e) {
             std::cout << getCurrentTimestamp() << "Error processing task: " << e.what() << std::endl;
-            task.result_promise.set_value(""); // Set empty result on error
+            std::string result = "ERROR: " + std::string(e.what());
+            if (!task.cache_key.empty()) {
+                TranscriptionCache::getInstance().complete(task.cache_key, result);
+            }
+            task.result_promise.set_value(result);
         }
+        busy_workers_--;
     }
     
-    std::cout << getCurrentTimestamp() << "Worker thread loop ended" << std::endl;
+    std::cout << getCurrentTimestamp() << "Worker " << worker_index << " loop ended" << std::endl;
 }
 
 std::string WhisperAi::processTask(const TranscriptionTask& task) {
+    // A helper queued behind other work may start after its job is done: leasing a state
+    // then could reload a model that was unloaded in the meantime
+    if (task.chunk_job && task.chunk_job->exhausted()) {
+        return "";
+    }
+    
+    // A model not loaded yet is loaded here, by the first worker that needs it
+    std::string error;
+    WhisperModelRegistry::Lease model = models_.acquire(task.chunk_job ? task.chunk_job->model : task.model, error);
+    if (!model && task.chunk_job) {
+        // The helper takes no window: the owner decodes whatever is left
+        std::cerr << "WhisperAi chunk helper without a model: " << error << std::endl;
+        return "";
+    }
+    if (!model) {
+        return taskError(error);
+    }
+    
     switch (task.type) {
         case TranscriptionTask::FILE: {
             // Load audio file first
             std::vector<float> audio_data;
-            if (!loadAudioFile(task.file_path, audio_data)) {
-                return ""; // Error already set by loadAudioFile
+            if (!loadAudioFile(task.file_path, audio_data, error)) {
+                return taskError(error);
             }
             
-            // Process with context lock
-            std::lock_guard<std::mutex> lock(context_mutex_);
-            return transcribeAudioDataInternal(audio_data);
+            if (pool_size_ > 1 && AudioChunker().shouldSplit(audio_data.size())) {
+                return transcribeChunked(model, audio_data, task);
+            }
+            return transcribeAudioDataInternal(model, audio_data, task.cancel_token.get(), task.listener);
         }
         
         case TranscriptionTask::AUDIO_DATA: {
-            // Process with context lock
-            std::lock_guard<std::mutex> lock(context_mutex_);
-            return transcribeAudioDataInternal(task.audio_data);
+            if (pool_size_ > 1 && AudioChunker().shouldSplit(task.audio_data.size())) {
+                return transcribeChunked(model, task.audio_data, task);
+            }
+            return transcribeAudioDataInternal(model, task.audio_data, task.cancel_token.get(), task.listener);
         }
         
-        default:
-            setError("Unknown task type");
+        case TranscriptionTask::CHUNK_WINDOWS: {
+            runChunkWindows(model, *task.chunk_job);
             return "";
+        }
+        
+        default:
+            return taskError("Unknown task type");
+    }
+}
+
+std::string WhisperAi::transcribeChunked(const WhisperModelRegistry::Lease& model, const std::vector<float>& audio_data,
+                                         const TranscriptionTask& task) {
+    auto job = std::make_shared<ChunkJob>(audio_data, task.model, AudioChunker().plan(audio_data.data(), audio_data.size()),
+                                          task.cancel_token, task.listener);
+    
+    // Helpers queue behind whatever is already waiting, so other users' tasks are not delayed;
+    // a helper that starts after every window is taken has nothing to do
+    size_t helpers = std::min(job->windows.size(), pool_size_) - 1;
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex_);
+        for (size_t i = 0; i < helpers; ++i) {
+            TranscriptionTask helper(TranscriptionTask::CHUNK_WINDOWS, "");
+            helper.chunk_job = job;
+            task_queue_.push(std::move(helper));
+        }
+    }
+    queue_cv_.notify_all();
+    std::cout << getCurrentTimestamp() << "Split " << audio_data.size() / 16000.0 << "s of audio into "
+              << job->windows.size() << " windows, " << helpers << " helper task(s) queued" << std::endl;
+    
+    // Every window is taken by someone who is running it, so waiting for the last cannot stall
+    runChunkWindows(model, *job);
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished_cv.wait(lock, [&job] { return job->finished == job->windows.size(); });
+    
+    if (task.cancel_token && task.cancel_token->isCancelled()) {
+        return "ERROR: Cancelled";
+    }
+    if (!job->error.empty()) {
+        return "ERROR: " + job->error; // A transcript with a window missing is not the recording's
+    }
+    return job->stitcher.text();
+}
+
+void WhisperAi::runChunkWindows(const WhisperModelRegistry::Lease& model, ChunkJob& job) {
+    for (size_t i = job.next_window++; i < job.windows.size(); i = job.next_window++) {
+        const AudioWindow& window = job.windows[i];
+        std::vector<TranscriptSegment> segments;
+        std::string result;
+        if (!job.cancel_token || !job.cancel_token->isCancelled()) {
+            std::vector<float> samples(job.audio.begin() + window.start, job.audio.begin() + window.end);
+            result = transcribeAudioDataInternal(model, samples, job.cancel_token.get(), TranscriptListener(), &segments);
+            for (TranscriptSegment& segment : segments) {
+                segment.start_seconds += window.start / 16000.0;
+                segment.end_seconds += window.start / 16000.0;
+            }
+        }
+        job.stitcher.addWindow(i, segments);
+        
+        std::lock_guard<std::mutex> lock(job.mutex);
+        if (isTaskError(result) && job.error.empty()) {
+            job.error = result.substr(7);
+        }
+        ++job.finished;
+        job.finished_cv.notify_all();
+    }
+}
+
+double WhisperAi::taskAudioSeconds(const TranscriptionTask& task) const {
+    if (task.type == TranscriptionTask::CHUNK_WINDOWS) {
+        return 0.0; // Accounted to the task that owns the windows
     }
+    if (task.type == TranscriptionTask::AUDIO_DATA) {
+        return task.audio_data.size() / 16000.0;
+    }
+    WavReader reader;
+    return reader.open(task.file_path) ? reader.durationSeconds() : 0.0;
+}
+
+void WhisperAi::recordTaskCost(const TranscriptionTask& task, double elapsed_ms, bool started) {
+    bool cancelled = task.cancel_token && task.cancel_token->isCancelled();
+    double audio_seconds = taskAudioSeconds(task);
+    if (audio_seconds <= 0.0) {
+        return;
+    }
+    
+    // CPU time ~ wall time x the threads this worker's inference ran on
+    double spent_cpu_ms = elapsed_ms * last_inference_threads;
+    std::lock_guard<std::mutex> lock(cost_mutex_);
+    if (!cancelled) {
+        double rate = spent_cpu_ms / audio_seconds;
+        cpu_ms_per_audio_second_ = cpu_ms_per_audio_second_ == 0.0 ? rate : 0.8 * cpu_ms_per_audio_second_ + 0.2 * rate;
+        return;
+    }
+    
+    double expected_cpu_ms = audio_seconds * cpu_ms_per_audio_second_;
+    double saved_cpu_ms = expected_cpu_ms - spent_cpu_ms;
+    double saved_seconds = expected_cpu_ms > 0.0 ? audio_seconds * saved_cpu_ms / expected_cpu_ms : audio_seconds;
+    CancellationToken::recordSavings(started, saved_seconds, saved_cpu_ms);
 }
 
 // Static method for generating task IDs
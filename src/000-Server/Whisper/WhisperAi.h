@@ -9,9 +9,10 @@
 #include <condition_variable>
 #include <future>
 #include <atomic>
+#include "999-ExternalServices/TranscriptSegment.h"
+#include "WhisperModelRegistry.h"
 
-// Forward declaration to avoid including whisper.h in header
-struct whisper_context;
+class CancellationToken;
 
 class WhisperAi {
 public:
@@ -22,40 +23,83 @@ public:
     WhisperAi(const WhisperAi&) = delete;
     WhisperAi& operator=(const WhisperAi&) = delete;
 
+    // Registry name of the model initialize() loads; requests that name no model use it
+    static constexpr const char* DEFAULT_MODEL = "default";
+    
     // Initialize with default model (ggml-base.en.bin) - thread-safe
-    bool initialize();
+    // pool_size: number of parallel workers; each borrows a whisper_state of the model its
+    // task asks for, sharing that model's weights (0 = derive from hardware_concurrency)
+    // threads_per_state: whisper threads per worker (0 = ask ThreadBudget on every inference)
+    // model_path: overrides the default model location (empty = default); loaded now and pinned
+    bool initialize(size_t pool_size = 0, int threads_per_state = 0, const std::string& model_path = "");
+    
+    // More models for requests to choose from (base, small, quantized variants) - thread-safe
+    // Loaded on first use, unloaded when idle or to make room (see WhisperModelRegistry)
+    bool registerModel(const std::string& name, const std::string& model_path);
+    
+    // Memory budget and idle TTL of the loaded models - thread-safe
+    void setModelCacheOptions(const WhisperModelRegistryOptions& options);
+    
+    // Resident memory, hits and evictions per registered model
+    std::vector<WhisperModelStats> getModelStats() const;
     
     // Transcribe audio file (expects 16kHz mono WAV format from browser) - thread-safe
-    std::string transcribeFile(const std::string& audio_file_path);
+    // Returns the text ("" if nothing was said) or "ERROR: ..." for this call's failure
+    // model: registry name, empty = DEFAULT_MODEL
+    std::string transcribeFile(const std::string& audio_file_path, const std::string& model = "");
     
     // Transcribe raw audio data (16kHz, mono, float32) - thread-safe
-    std::string transcribeAudioData(const std::vector<float>& audio_data);
+    std::string transcribeAudioData(const std::vector<float>& audio_data, const std::string& model = "");
     
     // Async transcription methods (non-blocking)
-    std::future<std::string> transcribeFileAsync(const std::string& audio_file_path);
-    std::future<std::string> transcribeAudioDataAsync(const std::vector<float> audio_data);
+    // cancel_token: a queued task is skipped and a running one aborted ("ERROR: Cancelled") once it is cancelled
+    // listener: segments and progress from the worker thread while it decodes (not for cache hits)
+    std::future<std::string> transcribeFileAsync(const std::string& audio_file_path,
+                                                 std::shared_ptr<CancellationToken> cancel_token = nullptr,
+                                                 TranscriptListener listener = TranscriptListener(),
+                                                 const std::string& model = "");
+    std::future<std::string> transcribeAudioDataAsync(const std::vector<float> audio_data,
+                                                      std::shared_ptr<CancellationToken> cancel_token = nullptr,
+                                                      TranscriptListener listener = TranscriptListener(),
+                                                      const std::string& model = "");
     
     // Get queue status
     size_t getQueueSize() const;
     
+    // Pool status
+    size_t getPoolSize() const;
+    size_t getBusyWorkers() const;
+    
+    // Trim silence before inference (voice activity detection) - thread-safe
+    void setVadEnabled(bool enabled);
+    bool isVadEnabled() const;
+    
     // Check if initialized properly - thread-safe
     bool isInitialized() const;
     
-    // Error handling - thread-safe
+    // Why initialize() or registerModel() failed - thread-safe; transcriptions report their own errors
     std::string getLastError() const;
 
 private:
     WhisperAi();
     ~WhisperAi();
 
+    // One long recording split into AudioChunker windows, shared by the workers decoding them
+    struct ChunkJob;
+    
     // Task structure for async processing
     struct TranscriptionTask {
-        enum Type { FILE, AUDIO_DATA };
+        enum Type { FILE, AUDIO_DATA, CHUNK_WINDOWS };
         Type type;
         std::string file_path;              // For FILE type
         std::vector<float> audio_data;      // For AUDIO_DATA type
         std::promise<std::string> result_promise;
         std::string task_id;
+        std::string cache_key;              // Claimed in TranscriptionCache, completed by the worker
+        std::string model;                  // Registry name of the model to decode with
+        std::shared_ptr<CancellationToken> cancel_token;
+        TranscriptListener listener;
+        std::shared_ptr<ChunkJob> chunk_job;    // For CHUNK_WINDOWS: help decoding another task's windows
         
         TranscriptionTask(Type t, const std::string& path) 
             : type(t), file_path(path), task_id(generateTaskId()) {}
@@ -67,7 +111,12 @@ private:
             : type(other.type), file_path(std::move(other.file_path)), 
               audio_data(std::move(other.audio_data)), 
               result_promise(std::move(other.result_promise)),
-              task_id(std::move(other.task_id)) {}
+              task_id(std::move(other.task_id)),
+              cache_key(std::move(other.cache_key)),
+              model(std::move(other.model)),
+              cancel_token(std::move(other.cancel_token)),
+              listener(std::move(other.listener)),
+              chunk_job(std::move(other.chunk_job)) {}
         
         TranscriptionTask& operator=(TranscriptionTask&& other) noexcept {
             if (this != &other) {
@@ -76,6 +125,11 @@ private:
                 audio_data = std::move(other.audio_data);
                 result_promise = std::move(other.result_promise);
                 task_id = std::move(other.task_id);
+                cache_key = std::move(other.cache_key);
+                model = std::move(other.model);
+                cancel_token = std::move(other.cancel_token);
+                listener = std::move(other.listener);
+                chunk_job = std::move(other.chunk_job);
             }
             return *this;
         }
@@ -88,32 +142,59 @@ private:
         static std::string generateTaskId();
     };
 
-    whisper_context* context_;
+    // Model weights and decoding states; a worker leases one state of its task's model at a time
+    // (whisper_full_with_state needs exclusive access to its state)
+    WhisperModelRegistry models_;
+    bool initialized_;
     std::string last_error_;
     
-    // Thread safety for context operations
+    // Thread safety for initialize / destroy
     mutable std::mutex context_mutex_;
+    mutable std::mutex error_mutex_;
+    
+    size_t pool_size_;                      // Worker threads, at most one running inference each
+    int threads_per_state_;                 // Fixed n_threads, 0 = ThreadBudget lease per inference
     
     // Async processing components
     std::queue<TranscriptionTask> task_queue_;
     mutable std::mutex queue_mutex_;
     std::condition_variable queue_cv_;
-    std::thread worker_thread_;
+    std::vector<std::thread> worker_threads_;
     std::atomic<bool> shutdown_;
     std::atomic<bool> worker_running_;
+    std::atomic<size_t> busy_workers_;
+    std::atomic<bool> vad_enabled_;
+    
+    // Measured inference cost, used to estimate what a cancellation saved
+    mutable std::mutex cost_mutex_;
+    double cpu_ms_per_audio_second_;
     
     // Helper methods
-    bool loadAudioFile(const std::string& file_path, std::vector<float>& audio_data);
+    std::string cacheKey(const std::string& audio_file_path, const std::string& model) const;
+    bool loadAudioFile(const std::string& file_path, std::vector<float>& audio_data, std::string& error);
+    double taskAudioSeconds(const TranscriptionTask& task) const;
+    void recordTaskCost(const TranscriptionTask& task, double elapsed_ms, bool started);
     void setError(const std::string& error);
     
-    // Internal transcription method (assumes context_mutex is already locked)
-    std::string transcribeAudioDataInternal(const std::vector<float>& audio_data);
+    // Internal transcription method (the model's state is leased by the calling worker)
+    // segments: receives the decoded segments, timed against audio_data before VAD
+    std::string transcribeAudioDataInternal(const WhisperModelRegistry::Lease& model, const std::vector<float>& audio_data,
+                                            const CancellationToken* cancel_token = nullptr,
+                                            const TranscriptListener& listener = TranscriptListener(),
+                                            std::vector<TranscriptSegment>* segments = nullptr);
+    
+    // Long recordings: decode AudioChunker windows on this worker while idle ones help, then stitch
+    std::string transcribeChunked(const WhisperModelRegistry::Lease& model, const std::vector<float>& audio_data,
+                                  const TranscriptionTask& task);
+    
+    // Decode windows of the job until none is left to take
+    void runChunkWindows(const WhisperModelRegistry::Lease& model, ChunkJob& job);
     
     // Worker thread methods
-    void startWorkerThread();
-    void stopWorkerThread();
-    void workerLoop();
+    void startWorkerThreads();
+    void stopWorkerThreads();
+    void workerLoop(size_t worker_index);
     
-    // Process a single task (called by worker thread)
+    // Process a single task (called by worker thread, which leases a state of the task's model)
     std::string processTask(const TranscriptionTask& task);
 };
@@ -0,0 +1,36 @@
+#include "WhisperAiBackend.h"
+#include "WhisperAi.h"
+#include "999-ExternalServices/CancellationToken.h"
+#include "999-ExternalServices/SharedAudioBuffer.h"
+
+WhisperAiBackend::WhisperAiBackend(const std::string& model)
+    : model_(model)
+{
+}
+
+std::string WhisperAiBackend::backendName() const {
+    return "whisper_ai:" + (model_.empty() ? std::string(WhisperAi::DEFAULT_MODEL) : model_);
+}
+
+std::string WhisperAiBackend::transcribe(const TranscriptionRequest& request) {
+    WhisperAi& whisper = WhisperAi::getInstance();
+    if (!whisper.isInitialized()) {
+        return "ERROR: WhisperAi not initialized";
+    }
+    TranscriptListener listener = request.listener ? *request.listener : TranscriptListener();
+
+    std::future<std::string> pending;
+    if (request.audio) {
+        std::vector<float> samples(request.audio->samples(), request.audio->samples() + request.audio->sampleCount());
+        pending = whisper.transcribeAudioDataAsync(std::move(samples), request.cancel_token, listener, model_);
+    } else {
+        pending = whisper.transcribeFileAsync(request.audio_file_path, request.cancel_token, listener, model_);
+    }
+
+    // WhisperAi reports this task's own failure as "ERROR: ..."; "" is a recording nobody spoke in
+    std::string result = pending.get();
+    if (request.cancel_token && request.cancel_token->isCancelled()) {
+        return "ERROR: Cancelled";
+    }
+    return result;
+}
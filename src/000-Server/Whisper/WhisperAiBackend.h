@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include "999-ExternalServices/TranscriptionBackend.h"
+
+/**
+ * @brief WhisperAiBackend - TranscriptionBackend running whisper in this process through WhisperAi
+ *
+ * The caller initializes WhisperAi first. Recordings go to WhisperAi's own worker pool and
+ * queue, which size their threads themselves, so request.threads is not used.
+ *
+ * Only the bench tools link whisper into their own process (bench_pipeline_load --model);
+ * the server does not, so whisper-backend in wt_config.xml cannot select this backend.
+ */
+class WhisperAiBackend : public TranscriptionBackend {
+public:
+    /**
+     * @param model Registry name of the model to decode with (empty = WhisperAi::DEFAULT_MODEL)
+     */
+    explicit WhisperAiBackend(const std::string& model = "");
+
+    std::string backendName() const override;
+    std::string transcribe(const TranscriptionRequest& request) override;
+
+private:
+    std::string model_;
+};
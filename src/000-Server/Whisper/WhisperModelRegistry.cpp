@@ -0,0 +1,470 @@
+#include "WhisperModelRegistry.h"
+#include "whisper.h"
+#include "999-ExternalServices/WhisperModelFile.h"
+#include "999-ExternalServices/WhisperModelLoader.h"
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+
+WhisperModelRegistry::Lease::Lease(Lease&& other) noexcept
+    : registry_(other.registry_), entry_(other.entry_), context_(other.context_), state_(other.state_) {
+    other.registry_ = nullptr;
+    other.entry_ = nullptr;
+    other.context_ = nullptr;
+    other.state_ = nullptr;
+}
+
+WhisperModelRegistry::Lease& WhisperModelRegistry::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::swap(registry_, other.registry_);
+        std::swap(entry_, other.entry_);
+        std::swap(context_, other.context_);
+        std::swap(state_, other.state_);
+    }
+    return *this;
+}
+
+WhisperModelRegistry::Lease::~Lease() {
+    release();
+}
+
+void WhisperModelRegistry::Lease::release() {
+    if (registry_ && state_) {
+        registry_->release(entry_, state_);
+    }
+    registry_ = nullptr;
+    entry_ = nullptr;
+    context_ = nullptr;
+    state_ = nullptr;
+}
+
+WhisperModelRegistry::WhisperModelRegistry()
+    : running_(false)
+{
+}
+
+WhisperModelRegistry::~WhisperModelRegistry() {
+    stop();
+
+    // Leases never outlive the workers holding them, so every state is back by now
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& item : entries_) {
+        Entry& entry = *item.second;
+        for (whisper_state* state : entry.free_states) {
+            whisper_free_state(state);
+        }
+        if (entry.context) {
+            whisper_free(entry.context);
+        }
+    }
+    entries_.clear();
+}
+
+void WhisperModelRegistry::configure(const WhisperModelRegistryOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        options_ = options;
+    }
+    // A shorter TTL takes effect now rather than after the evictor's current sleep
+    evictor_cv_.notify_all();
+}
+
+WhisperModelRegistryOptions WhisperModelRegistry::options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+bool WhisperModelRegistry::registerModel(const std::string& name, const std::string& path, bool pinned,
+                                         std::string& error) {
+    std::error_code ec;
+    const uint64_t file_bytes = std::filesystem::file_size(path, ec);
+    if (ec || !std::filesystem::is_regular_file(path, ec)) {
+        error = "Model file not found: " + path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it != entries_.end()) {
+        if (it->second->path != path) {
+            error = "Model " + name + " is already registered for " + it->second->path;
+            return false;
+        }
+        it->second->pinned = pinned;
+        return true;
+    }
+
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->path = path;
+    entry->pinned = pinned;
+    entry->weights_bytes = file_bytes;
+    entry->last_used = Clock::now();
+    entries_[name] = std::move(entry);
+    std::cout << "WhisperModelRegistry: registered " << name << " (" << path << (pinned ? ", pinned" : "") << ")" << std::endl;
+    return true;
+}
+
+bool WhisperModelRegistry::hasModel(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.count(name) > 0;
+}
+
+std::string WhisperModelRegistry::modelId(const std::string& name) const {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(name);
+        if (it == entries_.end()) {
+            return "";
+        }
+        path = it->second->path;
+    }
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    return path + ":" + std::to_string(ec ? 0 : size);
+}
+
+WhisperModelRegistry::Lease WhisperModelRegistry::acquire(const std::string& name, std::string& error) {
+    return acquire(name, true, error);
+}
+
+WhisperModelRegistry::Lease WhisperModelRegistry::acquire(const std::string& name, bool count_hit, std::string& error) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        error = "Unknown model: " + name;
+        return Lease();
+    }
+    Entry& entry = *it->second;
+    bool loaded_here = false;
+
+    for (;;) {
+        // Never two loads of one model: wait for the running load, or for an unload to free its memory first
+        if (entry.status == Status::Loading || entry.status == Status::Evicting) {
+            changed_cv_.wait(lock);
+            continue;
+        }
+
+        if (entry.status == Status::Unloaded) {
+            if (!makeRoomLocked(lock, entry.weights_bytes + entry.state_bytes, &entry)) {
+                continue;
+            }
+            if (!loadLocked(lock, entry, error)) {
+                return Lease();
+            }
+            loaded_here = true;
+            continue;
+        }
+
+        whisper_state* state = nullptr;
+        if (!entry.free_states.empty()) {
+            state = entry.free_states.back();
+            entry.free_states.pop_back();
+            ++entry.in_use;
+        } else {
+            // The first state always fits: a model without one is of no use
+            if (entry.states > 0 && !makeRoomLocked(lock, entry.state_bytes, &entry)) {
+                continue;
+            }
+            state = createStateLocked(lock, entry);
+            if (!state) {
+                error = "Failed to create a whisper state for model " + name;
+                return Lease();
+            }
+        }
+
+        if (count_hit && !loaded_here) {
+            ++entry.hits;
+        }
+        Lease lease;
+        lease.registry_ = this;
+        lease.entry_ = &entry;
+        lease.context_ = entry.context;
+        lease.state_ = state;
+        return lease;
+    }
+}
+
+bool WhisperModelRegistry::preload(const std::string& name, size_t states, std::string& error) {
+    // Held together, so each lease is a state of its own
+    std::vector<Lease> leases;
+    for (size_t i = 0; i < std::max<size_t>(1, states); ++i) {
+        Lease lease = acquire(name, false, error);
+        if (!lease) {
+            return !leases.empty();
+        }
+        leases.push_back(std::move(lease));
+    }
+    return true;
+}
+
+void WhisperModelRegistry::release(Entry* entry, whisper_state* state) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entry->free_states.push_back(state);
+        --entry->in_use;
+        entry->last_used = Clock::now();
+    }
+    changed_cv_.notify_all();
+}
+
+bool WhisperModelRegistry::loadLocked(std::unique_lock<std::mutex>& lock, Entry& entry, std::string& error) {
+    const std::string path = entry.path;
+    entry.status = Status::Loading;
+    entry.load_reservation = entry.weights_bytes + entry.state_bytes;
+    lock.unlock();
+
+    // Weights only: states are created per lease on top of them
+    auto load_start = Clock::now();
+    whisper_context* context = nullptr;
+    WhisperModelFile model_file;
+    if (model_file.open(path)) {
+        struct whisper_context_params cparams = whisper_context_default_params();
+        cparams.use_gpu = false; // Disable GPU for stability and consistency
+        context = WhisperModelLoader::load(model_file, cparams, false);
+        model_file.close();
+    }
+    double load_ms = std::chrono::duration<double, std::milli>(Clock::now() - load_start).count();
+
+    lock.lock();
+    entry.load_reservation = 0;
+    if (!context) {
+        entry.status = Status::Unloaded;
+        ++entry.load_failures;
+        error = model_file.getLastError().empty() ? "Failed to initialize whisper context from model: " + path
+                                                  : model_file.getLastError();
+        changed_cv_.notify_all();
+        return false;
+    }
+
+    entry.context = context;
+    entry.status = Status::Loaded;
+    entry.last_used = Clock::now();
+    entry.last_load_ms = load_ms;
+    ++entry.loads;
+    std::cout << "WhisperModelRegistry: loaded " << entry.name << " in " << static_cast<long>(load_ms) << " ms, "
+              << residentBytesLocked() / (1024 * 1024) << " MB resident" << std::endl;
+    changed_cv_.notify_all();
+    return true;
+}
+
+whisper_state* WhisperModelRegistry::createStateLocked(std::unique_lock<std::mutex>& lock, Entry& entry) {
+    // Counted as leased while unlocked, so the model cannot be unloaded under the new state
+    ++entry.states;
+    ++entry.in_use;
+    whisper_context* context = entry.context;
+    lock.unlock();
+
+    size_t rss_before_kb = WhisperModelFile::processRssKb();
+    whisper_state* state = whisper_init_state(context);
+    size_t rss_after_kb = WhisperModelFile::processRssKb();
+
+    lock.lock();
+    if (!state) {
+        --entry.states;
+        --entry.in_use;
+        changed_cv_.notify_all();
+        return nullptr;
+    }
+    if (entry.state_bytes == 0 && rss_after_kb > rss_before_kb) {
+        entry.state_bytes = static_cast<uint64_t>(rss_after_kb - rss_before_kb) * 1024;
+    }
+    return state;
+}
+
+bool WhisperModelRegistry::makeRoomLocked(std::unique_lock<std::mutex>& lock, uint64_t bytes, const Entry* keep) {
+    if (options_.memory_budget_mb == 0) {
+        return true;
+    }
+    const uint64_t budget = static_cast<uint64_t>(options_.memory_budget_mb) * 1024 * 1024;
+    if (residentBytesLocked() + bytes <= budget) {
+        return true;
+    }
+
+    // Least recently used model nobody holds a lease on
+    Entry* victim = nullptr;
+    bool leases_out = false;
+    for (auto& item : entries_) {
+        Entry& entry = *item.second;
+        if (entry.status == Status::Loading || entry.status == Status::Evicting) {
+            leases_out = leases_out || &entry != keep;
+            continue;
+        }
+        if (entry.status != Status::Loaded) {
+            continue;
+        }
+        if (entry.in_use > 0) {
+            leases_out = leases_out || !entry.pinned || &entry == keep;
+            continue;
+        }
+        if (&entry == keep || entry.pinned) {
+            continue;
+        }
+        if (!victim || entry.last_used < victim->last_used) {
+            victim = &entry;
+        }
+    }
+
+    if (victim) {
+        std::cout << "WhisperModelRegistry: unloading " << victim->name << " to stay within "
+                  << options_.memory_budget_mb << " MB" << std::endl;
+        unloadLocked(lock, *victim);
+        return false;
+    }
+    if (leases_out) {
+        changed_cv_.wait(lock);
+        return false;
+    }
+
+    // Only pinned models and the one asked for are left: the budget cannot be met
+    std::cout << "WhisperModelRegistry: " << (residentBytesLocked() + bytes) / (1024 * 1024)
+              << " MB exceeds the " << options_.memory_budget_mb << " MB budget, nothing left to unload" << std::endl;
+    return true;
+}
+
+void WhisperModelRegistry::unloadLocked(std::unique_lock<std::mutex>& lock, Entry& entry) {
+    entry.status = Status::Evicting;
+    whisper_context* context = entry.context;
+    std::vector<whisper_state*> states;
+    states.swap(entry.free_states);
+    entry.context = nullptr;
+    lock.unlock();
+
+    // States before the context they were created from
+    for (whisper_state* state : states) {
+        whisper_free_state(state);
+    }
+    whisper_free(context);
+
+    lock.lock();
+    entry.states = 0;
+    entry.status = Status::Unloaded;
+    ++entry.evictions;
+    changed_cv_.notify_all();
+}
+
+size_t WhisperModelRegistry::evictIdle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (options_.idle_ttl_seconds <= 0) {
+        return 0;
+    }
+    const auto ttl = std::chrono::seconds(options_.idle_ttl_seconds);
+
+    size_t evicted = 0;
+    for (;;) {
+        // Unloading releases the lock, so look for the next idle model afresh every time
+        Entry* idle = nullptr;
+        const auto now = Clock::now();
+        for (auto& item : entries_) {
+            Entry& entry = *item.second;
+            if (entry.status == Status::Loaded && !entry.pinned && entry.in_use == 0 && now - entry.last_used >= ttl) {
+                idle = &entry;
+                break;
+            }
+        }
+        if (!idle) {
+            return evicted;
+        }
+        std::cout << "WhisperModelRegistry: unloading " << idle->name << ", idle for "
+                  << std::chrono::duration_cast<std::chrono::seconds>(now - idle->last_used).count() << " s" << std::endl;
+        ++idle->idle_evictions;
+        unloadLocked(lock, *idle);
+        ++evicted;
+    }
+}
+
+void WhisperModelRegistry::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    evictor_ = std::thread(&WhisperModelRegistry::evictorLoop, this);
+}
+
+void WhisperModelRegistry::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    evictor_cv_.notify_all();
+    if (evictor_.joinable()) {
+        evictor_.join();
+    }
+}
+
+void WhisperModelRegistry::evictorLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        // A quarter of the TTL keeps a model at most 25% past its TTL
+        int interval_seconds = options_.idle_ttl_seconds > 0 ? std::clamp(options_.idle_ttl_seconds / 4, 1, 60) : 60;
+        evictor_cv_.wait_for(lock, std::chrono::seconds(interval_seconds));
+        if (!running_) {
+            break;
+        }
+        lock.unlock();
+        evictIdle();
+        lock.lock();
+    }
+}
+
+uint64_t WhisperModelRegistry::entryBytes(const Entry& entry) {
+    switch (entry.status) {
+        case Status::Loading: return entry.load_reservation;
+        case Status::Loaded:
+        case Status::Evicting: return entry.weights_bytes + entry.states * entry.state_bytes;
+        case Status::Unloaded: return 0;
+    }
+    return 0;
+}
+
+uint64_t WhisperModelRegistry::residentBytesLocked() const {
+    uint64_t total = 0;
+    for (const auto& item : entries_) {
+        total += entryBytes(*item.second);
+    }
+    return total;
+}
+
+uint64_t WhisperModelRegistry::residentBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return residentBytesLocked();
+}
+
+std::vector<WhisperModelStats> WhisperModelRegistry::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+    std::vector<WhisperModelStats> stats;
+    for (const auto& item : entries_) {
+        const Entry& entry = *item.second;
+        WhisperModelStats model;
+        model.name = entry.name;
+        model.path = entry.path;
+        switch (entry.status) {
+            case Status::Unloaded: model.status = "unloaded"; break;
+            case Status::Loading: model.status = "loading"; break;
+            case Status::Loaded: model.status = "loaded"; break;
+            case Status::Evicting: model.status = "evicting"; break;
+        }
+        model.pinned = entry.pinned;
+        model.resident_bytes = entry.status == Status::Loading ? 0 : entryBytes(entry);
+        model.weights_bytes = entry.weights_bytes;
+        model.state_bytes = entry.state_bytes;
+        model.states = entry.states;
+        model.states_in_use = entry.in_use;
+        model.hits = entry.hits;
+        model.loads = entry.loads;
+        model.load_failures = entry.load_failures;
+        model.evictions = entry.evictions;
+        model.idle_evictions = entry.idle_evictions;
+        model.last_load_ms = entry.last_load_ms;
+        model.idle_seconds = entry.in_use > 0 ? 0.0 : std::chrono::duration<double>(now - entry.last_used).count();
+        stats.push_back(model);
+    }
+    return stats;
+}
@@ -0,0 +1,207 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// Forward declaration to avoid including whisper.h in header
+struct whisper_context;
+struct whisper_state;
+
+/**
+ * @brief Memory budget and idle eviction of WhisperModelRegistry
+ */
+struct WhisperModelRegistryOptions {
+    size_t memory_budget_mb = 0;        // Weights plus states of every loaded model; 0 = no budget
+    int idle_ttl_seconds = 600;         // Unpinned models unused this long are unloaded; 0 = never
+};
+
+/**
+ * @brief One model as reported by WhisperModelRegistry::getStats()
+ */
+struct WhisperModelStats {
+    std::string name;
+    std::string path;
+    std::string status;             // "unloaded", "loading", "loaded" or "evicting"
+    bool pinned = false;
+    uint64_t resident_bytes = 0;    // weights_bytes + states x state_bytes while loaded
+    uint64_t weights_bytes = 0;
+    uint64_t state_bytes = 0;       // RSS growth of one whisper_init_state, measured on the first
+    size_t states = 0;              // Created, leased or free
+    size_t states_in_use = 0;
+    uint64_t hits = 0;              // Leases of a model this acquire() did not have to load
+    uint64_t loads = 0;
+    uint64_t load_failures = 0;
+    uint64_t evictions = 0;         // Budget and idle evictions
+    uint64_t idle_evictions = 0;
+    double last_load_ms = 0.0;
+    double idle_seconds = 0.0;      // Since the last lease was returned
+};
+
+/**
+ * @brief WhisperModelRegistry - Named whisper models, loaded on first use within a memory budget
+ *
+ * WhisperAi used to hold one model for the life of the process. The registry knows any
+ * number of models by name (base, small, quantized variants) and loads one only when a
+ * request asks for it. Each loaded model keeps the whisper_states its callers created on
+ * top of the shared weights and hands them out as leases, one per running inference.
+ *
+ * Before a load, or before another state is created, the least recently used models
+ * nobody holds a lease on are unloaded until the new memory fits memory_budget_mb; if the
+ * models in the way are still in use, the caller waits for their leases to come back.
+ * A model that is loading or being unloaded is never loaded a second time: callers wait
+ * for the load to finish, or for the memory to be freed before loading it again. An
+ * evictor thread unloads unpinned models idle for idle_ttl_seconds.
+ *
+ * Weights are counted at the model file's size; a state at the RSS its creation added.
+ */
+class WhisperModelRegistry {
+private:
+    struct Entry;
+
+public:
+    /**
+     * @brief A model's context and one of its states, exclusively the holder's until destroyed
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        explicit operator bool() const { return state_ != nullptr; }
+        whisper_context* context() const { return context_; }
+        whisper_state* state() const { return state_; }
+
+        // Hand the state back before the lease goes away
+        void release();
+
+    private:
+        friend class WhisperModelRegistry;
+
+        WhisperModelRegistry* registry_ = nullptr;
+        Entry* entry_ = nullptr;
+        whisper_context* context_ = nullptr;
+        whisper_state* state_ = nullptr;
+    };
+
+    WhisperModelRegistry();
+    ~WhisperModelRegistry();
+
+    WhisperModelRegistry(const WhisperModelRegistry&) = delete;
+    WhisperModelRegistry& operator=(const WhisperModelRegistry&) = delete;
+
+    void configure(const WhisperModelRegistryOptions& options);
+    WhisperModelRegistryOptions options() const;
+
+    /**
+     * @brief Make a model available under name; nothing is loaded yet
+     * @param pinned Never unloaded, neither for the budget nor when idle
+     * @return false if the file does not exist or name is taken by another path
+     */
+    bool registerModel(const std::string& name, const std::string& path, bool pinned, std::string& error);
+
+    bool hasModel(const std::string& name) const;
+
+    /**
+     * @brief Model path and size ("" for unknown names), identifying the model in cache keys
+     */
+    std::string modelId(const std::string& name) const;
+
+    /**
+     * @brief A state of the model, loading the model first if needed; blocks while memory is freed
+     *
+     * A thread must not hold another lease meanwhile: waiting for leases to come back could wait for its own.
+     * @return An empty lease with error set if the name is unknown or loading failed
+     */
+    Lease acquire(const std::string& name, std::string& error);
+
+    /**
+     * @brief Load the model and create states now rather than on the first requests; not counted as hits
+     */
+    bool preload(const std::string& name, size_t states, std::string& error);
+
+    /**
+     * @brief Start / stop the idle evictor thread
+     */
+    void start();
+    void stop();
+
+    /**
+     * @brief Unload models idle for at least idle_ttl_seconds; the evictor thread calls this
+     * @return Number of models unloaded
+     */
+    size_t evictIdle();
+
+    std::vector<WhisperModelStats> getStats() const;
+    uint64_t residentBytes() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Status { Unloaded, Loading, Loaded, Evicting };
+
+    struct Entry {
+        std::string name;
+        std::string path;
+        bool pinned = false;
+        Status status = Status::Unloaded;
+        whisper_context* context = nullptr;
+        std::vector<whisper_state*> free_states;
+        size_t states = 0;              // Including those being created
+        size_t in_use = 0;
+        uint64_t weights_bytes = 0;     // The model file's size
+        uint64_t state_bytes = 0;
+        uint64_t load_reservation = 0;  // Counted against the budget while Loading
+        Clock::time_point last_used;
+        uint64_t hits = 0;
+        uint64_t loads = 0;
+        uint64_t load_failures = 0;
+        uint64_t evictions = 0;
+        uint64_t idle_evictions = 0;
+        double last_load_ms = 0.0;
+    };
+
+    Lease acquire(const std::string& name, bool count_hit, std::string& error);
+    void release(Entry* entry, whisper_state* state);
+
+    // Load entry with the lock released; false with error set on failure
+    bool loadLocked(std::unique_lock<std::mutex>& lock, Entry& entry, std::string& error);
+
+    // Create one more state of a loaded entry with the lock released
+    whisper_state* createStateLocked(std::unique_lock<std::mutex>& lock, Entry& entry);
+
+    /**
+     * @brief Free memory for bytes more, unloading idle models other than keep, or wait for leases
+     * @return true if bytes fit (or nothing else can be freed); false if the lock was
+     *         released meanwhile and the caller has to look at its entry again
+     */
+    bool makeRoomLocked(std::unique_lock<std::mutex>& lock, uint64_t bytes, const Entry* keep);
+
+    // Unload with the lock released; entry is Evicting meanwhile so nobody loads it again
+    void unloadLocked(std::unique_lock<std::mutex>& lock, Entry& entry);
+
+    uint64_t residentBytesLocked() const;
+    static uint64_t entryBytes(const Entry& entry);
+
+    void evictorLoop();
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_cv_;    // A load finished, a model was unloaded or a lease came back
+    std::condition_variable evictor_cv_;
+    std::thread evictor_;
+    bool running_;
+
+    WhisperModelRegistryOptions options_;
+    std::map<std::string, std::unique_ptr<Entry>> entries_;
+};
@@ -0,0 +1,118 @@
+#include "003-Components/AudioStreamResource.h"
+#include "999-ExternalServices/StreamingTranscriber.h"
+#include <Wt/Http/Request.h>
+#include <Wt/Http/Response.h>
+#include <iterator>
+#include <cstring>
+
+// A 16kHz chunk is 0.5s (16KB) - anything far bigger is not from our recorder
+static constexpr size_t MAX_CHUNK_BYTES = 256 * 1024;
+// Chunks held while an earlier one is still in flight (8s of audio)
+static constexpr int MAX_SEQ_AHEAD = 16;
+// Live preview of one recording stops after an hour; the upload is still transcribed
+static constexpr size_t MAX_STREAM_SAMPLES = 60 * 60 * 16000;
+
+static int intParameter(const Wt::Http::Request& request, const std::string& name, int fallback)
+{
+    const std::string* value = request.getParameter(name);
+    if (!value) {
+        return fallback;
+    }
+    try {
+        return std::stoi(*value);
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+AudioStreamResource::AudioStreamResource()
+    : Wt::WResource(),
+    stream_id_(0),
+    next_seq_(0),
+    final_seq_(-1),
+    stream_samples_(0)
+{
+}
+
+AudioStreamResource::~AudioStreamResource()
+{
+    beingDeleted();
+}
+
+void AudioStreamResource::attach(int stream_id, std::shared_ptr<StreamingTranscriber> transcriber)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stream_id_ = stream_id;
+    transcriber_ = std::move(transcriber);
+    next_seq_ = 0;
+    final_seq_ = -1;
+    stream_samples_ = 0;
+    pending_chunks_.clear();
+}
+
+void AudioStreamResource::detach()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    transcriber_.reset();
+    pending_chunks_.clear();
+}
+
+void AudioStreamResource::handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response)
+{
+    response.setMimeType("text/plain");
+
+    int stream_id = intParameter(request, "stream", -1);
+    int seq = intParameter(request, "seq", -1);
+    bool is_final = intParameter(request, "final", 0) == 1;
+
+    if (seq < 0 || request.contentLength() > MAX_CHUNK_BYTES) {
+        response.setStatus(400);
+        return;
+    }
+
+    std::string body((std::istreambuf_iterator<char>(request.in())), std::istreambuf_iterator<char>());
+    std::vector<int16_t> samples(body.size() / sizeof(int16_t));
+    if (!samples.empty()) {
+        std::memcpy(samples.data(), body.data(), samples.size() * sizeof(int16_t));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!transcriber_ || stream_id != stream_id_ || seq < next_seq_ || pending_chunks_.count(seq)) {
+        // Late chunk of a finished or replaced recording, or a resent one
+        response.out() << "ignored";
+        return;
+    }
+
+    if (seq > next_seq_ + MAX_SEQ_AHEAD) {
+        // Further ahead than the recorder ever has chunks in flight
+        response.setStatus(400);
+        return;
+    }
+    stream_samples_ += samples.size();
+    if (stream_samples_ > MAX_STREAM_SAMPLES) {
+        // End the preview with what it has; later chunks of this stream are ignored
+        transcriber_->finish();
+        transcriber_.reset();
+        pending_chunks_.clear();
+        response.setStatus(413);
+        return;
+    }
+
+    pending_chunks_[seq] = std::move(samples);
+    if (is_final) {
+        final_seq_ = seq;
+    }
+
+    for (auto it = pending_chunks_.find(next_seq_); it != pending_chunks_.end(); it = pending_chunks_.find(next_seq_)) {
+        transcriber_->appendSamples(it->second.data(), it->second.size());
+        pending_chunks_.erase(it);
+        ++next_seq_;
+    }
+
+    if (final_seq_ >= 0 && next_seq_ > final_seq_) {
+        transcriber_->finish();
+        transcriber_.reset();
+    }
+
+    response.out() << "ok";
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <Wt/WResource.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstdint>
+
+class StreamingTranscriber;
+
+/*
+ * Receives the PCM chunks VoiceRecorder's JavaScript posts while recording.
+ * Each POST body is raw 16kHz mono Int16 (little endian) audio with query parameters
+ * stream=<id>&seq=<n> and final=1 on the last chunk. Chunks can arrive out of order
+ * on different server threads, so they are re-ordered by seq before being handed
+ * to the attached StreamingTranscriber. Only a few chunks may wait for a missing one,
+ * and a stream is cut off once its chunks add up to an hour of audio.
+ */
+class AudioStreamResource : public Wt::WResource
+{
+public:
+    AudioStreamResource();
+    ~AudioStreamResource() override;
+
+    // Route chunks of stream_id to transcriber; chunks of any other stream are dropped
+    void attach(int stream_id, std::shared_ptr<StreamingTranscriber> transcriber);
+    void detach();
+
+protected:
+    void handleRequest(const Wt::Http::Request& request, Wt::Http::Response& response) override;
+
+private:
+    std::mutex mutex_;
+    int stream_id_;
+    std::shared_ptr<StreamingTranscriber> transcriber_;
+    int next_seq_;
+    int final_seq_; // -1 until the final chunk has been announced
+    size_t stream_samples_; // Accepted so far, pending chunks included
+    std::map<int, std::vector<int16_t>> pending_chunks_;
+};
@@ -1,7 +1,15 @@
 #include "003-Components/VoiceRecorder.h"
 #include "003-Components/Button.h"
+#include "003-Components/AudioStreamResource.h"
 #include "999-ExternalServices/WhisperCliService.h"
+#include "999-ExternalServices/WhisperDaemonProtocol.h"
+#include "999-ExternalServices/StreamingTranscriber.h"
+#include "999-ExternalServices/CancellationToken.h"
+#include "999-ExternalServices/BackgroundExecutor.h"
+#include "999-ExternalServices/SharedAudioBuffer.h"
+#include "999-ExternalServices/RecordingStorage.h"
 #include <Wt/WApplication.h>
+#include <Wt/WServer.h>
 #include <Wt/WJavaScript.h>
 #include <Wt/WTemplate.h>
 #include <Wt/WText.h>
@@ -13,6 +21,47 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
+#include <fcntl.h>
+#include <unistd.h>
+
+static std::string trimWhitespace(const std::string& text)
+{
+    size_t start = text.find_first_not_of(" \t\n\r");
+    if (start == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t\n\r");
+    return text.substr(start, end - start + 1);
+}
+
+// Live segments of an upload reach the browser at most this often; a fast decoder would
+// otherwise cost one server push per segment
+static constexpr int LIVE_UPDATE_INTERVAL_MS = 250;
+
+// Segments collected on the transcribing thread between two pushes
+struct LiveTranscript {
+    std::mutex mutex;
+    std::string text;
+    int percent = 0;
+    bool has_segment = false;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point last_push;
+};
+
+// Uploads are kept in docroot/audio-files unless wt_config.xml sets archive-uploads to false
+static bool archiveUploadsEnabled()
+{
+    std::string value;
+    return !Wt::WApplication::readConfigurationProperty("archive-uploads", value) || value != "false";
+}
+
+// Live transcription while recording is off unless wt_config.xml sets live-transcription to true
+static bool liveTranscriptionEnabled()
+{
+    std::string value;
+    return Wt::WApplication::readConfigurationProperty("live-transcription", value) && value == "true";
+}
 
 VoiceRecorder::VoiceRecorder() 
     : is_recording_(false), 
@@ -23,7 +72,13 @@ VoiceRecorder::VoiceRecorder()
     is_audio_supported_(false),
     is_microphone_available_(false),
     is_enabled_(true),
-    transcription_in_progress_(false)
+    transcription_in_progress_(false),
+    transcription_cancel_(),
+    stream_resource_(std::make_shared<AudioStreamResource>()),
+    stream_id_(0),
+    streaming_enabled_(liveTranscriptionEnabled()),
+    current_recording_streamed_(false),
+    update_holders_(0)
 {
     // No external dependencies needed - using built-in WAV encoding
     
@@ -72,7 +127,18 @@ VoiceRecorder::~VoiceRecorder()
         recording_timer_->stop();
     }
     
-    // No thread cleanup needed since we use detached threads
+    // Stop a live transcription; its pending UI updates are dropped by bindSafe
+    if (streaming_transcriber_) {
+        streaming_transcriber_->cancel();
+    }
+    stream_resource_->detach();
+    
+    // Also runs when the session expires and the WApplication tears the widget tree down:
+    // drop a queued upload transcription or abort the running one. The executor job
+    // only holds the token and bindSafe callbacks, never this widget.
+    if (transcription_cancel_) {
+        transcription_cancel_->cancel();
+    }
 }
 
 void VoiceRecorder::setupUI()
@@ -148,8 +214,13 @@ void VoiceRecorder::setupUI()
 void VoiceRecorder::startRecording()
 {
     if (!is_recording_) {        
-        // Call the start member function
-        callJavaScriptMember("start", "");
+        current_recording_streamed_ = streaming_enabled_;
+        if (current_recording_streamed_) {
+            startStreamingTranscription();
+        }
+        
+        // Call the start member function (stream id 0 disables chunk streaming)
+        callJavaScriptMember("start", std::to_string(current_recording_streamed_ ? stream_id_ : 0));
         
         is_recording_ = true;
         recording_start_time_ = std::chrono::steady_clock::now();
@@ -189,52 +260,93 @@ void VoiceRecorder::stopRecording()
 void VoiceRecorder::onFileUploaded()
 {
     std::cout << "File uploaded successfully." << std::endl;
+    
+    // One transcription per widget: the spool file is left to Wt, which deletes it
+    if (transcription_in_progress_) {
+        status_text_->setText("Still transcribing the previous recording, please try again when it is done");
+        std::cout << "Upload refused, transcription already in progress" << std::endl;
+        return;
+    }
+    
     std::string tempFileName = file_upload_->spoolFileName();
     std::string clientFileName = file_upload_->clientFileName().toUTF8();
     
-    if (!tempFileName.empty()) {
-        // Create audio-files directory if it doesn't exist
+    if (tempFileName.empty()) {
+        status_text_->setText("Error: No file received for upload");
+        std::cout << "Error: tempFileName is empty" << std::endl;
+        return;
+    }
+    
+    // The spool file is ours from here on; RecordingStorage archives or deletes it
+    file_upload_->stealSpooledFile();
+    
+    std::string permanentPath;
+    if (archiveUploadsEnabled()) {
         std::string audioDir = createAudioFilesDirectory();
-        
         if (!audioDir.empty()) {
             // Generate unique filename to avoid conflicts - force new filename each time
-            std::string uniqueFileName = generateUniqueFileName(clientFileName);
-            std::string permanentPath = audioDir + "/" + uniqueFileName;
-            
-            // Save the uploaded file to the permanent location
-            if (saveAudioFile(tempFileName, permanentPath)) {
-                // Update current audio file path for this recording
-                current_audio_file_ = permanentPath;
-                status_text_->setText("Audio file saved: " + uniqueFileName);
-                std::cout << "Audio file saved: " << permanentPath << std::endl;
-                
-                // Clear any previous transcription to avoid showing old results
-                transcription_display_->setText("⏳ Transcribing audio, please wait...");
-                
-                // Start automatic transcription in background
-                transcribeCurrentAudio();
-            } else {
-                status_text_->setText("Error: Failed to save audio file");
-                std::cout << "Failed to save audio file to: " << permanentPath << std::endl;
-            }
+            permanentPath = audioDir + "/" + generateUniqueFileName(clientFileName);
         } else {
             status_text_->setText("Error: Could not create audio-files directory");
-            // Fallback to using temp file with unique name
-            current_audio_file_ = tempFileName;
-            std::cout << "Using temp file for transcription: " << tempFileName << std::endl;
-            
-            // Clear any previous transcription to avoid showing old results
-            transcription_display_->setText("⏳ Transcribing audio, please wait...");
-            
-            // Start automatic transcription even with temp file
-            transcribeCurrentAudio();
         }
-    } else {
-        status_text_->setText("Error: No file received for upload");
-        std::cout << "Error: tempFileName is empty" << std::endl;
+    }
+    
+    // Held open for the decoder, so the file can be renamed or removed right away.
+    // Streamed recordings are transcribed too: the live text is only a preview
+    int audio_fd = ::open(tempFileName.c_str(), O_RDONLY | O_CLOEXEC);
+    
+    // A rename when the spool and docroot share a file system, otherwise a copy on the I/O pool
+    if (!RecordingStorage::store(tempFileName, permanentPath)) {
+        std::filesystem::remove(tempFileName);
+    }
+    
+    if (audio_fd < 0) {
+        status_text_->setText("Error: Failed to read uploaded audio");
+        return;
+    }
+    
+    Wt::WApplication* app = Wt::WApplication::instance();
+    std::string session_id = app->sessionId();
+    auto on_decoded = bindSafe(std::function<void(std::shared_ptr<SharedAudioBuffer>, std::string)>(
+        [this](std::shared_ptr<SharedAudioBuffer> audio, std::string error_message) {
+            onAudioDecoded(audio, error_message);
+        }));
+    
+    // Clear any previous transcription to avoid showing old results
+    showTranscriptionProgress("⏳ Transcribing audio, please wait...");
+    transcription_in_progress_ = true;
+    acquireUpdates();
+    
+    // Decode once into a memfd the transcriber reads directly; short file work, so the I/O pool
+    bool queued = BackgroundExecutor::getIoInstance().post([audio_fd, tempFileName, session_id, on_decoded]() {
+        std::string error_message;
+        std::shared_ptr<SharedAudioBuffer> audio = SharedAudioBuffer::fromUploadDescriptor(audio_fd, tempFileName, error_message);
+        ::close(audio_fd);
+        Wt::WServer::instance()->post(session_id, [on_decoded, audio, error_message]() {
+            on_decoded(audio, error_message);
+        });
+    });
+    if (!queued) {
+        ::close(audio_fd);
+        onAudioDecoded(nullptr, "Server busy, please try again in a moment");
     }
 }
 
+void VoiceRecorder::onAudioDecoded(std::shared_ptr<SharedAudioBuffer> audio, const std::string& error_message)
+{
+    if (!audio) {
+        std::cout << "Failed to decode upload: " << error_message << std::endl;
+        onTranscriptionFinished("", error_message);
+        return;
+    }
+    
+    current_audio_ = audio;
+    std::cout << "Upload decoded: " << audio->sampleCount() << " samples from " << audio->sourcePath() << std::endl;
+    
+    // Start automatic transcription in background
+    runTranscription();
+}
+
 void VoiceRecorder::onFileTooLarge()
 {
     status_text_->setText("Error: Audio file too large. Please record a shorter audio clip.");
@@ -280,6 +392,98 @@ void VoiceRecorder::setupJavaScriptRecorder()
     setJavaScriptMember("sourceNode", "null");
     setJavaScriptMember("mediaStream", "null");
     
+    // Live streaming state: 16kHz Int16 chunks are POSTed to stream_resource_ while recording
+    setJavaScriptMember("streamUrl", Wt::WWebWidget::jsStringLiteral(stream_resource_->url()));
+    setJavaScriptMember("streamId", "0");
+    setJavaScriptMember("streamSeq", "0");
+    setJavaScriptMember("streamPending", "[]");
+    setJavaScriptMember("streamPendingLength", "0");
+    setJavaScriptMember("streamPos", "0");
+    setJavaScriptMember("streamPrev", "0");
+    
+    // Resample a block of captured audio to 16kHz and send it once 0.5s is buffered.
+    // The fractional read position carries over between blocks so chunk edges stay seamless.
+    setJavaScriptMember("pushStreamSamples", R"(
+        function(input, inputRate) {
+            if (!this.streamId) {
+                return;
+            }
+            var ratio = inputRate / 16000;
+            var out = [];
+            // streamPos is relative to input[0]; -1 addresses the last sample of the previous block
+            var pos = this.streamPos;
+            while (pos < input.length - 1) {
+                var index = Math.floor(pos);
+                var frac = pos - index;
+                var a = index < 0 ? this.streamPrev : input[index];
+                var b = input[index + 1];
+                var sample = Math.max(-1, Math.min(1, a * (1 - frac) + b * frac));
+                out.push(sample < 0 ? sample * 0x8000 : sample * 0x7FFF);
+                pos += ratio;
+            }
+            this.streamPos = pos - input.length;
+            this.streamPrev = input[input.length - 1];
+            
+            if (out.length > 0) {
+                this.streamPending.push(Int16Array.from(out));
+                this.streamPendingLength += out.length;
+            }
+            if (this.streamPendingLength >= 8000) {
+                this.sendStreamChunk(false);
+            }
+        }
+    )");
+    
+    setJavaScriptMember("sendStreamChunk", R"(
+        function(isFinal) {
+            if (!this.streamId) {
+                return;
+            }
+            var chunk = new Int16Array(this.streamPendingLength);
+            var offset = 0;
+            for (var i = 0; i < this.streamPending.length; i++) {
+                chunk.set(this.streamPending[i], offset);
+                offset += this.streamPending[i].length;
+            }
+            this.streamPending = [];
+            this.streamPendingLength = 0;
+            
+            var url = this.streamUrl + (this.streamUrl.indexOf('?') < 0 ? '?' : '&') +
+                      'stream=' + this.streamId + '&seq=' + (this.streamSeq++) + (isFinal ? '&final=1' : '');
+            fetch(url, {
+                method: 'POST',
+                headers: { 'Content-Type': 'application/octet-stream' },
+                body: chunk.buffer
+            }).catch(function(error) {
+                console.error('Failed to stream audio chunk:', error);
+            });
+            
+            if (isFinal) {
+                this.streamId = 0;
+            }
+        }
+    )");
+    
+    // AudioWorklet processor: captures on the audio thread and hands ~2048-frame blocks to the page
+    setJavaScriptMember("workletSource", R"(
+        "class WtRecorderProcessor extends AudioWorkletProcessor {" +
+        "  constructor() { super(); this.blocks = []; this.length = 0; }" +
+        "  process(inputs) {" +
+        "    var input = inputs[0];" +
+        "    if (input && input[0]) {" +
+        "      this.blocks.push(input[0].slice(0)); this.length += input[0].length;" +
+        "      if (this.length >= 2048) {" +
+        "        var merged = new Float32Array(this.length); var offset = 0;" +
+        "        for (var i = 0; i < this.blocks.length; i++) { merged.set(this.blocks[i], offset); offset += this.blocks[i].length; }" +
+        "        this.port.postMessage(merged, [merged.buffer]); this.blocks = []; this.length = 0;" +
+        "      }" +
+        "    }" +
+        "    return true;" +
+        "  }" +
+        "}" +
+        "registerProcessor('wt-recorder-processor', WtRecorderProcessor);"
+    )");
+    
     // WAV encoder helper functions
     setJavaScriptMember("encodeWAV", R"(
         function(samples, sampleRate) {
@@ -319,6 +523,93 @@ void VoiceRecorder::setupJavaScriptRecorder()
         }
     )");
     
+    // Lossless upload encoder, the same stream RiceCodec::encode writes (see RiceCodec.h for the layout)
+    setJavaScriptMember("encodeRice", R"(
+        function(samples, sampleRate) {
+            var BLOCK_SIZE = 4096, PARTITION_SIZE = 256, MAX_ORDER = 3, MAX_K = 20;
+            var count = samples.length;
+            var pcm = new Int16Array(count);
+            for (var i = 0; i < count; i++) {
+                var sample = Math.max(-1, Math.min(1, samples[i]));
+                pcm[i] = sample < 0 ? sample * 0x8000 : sample * 0x7FFF;
+            }
+
+            var out = new Uint8Array(16 + count * 3 + 1024);
+            var pos = 16;
+            var acc = 0, pending = 0;
+            var grow = function() {
+                var bigger = new Uint8Array(out.length * 2);
+                bigger.set(out);
+                out = bigger;
+            };
+            var writeBits = function(value, n) {
+                acc = (acc << n) | value;
+                pending += n;
+                while (pending >= 8) {
+                    pending -= 8;
+                    if (pos >= out.length) grow();
+                    out[pos++] = (acc >>> pending) & 0xFF;
+                }
+                acc &= (1 << pending) - 1;
+            };
+            var writeUnary = function(zeros) {
+                for (; zeros >= 16; zeros -= 16) writeBits(0, 16);
+                writeBits(1, zeros + 1);
+            };
+            var residualAt = function(order, i) {
+                var h1 = i >= 1 ? pcm[i - 1] : 0, h2 = i >= 2 ? pcm[i - 2] : 0, h3 = i >= 3 ? pcm[i - 3] : 0;
+                var prediction = order === 1 ? h1 : order === 2 ? 2 * h1 - h2 : order === 3 ? 3 * h1 - 3 * h2 + h3 : 0;
+                return pcm[i] - prediction;
+            };
+
+            var residuals = new Uint32Array(PARTITION_SIZE);
+            for (var block = 0; block < count; block += BLOCK_SIZE) {
+                var blockEnd = Math.min(block + BLOCK_SIZE, count);
+                var order = 0, bestSum = Infinity;
+                for (var candidate = 0; candidate <= MAX_ORDER; candidate++) {
+                    var sum = 0;
+                    for (var i = block; i < blockEnd; i++) sum += Math.abs(residualAt(candidate, i));
+                    if (sum < bestSum) { bestSum = sum; order = candidate; }
+                }
+                writeBits(order, 2);
+
+                for (var partition = block; partition < blockEnd; partition += PARTITION_SIZE) {
+                    var length = Math.min(partition + PARTITION_SIZE, blockEnd) - partition;
+                    var total = 0;
+                    for (var i = 0; i < length; i++) {
+                        var r = residualAt(order, partition + i);
+                        residuals[i] = (r << 1) ^ (r >> 31);
+                        total += residuals[i];
+                    }
+                    var estimate = 0;
+                    while (estimate < MAX_K && length * Math.pow(2, estimate + 1) <= total) estimate++;
+                    var k = estimate, bestBits = Infinity;
+                    for (var candidate = Math.max(0, estimate - 1); candidate <= Math.min(MAX_K, estimate + 1); candidate++) {
+                        var bits = length * (candidate + 1);
+                        for (var i = 0; i < length; i++) bits += residuals[i] >>> candidate;
+                        if (bits < bestBits) { bestBits = bits; k = candidate; }
+                    }
+
+                    writeBits(k, 5);
+                    var lowMask = (1 << k) - 1;
+                    for (var i = 0; i < length; i++) {
+                        writeUnary(residuals[i] >>> k);
+                        writeBits(residuals[i] & lowMask, k);
+                    }
+                }
+            }
+            if (pending > 0) writeBits(0, 8 - pending);
+
+            var view = new DataView(out.buffer);
+            view.setUint8(0, 0x57); view.setUint8(1, 0x52); view.setUint8(2, 0x43); view.setUint8(3, 0x31); // WRC1
+            view.setUint32(4, sampleRate, true);
+            view.setUint32(8, count, true);
+            view.setUint16(12, BLOCK_SIZE, true);
+            view.setUint16(14, PARTITION_SIZE, true);
+            return out.buffer.slice(0, pos);
+        }
+    )");
+
     // Resampling function to convert to 16kHz
     setJavaScriptMember("resampleTo16kHz", R"(
         function(audioBuffer) {
@@ -416,9 +707,16 @@ void VoiceRecorder::setupJavaScriptRecorder()
 
     // Start recording function
     setJavaScriptMember("start", R"(
-        function() {
+        function(streamId) {
             var self = this;
             
+            self.streamId = streamId || 0;
+            self.streamSeq = 0;
+            self.streamPending = [];
+            self.streamPendingLength = 0;
+            self.streamPos = 0;
+            self.streamPrev = 0;
+            
             console.log('Start function called, supported:', this.isSupported);
             
             if (!this.isSupported) {
@@ -453,26 +751,50 @@ void VoiceRecorder::setupJavaScriptRecorder()
                 
                 // Create audio nodes
                 self.sourceNode = self.audioContext.createMediaStreamSource(stream);
+                var sampleRate = self.audioContext.sampleRate;
                 
-                // Create ScriptProcessorNode for capturing audio data
-                var bufferSize = 4096;
-                self.processorNode = self.audioContext.createScriptProcessor(bufferSize, 1, 1);
+                var onSamples = function(samples) {
+                    self.recordedSamples.push(samples);
+                    self.pushStreamSamples(samples, sampleRate);
+                };
                 
-                self.processorNode.onaudioprocess = function(event) {
-                    var inputBuffer = event.inputBuffer;
-                    var inputData = inputBuffer.getChannelData(0);
+                var useScriptProcessor = function() {
+                    // Create ScriptProcessorNode for capturing audio data
+                    var bufferSize = 4096;
+                    self.processorNode = self.audioContext.createScriptProcessor(bufferSize, 1, 1);
                     
-                    // Copy the audio data
-                    var samples = new Float32Array(inputData.length);
-                    for (var i = 0; i < inputData.length; i++) {
-                        samples[i] = inputData[i];
-                    }
-                    self.recordedSamples.push(samples);
+                    self.processorNode.onaudioprocess = function(event) {
+                        // Copy the audio data
+                        onSamples(new Float32Array(event.inputBuffer.getChannelData(0)));
+                    };
+                    
+                    // Connect the audio nodes
+                    self.sourceNode.connect(self.processorNode);
+                    self.processorNode.connect(self.audioContext.destination);
                 };
                 
-                // Connect the audio nodes
-                self.sourceNode.connect(self.processorNode);
-                self.processorNode.connect(self.audioContext.destination);
+                if (self.audioContext.audioWorklet && window.AudioWorkletNode) {
+                    // Capture off the main thread; fall back to ScriptProcessor if the module fails to load
+                    var moduleUrl = URL.createObjectURL(new Blob([self.workletSource], { type: 'application/javascript' }));
+                    var context = self.audioContext;
+                    context.audioWorklet.addModule(moduleUrl).then(function() {
+                        URL.revokeObjectURL(moduleUrl);
+                        if (self.audioContext !== context || !self.sourceNode) {
+                            return; // Stopped while the module was loading
+                        }
+                        self.processorNode = new AudioWorkletNode(context, 'wt-recorder-processor');
+                        self.processorNode.port.onmessage = function(event) {
+                            onSamples(event.data);
+                        };
+                        self.sourceNode.connect(self.processorNode);
+                        self.processorNode.connect(context.destination);
+                    }).catch(function(error) {
+                        console.warn('AudioWorklet unavailable, using ScriptProcessor:', error);
+                        useScriptProcessor();
+                    });
+                } else {
+                    useScriptProcessor();
+                }
                 
                 console.log('Audio recording started with Web Audio API');
                 console.log('Status: Recording audio... Speak now');
@@ -506,6 +828,9 @@ void VoiceRecorder::setupJavaScriptRecorder()
                 self.sourceNode = null;
             }
             if (self.processorNode) {
+                if (self.processorNode.port) {
+                    self.processorNode.port.onmessage = null;
+                }
                 self.processorNode.disconnect();
                 self.processorNode = null;
             }
@@ -514,6 +839,11 @@ void VoiceRecorder::setupJavaScriptRecorder()
             self.mediaStream.getTracks().forEach(track => track.stop());
             self.mediaStream = null;
             
+            // Send the last partial chunk so the server can finalize the live transcription
+            if (self.streamId) {
+                self.sendStreamChunk(true);
+            }
+            
             // Process recorded audio data
             if (self.recordedSamples.length === 0) {
                 console.log('No audio data recorded');
@@ -571,9 +901,11 @@ void VoiceRecorder::setupJavaScriptRecorder()
             if (fileUploadElement) {
                 var fileInput = fileUploadElement.querySelector('input[type="file"]');
                 if (fileInput) {
-                    // Create a File object from the WAV blob
-                    var audioFile = new File([self.recordedBlob], 'recorded_audio_16khz_mono.wav', { 
-                        type: 'audio/wav',
+                    // The WAV blob is only for local playback; the upload is the lossless compact encoding
+                    var riceBuffer = self.encodeRice(resampledData, 16000);
+                    console.log('Encoded upload:', riceBuffer.byteLength, 'bytes (WAV:', wavBuffer.byteLength, ')');
+                    var audioFile = new File([riceBuffer], 'recorded_audio_16khz_mono.wrc', { 
+                        type: 'application/octet-stream',
                         lastModified: Date.now()
                     });
                     
@@ -586,7 +918,7 @@ void VoiceRecorder::setupJavaScriptRecorder()
                     var changeEvent = new Event('change', { bubbles: true });
                     fileInput.dispatchEvent(changeEvent);
                     
-                    console.log('16kHz WAV file set to upload widget:', audioFile.name, audioFile.size, 'bytes');
+                    console.log('16kHz recording set to upload widget:', audioFile.name, audioFile.size, 'bytes');
                     )" + js_signal_audio_widget_has_media_.createCall({"true"}) + R"(
                 
                 } else {
@@ -611,7 +943,7 @@ void VoiceRecorder::setupJavaScriptRecorder()
 
 void VoiceRecorder::transcribeCurrentAudio()
 {
-    if (current_audio_file_.empty()) {
+    if (!current_audio_) {
         transcription_display_->setText("No audio file to transcribe");
         return;
     }
@@ -622,98 +954,264 @@ void VoiceRecorder::transcribeCurrentAudio()
         return;
     }
     
+    // Mark transcription as in progress
+    transcription_in_progress_ = true;
+    acquireUpdates();
+    runTranscription();
+}
+
+void VoiceRecorder::runTranscription()
+{
     // Log the file being transcribed for debugging
-    std::cout << "Starting transcription for file: " << current_audio_file_ << std::endl;
+    std::cout << "Starting transcription for upload: " << current_audio_->sourcePath() << std::endl;
     
     // Show loading message in transcription area
-    transcription_display_->setText("⏳ Transcribing audio, please wait...");
-    
-    // Mark transcription as in progress
-    transcription_in_progress_ = true;
+    showTranscriptionProgress("⏳ Transcribing audio, please wait...");
     
-    // Get the application instance to enable server push
     Wt::WApplication* app = Wt::WApplication::instance();
-    app->enableUpdates(true);
     
-    // Capture the current audio file path to avoid race conditions
-    std::string audio_file_to_transcribe = current_audio_file_;
+    // Queue position updates come from a scheduler thread; bindSafe drops them once this widget is gone
+    std::string session_id = app->sessionId();
+    auto show_position = bindSafe(std::function<void(size_t)>([this](size_t position) {
+        onQueuePosition(position);
+    }));
+    auto on_queue_position = [session_id, show_position](size_t position) {
+        Wt::WServer::instance()->post(session_id, [show_position, position]() {
+            show_position(position);
+        });
+    };
     
-    // Create and detach a new thread for each transcription
-    // No need to manage thread lifetime - it cleans up automatically
-    std::thread([this, app, audio_file_to_transcribe]() {
-        this->performTranscriptionInBackground(app, audio_file_to_transcribe);
-    }).detach();
-}
-
-void VoiceRecorder::performTranscriptionInBackground(Wt::WApplication* app, const std::string& audio_file_path)
-{
-    std::string transcription_result;
-    std::string error_message;
+    // Segments are shown as whisper finishes them. Pushes are spaced LIVE_UPDATE_INTERVAL_MS apart;
+    // what is held back goes out with the next one, or is covered by the final result
+    auto live = std::make_shared<LiveTranscript>();
+    auto show_live = bindSafe(std::function<void(std::string, int)>([this](std::string text, int percent) {
+        onLiveTranscript(text, percent);
+    }));
+    auto push_live = [session_id, show_live, live](std::unique_lock<std::mutex>& lock) {
+        auto now = std::chrono::steady_clock::now();
+        if (now - live->last_push < std::chrono::milliseconds(LIVE_UPDATE_INTERVAL_MS)) {
+            return;
+        }
+        live->last_push = now;
+        std::string text = live->text;
+        int percent = live->percent;
+        lock.unlock();
+        Wt::WServer::instance()->post(session_id, [show_live, text, percent]() {
+            show_live(text, percent);
+        });
+    };
+    TranscriptListener listener;
+    listener.on_segment = [live, push_live](const TranscriptSegment& segment) {
+        std::unique_lock<std::mutex> lock(live->mutex);
+        if (!live->has_segment) {
+            live->has_segment = true;
+            std::cout << "First segment after " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - live->started).count() << " ms" << std::endl;
+        }
+        live->text += segment.text;
+        push_live(lock);
+    };
+    listener.on_progress = [live, push_live](int percent) {
+        std::unique_lock<std::mutex> lock(live->mutex);
+        live->percent = percent;
+        push_live(lock);
+    };
     
-    std::cout << "Background transcription started for: " << audio_file_path << std::endl;
+    // Results are delivered through WServer::post, so a widget destroyed in the meantime is never touched
+    auto cancel_token = CancellationToken::create();
+    transcription_cancel_ = cancel_token;
+    auto on_finished = bindSafe(std::function<void(std::string, std::string)>(
+        [this](std::string transcription_result, std::string error_message) {
+            onTranscriptionFinished(transcription_result, error_message);
+        }));
     
-    try {
-        // Create WhisperCliService only when needed
-        auto whisper_client = std::make_unique<WhisperCliService>();
-        
-        // Build paths relative to the current working directory (build/release or build/debug)
-        std::string whisper_executable_path = "./whisper_service";  // In current build directory
-        std::string model_path = "/apps/cv/models/ggml-base.en.bin";   // Absolute path for Docker container
-        
-        if (!whisper_client->initialize(whisper_executable_path, model_path)) {
-            error_message = "Failed to initialize Whisper service: " + whisper_client->getLastError();
-        } else {
-            std::cout << "WhisperCliService initialized successfully" << std::endl;
-            
-            // Use the synchronous API to transcribe the specific file
-            transcription_result = whisper_client->transcribeFile(audio_file_path);
-            
-            // Check if the result indicates an error
+    // The job waits in TranscriptionScheduler and reports back from its worker, so no thread is
+    // held while this session waits its turn however many sessions transcribe at once
+    WhisperCliService whisper_client;
+    whisper_client.initialize(WhisperCliService::defaultExecutablePath(), WhisperCliService::defaultModelPath());
+    // Keep the model loaded in a long-running whisper_service instead of reloading it per clip
+    whisper_client.enableDaemon(WhisperDaemonProtocol::defaultSocketPath());
+    // Recordings usually start and end with a few seconds of silence
+    whisper_client.setVadEnabled(true);
+    // Share the transcriber fairly with other sessions and report our place in line
+    whisper_client.setQueueContext(session_id, on_queue_position);
+    // Stop waiting/inferring as soon as the widget is destroyed
+    whisper_client.setCancellationToken(cancel_token);
+    // Show segments while the rest of the clip is still decoding
+    whisper_client.setTranscriptListener(listener);
+    
+    bool queued = whisper_client.transcribeAudioAsync(current_audio_,
+        [session_id, cancel_token, on_finished](const std::string& result) {
+            if (cancel_token->isCancelled()) {
+                return; // The widget or session is gone
+            }
+            std::string transcription_result = result;
+            std::string error_message;
             if (transcription_result.find("ERROR:") == 0) {
                 error_message = transcription_result.substr(6); // Remove "ERROR:" prefix
                 transcription_result.clear();
             }
-        }
-    } catch (const std::exception& e) {
-        error_message = "Exception during transcription: " + std::string(e.what());
+            Wt::WServer::instance()->post(session_id, [on_finished, transcription_result, error_message]() {
+                on_finished(transcription_result, error_message);
+            });
+        });
+    if (!queued) {
+        onTranscriptionFinished("", "Server busy, please try again in a moment");
+    }
+}
+
+void VoiceRecorder::onQueuePosition(size_t position)
+{
+    if (!transcription_in_progress_) {
+        return; // Late update of a transcription that already finished
     }
     
-    // Update the UI thread-safely using the application update lock
-    Wt::WApplication::UpdateLock uiLock(app);
-    if (uiLock) {
-        if (!transcription_result.empty()) {
-            // Success - only show the transcription text, no status messages
-            current_transcription_ = transcription_result;
-            transcription_display_->setText(transcription_result);
-            status_text_->setText("Transcription complete ✓");
-            
-            // Emit signal for external handlers
-            transcription_complete_.emit(transcription_result);
-            
-            std::cout << "Transcription completed: " << transcription_result << std::endl;
-        } else {
-            // Error
-            std::string error_text = "Transcription failed";
-            if (!error_message.empty()) {
-                error_text += ": " + error_message;
-            }
-            
-            transcription_display_->setText(error_text);
-            
-            std::cout << "Transcription failed: " << error_message << std::endl;
-        }
+    if (position == 0) {
+        showTranscriptionProgress("⏳ Transcribing audio, please wait...");
+    } else {
+        showTranscriptionProgress("⏳ Waiting for a free transcriber, you are #" + std::to_string(position) + " in line");
+    }
+    Wt::WApplication::instance()->triggerUpdate();
+}
+
+void VoiceRecorder::onLiveTranscript(const std::string& text, int percent)
+{
+    if (!transcription_in_progress_) {
+        return; // Late update of a transcription that already finished
+    }
+    
+    // A live preview of the whole recording is further along than the first segments
+    std::string trimmed = trimWhitespace(text);
+    if (!trimmed.empty() && !current_recording_streamed_) {
+        transcription_display_->setText(trimmed);
+    }
+    status_text_->setText("⏳ Transcribing... " + std::to_string(percent) + "%");
+    Wt::WApplication::instance()->triggerUpdate();
+}
+
+void VoiceRecorder::onTranscriptionFinished(const std::string& transcription_result, const std::string& error_message)
+{
+    if (!transcription_result.empty()) {
+        // Success - only show the transcription text, no status messages
+        current_transcription_ = transcription_result;
+        transcription_display_->setText(transcription_result);
+        status_text_->setText("Transcription complete ✓");
         
-        // Mark transcription as completed
-        transcription_in_progress_ = false;
+        // Emit signal for external handlers
+        transcription_complete_.emit(transcription_result);
         
-        // Trigger UI update
-        app->triggerUpdate();
+        std::cout << "Transcription completed: " << transcription_result << std::endl;
+    } else {
+        // Error
+        std::string error_text = "Transcription failed";
+        if (!error_message.empty()) {
+            error_text += ": " + error_message;
+        }
         
-        // Disable server push when done
-        app->enableUpdates(false);
+        transcription_display_->setText(error_text);
+        status_text_->setText("Transcription failed");
+        
+        std::cout << "Transcription failed: " << error_message << std::endl;
+    }
+    
+    // Mark transcription as completed
+    transcription_in_progress_ = false;
+    transcription_cancel_.reset();
+    current_audio_.reset();
+    
+    // The recording's own transcription replaces its live preview; a new recording keeps its stream
+    if (streaming_transcriber_ && !is_recording_) {
+        streaming_transcriber_->cancel();
+        streaming_transcriber_.reset();
+        stream_resource_->detach();
+        releaseUpdates();
+    }
+    
+    // Trigger UI update
+    Wt::WApplication::instance()->triggerUpdate();
+    
+    // Disable server push when done, unless a new recording's stream still uses it
+    releaseUpdates();
+}
+
+void VoiceRecorder::startStreamingTranscription()
+{
+    // The replaced stream's push hold passes to this one
+    if (streaming_transcriber_) {
+        streaming_transcriber_->cancel();
+    } else {
+        acquireUpdates();
     }
     
-    // Thread will be automatically cleaned up when this function exits
+    int stream_id = ++stream_id_;
+    Wt::WApplication* app = Wt::WApplication::instance();
+    std::string session_id = app->sessionId();
+    
+    // bindSafe turns updates that arrive after this widget is gone into no-ops
+    auto on_update = bindSafe(std::function<void(int, StreamingUpdate)>([this](int id, StreamingUpdate update) {
+        onStreamingUpdate(id, update);
+    }));
+    
+    streaming_transcriber_ = StreamingTranscriber::create(
+        WhisperCliService::defaultExecutablePath(), WhisperCliService::defaultModelPath(), WhisperDaemonProtocol::defaultSocketPath(),
+        session_id,
+        [session_id, stream_id, on_update](const StreamingUpdate& update) {
+            Wt::WServer::instance()->post(session_id, [on_update, stream_id, update]() {
+                on_update(stream_id, update);
+            });
+        });
+    stream_resource_->attach(stream_id, streaming_transcriber_);
+    
+    transcription_display_->setText("");
+    std::cout << "Started streaming transcription " << stream_id << std::endl;
+}
+
+void VoiceRecorder::onStreamingUpdate(int stream_id, const StreamingUpdate& update)
+{
+    if (stream_id != stream_id_ || !streaming_transcriber_) {
+        return; // Update of a recording that has been replaced or already transcribed from its upload
+    }
+    
+    // Only a preview: onTranscriptionFinished() shows the uploaded recording's transcription
+    std::string text = trimWhitespace(update.committed_text + update.partial_text);
+    if (!text.empty()) {
+        transcription_display_->setText(text);
+    }
+    if (!is_recording_ && !transcription_in_progress_) {
+        status_text_->setText("⏳ Finishing transcription...");
+    }
+    
+    Wt::WApplication::instance()->triggerUpdate();
+    if (update.final) {
+        streaming_transcriber_.reset();
+        std::cout << "Streaming transcription " << stream_id << " completed: " << text
+                  << (update.error.empty() ? "" : " (" + update.error + ")") << std::endl;
+        releaseUpdates();
+    }
+}
+
+void VoiceRecorder::showTranscriptionProgress(const std::string& message)
+{
+    // A streamed recording keeps its live preview in view until the result replaces it
+    if (current_recording_streamed_) {
+        status_text_->setText(message);
+    } else {
+        transcription_display_->setText(message);
+    }
+}
+
+void VoiceRecorder::acquireUpdates()
+{
+    if (update_holders_++ == 0) {
+        Wt::WApplication::instance()->enableUpdates(true);
+    }
+}
+
+void VoiceRecorder::releaseUpdates()
+{
+    if (update_holders_ > 0 && --update_holders_ == 0) {
+        Wt::WApplication::instance()->enableUpdates(false);
+    }
 }
 
 std::string VoiceRecorder::getTranscription() const
@@ -765,43 +1263,6 @@ std::string VoiceRecorder::generateUniqueFileName(const std::string& originalNam
     return "audio_" + ss.str() + extension;
 }
 
-bool VoiceRecorder::saveAudioFile(const std::string& tempPath, const std::string& permanentPath)
-{
-    try {
-        std::ifstream src(tempPath, std::ios::binary);
-        if (!src.is_open()) {
-            std::cerr << "Cannot open source file: " << tempPath << std::endl;
-            return false;
-        }
-        
-        std::ofstream dst(permanentPath, std::ios::binary);
-        if (!dst.is_open()) {
-            std::cerr << "Cannot create destination file: " << permanentPath << std::endl;
-            src.close();
-            return false;
-        }
-        
-        // Copy file contents
-        dst << src.rdbuf();
-        
-        src.close();
-        dst.close();
-        
-        // Verify the file was created successfully
-        if (std::filesystem::exists(permanentPath)) {
-            std::cout << "Successfully saved audio file: " << permanentPath << std::endl;
-            return true;
-        } else {
-            std::cerr << "File save verification failed: " << permanentPath << std::endl;
-            return false;
-        }
-        
-    } catch (const std::exception& e) {
-        std::cerr << "Exception while saving audio file: " << e.what() << std::endl;
-        return false;
-    }
-}
-
 void VoiceRecorder::updateRecordingTimer()
 {
     if (is_recording_) {
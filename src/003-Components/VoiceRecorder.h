@@ -12,11 +12,17 @@
 #include <Wt/WSignal.h>
 #include <Wt/WTimer.h>
 #include <memory>
+#include <functional>
 #include <thread>
 #include <chrono>
 
 class Button; // Forward declaration
 class WhisperServiceClient; // Forward declaration
+class AudioStreamResource; // Forward declaration
+class StreamingTranscriber; // Forward declaration
+struct StreamingUpdate; // Forward declaration
+class CancellationToken; // Forward declaration
+class SharedAudioBuffer; // Forward declaration
 
 
 class VoiceRecorder : public Wt::WContainerWidget
@@ -32,6 +38,10 @@ public:
     void transcribeCurrentAudio();
     std::string getTranscription() const;
     
+    // Live preview: stream PCM chunks while recording; the uploaded clip is still transcribed
+    // afterwards and replaces the preview. Defaults to wt_config.xml's live-transcription (off)
+    void setStreamingEnabled(bool enabled) { streaming_enabled_ = enabled; }
+    
     // Signal for when transcription is complete
     Wt::Signal<std::string>& transcriptionComplete() { return transcription_complete_; }
 
@@ -43,12 +53,21 @@ private:
     void onFileUploaded();
     void onFileTooLarge();
     void uploadFile();
-    void performTranscriptionInBackground(Wt::WApplication* app, const std::string& audio_file_path);
+    void onAudioDecoded(std::shared_ptr<SharedAudioBuffer> audio, const std::string& error_message);
+    void runTranscription();
+    void onQueuePosition(size_t position);
+    void onLiveTranscript(const std::string& text, int percent);
+    void onTranscriptionFinished(const std::string& transcription_result, const std::string& error_message);
+    void startStreamingTranscription();
+    void onStreamingUpdate(int stream_id, const StreamingUpdate& update);
+    void showTranscriptionProgress(const std::string& message);
+    // Server push stays on while the upload transcription or the live stream still needs it
+    void acquireUpdates();
+    void releaseUpdates();
     
     // Audio file management
     std::string createAudioFilesDirectory();
     std::string generateUniqueFileName(const std::string& originalName);
-    bool saveAudioFile(const std::string& tempPath, const std::string& permanentPath);
     
     // Timer management
     void updateRecordingTimer();
@@ -75,10 +94,22 @@ private:
     
     // Transcription data
     std::string current_transcription_;
-    std::string current_audio_file_;
+    // Last upload decoded into a memfd; released once its transcription finishes
+    std::shared_ptr<SharedAudioBuffer> current_audio_;
     Wt::Signal<std::string> transcription_complete_;
     
-    // Simple flag to prevent multiple simultaneous transcriptions
+    // Set from an accepted upload until its transcription finishes; further uploads are refused meanwhile
     bool transcription_in_progress_;
+    // Cancelled when the widget goes away (including session expiry) so queued/running inference stops
+    std::shared_ptr<CancellationToken> transcription_cancel_;
+    
+    // Streaming transcription state
+    std::shared_ptr<AudioStreamResource> stream_resource_;
+    std::shared_ptr<StreamingTranscriber> streaming_transcriber_;
+    int stream_id_;
+    bool streaming_enabled_;
+    bool current_recording_streamed_;
+    // acquireUpdates() calls not yet released
+    int update_holders_;
 
 };
@@ -0,0 +1,274 @@
+#include "PcmDecoder.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define PCM_DECODER_X86 1
+#include <immintrin.h>
+#endif
+
+// Channel sums are scaled once; 1/32768 and 1/65536 are exact, so mono and stereo
+// results are bit-identical to the per-sample division they replace
+static inline float scaleFor(int channels) {
+    return 1.0f / (32768.0f * static_cast<float>(channels));
+}
+
+static void int16ToMonoScalar(const int16_t* src, size_t frames, int channels, float* dst) {
+    const float scale = scaleFor(channels);
+
+    if (channels == 1) {
+        for (size_t i = 0; i < frames; ++i) {
+            dst[i] = static_cast<float>(src[i]) * scale;
+        }
+        return;
+    }
+
+    if (channels == 2) {
+        for (size_t i = 0; i < frames; ++i) {
+            dst[i] = static_cast<float>(static_cast<int32_t>(src[2 * i]) + src[2 * i + 1]) * scale;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < frames; ++i) {
+        const int16_t* frame = src + i * channels;
+        int32_t sum = 0;
+        for (int ch = 0; ch < channels; ++ch) {
+            sum += frame[ch];
+        }
+        dst[i] = static_cast<float>(sum) * scale;
+    }
+}
+
+#ifdef PCM_DECODER_X86
+
+__attribute__((target("sse2")))
+static void int16ToMonoSse2(const int16_t* src, size_t frames, int channels, float* dst) {
+    const float scale = scaleFor(channels);
+    const __m128 scale_v = _mm_set1_ps(scale);
+    size_t i = 0;
+
+    if (channels == 1) {
+        for (; i + 8 <= frames; i += 8) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            // Sign-extend by placing each sample in the high half and shifting back down
+            __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+            __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale_v));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale_v));
+        }
+    } else if (channels == 2) {
+        // madd with ones adds each L/R pair into one int32
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; i + 8 <= frames; i += 8) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 2 * i + 8));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_madd_epi16(a, ones)), scale_v));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_madd_epi16(b, ones)), scale_v));
+        }
+    }
+
+    int16ToMonoScalar(src + i * channels, frames - i, channels, dst + i);
+}
+
+__attribute__((target("avx2")))
+static void int16ToMonoAvx2(const int16_t* src, size_t frames, int channels, float* dst) {
+    const float scale = scaleFor(channels);
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    size_t i = 0;
+
+    if (channels == 1) {
+        for (; i + 16 <= frames; i += 16) {
+            __m256i lo = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+            __m256i hi = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8)));
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), scale_v));
+            _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), scale_v));
+        }
+    } else if (channels == 2) {
+        // madd works per 128-bit lane, which keeps the frames in order
+        const __m256i ones = _mm256_set1_epi16(1);
+        for (; i + 16 <= frames; i += 16) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 2 * i + 16));
+            _mm256_storeu_ps(dst + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(a, ones)), scale_v));
+            _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_madd_epi16(b, ones)), scale_v));
+        }
+    }
+
+    int16ToMonoScalar(src + i * channels, frames - i, channels, dst + i);
+}
+
+#endif // PCM_DECODER_X86
+
+void PcmDecoder::int16ToMono(const int16_t* src, size_t frames, int channels, float* dst) {
+    static const Isa best = detectIsa();
+    int16ToMono(src, frames, channels, dst, best);
+}
+
+void PcmDecoder::int16ToMono(const int16_t* src, size_t frames, int channels, float* dst, Isa isa) {
+    if (channels < 1 || frames == 0) {
+        return;
+    }
+    if (!isSupported(isa)) {
+        isa = Isa::Scalar;
+    }
+
+    switch (isa) {
+#ifdef PCM_DECODER_X86
+        case Isa::Avx2:
+            int16ToMonoAvx2(src, frames, channels, dst);
+            return;
+        case Isa::Sse2:
+            int16ToMonoSse2(src, frames, channels, dst);
+            return;
+#endif
+        default:
+            int16ToMonoScalar(src, frames, channels, dst);
+            return;
+    }
+}
+
+// Little-endian sample readers; memcpy keeps unaligned data chunks well-defined
+template <PcmDecoder::Encoding E>
+static inline double readSample(const unsigned char* p);
+
+template <>
+inline double readSample<PcmDecoder::Encoding::UInt8>(const unsigned char* p) {
+    return (static_cast<int>(p[0]) - 128) / 128.0;
+}
+
+template <>
+inline double readSample<PcmDecoder::Encoding::Int16>(const unsigned char* p) {
+    int16_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value / 32768.0;
+}
+
+template <>
+inline double readSample<PcmDecoder::Encoding::Int24>(const unsigned char* p) {
+    // Assemble into the top three bytes so the arithmetic shift sign-extends
+    int32_t value = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                                         (static_cast<uint32_t>(p[1]) << 16) |
+                                         (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+    return value / 8388608.0;
+}
+
+template <>
+inline double readSample<PcmDecoder::Encoding::Int32>(const unsigned char* p) {
+    int32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value / 2147483648.0;
+}
+
+template <>
+inline double readSample<PcmDecoder::Encoding::Float32>(const unsigned char* p) {
+    float value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <>
+inline double readSample<PcmDecoder::Encoding::Float64>(const unsigned char* p) {
+    double value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+template <PcmDecoder::Encoding E>
+static void genericToMono(const unsigned char* src, size_t frames, int channels, size_t sample_bytes, float* dst) {
+    const size_t frame_bytes = sample_bytes * channels;
+    for (size_t i = 0; i < frames; ++i) {
+        const unsigned char* frame = src + i * frame_bytes;
+        double sum = 0.0;
+        for (int ch = 0; ch < channels; ++ch) {
+            sum += readSample<E>(frame + ch * sample_bytes);
+        }
+        dst[i] = static_cast<float>(sum / channels);
+    }
+}
+
+void PcmDecoder::toMono(const void* src, size_t frames, int channels, Encoding encoding, float* dst) {
+    if (channels < 1 || frames == 0) {
+        return;
+    }
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(src);
+    const size_t sample_bytes = bytesPerSample(encoding);
+
+    switch (encoding) {
+        case Encoding::Int16:
+            if (reinterpret_cast<uintptr_t>(src) % alignof(int16_t) == 0) {
+                int16ToMono(static_cast<const int16_t*>(src), frames, channels, dst);
+            } else {
+                genericToMono<Encoding::Int16>(bytes, frames, channels, sample_bytes, dst);
+            }
+            return;
+        case Encoding::UInt8:
+            genericToMono<Encoding::UInt8>(bytes, frames, channels, sample_bytes, dst);
+            return;
+        case Encoding::Int24:
+            genericToMono<Encoding::Int24>(bytes, frames, channels, sample_bytes, dst);
+            return;
+        case Encoding::Int32:
+            genericToMono<Encoding::Int32>(bytes, frames, channels, sample_bytes, dst);
+            return;
+        case Encoding::Float32:
+            genericToMono<Encoding::Float32>(bytes, frames, channels, sample_bytes, dst);
+            return;
+        case Encoding::Float64:
+            genericToMono<Encoding::Float64>(bytes, frames, channels, sample_bytes, dst);
+            return;
+    }
+}
+
+size_t PcmDecoder::bytesPerSample(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::UInt8:
+            return 1;
+        case Encoding::Int16:
+            return 2;
+        case Encoding::Int24:
+            return 3;
+        case Encoding::Int32:
+        case Encoding::Float32:
+            return 4;
+        case Encoding::Float64:
+            return 8;
+    }
+    return 0;
+}
+
+PcmDecoder::Isa PcmDecoder::detectIsa() {
+    if (isSupported(Isa::Avx2)) {
+        return Isa::Avx2;
+    }
+    if (isSupported(Isa::Sse2)) {
+        return Isa::Sse2;
+    }
+    return Isa::Scalar;
+}
+
+bool PcmDecoder::isSupported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef PCM_DECODER_X86
+        case Isa::Sse2:
+            return __builtin_cpu_supports("sse2");
+        case Isa::Avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* PcmDecoder::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2:
+            return "avx2";
+        case Isa::Sse2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief PcmDecoder - Converts interleaved integer PCM to the mono float32 whisper expects
+ *
+ * Samples are scaled to [-1, 1) and all channels are averaged into one. The SSE2 and
+ * AVX2 kernels are compiled into the same binary and selected once at runtime from
+ * the CPU features, so the executable still runs on machines without AVX2; other
+ * architectures use the scalar kernel.
+ */
+class PcmDecoder {
+public:
+    enum class Isa { Scalar, Sse2, Avx2 };
+
+    // Sample layouts found in WAV data chunks (little-endian)
+    enum class Encoding { UInt8, Int16, Int24, Int32, Float32, Float64 };
+
+    /**
+     * @brief Decode int16 frames to mono float with the best kernel for this CPU
+     * @param src Interleaved samples, frames * channels values
+     * @param frames Number of frames (one sample per channel each)
+     * @param channels Channel count, at least 1
+     * @param dst Output buffer with room for frames values
+     */
+    static void int16ToMono(const int16_t* src, size_t frames, int channels, float* dst);
+
+    /**
+     * @brief Same as above with an explicit kernel (falls back to Scalar if the CPU lacks it)
+     */
+    static void int16ToMono(const int16_t* src, size_t frames, int channels, float* dst, Isa isa);
+
+    /**
+     * @brief Decode any supported encoding to mono float (int16 goes through the SIMD kernels)
+     * @param src Interleaved samples, no alignment requirement
+     */
+    static void toMono(const void* src, size_t frames, int channels, Encoding encoding, float* dst);
+
+    static size_t bytesPerSample(Encoding encoding);
+
+    // Best kernel supported by the running CPU
+    static Isa detectIsa();
+    static bool isSupported(Isa isa);
+    static const char* isaName(Isa isa);
+};
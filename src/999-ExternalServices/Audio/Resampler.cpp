@@ -0,0 +1,235 @@
+#include "Resampler.h"
+#include <algorithm>
+#include <cmath>
+#include <list>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <utility>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define RESAMPLER_X86 1
+#include <immintrin.h>
+#endif
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window
+static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    const double quarter_x_squared = x * x / 4.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= quarter_x_squared / (static_cast<double>(k) * k);
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+static float dotScalar(const float* x, const float* h, size_t taps) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < taps; ++i) {
+        sum += x[i] * h[i];
+    }
+    return sum;
+}
+
+#ifdef RESAMPLER_X86
+
+__attribute__((target("sse2")))
+static float dotSse2(const float* x, const float* h, size_t taps) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t i = 0; i < taps; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + i), _mm_loadu_ps(h + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + i + 4), _mm_loadu_ps(h + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+}
+
+__attribute__((target("avx2,fma")))
+static float dotAvx2(const float* x, const float* h, size_t taps) {
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t i = 0; i < taps; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(h + i), acc);
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+#endif // RESAMPLER_X86
+
+using DotFunction = float (*)(const float*, const float*, size_t);
+
+// taps is always a multiple of 8
+static DotFunction selectDot() {
+#ifdef RESAMPLER_X86
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return dotAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return dotSse2;
+    }
+#endif
+    return dotScalar;
+}
+
+Resampler::Resampler(int input_rate, int output_rate)
+    : bank_(filterBank(input_rate, output_rate))
+{
+}
+
+using RatePair = std::pair<int, int>;
+using BankPointer = std::shared_ptr<const ResamplerFilterBank>;
+
+static std::mutex banks_mutex;
+// prewarm()'s banks stay for good; any other rate pair an upload brings only takes an LRU slot
+static std::map<RatePair, BankPointer> pinned_banks;
+static std::list<std::pair<RatePair, BankPointer>> recent_banks;
+
+std::shared_ptr<const ResamplerFilterBank> Resampler::filterBank(int input_rate, int output_rate) {
+    const RatePair key{input_rate, output_rate};
+    std::lock_guard<std::mutex> lock(banks_mutex);
+    auto pinned = pinned_banks.find(key);
+    if (pinned != pinned_banks.end()) {
+        return pinned->second;
+    }
+    for (auto it = recent_banks.begin(); it != recent_banks.end(); ++it) {
+        if (it->first == key) {
+            recent_banks.splice(recent_banks.begin(), recent_banks, it);
+            return it->second;
+        }
+    }
+
+    BankPointer bank = buildFilterBank(input_rate, output_rate);
+    recent_banks.emplace_front(key, bank);
+    if (recent_banks.size() > MAX_CACHED_BANKS) {
+        recent_banks.pop_back(); // Resamplers still using it hold their own reference
+    }
+    return bank;
+}
+
+void Resampler::prewarm() {
+    for (int rate : {48000, 44100, 22050, 8000}) {
+        BankPointer bank = filterBank(rate, WHISPER_SAMPLE_RATE);
+        std::lock_guard<std::mutex> lock(banks_mutex);
+        pinned_banks[{rate, WHISPER_SAMPLE_RATE}] = bank;
+        recent_banks.remove_if([bank](const std::pair<RatePair, BankPointer>& entry) { return entry.second == bank; });
+    }
+}
+
+std::shared_ptr<const ResamplerFilterBank> Resampler::buildFilterBank(int input_rate, int output_rate) {
+    auto bank = std::make_shared<ResamplerFilterBank>();
+    const size_t divisor = std::gcd(input_rate, output_rate);
+    bank->input_rate = input_rate;
+    bank->output_rate = output_rate;
+    bank->up = output_rate / divisor;
+    bank->down = input_rate / divisor;
+    bank->phases = std::min(bank->up, MAX_PHASES);
+
+    // Cutoff in cycles per input sample, relative to the input Nyquist frequency
+    const double cutoff = ROLLOFF * std::min(1.0, static_cast<double>(bank->up) / bank->down);
+    bank->half_width = static_cast<size_t>(std::ceil(ZERO_CROSSINGS / cutoff));
+    bank->taps = (2 * bank->half_width + 7) / 8 * 8;
+    bank->coefficients.assign(bank->phases * bank->taps, 0.0f);
+
+    const double window_norm = besselI0(KAISER_BETA);
+    const double half_width = static_cast<double>(bank->half_width);
+
+    for (size_t p = 0; p < bank->phases; ++p) {
+        const double fraction = static_cast<double>(p) / bank->phases;
+        float* phase = bank->coefficients.data() + p * bank->taps;
+        double sum = 0.0;
+
+        // Tap i multiplies input sample base + i - (half_width - 1)
+        for (size_t i = 0; i < 2 * bank->half_width; ++i) {
+            const double t = static_cast<double>(i) - (half_width - 1.0) - fraction;
+            const double x = t / (half_width + 1.0);
+            if (std::fabs(x) >= 1.0) {
+                continue;
+            }
+            const double arg = M_PI * cutoff * t;
+            const double sinc = std::fabs(arg) < 1e-12 ? 1.0 : std::sin(arg) / arg;
+            const double window = besselI0(KAISER_BETA * std::sqrt(1.0 - x * x)) / window_norm;
+            const double value = cutoff * sinc * window;
+            phase[i] = static_cast<float>(value);
+            sum += value;
+        }
+
+        // Unity DC gain for every phase
+        if (sum != 0.0) {
+            for (size_t i = 0; i < 2 * bank->half_width; ++i) {
+                phase[i] = static_cast<float>(phase[i] / sum);
+            }
+        }
+    }
+
+    return bank;
+}
+
+void Resampler::process(const float* input, size_t count, std::vector<float>& output) const {
+    static const DotFunction dot = selectDot();
+    const ResamplerFilterBank& bank = *bank_;
+
+    if (bank.up == bank.down) {
+        output.assign(input, input + count);
+        return;
+    }
+
+    const size_t output_count = (count * bank.up + bank.down - 1) / bank.down;
+    output.resize(output_count);
+
+    const size_t left = bank.half_width - 1;   // Taps before the base sample
+
+    for (size_t j = 0; j < output_count; ++j) {
+        // Output j sits at input position j * M / L
+        const size_t position = j * bank.down;
+        size_t base = position / bank.up;
+        size_t remainder = position % bank.up;
+        size_t p = bank.phases == bank.up ? remainder : (remainder * bank.phases + bank.up / 2) / bank.up;
+        if (p == bank.phases) {
+            p = 0;
+            ++base;
+        }
+        const float* coefficients = bank.phase(p);
+
+        if (base >= left && base - left + bank.taps <= count) {
+            output[j] = dot(input + base - left, coefficients, bank.taps);
+            continue;
+        }
+
+        // Clip edges: samples outside the input count as silence
+        float sum = 0.0f;
+        for (size_t i = 0; i < 2 * bank.half_width; ++i) {
+            if (base + i < left) {
+                continue;
+            }
+            const size_t index = base + i - left;
+            if (index >= count) {
+                break;
+            }
+            sum += input[index] * coefficients[i];
+        }
+        output[j] = sum;
+    }
+}
+
+bool Resampler::toWhisperRate(std::vector<float>& audio, int sample_rate) {
+    if (sample_rate <= 0 || !isSupportedRate(static_cast<uint32_t>(sample_rate))) {
+        return false;
+    }
+    if (sample_rate == WHISPER_SAMPLE_RATE || audio.empty()) {
+        return true;
+    }
+
+    std::vector<float> resampled;
+    Resampler(sample_rate, WHISPER_SAMPLE_RATE).process(audio.data(), audio.size(), resampled);
+    audio.swap(resampled);
+    return true;
+}
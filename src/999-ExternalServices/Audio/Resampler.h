@@ -0,0 +1,84 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Windowed-sinc coefficients for one input/output rate pair
+ *
+ * The ratio is reduced to output/input = L/M. Each of the phases holds the taps for
+ * one fractional input position, stored contiguously and zero-padded to a multiple
+ * of 8 so the dot product never needs a scalar tail.
+ */
+struct ResamplerFilterBank {
+    int input_rate = 0;
+    int output_rate = 0;
+    size_t up = 1;              // L
+    size_t down = 1;            // M
+    size_t phases = 1;          // min(L, MAX_PHASES); phase p covers fraction p / phases
+    size_t half_width = 0;      // Input samples on each side of the centre
+    size_t taps = 0;            // Stride between phases (>= 2 * half_width, multiple of 8)
+    std::vector<float> coefficients;
+
+    const float* phase(size_t p) const { return coefficients.data() + p * taps; }
+};
+
+/**
+ * @brief Resampler - Polyphase windowed-sinc sample rate converter
+ *
+ * Converts mono float audio between arbitrary integer rates; whisper wants 16kHz.
+ * The low-pass cutoff follows the lower of the two Nyquist frequencies, so
+ * downsampling is alias-free and upsampling does not image. Filter banks are built
+ * once per rate pair and shared process-wide; the common capture rates (48k,
+ * 44.1k, 22.05k, 8k -> 16k) are built up front by prewarm() and kept, other pairs
+ * share a small LRU. The filter grows with the input rate, so decoders reject rates
+ * outside [MIN_INPUT_RATE, MAX_INPUT_RATE] (isSupportedRate()). The per-sample dot
+ * product uses AVX2/FMA or SSE2 when the CPU has it (same runtime dispatch as
+ * PcmDecoder).
+ */
+class Resampler {
+public:
+    static constexpr int WHISPER_SAMPLE_RATE = 16000;
+    static constexpr size_t MAX_PHASES = 1024;      // Rate pairs with a larger L share the nearest phase
+    static constexpr double ZERO_CROSSINGS = 16.0;  // Sinc lobes on each side of the centre
+    static constexpr double KAISER_BETA = 8.6;      // ~ -85 dB stop band
+    static constexpr double ROLLOFF = 0.94;         // Cutoff as a fraction of the lower Nyquist
+    static constexpr uint32_t MIN_INPUT_RATE = 4000;
+    static constexpr uint32_t MAX_INPUT_RATE = 384000; // ~1 MB of coefficients at worst
+    static constexpr size_t MAX_CACHED_BANKS = 8;   // Rate pairs besides the prewarmed ones
+
+    explicit Resampler(int input_rate, int output_rate = WHISPER_SAMPLE_RATE);
+
+    /**
+     * @brief Resample a complete clip
+     * @param input Samples at the input rate
+     * @param count Number of input samples
+     * @param output Replaced with count * output_rate / input_rate samples
+     */
+    void process(const float* input, size_t count, std::vector<float>& output) const;
+
+    // Sample rates WavReader and RiceCodec accept
+    static bool isSupportedRate(uint32_t sample_rate) {
+        return sample_rate >= MIN_INPUT_RATE && sample_rate <= MAX_INPUT_RATE;
+    }
+
+    /**
+     * @brief Convert audio in place to 16kHz (no-op if it already is)
+     * @return false if sample_rate is not a supported rate
+     */
+    static bool toWhisperRate(std::vector<float>& audio, int sample_rate);
+
+    // Build the filter banks for the usual capture rates ahead of the first request
+    static void prewarm();
+
+    // Shared bank for a rate pair, built on first use (rates must be supported)
+    static std::shared_ptr<const ResamplerFilterBank> filterBank(int input_rate, int output_rate);
+
+    const ResamplerFilterBank& bank() const { return *bank_; }
+
+private:
+    static std::shared_ptr<const ResamplerFilterBank> buildFilterBank(int input_rate, int output_rate);
+
+    std::shared_ptr<const ResamplerFilterBank> bank_;
+};
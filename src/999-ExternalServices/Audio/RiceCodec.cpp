@@ -0,0 +1,298 @@
+#include "RiceCodec.h"
+#include "Resampler.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+static constexpr char MAGIC[4] = {'W', 'R', 'C', '1'};
+static constexpr int ORDER_BITS = 2;
+static constexpr int RICE_PARAMETER_BITS = 5;
+// No valid residual needs a longer unary run; anything longer is a corrupt stream
+static constexpr uint32_t MAX_QUOTIENT = 1u << 20;
+
+static uint16_t readLe16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readLe32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void writeLe16(unsigned char* p, uint16_t value) {
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void writeLe32(unsigned char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+// Fixed polynomial predictors; h1..h3 are the previous three samples, newest first
+static inline int32_t predict(int order, int32_t h1, int32_t h2, int32_t h3) {
+    switch (order) {
+        case 1: return h1;
+        case 2: return 2 * h1 - h2;
+        case 3: return 3 * h1 - 3 * h2 + h3;
+        default: return 0;
+    }
+}
+
+static inline uint32_t zigzag(int32_t residual) {
+    return (static_cast<uint32_t>(residual) << 1) ^ static_cast<uint32_t>(residual >> 31);
+}
+
+namespace {
+
+/**
+ * MSB-first reader over a 64-bit window. Reads past the end see zero bits; overrun()
+ * reports whether any of those were consumed.
+ */
+class BitReader {
+public:
+    BitReader(const unsigned char* data, size_t size)
+        : cursor_(data), end_(data + size), window_(0), available_(0), padding_(0) {}
+
+    uint32_t readBits(int count) {
+        if (count == 0) {
+            return 0;
+        }
+        if (available_ < count) {
+            refill();
+        }
+        uint32_t value = static_cast<uint32_t>(window_ >> (64 - count));
+        window_ <<= count;
+        available_ -= count;
+        return value;
+    }
+
+    // Number of zero bits before the next one bit, which is consumed too
+    bool readUnary(uint32_t& quotient) {
+        quotient = 0;
+        while (true) {
+            refill();
+            int zeros = window_ ? __builtin_clzll(window_) : 64;
+            if (zeros < available_) {
+                quotient += static_cast<uint32_t>(zeros);
+                window_ = (zeros + 1 < 64) ? window_ << (zeros + 1) : 0;
+                available_ -= zeros + 1;
+                return true;
+            }
+            quotient += static_cast<uint32_t>(available_);
+            window_ = 0;
+            available_ = 0;
+            if (quotient > MAX_QUOTIENT || padding_ > 64) {
+                return false;
+            }
+        }
+    }
+
+    bool overrun() const { return padding_ > available_; }
+
+private:
+    void refill() {
+        while (available_ <= 56) {
+            uint64_t byte = 0;
+            if (cursor_ < end_) {
+                byte = *cursor_++;
+            } else {
+                padding_ += 8;
+            }
+            window_ |= byte << (56 - available_);
+            available_ += 8;
+        }
+    }
+
+    const unsigned char* cursor_;
+    const unsigned char* end_;
+    uint64_t window_;
+    int available_;     // Valid bits at the top of window_
+    int padding_;       // Zero bits appended after the end of the data
+};
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<unsigned char>& out) : out_(out), accumulator_(0), pending_(0) {}
+
+    void writeBits(uint32_t value, int count) {
+        accumulator_ = (accumulator_ << count) | value;
+        pending_ += count;
+        while (pending_ >= 8) {
+            pending_ -= 8;
+            out_.push_back(static_cast<unsigned char>(accumulator_ >> pending_));
+        }
+        accumulator_ &= (uint64_t(1) << pending_) - 1;
+    }
+
+    void writeUnary(uint32_t zeros) {
+        for (; zeros >= 16; zeros -= 16) {
+            writeBits(0, 16);
+        }
+        writeBits(1, static_cast<int>(zeros) + 1);
+    }
+
+    void flush() {
+        if (pending_ > 0) {
+            writeBits(0, 8 - pending_);
+        }
+    }
+
+private:
+    std::vector<unsigned char>& out_;
+    uint64_t accumulator_;
+    int pending_;
+};
+
+} // namespace
+
+bool RiceCodec::isEncoded(const void* data, size_t size) {
+    return size >= HEADER_BYTES && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool RiceCodec::decode(const void* data, size_t size, std::vector<int16_t>& samples, uint32_t& sample_rate,
+                       std::string& error) {
+    if (!isEncoded(data, size)) {
+        error = "Not a RiceCodec stream";
+        return false;
+    }
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    sample_rate = readLe32(bytes + 4);
+    const uint32_t sample_count = readLe32(bytes + 8);
+    const size_t block_size = readLe16(bytes + 12);
+    const size_t partition_size = readLe16(bytes + 14);
+    if (block_size == 0 || partition_size == 0) {
+        error = "Invalid RiceCodec header";
+        return false;
+    }
+    if (!Resampler::isSupportedRate(sample_rate)) {
+        error = "Invalid sample rate: " + std::to_string(sample_rate);
+        return false;
+    }
+    // Every sample costs at least one bit, which bounds what a truncated header can claim
+    if (sample_count / 8 > size - HEADER_BYTES) {
+        error = "RiceCodec stream truncated";
+        return false;
+    }
+
+    samples.resize(sample_count);
+    int16_t* out = samples.data();
+    BitReader reader(bytes + HEADER_BYTES, size - HEADER_BYTES);
+    int32_t h1 = 0, h2 = 0, h3 = 0;
+
+    for (size_t block = 0; block < sample_count; block += block_size) {
+        const size_t block_end = std::min<size_t>(block + block_size, sample_count);
+        const int order = static_cast<int>(reader.readBits(ORDER_BITS));
+
+        for (size_t partition = block; partition < block_end; partition += partition_size) {
+            const size_t partition_end = std::min(partition + partition_size, block_end);
+            const int k = static_cast<int>(reader.readBits(RICE_PARAMETER_BITS));
+            if (k > MAX_RICE_PARAMETER) {
+                error = "Invalid Rice parameter in RiceCodec stream";
+                return false;
+            }
+            for (size_t i = partition; i < partition_end; ++i) {
+                uint32_t quotient;
+                if (!reader.readUnary(quotient)) {
+                    error = "Corrupt residual in RiceCodec stream";
+                    return false;
+                }
+                const uint32_t u = (quotient << k) | reader.readBits(k);
+                const int32_t residual = static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1);
+                // A corrupt residual can be near +-2^31, so the sum is only range-checked in 64 bits
+                const int64_t sample = static_cast<int64_t>(predict(order, h1, h2, h3)) + residual;
+                if (sample < std::numeric_limits<int16_t>::min() || sample > std::numeric_limits<int16_t>::max()) {
+                    error = "Sample out of range in RiceCodec stream";
+                    return false;
+                }
+                out[i] = static_cast<int16_t>(sample);
+                h3 = h2;
+                h2 = h1;
+                h1 = static_cast<int32_t>(sample);
+            }
+            if (reader.overrun()) {
+                error = "RiceCodec stream truncated";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<unsigned char> RiceCodec::encode(const int16_t* samples, size_t count, uint32_t sample_rate,
+                                             size_t block_size, size_t partition_size) {
+    std::vector<unsigned char> out(HEADER_BYTES);
+    std::memcpy(out.data(), MAGIC, sizeof(MAGIC));
+    writeLe32(out.data() + 4, sample_rate);
+    writeLe32(out.data() + 8, static_cast<uint32_t>(count));
+    writeLe16(out.data() + 12, static_cast<uint16_t>(block_size));
+    writeLe16(out.data() + 14, static_cast<uint16_t>(partition_size));
+    out.reserve(HEADER_BYTES + count);
+
+    auto history = [samples](size_t i, size_t back) -> int32_t {
+        return i >= back ? samples[i - back] : 0;
+    };
+    auto residualAt = [samples, &history](int order, size_t i) -> int32_t {
+        return samples[i] - predict(order, history(i, 1), history(i, 2), history(i, 3));
+    };
+
+    BitWriter writer(out);
+    std::vector<uint32_t> residuals(partition_size);
+
+    for (size_t block = 0; block < count; block += block_size) {
+        const size_t block_end = std::min(block + block_size, count);
+
+        // Order with the smallest residual magnitude, as FLAC's fixed-predictor search
+        int order = 0;
+        uint64_t best_sum = std::numeric_limits<uint64_t>::max();
+        for (int candidate = 0; candidate <= MAX_ORDER; ++candidate) {
+            uint64_t sum = 0;
+            for (size_t i = block; i < block_end; ++i) {
+                int32_t residual = residualAt(candidate, i);
+                sum += static_cast<uint64_t>(residual < 0 ? -residual : residual);
+            }
+            if (sum < best_sum) {
+                best_sum = sum;
+                order = candidate;
+            }
+        }
+        writer.writeBits(static_cast<uint32_t>(order), ORDER_BITS);
+
+        for (size_t partition = block; partition < block_end; partition += partition_size) {
+            const size_t length = std::min(partition + partition_size, block_end) - partition;
+            uint64_t sum = 0;
+            for (size_t i = 0; i < length; ++i) {
+                residuals[i] = zigzag(residualAt(order, partition + i));
+                sum += residuals[i];
+            }
+
+            // k around log2 of the mean, then the exact cost picks among its neighbours
+            int estimate = 0;
+            while (estimate < MAX_RICE_PARAMETER && (static_cast<uint64_t>(length) << (estimate + 1)) <= sum) {
+                ++estimate;
+            }
+            int k = estimate;
+            uint64_t best_bits = std::numeric_limits<uint64_t>::max();
+            for (int candidate = std::max(0, estimate - 1); candidate <= std::min(MAX_RICE_PARAMETER, estimate + 1); ++candidate) {
+                uint64_t bits = static_cast<uint64_t>(length) * (candidate + 1);
+                for (size_t i = 0; i < length; ++i) {
+                    bits += residuals[i] >> candidate;
+                }
+                if (bits < best_bits) {
+                    best_bits = bits;
+                    k = candidate;
+                }
+            }
+
+            writer.writeBits(static_cast<uint32_t>(k), RICE_PARAMETER_BITS);
+            const uint32_t low_mask = (1u << k) - 1;
+            for (size_t i = 0; i < length; ++i) {
+                writer.writeUnary(residuals[i] >> k);
+                writer.writeBits(residuals[i] & low_mask, k);
+            }
+        }
+    }
+    writer.flush();
+    return out;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief RiceCodec - Lossless mono 16-bit audio: fixed linear prediction plus Rice coding
+ *
+ * The recorder encodes its uploads with this (VoiceRecorder's encodeRice, in JavaScript)
+ * instead of WAV; the server decodes back to the exact int16 samples. Speech compresses
+ * to roughly half of WAV, so the same max-request-size admits about twice the recording.
+ *
+ * Layout, all header fields little-endian:
+ *
+ *   "WRC1"  u32 sample_rate  u32 sample_count  u16 block_size  u16 partition_size
+ *
+ * followed by one MSB-first bit stream. Each block of block_size samples (the last may be
+ * shorter) starts with a 2-bit predictor order, 0..3, picking one of FLAC's fixed
+ * polynomial predictors. The prediction runs over the whole stream, with samples before
+ * the first one taken as zero, so blocks carry no warm-up samples. The block's residuals
+ * follow in partitions of partition_size, each a 5-bit Rice parameter k and then, per
+ * residual, the zigzag-mapped value u as (u >> k) zero bits, a one bit and the low k bits
+ * of u. The stream is zero-padded to a whole byte.
+ */
+class RiceCodec {
+public:
+    static constexpr size_t HEADER_BYTES = 16;
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 4096;
+    static constexpr size_t DEFAULT_PARTITION_SIZE = 256;
+    static constexpr int MAX_ORDER = 3;
+    static constexpr int MAX_RICE_PARAMETER = 20;  // Order-3 residuals of int16 fit in 19 bits
+
+    /**
+     * @brief True if data starts with the RiceCodec magic
+     */
+    static bool isEncoded(const void* data, size_t size);
+
+    /**
+     * @brief Decode a complete stream
+     * @param samples Replaced with the decoded samples
+     * @param sample_rate Set from the header
+     * @return false with error set if the stream is truncated or corrupt
+     */
+    static bool decode(const void* data, size_t size, std::vector<int16_t>& samples, uint32_t& sample_rate,
+                       std::string& error);
+
+    /**
+     * @brief Encode samples; produces the same bytes as the recorder's JavaScript encoder
+     */
+    static std::vector<unsigned char> encode(const int16_t* samples, size_t count, uint32_t sample_rate,
+                                             size_t block_size = DEFAULT_BLOCK_SIZE,
+                                             size_t partition_size = DEFAULT_PARTITION_SIZE);
+};
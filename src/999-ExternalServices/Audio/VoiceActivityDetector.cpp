@@ -0,0 +1,152 @@
+#include "VoiceActivityDetector.h"
+#include <algorithm>
+#include <cmath>
+
+void VadTimeMap::addSpan(size_t original_start, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    spans_.push_back({compactLength(), original_start, length});
+}
+
+size_t VadTimeMap::compactLength() const {
+    return spans_.empty() ? 0 : spans_.back().compact_start + spans_.back().length;
+}
+
+size_t VadTimeMap::toOriginalSample(size_t compact_sample) const {
+    if (spans_.empty()) {
+        return compact_sample;
+    }
+
+    // Last span starting at or before the sample
+    auto it = std::upper_bound(spans_.begin(), spans_.end(), compact_sample,
+        [](size_t sample, const VadSpan& span) { return sample < span.compact_start; });
+    if (it != spans_.begin()) {
+        --it;
+    }
+
+    size_t offset = std::min(compact_sample - std::min(compact_sample, it->compact_start), it->length);
+    return it->original_start + offset;
+}
+
+double VadTimeMap::toOriginalSeconds(double compact_seconds, int sample_rate) const {
+    size_t compact_sample = static_cast<size_t>(std::max(0.0, compact_seconds) * sample_rate + 0.5);
+    return static_cast<double>(toOriginalSample(compact_sample)) / sample_rate;
+}
+
+VoiceActivityDetector::VoiceActivityDetector(const VadOptions& options)
+    : options_(options)
+{
+}
+
+size_t VoiceActivityDetector::frameSize() const {
+    return static_cast<size_t>(options_.sample_rate) * options_.frame_ms / 1000;
+}
+
+std::vector<bool> VoiceActivityDetector::classifyFrames(const float* audio, size_t sample_count,
+                                                        std::vector<float>* energy_out) const {
+    const size_t frame_size = frameSize();
+    const size_t frame_count = frame_size > 0 ? sample_count / frame_size : 0;
+    if (frame_count == 0) {
+        return {};
+    }
+
+    // Per-frame RMS energy and zero-crossing rate
+    std::vector<float> energy(frame_count);
+    std::vector<float> zcr(frame_count);
+    for (size_t f = 0; f < frame_count; ++f) {
+        const float* frame = audio + f * frame_size;
+        double sum_squares = 0.0;
+        size_t crossings = 0;
+        for (size_t i = 0; i < frame_size; ++i) {
+            sum_squares += static_cast<double>(frame[i]) * frame[i];
+            if (i > 0 && ((frame[i] >= 0.0f) != (frame[i - 1] >= 0.0f))) {
+                ++crossings;
+            }
+        }
+        energy[f] = static_cast<float>(std::sqrt(sum_squares / frame_size));
+        zcr[f] = static_cast<float>(crossings) / frame_size;
+    }
+
+    // Noise floor: 10th percentile of frame energies
+    std::vector<float> sorted_energy(energy);
+    size_t percentile = sorted_energy.size() / 10;
+    std::nth_element(sorted_energy.begin(), sorted_energy.begin() + percentile, sorted_energy.end());
+    const float noise_floor = sorted_energy[percentile];
+    const float threshold = std::max(options_.min_energy, noise_floor * options_.energy_ratio);
+
+    std::vector<bool> speech(frame_count, false);
+    for (size_t f = 0; f < frame_count; ++f) {
+        bool voiced = energy[f] > threshold;
+        bool fricative = energy[f] > threshold * 0.5f && zcr[f] > options_.fricative_zcr;
+        speech[f] = voiced || fricative;
+    }
+
+    if (energy_out) {
+        *energy_out = std::move(energy);
+    }
+    return speech;
+}
+
+VadResult VoiceActivityDetector::process(const std::vector<float>& audio) const {
+    VadResult result;
+
+    const size_t frame_size = frameSize();
+    const size_t frame_count = frame_size > 0 ? audio.size() / frame_size : 0;
+
+    auto keepEverything = [&]() {
+        result.samples = audio;
+        result.time_map.addSpan(0, audio.size());
+        result.dropped_samples = 0;
+        return result;
+    };
+
+    if (frame_count < 2) {
+        return keepEverything();
+    }
+
+    std::vector<bool> speech = classifyFrames(audio.data(), audio.size());
+    if (std::find(speech.begin(), speech.end(), true) == speech.end()) {
+        return keepEverything();
+    }
+
+    // Speech regions in samples, padded and clamped to the clip
+    const size_t padding = static_cast<size_t>(options_.sample_rate) * options_.padding_ms / 1000;
+    const size_t max_gap = static_cast<size_t>(options_.sample_rate) * options_.max_gap_ms / 1000;
+    const size_t collapsed_gap = static_cast<size_t>(options_.sample_rate) * options_.collapsed_gap_ms / 1000;
+
+    std::vector<std::pair<size_t, size_t>> regions; // [start, end)
+    for (size_t f = 0; f < frame_count; ++f) {
+        if (!speech[f]) {
+            continue;
+        }
+        size_t start = f * frame_size;
+        size_t end = (f + 1) * frame_size;
+        start = start > padding ? start - padding : 0;
+        end = std::min(audio.size(), end + padding);
+
+        if (!regions.empty() && start <= regions.back().second + max_gap) {
+            // Short pause: keep it as is
+            regions.back().second = std::max(regions.back().second, end);
+        } else if (!regions.empty()) {
+            // Long pause: keep half of the collapsed gap on each side so words don't run together
+            regions.back().second = std::min(start, regions.back().second + collapsed_gap / 2);
+            regions.push_back({std::max(regions.back().second, start - std::min(start, collapsed_gap / 2)), end});
+        } else {
+            regions.push_back({start, end});
+        }
+    }
+
+    size_t kept = 0;
+    for (const auto& region : regions) {
+        kept += region.second - region.first;
+    }
+
+    result.samples.reserve(kept);
+    for (const auto& region : regions) {
+        result.time_map.addSpan(region.first, region.second - region.first);
+        result.samples.insert(result.samples.end(), audio.begin() + region.first, audio.begin() + region.second);
+    }
+    result.dropped_samples = audio.size() - result.samples.size();
+    return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+/**
+ * @brief Tuning knobs for VoiceActivityDetector (defaults are for 16kHz browser recordings)
+ */
+struct VadOptions {
+    int sample_rate = 16000;
+    int frame_ms = 20;               // Analysis frame length
+    float energy_ratio = 3.0f;       // Speech if frame RMS exceeds the noise floor by this factor
+    float min_energy = 0.003f;       // Absolute RMS threshold, protects against digital silence floors
+    float fricative_zcr = 0.25f;     // Quiet frames with a zero-crossing rate above this are kept ("s", "f")
+    int padding_ms = 200;            // Audio kept before and after every speech region
+    int max_gap_ms = 600;            // Internal pauses longer than this are collapsed...
+    int collapsed_gap_ms = 300;      // ...down to this much silence
+};
+
+/**
+ * @brief One contiguous run of kept samples
+ */
+struct VadSpan {
+    size_t compact_start;   // Offset in the trimmed buffer
+    size_t original_start;  // Offset in the original buffer
+    size_t length;
+};
+
+/**
+ * @brief Maps positions in the trimmed buffer back to the original recording
+ */
+class VadTimeMap {
+public:
+    void addSpan(size_t original_start, size_t length);
+
+    size_t toOriginalSample(size_t compact_sample) const;
+    double toOriginalSeconds(double compact_seconds, int sample_rate) const;
+
+    const std::vector<VadSpan>& spans() const { return spans_; }
+    size_t compactLength() const;
+
+private:
+    std::vector<VadSpan> spans_;
+};
+
+/**
+ * @brief Result of VoiceActivityDetector::process
+ */
+struct VadResult {
+    std::vector<float> samples;   // Trimmed audio handed to whisper
+    VadTimeMap time_map;          // Trimmed -> original positions
+    size_t dropped_samples = 0;   // Original length minus trimmed length
+};
+
+/**
+ * @brief VoiceActivityDetector - Frame energy / zero-crossing speech detector
+ *
+ * Removes leading and trailing silence and shortens long pauses before inference.
+ * The noise floor is estimated from the quietest frames of the clip itself, so it
+ * adapts to the microphone without a calibration phase. If no frame looks like
+ * speech the audio is returned untouched rather than risking an empty transcript.
+ */
+class VoiceActivityDetector {
+public:
+    explicit VoiceActivityDetector(const VadOptions& options = VadOptions());
+
+    VadResult process(const std::vector<float>& audio) const;
+
+    /**
+     * @brief Per-frame speech decision that process() builds its regions from
+     * @param energy Receives the RMS of every frame when set
+     * @return One entry per whole frame_ms frame; all false if nothing looks like speech
+     */
+    std::vector<bool> classifyFrames(const float* audio, size_t sample_count, std::vector<float>* energy = nullptr) const;
+
+    size_t frameSize() const;
+
+private:
+    VadOptions options_;
+};
@@ -0,0 +1,244 @@
+#include "WavReader.h"
+#include "Resampler.h"
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr uint16_t WAVE_FORMAT_PCM = 0x0001;
+static constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+static constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+static uint16_t readLe16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+static uint32_t readLe32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+WavReader::WavReader()
+    : mapping_(nullptr)
+    , mapping_size_(0)
+    , data_(nullptr)
+    , data_bytes_(0)
+{
+}
+
+WavReader::~WavReader() {
+    close();
+}
+
+WavReader::WavReader(WavReader&& other) noexcept
+    : mapping_(other.mapping_)
+    , mapping_size_(other.mapping_size_)
+    , data_(other.data_)
+    , data_bytes_(other.data_bytes_)
+    , format_(other.format_)
+    , last_error_(std::move(other.last_error_))
+{
+    other.mapping_ = nullptr;
+    other.mapping_size_ = 0;
+    other.data_ = nullptr;
+    other.data_bytes_ = 0;
+}
+
+WavReader& WavReader::operator=(WavReader&& other) noexcept {
+    if (this != &other) {
+        close();
+        mapping_ = other.mapping_;
+        mapping_size_ = other.mapping_size_;
+        data_ = other.data_;
+        data_bytes_ = other.data_bytes_;
+        format_ = other.format_;
+        last_error_ = std::move(other.last_error_);
+        other.mapping_ = nullptr;
+        other.mapping_size_ = 0;
+        other.data_ = nullptr;
+        other.data_bytes_ = 0;
+    }
+    return *this;
+}
+
+bool WavReader::open(const std::string& file_path) {
+    close();
+
+    int fd = ::open(file_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return fail("Cannot open audio file: " + file_path + " (" + std::strerror(errno) + ")");
+    }
+    bool mapped = mapDescriptor(fd, file_path);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    return mapped;
+}
+
+bool WavReader::openDescriptor(int fd) {
+    close();
+    return mapDescriptor(fd, "descriptor " + std::to_string(fd));
+}
+
+bool WavReader::mapDescriptor(int fd, const std::string& name) {
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size < 12) {
+        return fail("Invalid WAV header: " + name);
+    }
+
+    mapping_size_ = static_cast<size_t>(file_stat.st_size);
+    void* mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        mapping_size_ = 0;
+        return fail("Cannot map audio file: " + name + " (" + std::strerror(errno) + ")");
+    }
+    mapping_ = static_cast<unsigned char*>(mapping);
+
+    // Samples are consumed front to back exactly once
+    madvise(mapping_, mapping_size_, MADV_SEQUENTIAL);
+
+    if (!parse()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void WavReader::close() {
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+    mapping_ = nullptr;
+    mapping_size_ = 0;
+    data_ = nullptr;
+    data_bytes_ = 0;
+    format_ = WavFormat();
+}
+
+bool WavReader::parse() {
+    if (std::memcmp(mapping_, "RIFF", 4) != 0 || std::memcmp(mapping_ + 8, "WAVE", 4) != 0) {
+        return fail("Not a valid WAV file");
+    }
+
+    bool have_format = false;
+    size_t offset = 12;
+
+    while (offset + 8 <= mapping_size_) {
+        const unsigned char* chunk = mapping_ + offset;
+        const size_t declared_size = readLe32(chunk + 4);
+        const size_t available = mapping_size_ - offset - 8;
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (!parseFormat(chunk + 8, std::min(declared_size, available))) {
+                return false;
+            }
+            have_format = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                return fail("WAV data chunk precedes fmt chunk");
+            }
+            data_ = chunk + 8;
+            // Truncated or still-being-written files: use what is actually there
+            data_bytes_ = std::min(declared_size, available);
+            data_bytes_ -= data_bytes_ % format_.block_align;
+            break;
+        }
+
+        // Chunks are padded to an even size
+        offset += 8 + declared_size + (declared_size & 1);
+    }
+
+    if (!have_format) {
+        return fail("WAV file has no fmt chunk");
+    }
+    if (!data_ || data_bytes_ == 0) {
+        return fail("No audio data found");
+    }
+    return true;
+}
+
+bool WavReader::parseFormat(const unsigned char* chunk, size_t size) {
+    if (size < 16) {
+        return fail("WAV fmt chunk too short");
+    }
+
+    format_.audio_format = readLe16(chunk);
+    format_.channels = readLe16(chunk + 2);
+    format_.sample_rate = readLe32(chunk + 4);
+    format_.block_align = readLe16(chunk + 12);
+    format_.bits_per_sample = readLe16(chunk + 14);
+
+    if (format_.audio_format == WAVE_FORMAT_EXTENSIBLE) {
+        // cbSize, wValidBitsPerSample, dwChannelMask, then the SubFormat GUID whose first two bytes are the format tag
+        if (size < 40) {
+            return fail("WAVE_FORMAT_EXTENSIBLE fmt chunk too short");
+        }
+        format_.audio_format = readLe16(chunk + 24);
+    }
+
+    if (format_.channels == 0) {
+        return fail("Invalid channel count");
+    }
+    if (!Resampler::isSupportedRate(format_.sample_rate)) {
+        return fail("Invalid sample rate: " + std::to_string(format_.sample_rate));
+    }
+
+    if (format_.audio_format == WAVE_FORMAT_PCM) {
+        switch (format_.bits_per_sample) {
+            case 8:  format_.encoding = PcmDecoder::Encoding::UInt8; break;
+            case 16: format_.encoding = PcmDecoder::Encoding::Int16; break;
+            case 24: format_.encoding = PcmDecoder::Encoding::Int24; break;
+            case 32: format_.encoding = PcmDecoder::Encoding::Int32; break;
+            default:
+                return fail("Unsupported PCM bits per sample: " + std::to_string(format_.bits_per_sample));
+        }
+    } else if (format_.audio_format == WAVE_FORMAT_IEEE_FLOAT) {
+        switch (format_.bits_per_sample) {
+            case 32: format_.encoding = PcmDecoder::Encoding::Float32; break;
+            case 64: format_.encoding = PcmDecoder::Encoding::Float64; break;
+            default:
+                return fail("Unsupported float bits per sample: " + std::to_string(format_.bits_per_sample));
+        }
+    } else {
+        return fail("Unsupported WAV format tag: " + std::to_string(format_.audio_format));
+    }
+
+    // Trust our own frame size over a bogus block_align
+    format_.block_align = static_cast<uint16_t>(PcmDecoder::bytesPerSample(format_.encoding) * format_.channels);
+    return true;
+}
+
+bool WavReader::fail(const std::string& error) {
+    last_error_ = error;
+    return false;
+}
+
+size_t WavReader::frames() const {
+    return format_.block_align ? data_bytes_ / format_.block_align : 0;
+}
+
+double WavReader::durationSeconds() const {
+    return format_.sample_rate ? static_cast<double>(frames()) / format_.sample_rate : 0.0;
+}
+
+const int16_t* WavReader::int16Samples() const {
+    if (!data_ || format_.encoding != PcmDecoder::Encoding::Int16 ||
+        reinterpret_cast<uintptr_t>(data_) % alignof(int16_t) != 0) {
+        return nullptr;
+    }
+    return reinterpret_cast<const int16_t*>(data_);
+}
+
+void WavReader::decodeMono(std::vector<float>& audio_data) const {
+    audio_data.resize(frames());
+    PcmDecoder::toMono(data_, audio_data.size(), format_.channels, format_.encoding, audio_data.data());
+}
+
+void WavReader::decodeMono(std::vector<float>& audio_data, size_t first_frame, size_t frame_count) const {
+    first_frame = std::min(first_frame, frames());
+    audio_data.resize(std::min(frame_count, frames() - first_frame));
+    const unsigned char* first = static_cast<const unsigned char*>(data_) + first_frame * format_.block_align;
+    PcmDecoder::toMono(first, audio_data.size(), format_.channels, format_.encoding, audio_data.data());
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "PcmDecoder.h"
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Format of a WAV data chunk, taken from its fmt chunk
+ */
+struct WavFormat {
+    uint16_t audio_format = 0;      // 1 = PCM, 3 = IEEE float (resolved through WAVE_FORMAT_EXTENSIBLE)
+    uint16_t channels = 0;
+    uint32_t sample_rate = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t block_align = 0;       // Bytes per frame
+    PcmDecoder::Encoding encoding = PcmDecoder::Encoding::Int16;
+};
+
+/**
+ * @brief WavReader - Memory-mapped RIFF/WAVE reader
+ *
+ * Maps the file read-only and walks its chunks (fmt, data, and anything else such
+ * as LIST or fact, which is skipped), honouring the RIFF even-size padding. The
+ * sample data is exposed as a view into the mapping, so nothing is copied until the
+ * caller converts it; decodeMono() goes straight from the mapped pages to float.
+ *
+ * Supports 8/16/24/32-bit integer PCM and 32/64-bit IEEE float, plain or wrapped
+ * in WAVE_FORMAT_EXTENSIBLE. A data chunk whose size runs past the end of the file
+ * (streaming writers that never patch the header) is clamped to what is there.
+ */
+class WavReader {
+public:
+    WavReader();
+    ~WavReader();
+
+    WavReader(const WavReader&) = delete;
+    WavReader& operator=(const WavReader&) = delete;
+    WavReader(WavReader&& other) noexcept;
+    WavReader& operator=(WavReader&& other) noexcept;
+
+    /**
+     * @brief Map and parse a WAV file
+     * @param file_path Path to the file
+     * @return false with getLastError() set if the file is unreadable or not a supported WAV
+     */
+    bool open(const std::string& file_path);
+
+    /**
+     * @brief Map and parse a WAV held by an open descriptor (e.g. a memfd received over a socket)
+     * @param fd Descriptor positioned anywhere; it stays owned by the caller and may be closed after this returns
+     */
+    bool openDescriptor(int fd);
+    void close();
+
+    bool isOpen() const { return mapping_ != nullptr; }
+    const WavFormat& format() const { return format_; }
+
+    // Raw interleaved sample bytes inside the mapping; valid until close()
+    const void* data() const { return data_; }
+    size_t dataBytes() const { return data_bytes_; }
+    size_t frames() const;
+    double durationSeconds() const;
+
+    /**
+     * @brief Zero-copy int16 view of the samples
+     * @return nullptr unless the file is 16-bit PCM with a 2-byte aligned data chunk
+     */
+    const int16_t* int16Samples() const;
+
+    /**
+     * @brief Convert the samples to mono float in [-1, 1), averaging channels
+     * @param audio_data Resized to frames()
+     */
+    void decodeMono(std::vector<float>& audio_data) const;
+
+    /**
+     * @brief decodeMono() of frames [first_frame, first_frame + frame_count) only, clamped to the file
+     */
+    void decodeMono(std::vector<float>& audio_data, size_t first_frame, size_t frame_count) const;
+
+    std::string getLastError() const { return last_error_; }
+
+private:
+    bool mapDescriptor(int fd, const std::string& name);
+    bool parse();
+    bool parseFormat(const unsigned char* chunk, size_t size);
+    bool fail(const std::string& error);
+
+    unsigned char* mapping_;
+    size_t mapping_size_;
+    const unsigned char* data_;
+    size_t data_bytes_;
+    WavFormat format_;
+    std::string last_error_;
+};
@@ -0,0 +1,353 @@
+#include "AudioChunker.h"
+#include "Audio/VoiceActivityDetector.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <thread>
+#include <utility>
+
+static std::mutex default_options_mutex;
+static ChunkingOptions default_options;
+
+static std::mutex stats_mutex;
+static ChunkingStats stats;
+
+static std::string milliseconds(double seconds) {
+    return std::to_string(static_cast<long long>(seconds * 1000.0)) + "ms";
+}
+
+std::string ChunkingOptions::cacheTag() const {
+    if (strategy == ChunkStrategy::Off) {
+        return "off";
+    }
+    std::string tag = std::string(strategyName(strategy)) + ">=" + milliseconds(min_audio_seconds) + ":" +
+                      milliseconds(window_seconds) + "+" + milliseconds(overlap_seconds);
+    if (strategy == ChunkStrategy::Pauses) {
+        tag += "/" + milliseconds(search_seconds) + "/" + milliseconds(min_pause_seconds);
+    }
+    return tag;
+}
+
+const char* ChunkingOptions::strategyName(ChunkStrategy strategy) {
+    switch (strategy) {
+        case ChunkStrategy::Off: return "off";
+        case ChunkStrategy::Fixed: return "fixed";
+        case ChunkStrategy::Pauses: return "pauses";
+    }
+    return "off";
+}
+
+bool ChunkingOptions::parseStrategy(const std::string& name, ChunkStrategy& strategy) {
+    for (ChunkStrategy candidate : {ChunkStrategy::Off, ChunkStrategy::Fixed, ChunkStrategy::Pauses}) {
+        if (name == strategyName(candidate)) {
+            strategy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+AudioChunker::AudioChunker(const ChunkingOptions& options)
+    : options_(options)
+{
+}
+
+void AudioChunker::setDefaultOptions(const ChunkingOptions& options) {
+    std::lock_guard<std::mutex> lock(default_options_mutex);
+    default_options = options;
+}
+
+ChunkingOptions AudioChunker::defaultOptions() {
+    std::lock_guard<std::mutex> lock(default_options_mutex);
+    return default_options;
+}
+
+// A window's own part plus an overlap on either side fills one encoder window
+static size_t strideSamples(const ChunkingOptions& options) {
+    double own_seconds = std::max(1.0, options.window_seconds - 2.0 * options.overlap_seconds);
+    return static_cast<size_t>(own_seconds * options.sample_rate);
+}
+
+bool AudioChunker::shouldSplit(size_t sample_count) const {
+    if (options_.strategy == ChunkStrategy::Off || options_.sample_rate <= 0) {
+        return false;
+    }
+    double seconds = static_cast<double>(sample_count) / options_.sample_rate;
+    return seconds >= options_.min_audio_seconds && seconds > options_.window_seconds;
+}
+
+std::vector<AudioWindow> AudioChunker::plan(const float* samples, size_t sample_count) const {
+    if (!shouldSplit(sample_count)) {
+        AudioWindow whole;
+        whole.end = whole.own_end = sample_count;
+        return {whole};
+    }
+
+    const size_t overlap = static_cast<size_t>(options_.overlap_seconds * options_.sample_rate);
+    const size_t stride = strideSamples(options_);
+    const size_t search = std::min(static_cast<size_t>(options_.search_seconds * options_.sample_rate), stride / 2);
+
+    std::vector<bool> speech;
+    std::vector<float> energy;
+    size_t frame_size = 0;
+    if (options_.strategy == ChunkStrategy::Pauses) {
+        VadOptions vad_options;
+        vad_options.sample_rate = options_.sample_rate;
+        VoiceActivityDetector detector(vad_options);
+        speech = detector.classifyFrames(samples, sample_count, &energy);
+        frame_size = detector.frameSize();
+    }
+
+    // The last window only overlaps on its left, so it may run that much longer
+    std::vector<size_t> cuts = {0};
+    std::vector<bool> pause_cuts;
+    size_t position = 0;
+    while (sample_count - position > stride + overlap) {
+        size_t target = position + stride;
+        bool in_pause = false;
+        size_t cut = findCut(speech, energy, frame_size, target - search, target, in_pause);
+        cuts.push_back(cut);
+        pause_cuts.push_back(in_pause);
+        position = cut;
+    }
+    cuts.push_back(sample_count);
+
+    std::vector<AudioWindow> windows;
+    for (size_t i = 0; i + 1 < cuts.size(); ++i) {
+        AudioWindow window;
+        window.own_start = cuts[i];
+        window.own_end = cuts[i + 1];
+        window.start = window.own_start - std::min(window.own_start, overlap);
+        window.end = std::min(sample_count, window.own_end + overlap);
+        window.cut_in_pause = i < pause_cuts.size() && pause_cuts[i];
+        windows.push_back(window);
+    }
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    ++stats.recordings;
+    stats.windows += windows.size();
+    for (bool in_pause : pause_cuts) {
+        ++(in_pause ? stats.pause_cuts : stats.forced_cuts);
+    }
+    return windows;
+}
+
+size_t AudioChunker::findCut(const std::vector<bool>& speech, const std::vector<float>& energy, size_t frame_size,
+                             size_t earliest, size_t target, bool& in_pause) const {
+    in_pause = false;
+    if (speech.empty() || frame_size == 0) {
+        return target;
+    }
+    const size_t first = (earliest + frame_size - 1) / frame_size;
+    const size_t last = std::min(speech.size(), target / frame_size);
+    if (first >= last) {
+        return target;
+    }
+
+    // Longest run of non-speech frames; later runs win ties so windows stay long
+    size_t best_start = 0, best_length = 0, run_start = 0, run_length = 0;
+    for (size_t f = first; f < last; ++f) {
+        if (speech[f]) {
+            run_length = 0;
+            continue;
+        }
+        if (run_length++ == 0) {
+            run_start = f;
+        }
+        if (run_length >= best_length) {
+            best_start = run_start;
+            best_length = run_length;
+        }
+    }
+
+    const size_t min_pause_frames = std::max<size_t>(1,
+        static_cast<size_t>(options_.min_pause_seconds * options_.sample_rate) / frame_size);
+    if (best_length >= min_pause_frames) {
+        in_pause = true;
+        return best_start * frame_size + best_length * frame_size / 2;
+    }
+
+    // Speech throughout: the quietest frame is at least not the loudest part of a word
+    size_t quietest = first;
+    for (size_t f = first; f < last; ++f) {
+        if (energy[f] < energy[quietest]) {
+            quietest = f;
+        }
+    }
+    return quietest * frame_size + frame_size / 2;
+}
+
+bool AudioChunker::runParallel(size_t window_count, size_t parallelism, const std::function<bool(size_t)>& run) {
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    auto work = [&]() {
+        for (size_t i = next++; i < window_count && !failed; i = next++) {
+            bool ok = false;
+            try {
+                ok = run(i);
+            } catch (...) {
+                ok = false;
+            }
+            if (!ok) {
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < std::min(parallelism, window_count); ++i) {
+        helpers.emplace_back(work);
+    }
+    work();
+    for (auto& helper : helpers) {
+        helper.join();
+    }
+    return !failed;
+}
+
+ChunkingStats AudioChunker::getStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
+
+void AudioChunker::recordDeduplicatedWords(size_t words) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.deduplicated_words += words;
+}
+
+// [begin, end) of every whitespace-separated word
+static std::vector<std::pair<size_t, size_t>> wordSpans(const std::string& text) {
+    std::vector<std::pair<size_t, size_t>> spans;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        size_t begin = i;
+        while (i < text.size() && !std::isspace(static_cast<unsigned char>(text[i]))) {
+            ++i;
+        }
+        if (i > begin) {
+            spans.emplace_back(begin, i);
+        }
+    }
+    return spans;
+}
+
+// Lower-case letters and digits only, so "Home." matches "home"; punctuation-only words compare as written
+static std::string normalizedWord(const std::string& text, const std::pair<size_t, size_t>& span) {
+    std::string word;
+    for (size_t i = span.first; i < span.second; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (std::isalnum(c) || c >= 0x80) {
+            word += static_cast<char>(std::tolower(c));
+        }
+    }
+    return word.empty() ? text.substr(span.first, span.second - span.first) : word;
+}
+
+// Number of words at the start of next that repeat the end of previous; offset is where the rest of next begins
+static size_t repeatedWords(const std::string& previous, const std::string& next, size_t& offset) {
+    std::vector<std::pair<size_t, size_t>> tail = wordSpans(previous);
+    std::vector<std::pair<size_t, size_t>> head = wordSpans(next);
+    size_t longest = std::min({TranscriptStitcher::MAX_OVERLAP_WORDS, tail.size(), head.size()});
+    for (size_t k = longest; k > 0; --k) {
+        bool match = true;
+        for (size_t j = 0; j < k && match; ++j) {
+            match = normalizedWord(previous, tail[tail.size() - k + j]) == normalizedWord(next, head[j]);
+        }
+        if (match) {
+            offset = head[k - 1].second;
+            return k;
+        }
+    }
+    return 0;
+}
+
+TranscriptStitcher::TranscriptStitcher(const std::vector<AudioWindow>& windows, int sample_rate,
+                                       const TranscriptListener& listener)
+    : windows_(windows)
+    , sample_rate_(sample_rate)
+    , listener_(listener)
+    , pending_(windows.size())
+    , received_(windows.size(), false)
+    , windows_received_(0)
+    , next_to_flush_(0)
+    , stitched_()
+{
+}
+
+void TranscriptStitcher::addWindow(size_t index, const std::vector<TranscriptSegment>& segments) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= windows_.size() || received_[index]) {
+        return;
+    }
+
+    // The first and last windows also own whatever lies before or after the recording's cuts
+    const AudioWindow& window = windows_[index];
+    const double own_start = static_cast<double>(window.own_start) / sample_rate_;
+    const double own_end = static_cast<double>(window.own_end) / sample_rate_;
+    const bool first = index == 0;
+    const bool last = index + 1 == windows_.size();
+    for (const TranscriptSegment& segment : segments) {
+        double middle = (segment.start_seconds + segment.end_seconds) / 2.0;
+        if ((first || middle >= own_start) && (last || middle < own_end)) {
+            pending_[index].push_back(segment);
+        }
+    }
+
+    received_[index] = true;
+    ++windows_received_;
+    if (listener_.on_progress) {
+        listener_.on_progress(static_cast<int>(windows_received_ * 100 / windows_.size()));
+    }
+    flushLocked();
+}
+
+void TranscriptStitcher::flushLocked() {
+    while (next_to_flush_ < windows_.size() && received_[next_to_flush_]) {
+        bool boundary = next_to_flush_ > 0;
+        for (TranscriptSegment& segment : pending_[next_to_flush_]) {
+            // Only the first segment after a cut can repeat words the previous window already decoded
+            if (boundary && !stitched_.empty() && stitched_.back().end_seconds > segment.start_seconds) {
+                size_t offset = 0;
+                size_t words = repeatedWords(stitched_.back().text, segment.text, offset);
+                if (words > 0) {
+                    segment.text.erase(0, offset);
+                    AudioChunker::recordDeduplicatedWords(words);
+                }
+            }
+            boundary = false;
+            if (segment.text.find_first_not_of(" \t\n\r") == std::string::npos) {
+                continue;
+            }
+            stitched_.push_back(segment);
+            if (listener_.on_segment) {
+                listener_.on_segment(stitched_.back());
+            }
+        }
+        pending_[next_to_flush_].clear();
+        ++next_to_flush_;
+    }
+}
+
+bool TranscriptStitcher::complete() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return next_to_flush_ == windows_.size();
+}
+
+std::vector<TranscriptSegment> TranscriptStitcher::segments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stitched_;
+}
+
+std::string TranscriptStitcher::text() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string text;
+    for (const TranscriptSegment& segment : stitched_) {
+        text += segment.text;
+    }
+    text.erase(0, text.find_first_not_of(" \t\n\r"));
+    text.erase(text.find_last_not_of(" \t\n\r") + 1);
+    return text;
+}
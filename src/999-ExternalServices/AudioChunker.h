@@ -0,0 +1,163 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+#include "TranscriptSegment.h"
+
+/**
+ * @brief Where AudioChunker cuts a long recording
+ */
+enum class ChunkStrategy {
+    Off,        // One whisper_full over the whole recording
+    Fixed,      // Every window_seconds, wherever that falls
+    Pauses      // In the longest VAD pause shortly before every window_seconds (quietest frame if none)
+};
+
+/**
+ * @brief Window size and cut placement for AudioChunker
+ *
+ * Set once at server start from wt_config.xml (whisper-chunking, whisper-chunk-seconds)
+ * through AudioChunker::setDefaultOptions().
+ */
+struct ChunkingOptions {
+    ChunkStrategy strategy = ChunkStrategy::Pauses;
+    double min_audio_seconds = 60.0;    // Shorter recordings stay one whisper_full
+    double window_seconds = 30.0;       // Longest audio handed to whisper, overlaps included: one encoder window
+    double overlap_seconds = 1.0;       // Audio both neighbours decode on either side of a cut
+    double search_seconds = 6.0;        // How far before the target cut a pause is looked for
+    double min_pause_seconds = 0.1;     // Shorter runs of non-speech frames are not pauses
+    int sample_rate = 16000;
+
+    // Part of every transcript cache key: windows cut elsewhere transcribe differently
+    std::string cacheTag() const;
+
+    static const char* strategyName(ChunkStrategy strategy);
+
+    /**
+     * @brief "off", "fixed" or "pauses"
+     * @return false (strategy unchanged) for anything else
+     */
+    static bool parseStrategy(const std::string& name, ChunkStrategy& strategy);
+};
+
+/**
+ * @brief One window of a chunked recording, in samples
+ */
+struct AudioWindow {
+    size_t start = 0;           // Samples handed to whisper: [start, end)
+    size_t end = 0;
+    size_t own_start = 0;       // Segments centred in [own_start, own_end) belong to this window
+    size_t own_end = 0;
+    bool cut_in_pause = false;  // own_end was placed in a pause rather than forced
+};
+
+/**
+ * @brief Process-wide counters reported by AudioChunker::getStats()
+ */
+struct ChunkingStats {
+    uint64_t recordings = 0;            // Recordings split into more than one window
+    uint64_t windows = 0;
+    uint64_t pause_cuts = 0;
+    uint64_t forced_cuts = 0;           // No pause near the target: cut at the quietest frame or blindly
+    uint64_t deduplicated_words = 0;    // Words decoded twice across an overlap and dropped by the stitcher
+};
+
+/**
+ * @brief AudioChunker - Splits long recordings into windows that can be decoded in parallel
+ *
+ * One whisper_full over a long upload runs on a single state (or worker) for as long as
+ * the whole recording takes, however many others sit idle. Cut into windows of at most
+ * one encoder window (30 s), the recording can be spread over every idle state and
+ * stitched back together afterwards. Cuts go into the longest pause VoiceActivityDetector
+ * finds in the last search_seconds before each target, so words are rarely split; each
+ * window also decodes overlap_seconds past its cuts so a word that is split anyway ends
+ * up whole in one of the two neighbours, and TranscriptStitcher drops the copy.
+ */
+class AudioChunker {
+public:
+    explicit AudioChunker(const ChunkingOptions& options = defaultOptions());
+
+    static void setDefaultOptions(const ChunkingOptions& options);
+    static ChunkingOptions defaultOptions();
+
+    /**
+     * @brief True if a recording this long is split into more than one window
+     */
+    bool shouldSplit(size_t sample_count) const;
+
+    /**
+     * @brief Windows covering the samples, in order; a single window if shouldSplit() is false
+     */
+    std::vector<AudioWindow> plan(const float* samples, size_t sample_count) const;
+
+    const ChunkingOptions& options() const { return options_; }
+
+    /**
+     * @brief Call run(index) for every window on up to parallelism threads, the caller's included
+     * @return false if a run returned false; windows not yet started are then skipped
+     */
+    static bool runParallel(size_t window_count, size_t parallelism, const std::function<bool(size_t)>& run);
+
+    static ChunkingStats getStats();
+
+private:
+    friend class TranscriptStitcher;
+
+    // Cut position in [earliest, target], in samples
+    size_t findCut(const std::vector<bool>& speech, const std::vector<float>& energy, size_t frame_size,
+                   size_t earliest, size_t target, bool& in_pause) const;
+
+    static void recordDeduplicatedWords(size_t words);
+
+    ChunkingOptions options_;
+};
+
+/**
+ * @brief TranscriptStitcher - Joins the segments of a chunked recording back into one transcript
+ *
+ * Windows may finish in any order. Each keeps the segments whose midpoint lies in its own
+ * part of the recording; where neighbouring segments overlap in time, the words the later
+ * one repeats from the end of the earlier one are removed. Segments are passed to the
+ * listener in recording order as soon as every window before theirs is in, and progress
+ * is the share of windows done. Thread-safe; the listener is called under the lock.
+ */
+class TranscriptStitcher {
+public:
+    static constexpr size_t MAX_OVERLAP_WORDS = 8;
+
+    TranscriptStitcher(const std::vector<AudioWindow>& windows, int sample_rate,
+                       const TranscriptListener& listener = TranscriptListener());
+
+    /**
+     * @param segments Times relative to the start of the recording, not of the window
+     */
+    void addWindow(size_t index, const std::vector<TranscriptSegment>& segments);
+
+    bool complete() const;
+
+    /**
+     * @brief Stitched segments; only those of windows joined so far until complete()
+     */
+    std::vector<TranscriptSegment> segments() const;
+
+    /**
+     * @brief Concatenated segment text, trimmed like a single whisper_service transcript
+     */
+    std::string text() const;
+
+private:
+    void flushLocked();
+
+    mutable std::mutex mutex_;
+    std::vector<AudioWindow> windows_;
+    int sample_rate_;
+    TranscriptListener listener_;
+    std::vector<std::vector<TranscriptSegment>> pending_;
+    std::vector<bool> received_;
+    size_t windows_received_;
+    size_t next_to_flush_;
+    std::vector<TranscriptSegment> stitched_;
+};
@@ -0,0 +1,111 @@
+#include "BackgroundExecutor.h"
+#include <iostream>
+#include <algorithm>
+#include <exception>
+
+BackgroundExecutor& BackgroundExecutor::getInstance() {
+    static BackgroundExecutor instance("BackgroundExecutor", DEFAULT_THREADS, DEFAULT_MAX_QUEUED);
+    return instance;
+}
+
+BackgroundExecutor& BackgroundExecutor::getIoInstance() {
+    static BackgroundExecutor instance("BackgroundExecutor(io)", IO_THREADS, IO_MAX_QUEUED);
+    return instance;
+}
+
+BackgroundExecutor::BackgroundExecutor(const char* name, size_t threads, size_t max_queued)
+    : name_(name)
+    , shutdown_(false)
+    , thread_target_(threads)
+    , max_queued_(max_queued)
+    , running_(0)
+    , completed_(0)
+    , rejected_(0)
+    , failed_(0)
+{
+}
+
+BackgroundExecutor::~BackgroundExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void BackgroundExecutor::configure(size_t threads, size_t max_queued) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    thread_target_ = std::max<size_t>(1, threads);
+    max_queued_ = max_queued;
+}
+
+bool BackgroundExecutor::post(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() >= max_queued_) {
+            ++rejected_;
+            std::cout << name_ << ": queue full (" << queue_.size() << " queued), rejecting" << std::endl;
+            return false;
+        }
+
+        // Lazily start threads so processes that never post do not own idle ones
+        while (workers_.size() < thread_target_) {
+            workers_.emplace_back(&BackgroundExecutor::workerLoop, this);
+        }
+        queue_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+BackgroundExecutorStats BackgroundExecutor::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    BackgroundExecutorStats stats;
+    stats.threads = workers_.size();
+    stats.queued = queue_.size();
+    stats.running = running_;
+    stats.completed = completed_;
+    stats.rejected = rejected_;
+    stats.failed = failed_;
+    return stats;
+}
+
+void BackgroundExecutor::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cv_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+        if (shutdown_) {
+            return;
+        }
+
+        Job job = std::move(queue_.front());
+        queue_.pop_front();
+        ++running_;
+        lock.unlock();
+
+        bool ok = true;
+        try {
+            job();
+        } catch (const std::exception& e) {
+            ok = false;
+            std::cerr << name_ << ": job failed: " << e.what() << std::endl;
+        } catch (...) {
+            ok = false;
+            std::cerr << name_ << ": job failed with an unknown exception" << std::endl;
+        }
+        // Drop captures (callbacks, tokens) before taking the lock again
+        job = nullptr;
+
+        lock.lock();
+        --running_;
+        ++completed_;
+        if (!ok) {
+            ++failed_;
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <deque>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Counters reported by BackgroundExecutor::getStats()
+ */
+struct BackgroundExecutorStats {
+    size_t threads = 0;
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;      // Turned away because the queue was full
+    uint64_t failed = 0;        // Jobs that threw
+};
+
+/**
+ * @brief BackgroundExecutor - Fixed pool of threads for blocking work started from Wt sessions
+ *
+ * Wt's own worker threads must not block on a transcription, and a raw thread per
+ * request grows without bound when many users record at once. Jobs posted here run
+ * in FIFO order on a small fixed pool; the queue is bounded and post() returns false
+ * right away when it is full.
+ *
+ * Jobs run outside any session: they must not touch widgets and should hand their
+ * result back with WServer::post(session_id, ...).
+ *
+ * getInstance() is for longer blocking jobs; getIoInstance() is a separate pool for
+ * short file work (archiving and decoding uploads) so it never queues behind them.
+ * Transcriptions do not wait here: they are TranscriptionScheduler jobs.
+ */
+class BackgroundExecutor {
+public:
+    using Job = std::function<void()>;
+
+    static constexpr size_t DEFAULT_THREADS = 4;
+    static constexpr size_t DEFAULT_MAX_QUEUED = 64;
+    static constexpr size_t IO_THREADS = 2;
+    static constexpr size_t IO_MAX_QUEUED = 256;
+
+    static BackgroundExecutor& getInstance();
+    static BackgroundExecutor& getIoInstance();
+
+    BackgroundExecutor(const BackgroundExecutor&) = delete;
+    BackgroundExecutor& operator=(const BackgroundExecutor&) = delete;
+
+    /**
+     * @brief Change limits; threads are added on the fly, never removed
+     */
+    void configure(size_t threads, size_t max_queued);
+
+    /**
+     * @brief Queue a job
+     * @return false if the queue is full (the job was not queued)
+     */
+    bool post(Job job);
+
+    BackgroundExecutorStats getStats() const;
+
+private:
+    BackgroundExecutor(const char* name, size_t threads, size_t max_queued);
+    ~BackgroundExecutor();
+
+    void workerLoop();
+
+    const char* name_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<std::thread> workers_;
+    std::deque<Job> queue_;
+    bool shutdown_;
+
+    size_t thread_target_;
+    size_t max_queued_;
+
+    size_t running_;
+    uint64_t completed_;
+    uint64_t rejected_;
+    uint64_t failed_;
+};
@@ -0,0 +1,71 @@
+#include "CancellationToken.h"
+#include <algorithm>
+
+static std::mutex stats_mutex;
+static CancellationStats stats;
+
+std::shared_ptr<CancellationToken> CancellationToken::create() {
+    return std::shared_ptr<CancellationToken>(new CancellationToken());
+}
+
+CancellationToken::CancellationToken()
+    : cancelled_(false)
+    , next_handler_id_(1)
+{
+}
+
+void CancellationToken::cancel() {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    if (cancelled_.exchange(true)) {
+        return;
+    }
+    // Handlers are short (erase a queue entry, shut down a socket, kill a pid)
+    auto handlers = std::move(handlers_);
+    handlers_.clear();
+    for (auto& [id, handler] : handlers) {
+        handler();
+    }
+}
+
+bool CancellationToken::isCancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+}
+
+uint64_t CancellationToken::onCancel(Handler handler) {
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex_);
+        if (!cancelled_) {
+            uint64_t id = next_handler_id_++;
+            handlers_.emplace_back(id, std::move(handler));
+            return id;
+        }
+    }
+    handler();
+    return 0;
+}
+
+void CancellationToken::removeHandler(uint64_t id) {
+    if (id == 0) {
+        return;
+    }
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
+    handlers_.erase(std::remove_if(handlers_.begin(), handlers_.end(),
+                                   [id](const auto& entry) { return entry.first == id; }),
+                    handlers_.end());
+}
+
+void CancellationToken::recordSavings(bool was_running, double audio_seconds, double cpu_ms) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    if (was_running) {
+        ++stats.aborted_running;
+    } else {
+        ++stats.dropped_queued;
+    }
+    stats.saved_audio_seconds += std::max(0.0, audio_seconds);
+    stats.saved_cpu_ms += std::max(0.0, cpu_ms);
+}
+
+CancellationStats CancellationToken::getStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
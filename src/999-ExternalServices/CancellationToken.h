@@ -0,0 +1,70 @@
+#pragma once
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <utility>
+#include <cstdint>
+
+/**
+ * @brief Process-wide counters of work avoided by cancellation (CancellationToken::getStats())
+ */
+struct CancellationStats {
+    uint64_t dropped_queued = 0;      // Jobs removed before they started
+    uint64_t aborted_running = 0;     // Jobs stopped part way through inference
+    double saved_audio_seconds = 0.0; // Audio that was never transcribed
+    double saved_cpu_ms = 0.0;        // Estimated inference CPU time not spent
+};
+
+/**
+ * @brief CancellationToken - Shared flag that stops a transcription wherever it currently is
+ *
+ * The owner of a job (normally the widget that asked for it) keeps the token and calls
+ * cancel() when the result is no longer wanted. Each stage the job passes through
+ * registers a handler for as long as it holds the job: the scheduler drops it from the
+ * queue, the daemon client shuts down its socket, the CLI path kills the child process.
+ * Inference loops poll isCancelled() (whisper's abort callback).
+ */
+class CancellationToken {
+public:
+    using Handler = std::function<void()>;
+
+    static std::shared_ptr<CancellationToken> create();
+
+    CancellationToken(const CancellationToken&) = delete;
+    CancellationToken& operator=(const CancellationToken&) = delete;
+
+    /**
+     * @brief Set the flag and run every registered handler once (idempotent)
+     */
+    void cancel();
+    bool isCancelled() const;
+
+    /**
+     * @brief Run handler on cancel(); runs it right away if the token is already cancelled
+     * @return Id for removeHandler(), 0 if the handler already ran
+     */
+    uint64_t onCancel(Handler handler);
+
+    /**
+     * @brief Unregister a handler; after it returns the handler is not running and will not run
+     */
+    void removeHandler(uint64_t id);
+
+    /**
+     * @brief Account for work skipped because of a cancellation
+     * @param was_running true if inference had started, false if the job never left the queue
+     */
+    static void recordSavings(bool was_running, double audio_seconds, double cpu_ms);
+    static CancellationStats getStats();
+
+private:
+    CancellationToken();
+
+    std::atomic<bool> cancelled_;
+    // Held while handlers run so removeHandler() can wait for a running handler
+    mutable std::recursive_mutex mutex_;
+    std::vector<std::pair<uint64_t, Handler>> handlers_;
+    uint64_t next_handler_id_;
+};
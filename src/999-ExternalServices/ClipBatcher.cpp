@@ -0,0 +1,229 @@
+#include "ClipBatcher.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+// The clip nearest to the segment's midpoint owns it (separator time goes to the closer side)
+static size_t owningClip(const TranscriptSegment& segment, const std::vector<std::pair<double, double>>& clip_ranges) {
+    double midpoint = (segment.start_seconds + segment.end_seconds) / 2.0;
+    size_t owner = 0;
+    double best_distance = INFINITY;
+    for (size_t i = 0; i < clip_ranges.size(); ++i) {
+        double distance = std::max({0.0, clip_ranges[i].first - midpoint, midpoint - clip_ranges[i].second});
+        if (distance < best_distance) {
+            best_distance = distance;
+            owner = i;
+        }
+    }
+    return owner;
+}
+
+static TranscriptSegment toClipTime(const TranscriptSegment& segment, const std::pair<double, double>& clip_range) {
+    const double length = clip_range.second - clip_range.first;
+    TranscriptSegment local = segment;
+    local.start_seconds = std::clamp(segment.start_seconds - clip_range.first, 0.0, length);
+    local.end_seconds = std::clamp(segment.end_seconds - clip_range.first, 0.0, length);
+    return local;
+}
+
+ClipBatcher::ClipBatcher(const ClipBatcherOptions& options, Runner runner)
+    : options_(options)
+    , runner_(std::move(runner))
+    , leader_active_(false)
+    , in_flight_(0)
+    , callers_(0)
+{
+}
+
+ClipBatcher::InFlight::InFlight(ClipBatcher& batcher)
+    : batcher_(batcher)
+{
+    std::lock_guard<std::mutex> lock(batcher_.mutex_);
+    ++batcher_.in_flight_;
+}
+
+ClipBatcher::InFlight::~InFlight() {
+    {
+        std::lock_guard<std::mutex> lock(batcher_.mutex_);
+        --batcher_.in_flight_;
+    }
+    // A leader waiting for this request stops once it is answered without having queued a clip
+    batcher_.cv_.notify_all();
+}
+
+ClipBatchResult ClipBatcher::transcribe(const std::vector<float>& clip, int threads, const std::function<bool()>& should_abort,
+                                        const TranscriptListener& listener) {
+    Request request;
+    request.clip = &clip;
+    request.should_abort = &should_abort;
+    request.listener = &listener;
+    request.seconds = static_cast<double>(clip.size()) / options_.sample_rate;
+    request.threads = threads;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++callers_;
+    if (!enabled() || request.seconds > std::min(options_.max_clip_seconds, options_.max_packed_seconds)) {
+        // Arrived, but never joins a batch: a leader waiting for it can stop
+        cv_.notify_all();
+        lock.unlock();
+        runBatch({&request});
+        lock.lock();
+        --callers_;
+        return request.result;
+    }
+
+    pending_.push_back(&request);
+    cv_.notify_all();
+
+    while (!request.done) {
+        if (leader_active_) {
+            cv_.wait(lock);
+            continue;
+        }
+
+        // Lead: give other clips the window to show up, unless the batch is already full or
+        // every request in flight is already here
+        leader_active_ = true;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options_.window_ms);
+        cv_.wait_until(lock, deadline, [this]() {
+            return pendingSeconds() >= options_.max_packed_seconds || in_flight_ <= callers_;
+        });
+
+        std::vector<Request*> batch = takeBatch();
+        lock.unlock();
+        runBatch(batch);
+        lock.lock();
+
+        leader_active_ = false;
+        cv_.notify_all();
+    }
+    --callers_;
+    return request.result;
+}
+
+double ClipBatcher::pendingSeconds() const {
+    double seconds = 0.0;
+    for (const Request* request : pending_) {
+        seconds += request->seconds + options_.separator_seconds;
+    }
+    return seconds - options_.separator_seconds;
+}
+
+std::vector<ClipBatcher::Request*> ClipBatcher::takeBatch() {
+    // Oldest first; the first clip always fits because longer ones never get queued
+    std::vector<Request*> batch;
+    double seconds = 0.0;
+    while (!pending_.empty()) {
+        double added = pending_.front()->seconds + (batch.empty() ? 0.0 : options_.separator_seconds);
+        if (!batch.empty() && seconds + added > options_.max_packed_seconds) {
+            break;
+        }
+        seconds += added;
+        batch.push_back(pending_.front());
+        pending_.pop_front();
+    }
+    return batch;
+}
+
+void ClipBatcher::runBatch(const std::vector<Request*>& batch) {
+    const size_t separator = static_cast<size_t>(options_.separator_seconds * options_.sample_rate);
+
+    // Lay the clips end to end with silence in between
+    std::vector<float> packed;
+    std::vector<std::pair<double, double>> ranges;
+    if (batch.size() == 1) {
+        ranges.emplace_back(0.0, batch[0]->seconds);
+    } else {
+        size_t total = 0;
+        for (const Request* request : batch) {
+            total += request->clip->size() + separator;
+        }
+        packed.reserve(total);
+        for (const Request* request : batch) {
+            if (!packed.empty()) {
+                packed.insert(packed.end(), separator, 0.0f);
+            }
+            double start = static_cast<double>(packed.size()) / options_.sample_rate;
+            packed.insert(packed.end(), request->clip->begin(), request->clip->end());
+            ranges.emplace_back(start, start + request->seconds);
+        }
+    }
+    const std::vector<float>& audio = batch.size() == 1 ? *batch[0]->clip : packed;
+
+    // Only worth stopping when nobody in the batch wants a result anymore
+    auto should_abort = [&batch]() {
+        for (const Request* request : batch) {
+            if (!*request->should_abort || !(*request->should_abort)()) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    int threads = 0;
+    for (const Request* request : batch) {
+        threads = std::max(threads, request->threads);
+    }
+    
+    // Live segments are handed out by the same rule splitSegments applies to the final ones
+    TranscriptListener listener;
+    listener.on_segment = [&batch, &ranges](const TranscriptSegment& segment) {
+        size_t owner = owningClip(segment, ranges);
+        const TranscriptListener& target = *batch[owner]->listener;
+        if (target.on_segment) {
+            target.on_segment(toClipTime(segment, ranges[owner]));
+        }
+    };
+    listener.on_progress = [&batch](int percent) {
+        for (const Request* request : batch) {
+            if (request->listener->on_progress) {
+                request->listener->on_progress(percent);
+            }
+        }
+    };
+    
+    std::vector<TranscriptSegment> segments;
+    std::string error;
+    auto start_time = std::chrono::steady_clock::now();
+    bool success = runner_(audio, batch.size(), threads, should_abort, listener, segments, error);
+    double inference_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    std::vector<std::vector<TranscriptSegment>> per_clip;
+    if (success) {
+        per_clip = splitSegments(segments, ranges);
+    }
+    if (batch.size() > 1) {
+        std::cout << "ClipBatcher: " << batch.size() << " clips, " << static_cast<double>(audio.size()) / options_.sample_rate
+                  << "s packed, " << inference_ms << "ms" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < batch.size(); ++i) {
+        ClipBatchResult& result = batch[i]->result;
+        result.success = success;
+        result.error = error;
+        result.aborted = !success && should_abort();
+        result.batch_size = batch.size();
+        result.batch_audio_seconds = static_cast<double>(audio.size()) / options_.sample_rate;
+        result.inference_ms = inference_ms;
+        if (success) {
+            result.segments = std::move(per_clip[i]);
+        }
+        batch[i]->done = true;
+    }
+}
+
+std::vector<std::vector<TranscriptSegment>> ClipBatcher::splitSegments(
+    const std::vector<TranscriptSegment>& packed, const std::vector<std::pair<double, double>>& clip_ranges) {
+    std::vector<std::vector<TranscriptSegment>> per_clip(clip_ranges.size());
+    if (clip_ranges.empty()) {
+        return per_clip;
+    }
+
+    for (const TranscriptSegment& segment : packed) {
+        size_t owner = owningClip(segment, clip_ranges);
+        per_clip[owner].push_back(toClipTime(segment, clip_ranges[owner]));
+    }
+    return per_clip;
+}
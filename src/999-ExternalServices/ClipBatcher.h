@@ -0,0 +1,135 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include "TranscriptSegment.h"
+
+/**
+ * @brief Batching knobs (see whisper_service --batch-window-ms / --batch-max-seconds)
+ */
+struct ClipBatcherOptions {
+    int window_ms = 100;                // How long the first clip waits for company; 0 disables batching
+    double max_packed_seconds = 28.0;   // Stay inside whisper's 30 second encoder window
+    double max_clip_seconds = 10.0;     // Longer clips gain little from company and run alone right away
+    double separator_seconds = 1.0;     // Silence between clips so whisper closes a segment at each seam
+    int sample_rate = 16000;
+};
+
+/**
+ * @brief Result of one clip's share of a batch
+ */
+struct ClipBatchResult {
+    bool success = false;
+    bool aborted = false;
+    std::string error;
+    std::vector<TranscriptSegment> segments;   // Times relative to the clip
+    size_t batch_size = 0;                     // Clips that shared the inference run
+    double batch_audio_seconds = 0.0;          // Packed length, separators included
+    double inference_ms = 0.0;                 // Duration of the shared run
+};
+
+/**
+ * @brief ClipBatcher - Packs concurrent short clips into one whisper_full call
+ *
+ * whisper's encoder always processes a 30 second window, so a 3 second clip costs
+ * nearly as much as a 30 second one. Clips handed to transcribe() within window_ms
+ * of each other are laid end to end with silence in between, run once, and the
+ * segments are handed back to each clip by where their midpoint falls.
+ *
+ * There is no batching thread: the first waiting caller leads, collects what
+ * arrives during the window (or until max_packed_seconds is reached), runs the
+ * batch and wakes the others. Clips arriving while a batch runs form the next one.
+ * Clips longer than max_clip_seconds are run on their own without waiting.
+ *
+ * The window is only waited out while a request announced with InFlight has not
+ * reached transcribe() yet. A lone request (the server sends one at a time when
+ * its scheduler has a single worker) runs right away instead of idling for company
+ * that cannot come.
+ *
+ * Segments reported while a batch decodes go to the listener of the clip they fall
+ * in (same rule as splitSegments), progress to every listener in the batch.
+ */
+class ClipBatcher {
+public:
+    /**
+     * @brief Runs inference on packed audio
+     * @param clip_count Clips packed into audio (1 when it ran alone)
+     * @param threads Inference threads, the largest any clip in the batch asked for (0 = runner's default)
+     * @param should_abort Polled during inference, true when every caller in the batch gave up
+     * @param listener Segments (times in the packed audio) and progress while the run decodes
+     * @return false on failure (error filled in)
+     */
+    using Runner = std::function<bool(const std::vector<float>& audio, size_t clip_count, int threads,
+                                      const std::function<bool()>& should_abort, const TranscriptListener& listener,
+                                      std::vector<TranscriptSegment>& segments, std::string& error)>;
+
+    ClipBatcher(const ClipBatcherOptions& options, Runner runner);
+
+    ClipBatcher(const ClipBatcher&) = delete;
+    ClipBatcher& operator=(const ClipBatcher&) = delete;
+
+    /**
+     * @brief Marks a request that may call transcribe(), from when it arrives until it is answered
+     */
+    class InFlight {
+    public:
+        explicit InFlight(ClipBatcher& batcher);
+        ~InFlight();
+
+        InFlight(const InFlight&) = delete;
+        InFlight& operator=(const InFlight&) = delete;
+
+    private:
+        ClipBatcher& batcher_;
+    };
+
+    bool enabled() const { return options_.window_ms > 0; }
+    const ClipBatcherOptions& options() const { return options_; }
+
+    /**
+     * @brief Transcribe a clip, possibly together with others; blocks until done
+     * @param clip Mono samples at options().sample_rate
+     * @param threads Inference threads the caller was granted (0 = runner's default)
+     * @param should_abort Caller-specific abort check (may be empty)
+     * @param listener This clip's segments (times relative to the clip) and progress as they are decoded
+     */
+    ClipBatchResult transcribe(const std::vector<float>& clip, int threads, const std::function<bool()>& should_abort,
+                               const TranscriptListener& listener = TranscriptListener());
+
+    /**
+     * @brief Hand packed segments back to the clips they came from
+     * @param clip_ranges [start, end) of each clip in the packed buffer, in seconds
+     * @return One list per clip, times relative to that clip
+     */
+    static std::vector<std::vector<TranscriptSegment>> splitSegments(
+        const std::vector<TranscriptSegment>& packed, const std::vector<std::pair<double, double>>& clip_ranges);
+
+private:
+    struct Request {
+        const std::vector<float>* clip = nullptr;
+        const std::function<bool()>* should_abort = nullptr;
+        const TranscriptListener* listener = nullptr;
+        double seconds = 0.0;
+        int threads = 1;
+        bool done = false;
+        ClipBatchResult result;
+    };
+
+    double pendingSeconds() const;
+    std::vector<Request*> takeBatch();
+    void runBatch(const std::vector<Request*>& batch);
+
+    ClipBatcherOptions options_;
+    Runner runner_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Request*> pending_;
+    bool leader_active_;
+    size_t in_flight_;      // Open InFlight marks
+    size_t callers_;        // Threads inside transcribe()
+};
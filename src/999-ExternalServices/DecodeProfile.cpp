@@ -0,0 +1,31 @@
+#include "DecodeProfile.h"
+#include "whisper.h"
+#include <algorithm>
+#include <cmath>
+
+DecodeProfile DecodeProfile::forAudio(double seconds, size_t clip_count, const DecodeProfileOptions& options) {
+    DecodeProfile profile;
+    if (clip_count != 1 || seconds <= 0.0 || seconds >= options.short_clip_seconds) {
+        return profile;
+    }
+
+    int frames = static_cast<int>(std::ceil(seconds * FRAMES_PER_SECOND)) + options.audio_ctx_margin;
+    frames = std::clamp(frames, options.min_audio_ctx, FULL_AUDIO_CTX);
+    if (frames >= FULL_AUDIO_CTX) {
+        return profile;
+    }
+
+    profile.short_clip = true;
+    profile.audio_ctx = frames;
+    profile.single_segment = true;  // One window, nothing to split or carry over
+    profile.no_context = true;
+    return profile;
+}
+
+void DecodeProfile::apply(whisper_full_params& params) const {
+    params.audio_ctx = audio_ctx;
+    params.single_segment = single_segment;
+    if (no_context) {
+        params.no_context = true;
+    }
+}
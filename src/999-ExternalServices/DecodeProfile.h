@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+struct whisper_full_params;
+
+/**
+ * @brief Where the short-clip profile starts and how much encoder context it keeps
+ *
+ * Defaults come from bench/bench_short_clips (word error rate against reference
+ * transcripts for each setting); re-run it after changing model.
+ */
+struct DecodeProfileOptions {
+    double short_clip_seconds = 10.0;   // Clips below this use the short profile; 0 disables it
+    int audio_ctx_margin = 128;         // Encoder frames kept past the end of the clip (50 per second)
+    int min_audio_ctx = 256;            // Below ~5 s of context whisper starts dropping words
+
+    // Part of every transcript cache key: a changed profile must not serve old results
+    std::string cacheTag() const {
+        return short_clip_seconds > 0.0
+            ? "short<" + std::to_string(static_cast<int>(short_clip_seconds * 1000)) + "ms+" +
+              std::to_string(audio_ctx_margin) + "/" + std::to_string(min_audio_ctx)
+            : "full";
+    }
+};
+
+/**
+ * @brief DecodeProfile - Duration-aware whisper_full parameters
+ *
+ * whisper's encoder runs over a fixed 30 second window (1500 frames) however short
+ * the clip, so a 3 second recording pays for 27 seconds of padding. For clips under
+ * short_clip_seconds the short profile shrinks audio_ctx to the clip length plus a
+ * margin and decodes a single segment without carrying context between windows.
+ * Longer clips, and packed batches of several clips (which need their per-clip
+ * segments), keep the full-accuracy profile.
+ */
+struct DecodeProfile {
+    static constexpr int FULL_AUDIO_CTX = 1500;
+    static constexpr int FRAMES_PER_SECOND = 50;
+
+    bool short_clip = false;
+    int audio_ctx = 0;              // 0 = whisper's full 1500 frames
+    bool single_segment = false;
+    bool no_context = false;
+
+    /**
+     * @param seconds Length of the audio handed to whisper_full (after VAD)
+     * @param clip_count Clips packed into that audio by ClipBatcher
+     */
+    static DecodeProfile forAudio(double seconds, size_t clip_count = 1,
+                                  const DecodeProfileOptions& options = DecodeProfileOptions());
+
+    void apply(whisper_full_params& params) const;
+
+    const char* name() const { return short_clip ? "short" : "full"; }
+};
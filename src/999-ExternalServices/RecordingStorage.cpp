@@ -0,0 +1,204 @@
+#include "RecordingStorage.h"
+#include "BackgroundExecutor.h"
+#include <iostream>
+#include <algorithm>
+#include <mutex>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+// Per call; large enough that a typical recording moves in one or two system calls
+static constexpr size_t COPY_CHUNK_BYTES = 64 * 1024 * 1024;
+
+static std::mutex stats_mutex;
+static RecordingStorageStats stats;
+
+static double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool RecordingStorage::store(const std::string& source, const std::string& destination, Callback on_done) {
+    auto start = std::chrono::steady_clock::now();
+    RecordingStorageResult result;
+
+    if (destination.empty()) {
+        result.success = std::remove(source.c_str()) == 0 || errno == ENOENT;
+        result.method = RecordingStorageMethod::Removed;
+    } else if (std::rename(source.c_str(), destination.c_str()) == 0) {
+        result.success = true;
+        result.method = RecordingStorageMethod::Rename;
+    } else if (errno != EXDEV) {
+        result.error = "Cannot move " + source + " to " + destination + ": " + std::strerror(errno);
+    } else {
+        // Different file systems: the data has to move, which is not the caller's thread's job
+        return BackgroundExecutor::getIoInstance().post([source, destination, on_done]() {
+            RecordingStorageResult copied = copyAndRemove(source, destination);
+            if (on_done) {
+                on_done(copied);
+            }
+        });
+    }
+
+    result.elapsed_ms = millisecondsSince(start);
+    record(result);
+    if (on_done) {
+        on_done(result);
+    }
+    return true;
+}
+
+RecordingStorageResult RecordingStorage::copyAndRemove(const std::string& source, const std::string& destination) {
+    auto start = std::chrono::steady_clock::now();
+    std::string partial = destination + ".part";
+
+    RecordingStorageResult result = copyFile(source, partial);
+    if (result.success && std::rename(partial.c_str(), destination.c_str()) != 0) {
+        result.success = false;
+        result.method = RecordingStorageMethod::Failed;
+        result.error = "Cannot rename " + partial + ": " + std::strerror(errno);
+    }
+    if (!result.success) {
+        std::remove(partial.c_str());
+    }
+    std::remove(source.c_str());
+
+    result.elapsed_ms = millisecondsSince(start);
+    record(result);
+    return result;
+}
+
+RecordingStorageResult RecordingStorage::copyFile(const std::string& source, const std::string& destination) {
+    RecordingStorageResult result;
+
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        result.error = "Cannot open " + source + ": " + std::strerror(errno);
+        return result;
+    }
+    struct stat info;
+    if (fstat(in, &info) != 0) {
+        result.error = "Cannot stat " + source + ": " + std::strerror(errno);
+        close(in);
+        return result;
+    }
+    int out = open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (out < 0) {
+        result.error = "Cannot create " + destination + ": " + std::strerror(errno);
+        close(in);
+        return result;
+    }
+
+    const uint64_t size = static_cast<uint64_t>(info.st_size);
+    uint64_t copied = 0;
+    result.method = RecordingStorageMethod::CopyFileRange;
+
+    // Each method picks up where the previous one stopped; offsets are the shared file positions
+    while (copied < size && result.method == RecordingStorageMethod::CopyFileRange) {
+        ssize_t count = copy_file_range(in, nullptr, out, nullptr, std::min<uint64_t>(size - copied, COPY_CHUNK_BYTES), 0);
+        if (count > 0) {
+            copied += static_cast<uint64_t>(count);
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count == 0 || errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP) {
+            result.method = RecordingStorageMethod::Sendfile;
+        } else {
+            result.method = RecordingStorageMethod::Failed;
+        }
+    }
+    while (copied < size && result.method == RecordingStorageMethod::Sendfile) {
+        ssize_t count = sendfile(out, in, nullptr, std::min<uint64_t>(size - copied, COPY_CHUNK_BYTES));
+        if (count > 0) {
+            copied += static_cast<uint64_t>(count);
+        } else if (count < 0 && errno == EINTR) {
+            continue;
+        } else if (count == 0 || errno == EINVAL || errno == ENOSYS) {
+            result.method = RecordingStorageMethod::ReadWrite;
+        } else {
+            result.method = RecordingStorageMethod::Failed;
+        }
+    }
+    char buffer[64 * 1024];
+    while (copied < size && result.method == RecordingStorageMethod::ReadWrite) {
+        ssize_t count = read(in, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            result.method = RecordingStorageMethod::Failed;
+            break;
+        }
+        for (ssize_t written = 0; written < count;) {
+            ssize_t step = write(out, buffer + written, static_cast<size_t>(count - written));
+            if (step < 0 && errno == EINTR) {
+                continue;
+            }
+            if (step <= 0) {
+                result.method = RecordingStorageMethod::Failed;
+                break;
+            }
+            written += step;
+        }
+        copied += static_cast<uint64_t>(count);
+    }
+
+    int saved_errno = errno;
+    close(in);
+    if (close(out) != 0 && result.method != RecordingStorageMethod::Failed) {
+        saved_errno = errno;
+        result.method = RecordingStorageMethod::Failed;
+    }
+
+    result.bytes = copied;
+    result.success = result.method != RecordingStorageMethod::Failed && copied == size;
+    if (!result.success) {
+        result.method = RecordingStorageMethod::Failed;
+        result.error = "Cannot copy " + source + " to " + destination + ": " + std::strerror(saved_errno);
+    }
+    return result;
+}
+
+const char* RecordingStorage::methodName(RecordingStorageMethod method) {
+    switch (method) {
+        case RecordingStorageMethod::Rename: return "rename";
+        case RecordingStorageMethod::CopyFileRange: return "copy_file_range";
+        case RecordingStorageMethod::Sendfile: return "sendfile";
+        case RecordingStorageMethod::ReadWrite: return "read/write";
+        case RecordingStorageMethod::Removed: return "removed";
+        case RecordingStorageMethod::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+void RecordingStorage::record(const RecordingStorageResult& result) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    switch (result.method) {
+        case RecordingStorageMethod::Rename:
+            ++stats.renamed;
+            break;
+        case RecordingStorageMethod::CopyFileRange:
+        case RecordingStorageMethod::Sendfile:
+        case RecordingStorageMethod::ReadWrite:
+            ++stats.copied;
+            stats.sendfile_fallbacks += result.method == RecordingStorageMethod::Sendfile;
+            stats.read_write_fallbacks += result.method == RecordingStorageMethod::ReadWrite;
+            stats.bytes_copied += result.bytes;
+            stats.copy_ms_total += result.elapsed_ms;
+            break;
+        case RecordingStorageMethod::Failed:
+            ++stats.failed;
+            std::cerr << "RecordingStorage: " << result.error << std::endl;
+            break;
+        case RecordingStorageMethod::Removed:
+            break;
+    }
+}
+
+RecordingStorageStats RecordingStorage::getStats() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    return stats;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief How a recording reached its destination
+ */
+enum class RecordingStorageMethod {
+    Rename,         // Same file system: only the directory entry moved
+    CopyFileRange,  // In-kernel copy (reflink on file systems that support it)
+    Sendfile,       // In-kernel copy for kernels/file systems without copy_file_range
+    ReadWrite,      // Plain user-space copy, last resort
+    Removed,        // No destination: the source was deleted
+    Failed
+};
+
+struct RecordingStorageResult {
+    bool success = false;
+    RecordingStorageMethod method = RecordingStorageMethod::Failed;
+    uint64_t bytes = 0;         // Bytes copied (0 for a rename)
+    double elapsed_ms = 0.0;
+    std::string error;
+};
+
+/**
+ * @brief Counters reported by RecordingStorage::getStats()
+ */
+struct RecordingStorageStats {
+    uint64_t renamed = 0;
+    uint64_t copied = 0;        // Any of the copy methods
+    uint64_t sendfile_fallbacks = 0;
+    uint64_t read_write_fallbacks = 0;
+    uint64_t failed = 0;
+    uint64_t bytes_copied = 0;
+    double copy_ms_total = 0.0;
+};
+
+/**
+ * @brief RecordingStorage - Moves uploaded recordings into the archive without copying in user space
+ *
+ * store() first tries rename(2), which is a metadata update when the Wt spool directory and
+ * the docroot share a file system, and returns right away. Otherwise the copy is queued on
+ * BackgroundExecutor's I/O pool: copy_file_range(2) (which also reflinks on btrfs/XFS),
+ * falling back to sendfile(2) and finally read/write. The copy goes to "<destination>.part"
+ * and is renamed into place when complete, so a half-written file is never visible under
+ * the final name; the source is removed afterwards either way.
+ *
+ * The caller may keep reading the source through a descriptor it opened before store().
+ */
+class RecordingStorage {
+public:
+    using Callback = std::function<void(const RecordingStorageResult& result)>;
+
+    /**
+     * @brief Move source to destination (or delete source when destination is empty)
+     * @param on_done Optional; called inline after a rename, from the I/O pool after a copy
+     * @return false if the copy could not be queued (source is left in place)
+     */
+    static bool store(const std::string& source, const std::string& destination, Callback on_done = nullptr);
+
+    /**
+     * @brief The synchronous fallback behind store(): copy, then remove the source
+     */
+    static RecordingStorageResult copyAndRemove(const std::string& source, const std::string& destination);
+
+    static const char* methodName(RecordingStorageMethod method);
+
+    static RecordingStorageStats getStats();
+
+private:
+    static RecordingStorageResult copyFile(const std::string& source, const std::string& destination);
+    static void record(const RecordingStorageResult& result);
+};
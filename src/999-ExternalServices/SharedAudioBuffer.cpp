@@ -0,0 +1,188 @@
+#include "SharedAudioBuffer.h"
+#include "Audio/WavReader.h"
+#include "Audio/Resampler.h"
+#include "Audio/RiceCodec.h"
+#include "Audio/PcmDecoder.h"
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#include <limits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+
+static void writeLe16(unsigned char* p, uint16_t value) {
+    p[0] = static_cast<unsigned char>(value);
+    p[1] = static_cast<unsigned char>(value >> 8);
+}
+
+static void writeLe32(unsigned char* p, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+static bool writeAll(int fd, const void* data, size_t size) {
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t written = write(fd, cursor, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+std::shared_ptr<SharedAudioBuffer> SharedAudioBuffer::fromWavFile(const std::string& file_path, std::string& error) {
+    WavReader reader;
+    if (!reader.open(file_path)) {
+        error = reader.getLastError();
+        return nullptr;
+    }
+    return fromReader(reader, file_path, error);
+}
+
+std::shared_ptr<SharedAudioBuffer> SharedAudioBuffer::fromUploadDescriptor(int fd, const std::string& source_path,
+                                                                           std::string& error) {
+    unsigned char magic[RiceCodec::HEADER_BYTES];
+    ssize_t peeked = pread(fd, magic, sizeof(magic), 0);
+    if (peeked > 0 && RiceCodec::isEncoded(magic, static_cast<size_t>(peeked))) {
+        return fromRiceDescriptor(fd, source_path, error);
+    }
+
+    WavReader reader;
+    if (!reader.openDescriptor(fd)) {
+        error = reader.getLastError();
+        return nullptr;
+    }
+    return fromReader(reader, source_path, error);
+}
+
+std::shared_ptr<SharedAudioBuffer> SharedAudioBuffer::fromPcm(const int16_t* samples, size_t sample_count,
+                                                              const std::string& source_path, std::string& error) {
+    std::vector<float> converted(sample_count);
+    PcmDecoder::int16ToMono(samples, sample_count, 1, converted.data());
+    return fromSamples(converted, SAMPLE_RATE, source_path, error);
+}
+
+std::shared_ptr<SharedAudioBuffer> SharedAudioBuffer::fromRiceDescriptor(int fd, const std::string& source_path,
+                                                                         std::string& error) {
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        error = "Cannot stat " + source_path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        error = "Cannot map " + source_path + ": " + std::strerror(errno);
+        return nullptr;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    std::vector<int16_t> pcm;
+    uint32_t sample_rate = 0;
+    bool decoded = RiceCodec::decode(mapping, size, pcm, sample_rate, error);
+    munmap(mapping, size);
+    if (!decoded) {
+        error += ": " + source_path;
+        return nullptr;
+    }
+
+    std::vector<float> samples(pcm.size());
+    PcmDecoder::int16ToMono(pcm.data(), pcm.size(), 1, samples.data());
+    return fromSamples(samples, static_cast<int>(sample_rate), source_path, error);
+}
+
+std::shared_ptr<SharedAudioBuffer> SharedAudioBuffer::fromReader(WavReader& reader, const std::string& file_path,
+                                                                 std::string& error) {
+    std::vector<float> samples;
+    reader.decodeMono(samples);
+    int sample_rate = static_cast<int>(reader.format().sample_rate);
+    reader.close();
+    return fromSamples(samples, sample_rate, file_path, error);
+}
+
+std::shared_ptr<SharedAudioBuffer> SharedAudioBuffer::fromSamples(std::vector<float>& samples, int sample_rate,
+                                                                  const std::string& file_path, std::string& error) {
+    if (!Resampler::toWhisperRate(samples, sample_rate)) {
+        error = "Invalid sample rate in " + file_path;
+        return nullptr;
+    }
+
+    const size_t data_bytes = samples.size() * sizeof(float);
+    if (data_bytes > std::numeric_limits<uint32_t>::max() - HEADER_BYTES) {
+        error = "Audio too long: " + file_path;
+        return nullptr;
+    }
+
+    unsigned char header[HEADER_BYTES];
+    std::memcpy(header, "RIFF", 4);
+    writeLe32(header + 4, static_cast<uint32_t>(HEADER_BYTES - 8 + data_bytes));
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    writeLe32(header + 16, 16);
+    writeLe16(header + 20, WAVE_FORMAT_IEEE_FLOAT);
+    writeLe16(header + 22, 1);
+    writeLe32(header + 24, SAMPLE_RATE);
+    writeLe32(header + 28, SAMPLE_RATE * sizeof(float));
+    writeLe16(header + 32, sizeof(float));
+    writeLe16(header + 34, 32);
+    std::memcpy(header + 36, "data", 4);
+    writeLe32(header + 40, static_cast<uint32_t>(data_bytes));
+
+    int fd = memfd_create("whisper-audio", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+        error = "Cannot create memfd: " + std::string(std::strerror(errno));
+        return nullptr;
+    }
+    if (!writeAll(fd, header, sizeof(header)) || !writeAll(fd, samples.data(), data_bytes)) {
+        error = "Cannot write memfd: " + std::string(std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    // Receivers map it; make sure nobody can shrink or rewrite it while they do
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        error = "Cannot seal memfd: " + std::string(std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    const size_t mapping_size = HEADER_BYTES + data_bytes;
+    void* mapping = mmap(nullptr, mapping_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        error = "Cannot map memfd: " + std::string(std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    return std::shared_ptr<SharedAudioBuffer>(
+        new SharedAudioBuffer(fd, mapping, mapping_size, samples.size(), file_path));
+}
+
+SharedAudioBuffer::SharedAudioBuffer(int fd, void* mapping, size_t mapping_size, size_t sample_count,
+                                     const std::string& source_path)
+    : fd_(fd)
+    , mapping_(mapping)
+    , mapping_size_(mapping_size)
+    , samples_(reinterpret_cast<const float*>(static_cast<const unsigned char*>(mapping) + HEADER_BYTES))
+    , sample_count_(sample_count)
+    , source_path_(source_path)
+{
+}
+
+SharedAudioBuffer::~SharedAudioBuffer() {
+    munmap(mapping_, mapping_size_);
+    close(fd_);
+}
+
+std::string SharedAudioBuffer::procPath() const {
+    return "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd_);
+}
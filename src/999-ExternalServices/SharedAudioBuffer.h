@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+class WavReader;
+
+/**
+ * @brief SharedAudioBuffer - An upload decoded once into a sealed memfd
+ *
+ * The memfd holds a complete WAV file of 32-bit float, mono, 16kHz samples, which is
+ * exactly what whisper consumes, so the transcription side neither resamples nor
+ * touches the disk. The descriptor is handed to the daemon with SCM_RIGHTS; the
+ * one-shot CLI fallback opens it as /proc/<pid>/fd/<n>. After writing, the memfd is
+ * sealed against writes and resizing, so a receiver can map it without fearing
+ * SIGBUS or the samples changing underneath it.
+ *
+ * The server keeps a read-only mapping for the cache key; the buffer (descriptor and
+ * mapping) goes away with the last shared_ptr.
+ */
+class SharedAudioBuffer {
+public:
+    static constexpr int SAMPLE_RATE = 16000;
+    static constexpr size_t HEADER_BYTES = 44;  // Canonical RIFF/fmt/data header
+
+    /**
+     * @brief Decode a WAV file (any rate, channel count and sample format WavReader supports)
+     * @param error Set when nullptr is returned
+     */
+    static std::shared_ptr<SharedAudioBuffer> fromWavFile(const std::string& file_path, std::string& error);
+
+    /**
+     * @brief Decode an upload from an open descriptor, which stays owned by the caller
+     * @param source_path Where the descriptor came from, for logging
+     *
+     * Accepts WAV as well as the recorder's RiceCodec encoding, told apart by their magic.
+     * Lets the caller open an upload, hand the file itself to RecordingStorage and still
+     * decode it afterwards, whatever has happened to the path in the meantime.
+     */
+    static std::shared_ptr<SharedAudioBuffer> fromUploadDescriptor(int fd, const std::string& source_path, std::string& error);
+
+    /**
+     * @brief Copy 16kHz mono signed 16-bit samples, e.g. a live stream's window, into a buffer
+     * @param source_path What the samples are, for logging
+     */
+    static std::shared_ptr<SharedAudioBuffer> fromPcm(const int16_t* samples, size_t sample_count,
+                                                      const std::string& source_path, std::string& error);
+
+    ~SharedAudioBuffer();
+
+    SharedAudioBuffer(const SharedAudioBuffer&) = delete;
+    SharedAudioBuffer& operator=(const SharedAudioBuffer&) = delete;
+
+    int fd() const { return fd_; }
+    const float* samples() const { return samples_; }
+    size_t sampleCount() const { return sample_count_; }
+    double durationSeconds() const { return static_cast<double>(sample_count_) / SAMPLE_RATE; }
+
+    // Where the samples came from, for logging
+    const std::string& sourcePath() const { return source_path_; }
+
+    /**
+     * @brief Path another process of the same user can open the buffer through
+     */
+    std::string procPath() const;
+
+private:
+    static std::shared_ptr<SharedAudioBuffer> fromRiceDescriptor(int fd, const std::string& source_path, std::string& error);
+    static std::shared_ptr<SharedAudioBuffer> fromReader(WavReader& reader, const std::string& file_path, std::string& error);
+    static std::shared_ptr<SharedAudioBuffer> fromSamples(std::vector<float>& samples, int sample_rate,
+                                                          const std::string& file_path, std::string& error);
+
+    SharedAudioBuffer(int fd, void* mapping, size_t mapping_size, size_t sample_count, const std::string& source_path);
+
+    int fd_;
+    void* mapping_;
+    size_t mapping_size_;
+    const float* samples_;
+    size_t sample_count_;
+    std::string source_path_;
+};
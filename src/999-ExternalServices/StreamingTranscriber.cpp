@@ -0,0 +1,209 @@
+#include "StreamingTranscriber.h"
+#include "WhisperCliService.h"
+#include "CancellationToken.h"
+#include "TranscriptionScheduler.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+StreamingTranscriber::StreamingTranscriber(const std::string& whisper_executable_path,
+                                           const std::string& model_path,
+                                           const std::string& socket_path,
+                                           const std::string& session_id,
+                                           UpdateCallback callback)
+    : service_(std::make_unique<WhisperCliService>())
+    , session_id_(session_id)
+    , callback_(std::move(callback))
+    , cancel_token_(CancellationToken::create())
+    , last_run_end_(0)
+    , pass_pending_(false)
+    , finished_(false)
+    , final_pass_started_(false)
+    , cancelled_(false)
+{
+    service_->initialize(whisper_executable_path, model_path);
+    service_->enableDaemon(socket_path);
+    // Segment times come back in window coordinates either way, so commits stay aligned
+    service_->setVadEnabled(true);
+    // A running pass is aborted through its daemon connection
+    service_->setCancellationToken(cancel_token_);
+}
+
+StreamingTranscriber::~StreamingTranscriber() {
+    // Queued and running passes hold a shared_ptr to us, so by now none is left
+}
+
+std::shared_ptr<StreamingTranscriber> StreamingTranscriber::create(const std::string& whisper_executable_path,
+                                                                   const std::string& model_path,
+                                                                   const std::string& socket_path,
+                                                                   const std::string& session_id,
+                                                                   UpdateCallback callback) {
+    return std::shared_ptr<StreamingTranscriber>(
+        new StreamingTranscriber(whisper_executable_path, model_path, socket_path, session_id, std::move(callback)));
+}
+
+void StreamingTranscriber::appendSamples(const int16_t* samples, size_t count) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (finished_ || cancelled_) {
+            return;
+        }
+        buffer_.insert(buffer_.end(), samples, samples + count);
+    }
+    schedulePass();
+}
+
+void StreamingTranscriber::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    schedulePass();
+}
+
+void StreamingTranscriber::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    // Drops a queued pass from the scheduler and aborts a running one
+    cancel_token_->cancel();
+}
+
+size_t StreamingTranscriber::bufferedSamples() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buffer_.size();
+}
+
+void StreamingTranscriber::schedulePass() {
+    double window_seconds;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pass_pending_ || cancelled_ || final_pass_started_ ||
+            (!finished_ && buffer_.size() < last_run_end_ + STEP_SAMPLES)) {
+            return;
+        }
+        pass_pending_ = true;
+        window_seconds = static_cast<double>(buffer_.size()) / SAMPLE_RATE;
+    }
+
+    auto self = shared_from_this();
+    uint64_t job_id = TranscriptionScheduler::getInstance().submit(
+        session_id_, window_seconds, [self]() { self->runPass(); }, nullptr, cancel_token_);
+    if (job_id != 0) {
+        return;
+    }
+
+    // Queue full: the next chunk tries again, only a last pass that cannot wait has to report it
+    bool final_pass;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pass_pending_ = false;
+        final_pass = finished_ && !cancelled_;
+        final_pass_started_ = final_pass_started_ || final_pass;
+    }
+    if (final_pass) {
+        StreamingUpdate update;
+        update.final = true;
+        update.error = "Server busy, please try again in a moment";
+        update.committed_text = committed_text_;
+        callback_(update);
+    }
+}
+
+void StreamingTranscriber::runPass() {
+    std::vector<int16_t> window;
+    bool final_pass = false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            pass_pending_ = false;
+            return;
+        }
+        final_pass = finished_;
+        final_pass_started_ = final_pass;
+        window = buffer_;
+        last_run_end_ = buffer_.size();
+    }
+
+    StreamingUpdate update;
+    update.final = final_pass;
+
+    if (window.empty()) {
+        update.committed_text = committed_text_;
+        callback_(update);
+        return;
+    }
+
+    json response = service_->transcribePcm(window);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (cancelled_) {
+            pass_pending_ = false;
+            return;
+        }
+    }
+
+    // Samples at the front of buffer_ that the next pass no longer covers
+    size_t committed_samples = 0;
+
+    if (!response.value("success", false)) {
+        update.error = response.value("error", std::string("Transcription failed"));
+        if (!final_pass && window.size() >= MAX_WINDOW_SAMPLES) {
+            // Audio a failed pass missed is lost to the preview; keep the tail at one window
+            committed_samples = window.size() - (MAX_WINDOW_SAMPLES - STEP_SAMPLES);
+        }
+        update.committed_text = committed_text_;
+        callback_(update);
+    } else {
+        const json& segments = response["segments"];
+        size_t keep_from = segments.size(); // First segment that stays uncommitted
+
+        if (final_pass) {
+            for (const auto& segment : segments) {
+                committed_text_ += segment.value("text", std::string());
+            }
+        } else if (window.size() >= COMMIT_SAMPLES && segments.size() >= 2) {
+            // The last segment may still be cut mid-word; everything before it is stable
+            keep_from = segments.size() - 1;
+        } else if (window.size() >= MAX_WINDOW_SAMPLES) {
+            // One long segment: commit it anyway to keep the next pass short
+            keep_from = segments.size();
+        } else {
+            keep_from = 0;
+        }
+
+        if (!final_pass && keep_from > 0) {
+            for (size_t i = 0; i < keep_from; ++i) {
+                committed_text_ += segments[i].value("text", std::string());
+            }
+            committed_samples = keep_from < segments.size()
+                ? static_cast<size_t>(std::lround(segments[keep_from].value("start_time", 0.0) * SAMPLE_RATE))
+                : window.size();
+            committed_samples = std::min(committed_samples, window.size());
+        } else if (!final_pass && segments.empty() && window.size() >= MAX_WINDOW_SAMPLES) {
+            // Nothing heard in a whole window: drop all but its end, where a word may be starting
+            committed_samples = window.size() - (MAX_WINDOW_SAMPLES - STEP_SAMPLES);
+        }
+
+        for (size_t i = keep_from; i < segments.size(); ++i) {
+            update.partial_text += segments[i].value("text", std::string());
+        }
+        update.committed_text = committed_text_;
+        callback_(update);
+    }
+
+    if (final_pass) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer_.erase(buffer_.begin(), buffer_.begin() + committed_samples);
+        last_run_end_ -= committed_samples;
+        pass_pending_ = false;
+    }
+    // Audio that arrived (or finish() called) while this pass ran
+    schedulePass();
+}
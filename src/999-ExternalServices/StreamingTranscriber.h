@@ -0,0 +1,97 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+class CancellationToken;
+class WhisperCliService;
+
+/**
+ * @brief Snapshot of a live transcription pushed to the UI
+ */
+struct StreamingUpdate {
+    std::string committed_text;  // Text that will not change anymore
+    std::string partial_text;    // Best guess for the audio after the committed part
+    bool final = false;          // Recording stopped and all audio has been transcribed
+    std::string error;           // Set when the last transcription attempt failed
+};
+
+/**
+ * @brief StreamingTranscriber - Sliding-window transcription of audio that is still being recorded
+ *
+ * Samples are appended while the user speaks. Every STEP_SAMPLES of new audio a pass
+ * re-transcribes the uncommitted tail of the buffer through the whisper daemon. Once the
+ * tail is long enough, every segment but the last is committed and dropped from the
+ * buffer, so each pass only covers the last few seconds and the time-to-first-word does
+ * not grow with the length of the recording. A tail in which whisper hears nothing is
+ * cut back to one window, so a silent stream costs the same per pass as a spoken one.
+ *
+ * Passes are TranscriptionScheduler jobs of the recording's session, one at a time, so
+ * live recordings share the transcriber fairly with uploads and take their threads from
+ * ThreadBudget. Queued passes hold a shared_ptr to the transcriber: the owner can let go
+ * of it (or cancel()) without waiting for a running pass.
+ */
+class StreamingTranscriber : public std::enable_shared_from_this<StreamingTranscriber> {
+public:
+    using UpdateCallback = std::function<void(const StreamingUpdate&)>;
+
+    static constexpr int SAMPLE_RATE = 16000;
+    static constexpr size_t STEP_SAMPLES = SAMPLE_RATE;              // Re-run after 1s of new audio
+    static constexpr size_t COMMIT_SAMPLES = 10 * SAMPLE_RATE;       // Commit segments once the tail reaches 10s
+    static constexpr size_t MAX_WINDOW_SAMPLES = 25 * SAMPLE_RATE;   // Stay below whisper's 30s window
+
+    /**
+     * @brief Create a transcriber; passes start as samples arrive
+     * @param whisper_executable_path whisper_service executable (used to spawn the daemon)
+     * @param model_path Whisper model file
+     * @param socket_path Daemon socket
+     * @param session_id TranscriptionScheduler fairness domain, normally the Wt session id
+     * @param callback Called from a scheduler thread after every pass
+     */
+    static std::shared_ptr<StreamingTranscriber> create(const std::string& whisper_executable_path,
+                                                        const std::string& model_path,
+                                                        const std::string& socket_path,
+                                                        const std::string& session_id,
+                                                        UpdateCallback callback);
+    ~StreamingTranscriber();
+
+    // Append 16kHz mono samples in recording order
+    void appendSamples(const int16_t* samples, size_t count);
+
+    // No more samples will arrive; a last pass runs and reports final = true
+    void finish();
+
+    // Stop as soon as possible without reporting anything else
+    void cancel();
+
+    // Uncommitted audio the next pass will cover, in samples
+    size_t bufferedSamples();
+
+private:
+    StreamingTranscriber(const std::string& whisper_executable_path,
+                         const std::string& model_path,
+                         const std::string& socket_path,
+                         const std::string& session_id,
+                         UpdateCallback callback);
+
+    // Queue the next pass if enough audio is waiting and none is queued or running
+    void schedulePass();
+    void runPass();
+
+    std::unique_ptr<WhisperCliService> service_;   // Only used by the one pass in flight
+    std::string session_id_;
+    UpdateCallback callback_;
+    std::shared_ptr<CancellationToken> cancel_token_;
+
+    std::mutex mutex_;
+    std::vector<int16_t> buffer_;   // Uncommitted audio only
+    size_t last_run_end_;           // buffer_ size covered by the last pass
+    bool pass_pending_;             // A pass is queued or running
+    bool finished_;
+    bool final_pass_started_;
+    bool cancelled_;
+    std::string committed_text_;    // Written by passes only, which never overlap
+};
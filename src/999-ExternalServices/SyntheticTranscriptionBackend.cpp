@@ -0,0 +1,276 @@
+#include "SyntheticTranscriptionBackend.h"
+#include "CancellationToken.h"
+#include "SharedAudioBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static const char* const WORDS[] = {
+    "the", "recording", "of", "a", "meeting", "about", "next", "week", "and", "schedule",
+    "we", "should", "review", "draft", "before", "release", "please", "send", "notes", "to",
+    "team", "budget", "for", "project", "is", "on", "track", "thanks", "everyone", "today"
+};
+static constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+static constexpr double WORDS_PER_SECOND = 2.5;
+static constexpr double TWO_PI = 6.283185307179586;
+
+// splitmix64: a generator whose output is the same on every platform, unlike <random>'s distributions
+class SyntheticRandom {
+public:
+    explicit SyntheticRandom(uint64_t seed) : state_(seed) {}
+
+    uint64_t next() {
+        uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1)
+    double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    // Standard normal, Box-Muller
+    double normal() {
+        double u1 = 1.0 - uniform();
+        return std::sqrt(-2.0 * std::log(u1)) * std::cos(TWO_PI * uniform());
+    }
+
+private:
+    uint64_t state_;
+};
+
+static uint64_t fnv1a(const std::string& text, uint64_t hash = 0xCBF29CE484222325ull) {
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+std::string SyntheticBackendOptions::describe() const {
+    std::ostringstream spec;
+    spec << "distribution=" << distributionName(distribution) << ",base-ms=" << base_ms
+         << ",per-second-ms=" << per_second_ms << ",spread=" << spread << ",failure-rate=" << failure_rate
+         << ",cpu-burn=" << cpu_burn << ",segment-seconds=" << segment_seconds << ",seed=" << seed;
+    return spec.str();
+}
+
+const char* SyntheticBackendOptions::distributionName(LatencyDistribution distribution) {
+    switch (distribution) {
+        case LatencyDistribution::Fixed: return "fixed";
+        case LatencyDistribution::Uniform: return "uniform";
+        case LatencyDistribution::LogNormal: return "lognormal";
+    }
+    return "fixed";
+}
+
+bool SyntheticBackendOptions::parse(const std::string& spec, SyntheticBackendOptions& options, std::string& error) {
+    SyntheticBackendOptions parsed = options;
+    std::istringstream pairs(spec);
+    std::string pair;
+    while (std::getline(pairs, pair, ',')) {
+        pair.erase(0, pair.find_first_not_of(" \t"));
+        pair.erase(pair.find_last_not_of(" \t") + 1);
+        if (pair.empty()) {
+            continue;
+        }
+        size_t equals = pair.find('=');
+        std::string key = pair.substr(0, equals);
+        std::string value = equals == std::string::npos ? std::string() : pair.substr(equals + 1);
+
+        if (key == "distribution") {
+            bool known = false;
+            for (LatencyDistribution candidate : {LatencyDistribution::Fixed, LatencyDistribution::Uniform,
+                                                  LatencyDistribution::LogNormal}) {
+                if (value == distributionName(candidate)) {
+                    parsed.distribution = candidate;
+                    known = true;
+                }
+            }
+            if (!known) {
+                error = "unknown distribution \"" + value + "\" (fixed, uniform or lognormal)";
+                return false;
+            }
+            continue;
+        }
+
+        char* end = nullptr;
+        double number = std::strtod(value.c_str(), &end);
+        if (value.empty() || *end != '\0' || !std::isfinite(number) || number < 0.0) {
+            error = "\"" + pair + "\" needs a number >= 0";
+            return false;
+        }
+        if (key == "base-ms") {
+            parsed.base_ms = number;
+        } else if (key == "per-second-ms") {
+            parsed.per_second_ms = number;
+        } else if (key == "spread") {
+            parsed.spread = number;
+        } else if (key == "failure-rate" && number <= 1.0) {
+            parsed.failure_rate = number;
+        } else if (key == "cpu-burn" && number <= 1.0) {
+            parsed.cpu_burn = number;
+        } else if (key == "segment-seconds" && number > 0.0) {
+            parsed.segment_seconds = number;
+        } else if (key == "seed") {
+            parsed.seed = static_cast<uint64_t>(number);
+        } else if (key == "failure-rate" || key == "cpu-burn" || key == "segment-seconds") {
+            error = "\"" + pair + "\" is out of range";
+            return false;
+        } else {
+            error = "unknown key \"" + key + "\"";
+            return false;
+        }
+    }
+    options = parsed;
+    return true;
+}
+
+SyntheticTranscriptionBackend::SyntheticTranscriptionBackend(const SyntheticBackendOptions& options)
+    : options_(options)
+    , stats_()
+{
+}
+
+std::string SyntheticTranscriptionBackend::backendName() const {
+    return "synthetic";
+}
+
+/**
+ * @brief Let ms pass, spinning on threads cores for the first burn_ms of it
+ * @return false as soon as the token is cancelled
+ */
+static bool spend(double ms, double burn_ms, int threads, CancellationToken* cancel_token,
+                  std::mutex& wake_mutex, std::condition_variable& wake_cv) {
+    const auto start = Clock::now();
+    const auto burn_end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(burn_ms));
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(ms));
+    auto cancelled = [cancel_token]() { return cancel_token && cancel_token->isCancelled(); };
+
+    if (burn_ms > 0.0) {
+        auto spin = [&]() {
+            volatile uint64_t sink = 0;
+            while (Clock::now() < burn_end && !cancelled()) {
+                for (int i = 0; i < 1000; ++i) {
+                    sink = sink * 6364136223846793005ull + 1442695040888963407ull;
+                }
+            }
+        };
+        std::vector<std::thread> helpers;
+        for (int i = 1; i < threads; ++i) {
+            helpers.emplace_back(spin);
+        }
+        spin();
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(wake_mutex);
+    return !wake_cv.wait_until(lock, end, cancelled);
+}
+
+std::string SyntheticTranscriptionBackend::transcribe(const TranscriptionRequest& request) {
+    const std::string identity = request.audio ? request.audio->sourcePath() : request.audio_file_path;
+    const double duration_seconds = request.audio ? request.audio->durationSeconds() : request.duration_seconds;
+    SyntheticRandom random(options_.seed ^ fnv1a(identity + "#" + std::to_string(std::llround(duration_seconds * 1000.0))));
+
+    // Latency and failure are drawn first, so they do not depend on the transcript's words
+    double median_ms = options_.base_ms + options_.per_second_ms * duration_seconds;
+    double latency_ms = median_ms;
+    if (options_.distribution == LatencyDistribution::Uniform) {
+        latency_ms = median_ms * std::max(0.0, 1.0 + options_.spread * (2.0 * random.uniform() - 1.0));
+    } else if (options_.distribution == LatencyDistribution::LogNormal) {
+        latency_ms = median_ms * std::exp(options_.spread * random.normal());
+    }
+    bool fails = random.uniform() < options_.failure_rate;
+    size_t segment_count = std::max<size_t>(1, static_cast<size_t>(std::ceil(duration_seconds / options_.segment_seconds)));
+    size_t fail_after = fails ? static_cast<size_t>(random.uniform() * segment_count) : segment_count;
+    double fail_share = random.uniform();
+
+    const int threads = std::max(1, request.threads);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.requests;
+        stats_.peak_in_flight = std::max(stats_.peak_in_flight, ++stats_.in_flight);
+        stats_.simulated_ms += latency_ms;
+    }
+
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+    uint64_t cancel_handler = 0;
+    if (request.cancel_token) {
+        cancel_handler = request.cancel_token->onCancel([&wake_mutex, &wake_cv]() {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            wake_cv.notify_all();
+        });
+    }
+
+    const double slice_ms = latency_ms / segment_count;
+    std::string result;
+    bool cancelled = false;
+    double burned_cpu_ms = 0.0;
+    for (size_t i = 0; i < segment_count && !cancelled; ++i) {
+        if (i == fail_after) {
+            // A failure costs part of a segment's time before it shows
+            cancelled = !spend(slice_ms * fail_share, 0.0, threads, request.cancel_token.get(), wake_mutex, wake_cv);
+            break;
+        }
+        if (!spend(slice_ms, slice_ms * options_.cpu_burn, threads, request.cancel_token.get(), wake_mutex, wake_cv)) {
+            cancelled = true;
+            break;
+        }
+        burned_cpu_ms += slice_ms * options_.cpu_burn * threads;
+
+        TranscriptSegment segment;
+        segment.start_seconds = i * options_.segment_seconds;
+        segment.end_seconds = std::min(duration_seconds, (i + 1) * options_.segment_seconds);
+        size_t words = std::max<size_t>(1, static_cast<size_t>((segment.end_seconds - segment.start_seconds) * WORDS_PER_SECOND));
+        for (size_t w = 0; w < words; ++w) {
+            segment.text += std::string(" ") + WORDS[random.next() % WORD_COUNT];
+        }
+        result += segment.text;
+        if (request.listener && request.listener->on_segment) {
+            request.listener->on_segment(segment);
+        }
+        if (request.listener && request.listener->on_progress) {
+            request.listener->on_progress(static_cast<int>((i + 1) * 100 / segment_count));
+        }
+    }
+
+    if (request.cancel_token) {
+        request.cancel_token->removeHandler(cancel_handler);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --stats_.in_flight;
+        stats_.burned_cpu_ms += burned_cpu_ms;
+        if (cancelled) {
+            ++stats_.cancelled;
+        } else if (fails) {
+            ++stats_.failures;
+        }
+    }
+
+    if (cancelled) {
+        return "ERROR: Cancelled";
+    }
+    if (fails) {
+        return "ERROR: Synthetic failure";
+    }
+    result.erase(0, result.find_first_not_of(' '));
+    return result;
+}
+
+SyntheticBackendStats SyntheticTranscriptionBackend::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
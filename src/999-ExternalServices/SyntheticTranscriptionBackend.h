@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+#include "TranscriptionBackend.h"
+
+/**
+ * @brief Shape of the latency SyntheticTranscriptionBackend draws for each recording
+ */
+enum class LatencyDistribution {
+    Fixed,      // Always the median
+    Uniform,    // median x (1 +- spread)
+    LogNormal   // median x e^(spread x N(0, 1)): a long tail like real decodes on a shared machine
+};
+
+/**
+ * @brief What SyntheticTranscriptionBackend pretends to cost
+ *
+ * Set from wt_config.xml (whisper-synthetic) or bench_pipeline_load's --synthetic as a
+ * spec string, e.g. "distribution=lognormal,base-ms=150,per-second-ms=60,spread=0.4,failure-rate=0.02,cpu-burn=0.5".
+ */
+struct SyntheticBackendOptions {
+    LatencyDistribution distribution = LatencyDistribution::LogNormal;
+    double base_ms = 150.0;             // Median latency of an empty recording (model warm-up, encoder pass)
+    double per_second_ms = 60.0;        // Added to the median per second of audio
+    double spread = 0.4;                // Uniform: +- fraction of the median; LogNormal: sigma of ln(latency)
+    double failure_rate = 0.0;          // Share of recordings that fail part way through
+    double cpu_burn = 0.0;              // Share of the latency spent spinning on request.threads cores instead of sleeping
+    double segment_seconds = 5.0;       // Audio per reported segment
+    uint64_t seed = 1;
+
+    // The options as a spec string parse() accepts
+    std::string describe() const;
+
+    static const char* distributionName(LatencyDistribution distribution);
+
+    /**
+     * @brief Comma-separated key=value pairs; keys not given keep their current value
+     * @return false with error set on an unknown key or a value out of range (options then unchanged)
+     */
+    static bool parse(const std::string& spec, SyntheticBackendOptions& options, std::string& error);
+};
+
+/**
+ * @brief Counters reported by SyntheticTranscriptionBackend::getStats()
+ */
+struct SyntheticBackendStats {
+    uint64_t requests = 0;
+    uint64_t failures = 0;          // Drawn by failure_rate
+    uint64_t cancelled = 0;
+    size_t in_flight = 0;
+    size_t peak_in_flight = 0;      // Highest concurrency the scheduler let through
+    double simulated_ms = 0.0;      // Latency drawn for every request, cancelled ones in full
+    double burned_cpu_ms = 0.0;     // CPU time spent spinning in completed segments, summed over threads
+};
+
+/**
+ * @brief SyntheticTranscriptionBackend - Transcribes nothing, deterministically
+ *
+ * Stands in for whisper where no model is available (the repository's model is a
+ * placeholder), so the upload -> cache -> scheduler -> executor -> server push path can
+ * be loaded with thousands of recordings. Each recording draws its latency, whether it
+ * fails and its transcript from a generator seeded with options.seed and the recording's
+ * path and length, so a run is reproducible recording by recording whatever order the
+ * scheduler picks. The latency is spread over one segment per segment_seconds of audio;
+ * segments and progress reach the listener as their share of the time passes. Cancelling
+ * the token ends the wait at once.
+ */
+class SyntheticTranscriptionBackend : public TranscriptionBackend {
+public:
+    explicit SyntheticTranscriptionBackend(const SyntheticBackendOptions& options = SyntheticBackendOptions());
+
+    std::string backendName() const override;
+    std::string transcribe(const TranscriptionRequest& request) override;
+
+    const SyntheticBackendOptions& options() const { return options_; }
+    SyntheticBackendStats getStats() const;
+
+private:
+    const SyntheticBackendOptions options_;
+
+    mutable std::mutex mutex_;
+    SyntheticBackendStats stats_;
+};
@@ -0,0 +1,112 @@
+#include "ThreadBudget.h"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+
+ThreadLease::ThreadLease(ThreadLease&& other) noexcept
+    : budget_(other.budget_)
+    , threads_(other.threads_)
+{
+    other.budget_ = nullptr;
+    other.threads_ = 0;
+}
+
+ThreadLease& ThreadLease::operator=(ThreadLease&& other) noexcept {
+    if (this != &other) {
+        if (budget_) {
+            budget_->release(threads_);
+        }
+        budget_ = other.budget_;
+        threads_ = other.threads_;
+        other.budget_ = nullptr;
+        other.threads_ = 0;
+    }
+    return *this;
+}
+
+ThreadLease::~ThreadLease() {
+    if (budget_) {
+        budget_->release(threads_);
+    }
+}
+
+ThreadBudget& ThreadBudget::getInstance() {
+    static ThreadBudget instance;
+    return instance;
+}
+
+ThreadBudget::ThreadBudget()
+    : total_cores_(std::max(1, (int)std::thread::hardware_concurrency()))
+    , reserved_cores_(0)
+    , max_threads_per_job_(DEFAULT_MAX_THREADS_PER_JOB)
+    , active_jobs_(0)
+    , allocated_threads_(0)
+    , last_grant_(0)
+    , grants_(0)
+    , oversubscribed_grants_(0)
+{
+}
+
+void ThreadBudget::reserveForWt(int wt_threads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int wanted = std::max(1, (wt_threads + WT_THREADS_PER_CORE - 1) / WT_THREADS_PER_CORE);
+    // Transcription always keeps at least one core
+    reserved_cores_ = std::min(wanted, total_cores_ - 1);
+    std::cout << "ThreadBudget: " << total_cores_ << " cores, " << reserved_cores_ << " reserved for "
+              << wt_threads << " Wt threads, " << availableLocked() << " for transcription" << std::endl;
+}
+
+void ThreadBudget::configure(int total_cores, int reserved_cores, int max_threads_per_job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (total_cores > 0) {
+        total_cores_ = total_cores;
+    }
+    reserved_cores_ = std::clamp(reserved_cores, 0, total_cores_ - 1);
+    if (max_threads_per_job > 0) {
+        max_threads_per_job_ = max_threads_per_job;
+    }
+}
+
+int ThreadBudget::availableLocked() const {
+    return std::max(1, total_cores_ - reserved_cores_);
+}
+
+ThreadLease ThreadBudget::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int available = availableLocked();
+    ++active_jobs_;
+
+    // Equal share among everyone running now, limited to what earlier jobs left over
+    int share = std::max(1, available / static_cast<int>(active_jobs_));
+    int unallocated = available - allocated_threads_;
+    int threads = std::min({share, unallocated, max_threads_per_job_});
+    if (threads < 1) {
+        threads = 1;
+        ++oversubscribed_grants_;
+    }
+
+    allocated_threads_ += threads;
+    last_grant_ = threads;
+    ++grants_;
+    return ThreadLease(this, threads);
+}
+
+void ThreadBudget::release(int threads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocated_threads_ -= threads;
+    --active_jobs_;
+}
+
+ThreadBudgetStats ThreadBudget::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ThreadBudgetStats stats;
+    stats.total_cores = total_cores_;
+    stats.reserved_cores = reserved_cores_;
+    stats.max_threads_per_job = max_threads_per_job_;
+    stats.active_jobs = active_jobs_;
+    stats.allocated_threads = allocated_threads_;
+    stats.last_grant = last_grant_;
+    stats.grants = grants_;
+    stats.oversubscribed_grants = oversubscribed_grants_;
+    return stats;
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief Current split reported by ThreadBudget::getStats()
+ */
+struct ThreadBudgetStats {
+    int total_cores = 0;
+    int reserved_cores = 0;         // Kept free for the Wt worker pool
+    int max_threads_per_job = 0;
+    size_t active_jobs = 0;
+    int allocated_threads = 0;      // Sum over active jobs, may exceed the budget under load
+    int last_grant = 0;
+    uint64_t grants = 0;
+    uint64_t oversubscribed_grants = 0; // Jobs started with nothing left, given 1 thread anyway
+};
+
+class ThreadBudget;
+
+/**
+ * @brief Threads granted to one inference, returned to the budget on destruction
+ */
+class ThreadLease {
+public:
+    ThreadLease() : budget_(nullptr), threads_(0) {}
+    ThreadLease(ThreadLease&& other) noexcept;
+    ThreadLease& operator=(ThreadLease&& other) noexcept;
+    ~ThreadLease();
+
+    ThreadLease(const ThreadLease&) = delete;
+    ThreadLease& operator=(const ThreadLease&) = delete;
+
+    int threads() const { return threads_; }
+
+private:
+    friend class ThreadBudget;
+    ThreadLease(ThreadBudget* budget, int threads) : budget_(budget), threads_(threads) {}
+
+    ThreadBudget* budget_;
+    int threads_;
+};
+
+/**
+ * @brief ThreadBudget - Shares the cores left over by Wt between running whisper_full calls
+ *
+ * Every inference takes a lease before whisper_full and uses lease.threads() as
+ * n_threads. A new job gets an equal share of the transcription cores among the jobs
+ * running with it, but never more than is still unallocated, so one job on an idle
+ * server gets all of them (up to max_threads_per_job) and ten jobs do not each start
+ * four threads on a four core machine. Jobs keep their grant until they finish; the
+ * next ones make up for it by getting less.
+ *
+ * Wt's worker threads mostly wait on the network, so the reservation is one core per
+ * WT_THREADS_PER_CORE of them (num-threads in wt_config.xml), at least one.
+ */
+class ThreadBudget {
+public:
+    static constexpr int WT_THREADS_PER_CORE = 4;
+    static constexpr int DEFAULT_MAX_THREADS_PER_JOB = 8;   // whisper scales poorly past this
+
+    static ThreadBudget& getInstance();
+
+    ThreadBudget(const ThreadBudget&) = delete;
+    ThreadBudget& operator=(const ThreadBudget&) = delete;
+
+    /**
+     * @brief Reserve cores for the Wt worker pool
+     * @param wt_threads num-threads from the Wt configuration
+     */
+    void reserveForWt(int wt_threads);
+
+    /**
+     * @brief Override the machine size and per-job cap (0 keeps the current value)
+     */
+    void configure(int total_cores, int reserved_cores, int max_threads_per_job = 0);
+
+    /**
+     * @brief Threads for an inference that starts now; always at least 1
+     */
+    ThreadLease acquire();
+
+    ThreadBudgetStats getStats() const;
+
+private:
+    friend class ThreadLease;
+
+    ThreadBudget();
+    void release(int threads);
+    int availableLocked() const;
+
+    mutable std::mutex mutex_;
+    int total_cores_;
+    int reserved_cores_;
+    int max_threads_per_job_;
+    size_t active_jobs_;
+    int allocated_threads_;
+    int last_grant_;
+    uint64_t grants_;
+    uint64_t oversubscribed_grants_;
+};
@@ -0,0 +1,26 @@
+#pragma once
+#include <string>
+#include <functional>
+
+/**
+ * @brief One piece of transcript with times in seconds
+ */
+struct TranscriptSegment {
+    double start_seconds = 0.0;
+    double end_seconds = 0.0;
+    std::string text;
+};
+
+/**
+ * @brief Receives a transcription's results while whisper is still decoding
+ *
+ * Both members are optional. They are called in order on the thread running the
+ * inference (or reading the whisper_service response), always before the final
+ * result is returned, so the final transcript supersedes everything reported here.
+ */
+struct TranscriptListener {
+    std::function<void(const TranscriptSegment&)> on_segment;   // Each segment once whisper has finished it
+    std::function<void(int)> on_progress;                       // Percent of the audio decoded so far
+
+    explicit operator bool() const { return on_segment || on_progress; }
+};
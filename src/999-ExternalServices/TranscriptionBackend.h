@@ -0,0 +1,48 @@
+#pragma once
+#include <string>
+#include <memory>
+#include "TranscriptSegment.h"
+
+class CancellationToken;
+class SharedAudioBuffer;
+
+/**
+ * @brief One recording handed to a TranscriptionBackend
+ *
+ * Everything in front of the backend (cache lookup, TranscriptionScheduler slot,
+ * ThreadBudget lease) has already happened when transcribe() sees it.
+ */
+struct TranscriptionRequest {
+    std::string audio_file_path;                // Where the recording came from; the audio itself when audio is null
+    std::shared_ptr<SharedAudioBuffer> audio;   // Decoded samples, when the caller has them in a memfd
+    double duration_seconds = 0.0;              // 0 if unknown (the file is not a readable WAV)
+    int threads = 1;                            // ThreadBudget grant
+    const TranscriptListener* listener = nullptr;
+    std::shared_ptr<CancellationToken> cancel_token;
+};
+
+/**
+ * @brief TranscriptionBackend - The engine that turns a scheduled recording into text
+ *
+ * WhisperCliService is the default backend (whisper_service daemon, worker pool or one-shot
+ * CLI); SyntheticTranscriptionBackend only pretends to transcribe, so the upload, queue and
+ * push path can be load-tested without a model. Those are what wt_config.xml's
+ * whisper-backend chooses between. WhisperAiBackend runs whisper in-process for the bench
+ * tools, which link whisper themselves; the server does not.
+ * WhisperCliService::setDefaultBackend() swaps the engine behind every later service.
+ *
+ * Implementations are shared between threads and must be thread-safe.
+ */
+class TranscriptionBackend {
+public:
+    virtual ~TranscriptionBackend() = default;
+
+    // Short identifier for logs, stats and transcript cache keys
+    virtual std::string backendName() const = 0;
+
+    /**
+     * @brief Transcribe one recording, blocking until done
+     * @return Transcribed text or error message starting with "ERROR:" ("ERROR: Cancelled" once the token fired)
+     */
+    virtual std::string transcribe(const TranscriptionRequest& request) = 0;
+};
@@ -0,0 +1,512 @@
+#include "TranscriptionCache.h"
+#include "CancellationToken.h"
+#include "Audio/WavReader.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+static constexpr const char* CACHE_FILE_EXTENSION = ".txt";
+// mkstemp template suffix: <key>.tmp.XXXXXX
+static constexpr const char* TEMPORARY_FILE_INFIX = ".tmp.";
+
+// XXH64 (https://github.com/Cyan4973/xxHash): ~10 GB/s, plenty to hash a whole recording per request
+static constexpr uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t read32(const unsigned char* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t xxhRound(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t xxhMerge(uint64_t acc, uint64_t value) {
+    acc ^= xxhRound(0, value);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+static uint64_t hash64(const void* data, size_t length, uint64_t seed) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const unsigned char* end = p + length;
+    uint64_t h;
+
+    if (length >= 32) {
+        uint64_t v1 = seed + PRIME64_1 + PRIME64_2;
+        uint64_t v2 = seed + PRIME64_2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - PRIME64_1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = xxhRound(v1, read64(p));
+            v2 = xxhRound(v2, read64(p + 8));
+            v3 = xxhRound(v3, read64(p + 16));
+            v4 = xxhRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = xxhMerge(h, v1);
+        h = xxhMerge(h, v2);
+        h = xxhMerge(h, v3);
+        h = xxhMerge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+
+    h += static_cast<uint64_t>(length);
+
+    while (p + 8 <= end) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        ++p;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+static std::string formatKey(uint64_t audio_hash, const std::string& params) {
+    std::ostringstream key;
+    key << std::hex << std::setfill('0') << std::setw(16) << audio_hash
+        << std::setw(16) << hash64(params.data(), params.size(), 0);
+    return key.str();
+}
+
+static std::shared_future<std::string> readyFuture(const std::string& result) {
+    std::promise<std::string> promise;
+    promise.set_value(result);
+    return promise.get_future().share();
+}
+
+TranscriptionCache& TranscriptionCache::getInstance() {
+    static TranscriptionCache instance;
+    return instance;
+}
+
+TranscriptionCache::TranscriptionCache()
+    : memory_bytes_(0)
+    , memory_limit_(DEFAULT_MEMORY_BYTES)
+    , disk_bytes_(0)
+    , disk_limit_(DEFAULT_DISK_BYTES)
+    , memory_hits_(0)
+    , disk_hits_(0)
+    , misses_(0)
+    , coalesced_(0)
+    , abandoned_(0)
+    , evictions_(0)
+{
+}
+
+void TranscriptionCache::setDiskDirectory(const std::string& directory, size_t max_bytes) {
+    // Transcripts are the users' words: only the server's own user may list or read them
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (!ec) {
+        fs::permissions(directory, fs::perms::owner_all, fs::perm_options::replace, ec);
+    }
+    if (ec) {
+        std::cerr << "TranscriptionCache: cannot create " << directory << ": " << ec.message() << std::endl;
+        return;
+    }
+
+    // Index whatever a previous run left behind, least recently used first
+    struct Existing {
+        fs::file_time_type time;
+        std::string key;
+        size_t bytes;
+    };
+    std::vector<Existing> existing;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file() && entry.path().filename().string().find(TEMPORARY_FILE_INFIX) != std::string::npos) {
+            fs::remove(entry.path(), ec); // Left by a write that never finished
+            continue;
+        }
+        if (!entry.is_regular_file() || entry.path().extension() != CACHE_FILE_EXTENSION) {
+            continue;
+        }
+        existing.push_back({entry.last_write_time(), entry.path().stem().string(),
+                            static_cast<size_t>(entry.file_size())});
+    }
+    std::sort(existing.begin(), existing.end(),
+              [](const Existing& a, const Existing& b) { return a.time < b.time; });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    disk_directory_ = directory;
+    disk_limit_ = max_bytes;
+    disk_lru_.clear();
+    disk_index_.clear();
+    disk_bytes_ = 0;
+
+    for (const Existing& entry : existing) {
+        disk_lru_.push_front({entry.key, entry.bytes});
+        disk_index_[entry.key] = disk_lru_.begin();
+        disk_bytes_ += entry.bytes;
+    }
+    while (disk_bytes_ > disk_limit_ && !disk_lru_.empty()) {
+        fs::remove(diskPath(disk_lru_.back().key), ec);
+        disk_bytes_ -= disk_lru_.back().bytes;
+        disk_index_.erase(disk_lru_.back().key);
+        disk_lru_.pop_back();
+        ++evictions_;
+    }
+
+    std::cout << "TranscriptionCache: " << disk_index_.size() << " entries (" << disk_bytes_
+              << " bytes) on disk in " << directory << std::endl;
+}
+
+void TranscriptionCache::setMemoryLimit(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_limit_ = max_bytes;
+    while (memory_bytes_ > memory_limit_ && !memory_lru_.empty()) {
+        memory_bytes_ -= memory_lru_.back().key.size() + memory_lru_.back().result.size();
+        memory_index_.erase(memory_lru_.back().key);
+        memory_lru_.pop_back();
+        ++evictions_;
+    }
+}
+
+std::string TranscriptionCache::makeKey(const WavReader& reader, const std::string& params) {
+    // The container (header size, LIST chunks, file name) does not matter, only the samples and their format
+    const WavFormat& format = reader.format();
+    uint64_t seed = (static_cast<uint64_t>(format.sample_rate) << 32) |
+                    (static_cast<uint64_t>(format.channels) << 16) |
+                    static_cast<uint64_t>(format.encoding);
+    return formatKey(hash64(reader.data(), reader.dataBytes(), seed), params);
+}
+
+std::string TranscriptionCache::makeKey(const float* samples, size_t count, const std::string& params) {
+    return formatKey(hash64(samples, count * sizeof(float), 0x66333200), params);
+}
+
+bool TranscriptionCache::acquire(const std::string& key, std::shared_future<std::string>& pending) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        std::string result;
+        if (lookupMemory(key, result)) {
+            ++memory_hits_;
+            pending = readyFuture(result);
+            return false;
+        }
+
+        auto in_flight = in_flight_.find(key);
+        if (in_flight != in_flight_.end()) {
+            ++coalesced_;
+            pending = in_flight->second.future;
+            return false;
+        }
+
+        InFlight& claim = in_flight_[key];
+        claim.future = claim.promise.get_future().share();
+        pending = claim.future;
+    }
+
+    // Disk I/O happens outside the lock; identical requests already wait on our claim
+    std::string result;
+    if (lookupDisk(key, result)) {
+        ++disk_hits_;
+        std::promise<std::string> promise;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            storeMemory(key, result);
+            auto claim = in_flight_.find(key);
+            promise = std::move(claim->second.promise);
+            in_flight_.erase(claim);
+        }
+        promise.set_value(result);
+        return false;
+    }
+
+    ++misses_;
+    return true;
+}
+
+bool TranscriptionCache::acquireAsync(const std::string& key, ResultCallback on_result) {
+    std::shared_future<std::string> pending;
+    if (acquire(key, pending)) {
+        return true;
+    }
+    if (pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto claim = in_flight_.find(key);
+        if (claim != in_flight_.end()) {
+            claim->second.callbacks.push_back(std::move(on_result));
+            return false;
+        }
+    }
+    // Already settled, or about to be: complete() only sets the value after releasing the lock
+    try {
+        on_result(false, pending.get());
+    } catch (const Abandoned&) {
+        on_result(true, std::string());
+    }
+    return false;
+}
+
+void TranscriptionCache::complete(const std::string& key, const std::string& result) {
+    const bool cacheable = isCacheable(result);
+    std::promise<std::string> promise;
+    std::vector<ResultCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto claim = in_flight_.find(key);
+        if (claim == in_flight_.end()) {
+            return;
+        }
+        promise = std::move(claim->second.promise);
+        callbacks = std::move(claim->second.callbacks);
+        in_flight_.erase(claim);
+        if (cacheable) {
+            storeMemory(key, result);
+        }
+    }
+
+    // Waiters are released first, the disk write is only for future requests
+    promise.set_value(result);
+    for (auto& callback : callbacks) {
+        callback(false, result);
+    }
+    if (cacheable) {
+        storeDisk(key, result);
+    }
+}
+
+void TranscriptionCache::abandon(const std::string& key) {
+    std::promise<std::string> promise;
+    std::vector<ResultCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto claim = in_flight_.find(key);
+        if (claim == in_flight_.end()) {
+            return;
+        }
+        promise = std::move(claim->second.promise);
+        callbacks = std::move(claim->second.callbacks);
+        in_flight_.erase(claim);
+    }
+    ++abandoned_;
+    promise.set_exception(std::make_exception_ptr(Abandoned()));
+    for (auto& callback : callbacks) {
+        callback(true, std::string());
+    }
+}
+
+std::string TranscriptionCache::getOrCompute(const std::string& key, const std::function<std::string()>& compute,
+                                             const std::shared_ptr<CancellationToken>& cancel_token) {
+    while (true) {
+        std::shared_future<std::string> pending;
+        if (!acquire(key, pending)) {
+            try {
+                return pending.get();
+            } catch (const Abandoned&) {
+                continue; // Take the claim over, or wait for whoever did
+            }
+        }
+
+        std::string result;
+        try {
+            result = compute();
+        } catch (const std::exception& e) {
+            result = std::string("ERROR: ") + e.what();
+        }
+        if (cancel_token && cancel_token->isCancelled()) {
+            abandon(key);
+        } else {
+            complete(key, result);
+        }
+        return result;
+    }
+}
+
+TranscriptionCacheStats TranscriptionCache::getStats() const {
+    TranscriptionCacheStats stats;
+    stats.memory_hits = memory_hits_;
+    stats.disk_hits = disk_hits_;
+    stats.misses = misses_;
+    stats.coalesced = coalesced_;
+    stats.abandoned = abandoned_;
+    stats.evictions = evictions_;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.memory_entries = memory_index_.size();
+    stats.memory_bytes = memory_bytes_;
+    stats.disk_entries = disk_index_.size();
+    stats.disk_bytes = disk_bytes_;
+    return stats;
+}
+
+bool TranscriptionCache::isCacheable(const std::string& result) {
+    // WhisperAi reports failures as "", the CLI service as "ERROR: ..."
+    return !result.empty() && result.rfind("ERROR:", 0) != 0;
+}
+
+bool TranscriptionCache::lookupMemory(const std::string& key, std::string& result) {
+    auto it = memory_index_.find(key);
+    if (it == memory_index_.end()) {
+        return false;
+    }
+    memory_lru_.splice(memory_lru_.begin(), memory_lru_, it->second);
+    result = it->second->result;
+    return true;
+}
+
+void TranscriptionCache::storeMemory(const std::string& key, const std::string& result) {
+    auto existing = memory_index_.find(key);
+    if (existing != memory_index_.end()) {
+        memory_bytes_ -= existing->second->key.size() + existing->second->result.size();
+        memory_lru_.erase(existing->second);
+        memory_index_.erase(existing);
+    }
+
+    memory_lru_.push_front({key, result});
+    memory_index_[key] = memory_lru_.begin();
+    memory_bytes_ += key.size() + result.size();
+
+    while (memory_bytes_ > memory_limit_ && memory_lru_.size() > 1) {
+        memory_bytes_ -= memory_lru_.back().key.size() + memory_lru_.back().result.size();
+        memory_index_.erase(memory_lru_.back().key);
+        memory_lru_.pop_back();
+        ++evictions_;
+    }
+}
+
+bool TranscriptionCache::lookupDisk(const std::string& key, std::string& result) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (disk_directory_.empty() || disk_index_.find(key) == disk_index_.end()) {
+            return false;
+        }
+        path = diskPath(key);
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::ostringstream content;
+    bool found = file && (content << file.rdbuf());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = disk_index_.find(key);
+    if (it == disk_index_.end()) {
+        return false;
+    }
+    if (!found) {
+        // Removed behind our back
+        disk_bytes_ -= it->second->bytes;
+        disk_lru_.erase(it->second);
+        disk_index_.erase(it);
+        return false;
+    }
+
+    disk_lru_.splice(disk_lru_.begin(), disk_lru_, it->second);
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+    result = content.str();
+    return true;
+}
+
+void TranscriptionCache::storeDisk(const std::string& key, const std::string& result) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (disk_directory_.empty()) {
+            return;
+        }
+        path = diskPath(key);
+    }
+
+    // Write a file of our own (0600, unique even when two servers share the directory),
+    // then rename it so a concurrent reader never sees half a file
+    std::string temporary_path = path.substr(0, path.size() - std::strlen(CACHE_FILE_EXTENSION)) +
+                                 TEMPORARY_FILE_INFIX + "XXXXXX";
+    int fd = mkstemp(temporary_path.data());
+    if (fd < 0) {
+        return;
+    }
+    size_t written = 0;
+    while (written < result.size()) {
+        ssize_t count = write(fd, result.data() + written, result.size() - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        written += static_cast<size_t>(count);
+    }
+    std::error_code ec;
+    if (close(fd) != 0 || written < result.size()) {
+        fs::remove(temporary_path, ec);
+        return;
+    }
+    fs::rename(temporary_path, path, ec);
+    if (ec) {
+        fs::remove(temporary_path, ec);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto existing = disk_index_.find(key);
+    if (existing != disk_index_.end()) {
+        disk_bytes_ -= existing->second->bytes;
+        disk_lru_.erase(existing->second);
+        disk_index_.erase(existing);
+    }
+    disk_lru_.push_front({key, result.size()});
+    disk_index_[key] = disk_lru_.begin();
+    disk_bytes_ += result.size();
+
+    while (disk_bytes_ > disk_limit_ && disk_lru_.size() > 1) {
+        fs::remove(diskPath(disk_lru_.back().key), ec);
+        disk_bytes_ -= disk_lru_.back().bytes;
+        disk_index_.erase(disk_lru_.back().key);
+        disk_lru_.pop_back();
+        ++evictions_;
+    }
+}
+
+std::string TranscriptionCache::diskPath(const std::string& key) const {
+    return disk_directory_ + "/" + key + CACHE_FILE_EXTENSION;
+}
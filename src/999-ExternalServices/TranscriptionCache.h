@@ -0,0 +1,172 @@
+#pragma once
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <future>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+class WavReader;
+class CancellationToken;
+
+/**
+ * @brief Counters reported by TranscriptionCache::getStats()
+ */
+struct TranscriptionCacheStats {
+    uint64_t memory_hits = 0;
+    uint64_t disk_hits = 0;
+    uint64_t misses = 0;          // Requests that ran inference
+    uint64_t coalesced = 0;       // Requests that waited for an identical in-flight inference
+    uint64_t abandoned = 0;       // Claims given up by a cancelled owner (a waiter takes over)
+    uint64_t evictions = 0;
+    size_t memory_entries = 0;
+    size_t memory_bytes = 0;
+    size_t disk_entries = 0;
+    size_t disk_bytes = 0;
+};
+
+/**
+ * @brief TranscriptionCache - Content-addressed cache of transcription results
+ *
+ * Keys are a hash of the decoded PCM together with everything that changes the output
+ * (model, VAD, language...), so a re-upload of the same recording under a different
+ * file name is still a hit. Results live in an in-memory LRU and, once a directory is
+ * configured, in one small file per key on disk; both tiers are capped in bytes.
+ *
+ * Identical requests that arrive while the first one is still running do not start a
+ * second inference: they wait on the first one's result (coalescing). Error results
+ * are handed to those waiters but never stored. An owner that is cancelled abandons
+ * its claim instead, and one of the waiters takes it over.
+ */
+class TranscriptionCache {
+public:
+    static constexpr size_t DEFAULT_MEMORY_BYTES = 16 * 1024 * 1024;
+    static constexpr size_t DEFAULT_DISK_BYTES = 256 * 1024 * 1024;
+
+    /**
+     * @brief Receives someone else's result; abandoned is set (result empty) when its owner gave up the claim
+     */
+    using ResultCallback = std::function<void(bool abandoned, const std::string& result)>;
+
+    static TranscriptionCache& getInstance();
+
+    TranscriptionCache(const TranscriptionCache&) = delete;
+    TranscriptionCache& operator=(const TranscriptionCache&) = delete;
+
+    /**
+     * @brief Enable the on-disk tier
+     * @param directory Created if missing; existing entries are indexed oldest-first
+     * @param max_bytes Size cap, least recently used files are removed beyond it
+     */
+    void setDiskDirectory(const std::string& directory, size_t max_bytes = DEFAULT_DISK_BYTES);
+    void setMemoryLimit(size_t max_bytes);
+
+    /**
+     * @brief Key for a WAV file's samples (hashed straight from the mapped data chunk)
+     * @param params Model id and decoding parameters that affect the transcript
+     */
+    static std::string makeKey(const WavReader& reader, const std::string& params);
+    static std::string makeKey(const float* samples, size_t count, const std::string& params);
+
+    /**
+     * @brief Claim a key
+     * @param pending Set to the (possibly already available) result when the call returns false
+     * @return true if the caller must produce the result and then call complete()
+     */
+    bool acquire(const std::string& key, std::shared_future<std::string>& pending);
+
+    /**
+     * @brief acquire() for callers that must not block on someone else's claim
+     * @param on_result Called when the call returns false: right away for a stored result, otherwise
+     *        from the thread that completes or abandons the claim (call acquireAsync() again then)
+     * @return true if the caller must produce the result and then call complete() or abandon()
+     */
+    bool acquireAsync(const std::string& key, ResultCallback on_result);
+
+    /**
+     * @brief Publish the result for a key claimed with acquire() and wake up waiters
+     */
+    void complete(const std::string& key, const std::string& result);
+
+    /**
+     * @brief Thrown by the pending result of an abandoned claim: call acquire() again
+     */
+    struct Abandoned : std::runtime_error {
+        Abandoned() : std::runtime_error("transcription claim abandoned") {}
+    };
+
+    /**
+     * @brief Give up a key claimed with acquire() without a result (its owner was cancelled)
+     *
+     * Nothing is stored. Waiters get Abandoned, so the first of them to call acquire()
+     * again transcribes the audio under its own cancellation token.
+     */
+    void abandon(const std::string& key);
+
+    /**
+     * @brief acquire() + compute() + complete() in one call
+     * @param cancel_token The caller's token: if it fired by the time compute() returns, the
+     *        claim is abandoned rather than completed, so waiters are not handed the cancellation
+     */
+    std::string getOrCompute(const std::string& key, const std::function<std::string()>& compute,
+                             const std::shared_ptr<CancellationToken>& cancel_token = nullptr);
+
+    TranscriptionCacheStats getStats() const;
+
+private:
+    TranscriptionCache();
+
+    struct MemoryEntry {
+        std::string key;
+        std::string result;
+    };
+
+    struct DiskEntry {
+        std::string key;
+        size_t bytes;
+    };
+
+    static bool isCacheable(const std::string& result);
+
+    bool lookupMemory(const std::string& key, std::string& result);
+    void storeMemory(const std::string& key, const std::string& result);
+    bool lookupDisk(const std::string& key, std::string& result);
+    void storeDisk(const std::string& key, const std::string& result);
+    std::string diskPath(const std::string& key) const;
+
+    mutable std::mutex mutex_;
+
+    // Memory tier: most recently used at the front
+    std::list<MemoryEntry> memory_lru_;
+    std::unordered_map<std::string, std::list<MemoryEntry>::iterator> memory_index_;
+    size_t memory_bytes_;
+    size_t memory_limit_;
+
+    // Disk tier index, same ordering
+    std::string disk_directory_;
+    std::list<DiskEntry> disk_lru_;
+    std::unordered_map<std::string, std::list<DiskEntry>::iterator> disk_index_;
+    size_t disk_bytes_;
+    size_t disk_limit_;
+
+    // Requests currently being transcribed
+    struct InFlight {
+        std::promise<std::string> promise;
+        std::shared_future<std::string> future;
+        std::vector<ResultCallback> callbacks;   // acquireAsync() waiters
+    };
+    std::unordered_map<std::string, InFlight> in_flight_;
+
+    std::atomic<uint64_t> memory_hits_;
+    std::atomic<uint64_t> disk_hits_;
+    std::atomic<uint64_t> misses_;
+    std::atomic<uint64_t> coalesced_;
+    std::atomic<uint64_t> abandoned_;
+    std::atomic<uint64_t> evictions_;
+};
@@ -0,0 +1,310 @@
+#include "TranscriptionScheduler.h"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+
+// Clips shorter than this still cost something, otherwise a flood of empty uploads would be free
+static constexpr double MIN_JOB_COST_SECONDS = 1.0;
+// Weight of the newest completed job in the CPU-per-audio-second estimate
+static constexpr double CPU_RATE_SMOOTHING = 0.2;
+
+TranscriptionScheduler& TranscriptionScheduler::getInstance() {
+    static TranscriptionScheduler instance;
+    return instance;
+}
+
+TranscriptionScheduler::TranscriptionScheduler()
+    : shutdown_(false)
+    , virtual_time_(0.0)
+    , next_id_(1)
+    , max_queued_(DEFAULT_MAX_QUEUED)
+    , max_queued_per_session_(DEFAULT_MAX_QUEUED_PER_SESSION)
+    , worker_target_(DEFAULT_WORKERS)
+    // whisper_service runs inference on min(4, cores) threads
+    , threads_per_job_(std::max(1, std::min(4, (int)std::thread::hardware_concurrency())))
+    , running_(0)
+    , completed_(0)
+    , rejected_(0)
+    , cancelled_(0)
+    , aborted_(0)
+    , cpu_ms_per_audio_second_(0.0)
+{
+}
+
+TranscriptionScheduler::~TranscriptionScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void TranscriptionScheduler::configure(size_t workers, size_t max_queued, size_t max_queued_per_session) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    worker_target_ = std::max<size_t>(1, workers);
+    max_queued_ = max_queued;
+    max_queued_per_session_ = max_queued_per_session;
+}
+
+uint64_t TranscriptionScheduler::submit(const std::string& session_id, double expected_seconds, Job job,
+                                        PositionCallback on_position,
+                                        std::shared_ptr<CancellationToken> cancel_token) {
+    std::vector<Notification> notifications;
+    uint64_t id;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        auto session = sessions_.find(session_id);
+        size_t session_queued = session == sessions_.end() ? 0 : session->second.jobs.size();
+        if (jobs_.size() >= max_queued_ || session_queued >= max_queued_per_session_) {
+            ++rejected_;
+            std::cout << "TranscriptionScheduler: queue full (" << jobs_.size() << " queued, "
+                      << session_queued << " for this session), rejecting" << std::endl;
+            return 0;
+        }
+
+        // Lazily start workers so processes that never transcribe do not own idle threads
+        while (workers_.size() < worker_target_) {
+            workers_.emplace_back(&TranscriptionScheduler::workerLoop, this);
+        }
+
+        id = next_id_++;
+        double cost = std::max(MIN_JOB_COST_SECONDS, expected_seconds);
+        jobs_[id] = QueuedJob{id, session_id, cost, std::move(job), std::move(on_position), 0, cancel_token, 0};
+
+        if (session == sessions_.end()) {
+            // A session that was idle starts at the current virtual time: no credit for having been away
+            session = sessions_.emplace(session_id, SessionQueue()).first;
+            session->second.virtual_time = virtual_time_;
+        }
+        session->second.jobs.insert({cost, id});
+
+        collectPositionChanges(notifications);
+        cv_.notify_one();
+        notify(lock, notifications);
+    }
+
+    // Registered without mutex_ held: a token that is already cancelled runs the handler right here.
+    // Streams reuse one token for many jobs, so the handler goes away with the job it was for.
+    if (cancel_token) {
+        uint64_t handler = cancel_token->onCancel([this, id]() { cancel(id); });
+        bool still_queued;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto queued = jobs_.find(id);
+            still_queued = queued != jobs_.end();
+            if (still_queued) {
+                queued->second.cancel_handler = handler;
+            }
+        }
+        if (!still_queued) {
+            cancel_token->removeHandler(handler);
+        }
+    }
+    return id;
+}
+
+bool TranscriptionScheduler::cancel(uint64_t job_id) {
+    std::vector<Notification> notifications;
+    QueuedJob dropped;
+    double dropped_seconds;
+    double dropped_cpu_ms;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto job = jobs_.find(job_id);
+        if (job == jobs_.end()) {
+            return false;
+        }
+
+        auto session = sessions_.find(job->second.session_id);
+        session->second.jobs.erase({job->second.cost, job_id});
+        if (session->second.jobs.empty()) {
+            sessions_.erase(session);
+        }
+        dropped_seconds = job->second.cost;
+        dropped_cpu_ms = estimateCpuMs(job->second.cost);
+        // Destroy the job (and whatever it captured) outside the lock
+        dropped = std::move(job->second);
+        jobs_.erase(job);
+        ++cancelled_;
+
+        collectPositionChanges(notifications);
+        notify(lock, notifications);
+    }
+
+    removeCancelHandler(dropped);
+    CancellationToken::recordSavings(false, dropped_seconds, dropped_cpu_ms);
+    return true;
+}
+
+TranscriptionSchedulerStats TranscriptionScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TranscriptionSchedulerStats stats;
+    stats.queued = jobs_.size();
+    stats.running = running_;
+    stats.completed = completed_;
+    stats.rejected = rejected_;
+    stats.cancelled = cancelled_;
+    stats.aborted = aborted_;
+    stats.cpu_ms_per_audio_second = cpu_ms_per_audio_second_;
+    return stats;
+}
+
+void TranscriptionScheduler::workerLoop() {
+    while (true) {
+        QueuedJob job;
+        std::vector<Notification> notifications;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return shutdown_ || !jobs_.empty(); });
+            if (shutdown_) {
+                return;
+            }
+
+            auto session = pickNext();
+            auto next = session->second.jobs.begin();
+            auto queued = jobs_.find(next->second);
+
+            // Virtual time advances to the start tag of the job being served
+            double start = std::max(session->second.virtual_time, virtual_time_);
+            virtual_time_ = start;
+            session->second.virtual_time = start + next->first;
+
+            session->second.jobs.erase(next);
+            if (session->second.jobs.empty()) {
+                sessions_.erase(session);
+            }
+
+            job = std::move(queued->second);
+            jobs_.erase(queued);
+            ++running_;
+
+            if (job.on_position) {
+                notifications.emplace_back(job.on_position, 0);
+            }
+            collectPositionChanges(notifications);
+            notify(lock, notifications);
+        }
+        removeCancelHandler(job);
+
+        auto start_time = std::chrono::steady_clock::now();
+        try {
+            job.job();
+        } catch (const std::exception& e) {
+            std::cerr << "TranscriptionScheduler: job " << job.id << " threw: " << e.what() << std::endl;
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+        recordRun(job, std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+}
+
+double TranscriptionScheduler::estimateCpuMs(double audio_seconds) const {
+    return audio_seconds * cpu_ms_per_audio_second_;
+}
+
+void TranscriptionScheduler::recordRun(const QueuedJob& job, double elapsed_ms) {
+    double elapsed_cpu_ms = elapsed_ms * threads_per_job_;
+    bool aborted = job.cancel_token && job.cancel_token->isCancelled();
+    double saved_cpu_ms = 0.0;
+    double saved_seconds = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --running_;
+        if (aborted) {
+            // What the whole clip would have cost minus what was spent before the abort landed
+            ++aborted_;
+            double expected_cpu_ms = estimateCpuMs(job.cost);
+            saved_cpu_ms = expected_cpu_ms - elapsed_cpu_ms;
+            saved_seconds = expected_cpu_ms > 0.0 ? job.cost * saved_cpu_ms / expected_cpu_ms : 0.0;
+        } else {
+            ++completed_;
+            double rate = elapsed_cpu_ms / job.cost;
+            cpu_ms_per_audio_second_ = cpu_ms_per_audio_second_ == 0.0
+                ? rate
+                : cpu_ms_per_audio_second_ + CPU_RATE_SMOOTHING * (rate - cpu_ms_per_audio_second_);
+        }
+    }
+    if (aborted) {
+        CancellationToken::recordSavings(true, saved_seconds, saved_cpu_ms);
+    }
+}
+
+void TranscriptionScheduler::removeCancelHandler(const QueuedJob& job) {
+    // Never called with mutex_ held: the token holds its own lock while a handler waits for mutex_
+    if (job.cancel_token) {
+        job.cancel_token->removeHandler(job.cancel_handler);
+    }
+}
+
+std::map<std::string, TranscriptionScheduler::SessionQueue>::iterator TranscriptionScheduler::pickNext() {
+    // Smallest virtual finish time wins: fair across sessions, shortest job first within them
+    auto best = sessions_.end();
+    double best_finish = 0.0;
+    for (auto it = sessions_.begin(); it != sessions_.end(); ++it) {
+        double start = std::max(it->second.virtual_time, virtual_time_);
+        double finish = start + it->second.jobs.begin()->first;
+        if (best == sessions_.end() || finish < best_finish) {
+            best = it;
+            best_finish = finish;
+        }
+    }
+    return best;
+}
+
+void TranscriptionScheduler::collectPositionChanges(std::vector<Notification>& notifications) {
+    // Replay pickNext() on a copy to find the order the waiting jobs will run in
+    std::map<std::string, std::pair<double, std::vector<std::pair<double, uint64_t>>>> plan;
+    for (const auto& [session_id, session] : sessions_) {
+        plan[session_id] = {session.virtual_time,
+                            std::vector<std::pair<double, uint64_t>>(session.jobs.begin(), session.jobs.end())};
+    }
+    std::map<std::string, size_t> next_index;
+
+    double virtual_time = virtual_time_;
+    for (size_t position = 1; position <= jobs_.size(); ++position) {
+        const std::string* best_session = nullptr;
+        double best_start = 0.0;
+        double best_finish = 0.0;
+        for (const auto& [session_id, entry] : plan) {
+            size_t index = next_index[session_id];
+            if (index >= entry.second.size()) {
+                continue;
+            }
+            double start = std::max(entry.first, virtual_time);
+            double finish = start + entry.second[index].first;
+            if (!best_session || finish < best_finish) {
+                best_session = &session_id;
+                best_start = start;
+                best_finish = finish;
+            }
+        }
+
+        auto& entry = plan[*best_session];
+        uint64_t id = entry.second[next_index[*best_session]++].second;
+        virtual_time = best_start;
+        entry.first = best_finish;
+
+        QueuedJob& job = jobs_[id];
+        if (job.last_position != position) {
+            job.last_position = position;
+            if (job.on_position) {
+                notifications.emplace_back(job.on_position, position);
+            }
+        }
+    }
+}
+
+void TranscriptionScheduler::notify(std::unique_lock<std::mutex>& lock, const std::vector<Notification>& notifications) {
+    // Callbacks run without mutex_ held, one batch at a time
+    std::lock_guard<std::mutex> notify_lock(notify_mutex_);
+    lock.unlock();
+    for (const auto& [callback, position] : notifications) {
+        callback(position);
+    }
+}
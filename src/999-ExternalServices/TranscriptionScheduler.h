@@ -0,0 +1,142 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+#include "CancellationToken.h"
+
+/**
+ * @brief Counters reported by TranscriptionScheduler::getStats()
+ */
+struct TranscriptionSchedulerStats {
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t completed = 0;
+    uint64_t rejected = 0;        // Turned away because the queue was full
+    uint64_t cancelled = 0;       // Removed from the queue before they started
+    uint64_t aborted = 0;         // Cancelled while running
+    double cpu_ms_per_audio_second = 0.0; // Learned from completed jobs, used to estimate savings
+};
+
+/**
+ * @brief TranscriptionScheduler - Fair, bounded queue in front of the transcription backend
+ *
+ * Every job carries the session that submitted it and its expected cost (the clip
+ * duration from the WAV header). Sessions are served with weighted fair queueing on
+ * audio seconds: the next job is the one whose session would finish it first in
+ * virtual time, so a user with a pile of long uploads cannot starve someone with a
+ * short clip, and within a session the shortest clip goes first.
+ *
+ * The queue is bounded overall and per session. submit() returns 0 right away when
+ * it is full instead of letting callers pile up behind a lock. Jobs that are still
+ * waiting get their 1-based position in line whenever it changes, and 0 when they
+ * start running.
+ *
+ * A job submitted with a CancellationToken leaves the queue as soon as the token is
+ * cancelled; stopping a job that already runs is up to the job itself. Either way
+ * the estimated CPU time saved is reported to CancellationToken::recordSavings().
+ */
+class TranscriptionScheduler {
+public:
+    using Job = std::function<void()>;
+    using PositionCallback = std::function<void(size_t position)>;
+
+    static constexpr size_t DEFAULT_WORKERS = 1;
+    static constexpr size_t DEFAULT_MAX_QUEUED = 32;
+    static constexpr size_t DEFAULT_MAX_QUEUED_PER_SESSION = 4;
+
+    static TranscriptionScheduler& getInstance();
+
+    TranscriptionScheduler(const TranscriptionScheduler&) = delete;
+    TranscriptionScheduler& operator=(const TranscriptionScheduler&) = delete;
+
+    /**
+     * @brief Change limits; workers are added on the fly, never removed
+     */
+    void configure(size_t workers, size_t max_queued, size_t max_queued_per_session);
+
+    /**
+     * @brief Queue a job
+     * @param session_id Fairness domain (Wt session id, "" for anonymous callers)
+     * @param expected_seconds Expected cost, normally the audio duration
+     * @param job Runs on a scheduler thread
+     * @param on_position Called from scheduler threads with the job's place in line (0 = started);
+     *        it must not call back into the scheduler
+     * @param cancel_token Drops the job from the queue when cancelled; the job should watch it too
+     * @return Job id, or 0 if the queue is full (nothing was queued)
+     */
+    uint64_t submit(const std::string& session_id, double expected_seconds, Job job,
+                    PositionCallback on_position = nullptr,
+                    std::shared_ptr<CancellationToken> cancel_token = nullptr);
+
+    /**
+     * @brief Drop a job that has not started yet
+     * @return false if it is already running or finished
+     */
+    bool cancel(uint64_t job_id);
+
+    TranscriptionSchedulerStats getStats() const;
+
+private:
+    TranscriptionScheduler();
+    ~TranscriptionScheduler();
+
+    struct QueuedJob {
+        uint64_t id;
+        std::string session_id;
+        double cost;
+        Job job;
+        PositionCallback on_position;
+        size_t last_position;
+        std::shared_ptr<CancellationToken> cancel_token;
+        uint64_t cancel_handler; // Removed from the token once the job leaves the queue
+    };
+
+    // Jobs of one session ordered shortest first (id breaks ties in arrival order)
+    struct SessionQueue {
+        std::set<std::pair<double, uint64_t>> jobs;
+        double virtual_time = 0.0;
+    };
+
+    using Notification = std::pair<PositionCallback, size_t>;
+
+    void workerLoop();
+    std::map<std::string, SessionQueue>::iterator pickNext();
+    void collectPositionChanges(std::vector<Notification>& notifications);
+    void notify(std::unique_lock<std::mutex>& lock, const std::vector<Notification>& notifications);
+    double estimateCpuMs(double audio_seconds) const;
+    void recordRun(const QueuedJob& job, double elapsed_ms);
+    static void removeCancelHandler(const QueuedJob& job);
+
+    mutable std::mutex mutex_;
+    // Taken before mutex_ is released so position updates reach callers in the order they happened
+    std::mutex notify_mutex_;
+    std::condition_variable cv_;
+    std::vector<std::thread> workers_;
+    bool shutdown_;
+
+    std::unordered_map<uint64_t, QueuedJob> jobs_;
+    std::map<std::string, SessionQueue> sessions_;
+    double virtual_time_;
+    uint64_t next_id_;
+
+    size_t max_queued_;
+    size_t max_queued_per_session_;
+    size_t worker_target_;
+    int threads_per_job_;
+
+    size_t running_;
+    uint64_t completed_;
+    uint64_t rejected_;
+    uint64_t cancelled_;
+    uint64_t aborted_;
+    double cpu_ms_per_audio_second_;
+};
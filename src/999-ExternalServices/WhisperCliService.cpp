@@ -1,4 +1,16 @@
 #include "WhisperCliService.h"
+#include "WhisperDaemonClient.h"
+#include "WhisperDaemonProtocol.h"
+#include "WhisperWorkerPool.h"
+#include "TranscriptionCache.h"
+#include "TranscriptionScheduler.h"
+#include "CancellationToken.h"
+#include "DecodeProfile.h"
+#include "ThreadBudget.h"
+#include "WhisperModelFile.h"
+#include "SharedAudioBuffer.h"
+#include "AudioChunker.h"
+#include "Audio/WavReader.h"
 #include <iostream>
 #include <array>
 #include <sstream>
@@ -7,15 +19,63 @@
 #include <thread>
 #include <chrono>
 #include <mutex>
-#include <sys/file.h>
+#include <memory>
+#include <filesystem>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
-// Global mutex to prevent concurrent transcriptions
-static std::mutex transcription_mutex;
+static const std::string CANCELLED_RESULT = "ERROR: Cancelled";
+static const std::string BUSY_RESULT = "ERROR: Server busy, please try again in a moment";
+
+// Hands a scheduled job's result to its callback once; a job dropped from the queue reports the cancellation
+class AsyncResult {
+public:
+    explicit AsyncResult(std::function<void(const std::string&)> deliver) : deliver_(std::move(deliver)) {}
+
+    ~AsyncResult() {
+        try {
+            deliver(CANCELLED_RESULT);
+        } catch (const std::exception& e) {
+            std::cerr << "WhisperCliService: result callback threw: " << e.what() << std::endl;
+        }
+    }
+
+    void deliver(const std::string& result) {
+        auto deliver = std::move(deliver_);
+        deliver_ = nullptr;
+        if (deliver) {
+            deliver(result);
+        }
+    }
+
+    void discard() { deliver_ = nullptr; }
+
+private:
+    std::function<void(const std::string&)> deliver_;
+};
+
+// One daemon connection per worker thread, reused across WhisperCliService instances
+static thread_local std::unique_ptr<WhisperDaemonClient> thread_daemon_client;
+
+static std::mutex default_paths_mutex;
+static std::string default_executable_path = "./whisper_service";   // In current build directory
+static std::string default_model_path = WhisperModelFile::DEFAULT_PATH;
+static std::shared_ptr<TranscriptionBackend> default_backend;
 
 WhisperCliService::WhisperCliService()
     : initialized_(false)
     , whisper_executable_path_()
     , model_path_()
+    , daemon_socket_path_()
+    , vad_enabled_(false)
+    , queue_session_id_()
+    , on_queue_position_()
+    , cancel_token_()
+    , listener_()
+    , backend_(defaultBackend())
     , last_error_()
 {
 }
@@ -31,6 +91,58 @@ bool WhisperCliService::initialize(const std::string& whisper_executable_path, c
     return true;
 }
 
+void WhisperCliService::setDefaultPaths(const std::string& whisper_executable_path, const std::string& model_path) {
+    std::lock_guard<std::mutex> lock(default_paths_mutex);
+    default_executable_path = whisper_executable_path;
+    default_model_path = model_path;
+}
+
+std::string WhisperCliService::defaultExecutablePath() {
+    std::lock_guard<std::mutex> lock(default_paths_mutex);
+    return default_executable_path;
+}
+
+std::string WhisperCliService::defaultModelPath() {
+    std::lock_guard<std::mutex> lock(default_paths_mutex);
+    return default_model_path;
+}
+
+void WhisperCliService::setDefaultBackend(std::shared_ptr<TranscriptionBackend> backend) {
+    std::lock_guard<std::mutex> lock(default_paths_mutex);
+    default_backend = std::move(backend);
+}
+
+std::shared_ptr<TranscriptionBackend> WhisperCliService::defaultBackend() {
+    std::lock_guard<std::mutex> lock(default_paths_mutex);
+    return default_backend;
+}
+
+void WhisperCliService::setBackend(std::shared_ptr<TranscriptionBackend> backend) {
+    backend_ = std::move(backend);
+}
+
+void WhisperCliService::enableDaemon(const std::string& socket_path) {
+    daemon_socket_path_ = socket_path;
+}
+
+void WhisperCliService::setVadEnabled(bool enabled) {
+    vad_enabled_ = enabled;
+}
+
+void WhisperCliService::setQueueContext(const std::string& session_id,
+                                        std::function<void(size_t)> on_position) {
+    queue_session_id_ = session_id;
+    on_queue_position_ = std::move(on_position);
+}
+
+void WhisperCliService::setCancellationToken(std::shared_ptr<CancellationToken> cancel_token) {
+    cancel_token_ = std::move(cancel_token);
+}
+
+void WhisperCliService::setTranscriptListener(TranscriptListener listener) {
+    listener_ = std::move(listener);
+}
+
 bool WhisperCliService::isInitialized() const {
     return initialized_;
 }
@@ -40,114 +152,615 @@ std::string WhisperCliService::transcribeFile(const std::string& audio_file_path
         setError("WhisperCliService not initialized");
         return "ERROR: Service not initialized";
     }
+    if (cancel_token_ && cancel_token_->isCancelled()) {
+        return CANCELLED_RESULT;
+    }
+
+    // One pass over the WAV gives both the cache key and the clip length the scheduler charges for
+    std::string cache_key;
+    double duration_seconds = 0.0;
+    inspectAudio(audio_file_path, cache_key, duration_seconds);
+
+    // Identical audio (re-uploads, retries) is answered from the cache or joins the running inference
+    if (cache_key.empty()) {
+        return transcribeScheduled(audio_file_path, nullptr, duration_seconds);
+    }
+    return TranscriptionCache::getInstance().getOrCompute(cache_key, [this, &audio_file_path, duration_seconds]() {
+        return transcribeScheduled(audio_file_path, nullptr, duration_seconds);
+    }, cancel_token_);
+}
+
+std::string WhisperCliService::transcribeAudio(const std::shared_ptr<SharedAudioBuffer>& audio) {
+    if (!initialized_) {
+        setError("WhisperCliService not initialized");
+        return "ERROR: Service not initialized";
+    }
+    if (cancel_token_ && cancel_token_->isCancelled()) {
+        return CANCELLED_RESULT;
+    }
+
+    std::string cache_key = TranscriptionCache::makeKey(audio->samples(), audio->sampleCount(), cacheParams());
+    return TranscriptionCache::getInstance().getOrCompute(cache_key, [this, &audio]() {
+        return transcribeScheduled(audio->sourcePath(), audio, audio->durationSeconds());
+    }, cancel_token_);
+}
+
+void WhisperCliService::inspectAudio(const std::string& audio_file_path, std::string& cache_key,
+                                     double& duration_seconds) const {
+    WavReader reader;
+    if (!reader.open(audio_file_path)) {
+        return; // Let the service report the problem
+    }
+    duration_seconds = reader.durationSeconds();
+    cache_key = TranscriptionCache::makeKey(reader, cacheParams());
+}
+
+std::string WhisperCliService::cacheParams() const {
+    // Everything that changes the transcript besides the samples themselves
+    std::error_code ec;
+    auto model_size = std::filesystem::file_size(model_path_, ec);
+    std::ostringstream params;
+    params << "model=" << model_path_ << ":" << (ec ? 0 : model_size) << ";vad=" << vad_enabled_
+           << ";profile=" << DecodeProfileOptions().cacheTag() << ";chunks=" << AudioChunker::defaultOptions().cacheTag();
+    if (backend_) {
+        params << ";backend=" << backend_->backendName();
+    }
+    return params.str();
+}
+
+std::string WhisperCliService::transcribeScheduled(const std::string& audio_file_path,
+                                                   const std::shared_ptr<SharedAudioBuffer>& audio,
+                                                   double duration_seconds) {
+    auto result = std::make_shared<std::promise<std::string>>();
+    std::future<std::string> pending = result->get_future();
+
+    // The job holds the only reference to the promise, so dropping it from the queue breaks the promise
+    uint64_t job_id = TranscriptionScheduler::getInstance().submit(
+        queue_session_id_, duration_seconds,
+        [this, audio_file_path, audio, duration_seconds, result = std::move(result)]() {
+            try {
+                result->set_value(transcribeUncached(audio_file_path, audio, duration_seconds));
+            } catch (...) {
+                result->set_exception(std::current_exception());
+            }
+        },
+        on_queue_position_, cancel_token_);
+
+    if (job_id == 0) {
+        setError("Transcription queue is full");
+        return BUSY_RESULT;
+    }
+    try {
+        return pending.get();
+    } catch (const std::future_error&) {
+        // The scheduler dropped the queued job (and its promise) because the token was cancelled
+        return CANCELLED_RESULT;
+    }
+}
 
-    // Use mutex to serialize transcriptions for stability
-    std::lock_guard<std::mutex> lock(transcription_mutex);
-    std::cout << "Starting transcription for: " << audio_file_path << std::endl;
+std::string WhisperCliService::transcribeUncached(const std::string& audio_file_path,
+                                                  const std::shared_ptr<SharedAudioBuffer>& audio,
+                                                  double duration_seconds) {
+    if (cancel_token_ && cancel_token_->isCancelled()) {
+        return CANCELLED_RESULT;
+    }
+    ThreadLease lease = ThreadBudget::getInstance().acquire();
+    std::cout << "Starting transcription for: " << audio_file_path << " on " << lease.threads() << " thread(s)" << std::endl;
     
-    auto result = executeWhisperService(audio_file_path);
+    // Every attempt decodes from the start, so only segments past the ones already passed on go through
+    TranscriptListener listener;
+    if (listener_.on_segment) {
+        auto delivered_until = std::make_shared<double>(-1.0);
+        listener.on_segment = [on_segment = listener_.on_segment, delivered_until](const TranscriptSegment& segment) {
+            if (segment.end_seconds > *delivered_until) {
+                *delivered_until = segment.end_seconds;
+                on_segment(segment);
+            }
+        };
+    }
+    listener.on_progress = listener_.on_progress;
+    
+    TranscriptionRequest request;
+    request.audio_file_path = audio_file_path;
+    request.audio = audio;
+    request.duration_seconds = duration_seconds;
+    request.threads = lease.threads();
+    request.listener = listener ? &listener : nullptr;
+    request.cancel_token = cancel_token_;
+    std::string result = backend_ ? backend_->transcribe(request) : transcribe(request);
     
     std::cout << "Completed transcription for: " << audio_file_path << std::endl;
               
     return result;
 }
 
-void WhisperCliService::transcribeFileAsync(const std::string& audio_file_path,
-                                            std::function<void(const std::string&)> callback) {
-    // For now, implement as synchronous call
-    // In the future, this could be implemented with std::async or threading
-    std::string result = transcribeFile(audio_file_path);
-    if (callback) {
+std::string WhisperCliService::backendName() const {
+    return "whisper_service";
+}
+
+std::string WhisperCliService::transcribe(const TranscriptionRequest& request) {
+    static const TranscriptListener no_listener;
+    const TranscriptListener& listener = request.listener ? *request.listener : no_listener;
+    const std::shared_ptr<SharedAudioBuffer>& audio = request.audio;
+    // The caller's token; a request without one follows setCancellationToken()
+    CancellationToken* cancel_token = request.cancel_token ? request.cancel_token.get() : cancel_token_.get();
+    
+    std::string result;
+    bool served = false;
+    if (persistentBackendEnabled()) {
+        // Long recordings are cut into windows that idle workers decode alongside this one;
+        // the single daemon decodes one at a time, so there it would only add the overlaps
+        WhisperWorkerPool& pool = WhisperWorkerPool::getInstance();
+        served = audio && pool.isRunning() && pool.getStats().workers > 1 &&
+                 AudioChunker().shouldSplit(audio->sampleCount()) &&
+                 executeChunkedRequest(audio, request.threads, listener, cancel_token, result);
+        served = served || executeDaemonRequest(request.audio_file_path, audio, request.threads, listener,
+                                                cancel_token, result);
+    }
+    if (!served) {
+        // A one-shot child cannot receive the descriptor, but it can open ours through /proc
+        result = executeWhisperService(audio ? audio->procPath() : request.audio_file_path, request.threads, listener,
+                                       cancel_token);
+    }
+    return result;
+}
+
+json WhisperCliService::transcribePcm(const std::vector<int16_t>& samples) {
+    json response;
+    response["success"] = false;
+    
+    if (backend_) {
+        return transcribePcmOnBackend(samples);
+    }
+    if (!initialized_ || !persistentBackendEnabled()) {
+        response["error"] = "PCM transcription requires the whisper daemon";
+        setError(response["error"].get<std::string>());
+        return response;
+    }
+    
+    json request;
+    request["op"] = "transcribe";
+    request["pcm"] = "s16le";
+    request["vad"] = vad_enabled_;
+    if (listener_) {
+        request["stream"] = true;
+    }
+    
+    // The daemon serializes inference itself, so PCM requests do not go through TranscriptionScheduler
+    ThreadLease lease = ThreadBudget::getInstance().acquire();
+    request["threads"] = lease.threads();
+    std::string error;
+    if (!sendRequest(request, response, error, samples.data(), samples.size() * sizeof(int16_t), cancel_token_.get(),
+                     -1, listener_ ? &listener_ : nullptr)) {
+        setError(error);
+        response = json{{"success", false}, {"error", error}};
+    }
+    return response;
+}
+
+json WhisperCliService::transcribePcmOnBackend(const std::vector<int16_t>& samples) {
+    std::string error;
+    std::shared_ptr<SharedAudioBuffer> audio = SharedAudioBuffer::fromPcm(samples.data(), samples.size(), "pcm", error);
+    if (!audio) {
+        setError(error);
+        return json{{"success", false}, {"error", error}};
+    }
+    
+    // The daemon's response carries the segments; a backend only hands them to the listener
+    json segments = json::array();
+    TranscriptListener listener;
+    listener.on_segment = [&segments, forward = listener_.on_segment](const TranscriptSegment& segment) {
+        segments.push_back({{"text", segment.text}, {"start_time", segment.start_seconds},
+                            {"end_time", segment.end_seconds}});
+        if (forward) {
+            forward(segment);
+        }
+    };
+    listener.on_progress = listener_.on_progress;
+    
+    // Like the daemon path, PCM requests do not go through TranscriptionScheduler
+    ThreadLease lease = ThreadBudget::getInstance().acquire();
+    TranscriptionRequest request;
+    request.audio_file_path = audio->sourcePath();
+    request.audio = audio;
+    request.duration_seconds = audio->durationSeconds();
+    request.threads = lease.threads();
+    request.listener = &listener;
+    request.cancel_token = cancel_token_;
+    std::string result = backend_->transcribe(request);
+    
+    if (result.rfind("ERROR:", 0) == 0) {
+        error = result.substr(6);
+        error.erase(0, error.find_first_not_of(' '));
+        setError(error);
+        return json{{"success", false}, {"error", error}};
+    }
+    return json{{"success", true}, {"transcription", result}, {"segments", segments}};
+}
+
+bool WhisperCliService::transcribeFileAsync(const std::string& audio_file_path, AsyncCallback callback) {
+    std::string cache_key;
+    double duration_seconds = 0.0;
+    if (initialized_) {
+        inspectAudio(audio_file_path, cache_key, duration_seconds);
+    }
+    bool queued = startAsync(std::make_shared<WhisperCliService>(*this), cache_key, audio_file_path, nullptr,
+                             duration_seconds, std::move(callback));
+    if (!queued) {
+        setError("Transcription queue is full");
+    }
+    return queued;
+}
+
+bool WhisperCliService::transcribeAudioAsync(const std::shared_ptr<SharedAudioBuffer>& audio, AsyncCallback callback) {
+    std::string cache_key;
+    if (initialized_) {
+        cache_key = TranscriptionCache::makeKey(audio->samples(), audio->sampleCount(), cacheParams());
+    }
+    bool queued = startAsync(std::make_shared<WhisperCliService>(*this), cache_key, audio->sourcePath(), audio,
+                             audio->durationSeconds(), std::move(callback));
+    if (!queued) {
+        setError("Transcription queue is full");
+    }
+    return queued;
+}
+
+bool WhisperCliService::startAsync(const std::shared_ptr<WhisperCliService>& service, const std::string& cache_key,
+                                   const std::string& audio_file_path, const std::shared_ptr<SharedAudioBuffer>& audio,
+                                   double duration_seconds, AsyncCallback callback) {
+    if (!callback) {
+        callback = [](const std::string&) {};
+    }
+    if (!service->initialized_) {
+        service->setError("WhisperCliService not initialized");
+        callback("ERROR: Service not initialized");
+        return true;
+    }
+    if (service->cancel_token_ && service->cancel_token_->isCancelled()) {
+        callback(CANCELLED_RESULT);
+        return true;
+    }
+    if (cache_key.empty()) {
+        return scheduleAsync(service, audio_file_path, audio, duration_seconds, std::move(callback));
+    }
+
+    // Identical audio is answered from the cache, or by the running inference once it completes
+    TranscriptionCache& cache = TranscriptionCache::getInstance();
+    bool owner = cache.acquireAsync(cache_key, [service, cache_key, audio_file_path, audio, duration_seconds,
+                                                callback](bool abandoned, const std::string& result) {
+        if (!abandoned) {
+            callback(result);
+        } else if (!startAsync(service, cache_key, audio_file_path, audio, duration_seconds, callback)) {
+            // Its owner was cancelled and there is no room to take the claim over
+            callback(BUSY_RESULT);
+        }
+    });
+    if (!owner) {
+        return true;
+    }
+
+    bool queued = scheduleAsync(service, audio_file_path, audio, duration_seconds,
+                                [service, cache_key, callback](const std::string& result) {
+        TranscriptionCache& cache = TranscriptionCache::getInstance();
+        if (service->cancel_token_ && service->cancel_token_->isCancelled()) {
+            cache.abandon(cache_key);   // A waiter takes it over under its own token
+        } else {
+            cache.complete(cache_key, result);
+        }
         callback(result);
+    });
+    if (!queued) {
+        cache.complete(cache_key, BUSY_RESULT); // Not stored; requests waiting on the claim are busy too
+    }
+    return queued;
+}
+
+bool WhisperCliService::scheduleAsync(const std::shared_ptr<WhisperCliService>& service,
+                                      const std::string& audio_file_path, const std::shared_ptr<SharedAudioBuffer>& audio,
+                                      double duration_seconds, AsyncCallback callback) {
+    // The job and this call hold the only references, so a job dropped from the queue reports the cancellation
+    auto result = std::make_shared<AsyncResult>(std::move(callback));
+    uint64_t job_id = TranscriptionScheduler::getInstance().submit(
+        service->queue_session_id_, duration_seconds,
+        [service, audio_file_path, audio, duration_seconds, result]() {
+            std::string text;
+            try {
+                text = service->transcribeUncached(audio_file_path, audio, duration_seconds);
+            } catch (const std::exception& e) {
+                text = "ERROR: Exception during transcription: " + std::string(e.what());
+            }
+            result->deliver(text);
+        },
+        service->on_queue_position_, service->cancel_token_);
+    if (job_id == 0) {
+        result->discard();
+        return false;
     }
+    return true;
 }
 
 std::string WhisperCliService::getLastError() const {
     return last_error_;
 }
 
-std::string WhisperCliService::executeWhisperService(const std::string& audio_file_path) {
-    // Use file locking to prevent concurrent transcriptions
-    // This ensures only one transcription runs at a time for stability
-    std::ostringstream command_stream;
-    command_stream << "flock /tmp/whisper.lock timeout 60s \"" << whisper_executable_path_ << "\" \"" 
-                   << model_path_ << "\" \"" << audio_file_path << "\" 2>/dev/null";
-    std::string command = command_stream.str();
+std::string WhisperCliService::executeWhisperService(const std::string& audio_file_path, int threads,
+                                                     const TranscriptListener& listener, CancellationToken* cancel_token) {
+    // Concurrency is bounded by TranscriptionScheduler's worker count, not a file lock.
+    // The child is started directly (no shell) so a cancellation can signal it.
+    std::vector<std::string> arguments = {"timeout", "60s", whisper_executable_path_, model_path_, audio_file_path,
+                                          "--threads", std::to_string(threads)};
+    if (vad_enabled_) {
+        arguments.push_back("--vad");
+    }
+    if (listener) {
+        arguments.push_back("--stream");
+    }
+    std::vector<char*> argv;
+    for (auto& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
     
-    std::cout << "Executing (serialized): " << command << std::endl;
+    std::cout << "Executing: timeout 60s " << whisper_executable_path_ << " " << model_path_ << " " 
+              << audio_file_path << " --threads " << threads << (vad_enabled_ ? " --vad" : "")
+              << (listener ? " --stream" : "") << std::endl;
     
-    // Execute command with robust error handling
-    FILE* pipe = popen(command.c_str(), "r");
-    if (!pipe) {
+    int output_pipe[2];
+    if (pipe2(output_pipe, O_CLOEXEC) != 0) {
         setError("Failed to execute whisper service");
         return "ERROR: Failed to execute whisper service";
     }
     
+    pid_t child = fork();
+    if (child < 0) {
+        close(output_pipe[0]);
+        close(output_pipe[1]);
+        setError("Failed to execute whisper service");
+        return "ERROR: Failed to execute whisper service";
+    }
+    if (child == 0) {
+        dup2(output_pipe[1], STDOUT_FILENO);
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDERR_FILENO);
+        }
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    close(output_pipe[1]);
+    
+    // timeout(1) forwards SIGTERM to whisper_service. The child stays a zombie until
+    // waitpid below, so its pid cannot be reused while the handler may still fire.
+    uint64_t cancel_handler = 0;
+    if (cancel_token) {
+        cancel_handler = cancel_token->onCancel([child]() { kill(child, SIGTERM); });
+    }
+    
     // Read output with buffering to prevent blocking
     std::array<char, 4096> buffer;
     std::string result;
     result.reserve(8192); // Reserve space to reduce allocations
+    bool too_large = false;
+    size_t response_start = 0; // With --stream, the response follows the last event line
     
-    while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-        result += buffer.data();
+    while (true) {
+        ssize_t count = read(output_pipe[0], buffer.data(), buffer.size());
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        result.append(buffer.data(), count);
+        
+        // Event lines are complete JSON documents; the response is the one line that is not an event
+        for (size_t newline; listener && (newline = result.find('\n', response_start)) != std::string::npos;) {
+            json line = json::parse(result.begin() + response_start, result.begin() + newline, nullptr, false);
+            if (!WhisperDaemonProtocol::dispatchEvent(line, &listener)) {
+                break;
+            }
+            response_start = newline + 1;
+        }
         
         // Prevent excessive memory usage
         if (result.size() > 1024 * 1024) { // 1MB limit
-            setError("Output too large, possible infinite loop");
-            pclose(pipe);
-            return "ERROR: Output too large";
+            too_large = true;
+            kill(child, SIGTERM);
+            break;
         }
     }
+    close(output_pipe[0]);
     
-    int exit_code = pclose(pipe);
+    if (cancel_token) {
+        cancel_token->removeHandler(cancel_handler);
+    }
+    int status = 0;
+    waitpid(child, &status, 0);
     
-    // Additional cleanup - ensure no zombie processes
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (cancel_token && cancel_token->isCancelled()) {
+        return CANCELLED_RESULT;
+    }
+    if (too_large) {
+        setError("Output too large, possible infinite loop");
+        return "ERROR: Output too large";
+    }
     
-    if (exit_code == 0) {
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
         // Success - parse JSON and extract transcription
         try {
-            // Remove trailing newline if present
+            // Remove the events and the trailing newline, if present
+            result.erase(0, response_start);
             if (!result.empty() && result.back() == '\n') {
                 result.pop_back();
             }
             
-            json response = json::parse(result);
-            
-            if (response.contains("success") && response["success"].get<bool>()) {
-                if (response.contains("transcription")) {
-                    std::string transcription = response["transcription"].get<std::string>();
-                    
-                    // Log detailed info for debugging
-                    if (response.contains("timing")) {
-                        auto timing = response["timing"];
-                        std::cout << "Transcription completed in " 
-                                  << timing["total_processing_ms"].get<int>() << "ms" << std::endl;
-                    }
-                    
-                    return transcription;
-                } else {
-                    setError("JSON response missing transcription field");
-                    return "ERROR: Invalid response format";
-                }
-            } else {
-                std::string error_msg = "Transcription failed";
-                if (response.contains("error")) {
-                    error_msg = response["error"].get<std::string>();
-                }
-                setError(error_msg);
-                return "ERROR: " + error_msg;
-            }
+            return handleServiceResponse(json::parse(result));
         } catch (const json::exception& e) {
             setError("Failed to parse JSON response: " + std::string(e.what()));
             return "ERROR: Invalid JSON response: " + result;
         }
     } else {
-        setError("Whisper service failed with exit code " + std::to_string(exit_code / 256) + ". Output: " + result);
+        int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        setError("Whisper service failed with exit code " + std::to_string(exit_code) + ". Output: " + result);
         return "ERROR: Transcription failed: " + result;
     }
 }
 
+WhisperDaemonClient& WhisperCliService::daemonClient() {
+    if (!thread_daemon_client || !thread_daemon_client->matches(daemon_socket_path_, model_path_)) {
+        thread_daemon_client = std::make_unique<WhisperDaemonClient>(
+            daemon_socket_path_, whisper_executable_path_, model_path_);
+    }
+    return *thread_daemon_client;
+}
+
+bool WhisperCliService::persistentBackendEnabled() const {
+    return !daemon_socket_path_.empty() || WhisperWorkerPool::getInstance().isRunning();
+}
+
+bool WhisperCliService::sendRequest(const json& request, json& response, std::string& error,
+                                    const void* payload, size_t payload_size, CancellationToken* cancel_token,
+                                    int pass_fd, const TranscriptListener* listener) {
+    // The server's worker pool, when configured, replaces the single shared daemon
+    WhisperWorkerPool& pool = WhisperWorkerPool::getInstance();
+    if (pool.isRunning()) {
+        return pool.request(request, response, error, payload, payload_size, cancel_token, pass_fd, listener);
+    }
+    return daemonClient().request(request, response, error, payload, payload_size, cancel_token, pass_fd, listener);
+}
+
+bool WhisperCliService::executeDaemonRequest(const std::string& audio_file_path,
+                                             const std::shared_ptr<SharedAudioBuffer>& audio,
+                                             int threads, const TranscriptListener& listener,
+                                             CancellationToken* cancel_token, std::string& result) {
+    json request;
+    request["op"] = "transcribe";
+    if (audio) {
+        request["audio_fd"] = "wav"; // The memfd rides along with the frame
+    } else {
+        request["audio_file"] = audio_file_path;
+    }
+    request["vad"] = vad_enabled_;
+    request["threads"] = threads;
+    if (listener) {
+        request["stream"] = true;
+    }
+    
+    json response;
+    std::string error;
+    if (!sendRequest(request, response, error, nullptr, 0, cancel_token, audio ? audio->fd() : -1,
+                     listener ? &listener : nullptr)) {
+        if (cancel_token && cancel_token->isCancelled()) {
+            result = CANCELLED_RESULT; // Not a daemon failure, do not fall back to the CLI
+            return true;
+        }
+        setError("Whisper daemon unavailable, falling back to CLI: " + error);
+        return false;
+    }
+    
+    try {
+        result = handleServiceResponse(response);
+    } catch (const json::exception& e) {
+        setError("Failed to read daemon response: " + std::string(e.what()));
+        result = "ERROR: Invalid daemon response";
+    }
+    return true;
+}
+
+bool WhisperCliService::executeChunkedRequest(const std::shared_ptr<SharedAudioBuffer>& audio, int threads,
+                                              const TranscriptListener& listener, CancellationToken* cancel_token,
+                                              std::string& result) {
+    AudioChunker chunker;
+    std::vector<AudioWindow> windows = chunker.plan(audio->samples(), audio->sampleCount());
+    TranscriptStitcher stitcher(windows, SharedAudioBuffer::SAMPLE_RATE, listener);
+    
+    // As many windows at once as there are idle workers; with none, this job waits for one like any other
+    size_t parallelism = std::max<size_t>(1, WhisperWorkerPool::getInstance().getStats().idle);
+    const std::thread::id caller = std::this_thread::get_id();
+    std::mutex error_mutex;
+    std::string error;
+    
+    auto start = std::chrono::steady_clock::now();
+    bool completed = AudioChunker::runParallel(windows.size(), parallelism, [&](size_t index) {
+        // Windows on borrowed workers take their own share of the cores
+        ThreadLease lease;
+        if (std::this_thread::get_id() != caller) {
+            lease = ThreadBudget::getInstance().acquire();
+        }
+        
+        json request;
+        request["op"] = "transcribe";
+        request["audio_fd"] = "wav";
+        request["window"] = {windows[index].start, windows[index].end};
+        request["vad"] = vad_enabled_;
+        request["threads"] = lease.threads() > 0 ? lease.threads() : threads;
+        
+        json response;
+        std::string request_error;
+        if (!sendRequest(request, response, request_error, nullptr, 0, cancel_token, audio->fd()) ||
+            !response.value("success", false) || !response.contains("segments")) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            error = request_error.empty() ? response.value("error", std::string("invalid response")) : request_error;
+            return false;
+        }
+        
+        std::vector<TranscriptSegment> segments;
+        for (const json& segment : response["segments"]) {
+            TranscriptSegment piece;
+            piece.text = segment.value("text", "");
+            piece.start_seconds = segment.value("start_time", 0.0);
+            piece.end_seconds = segment.value("end_time", 0.0);
+            segments.push_back(std::move(piece));
+        }
+        stitcher.addWindow(index, segments);
+        return true;
+    });
+    
+    if (cancel_token && cancel_token->isCancelled()) {
+        result = CANCELLED_RESULT;
+        return true;
+    }
+    if (!completed) {
+        setError("Chunked transcription failed, retrying as one request: " + error);
+        return false;
+    }
+    
+    size_t pause_cuts = std::count_if(windows.begin(), windows.end(), [](const AudioWindow& w) { return w.cut_in_pause; });
+    std::cout << "Transcribed " << windows.size() << " windows (" << pause_cuts << " cut in pauses) on up to "
+              << std::min(parallelism, windows.size()) << " worker(s) in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count()
+              << "ms" << std::endl;
+    result = stitcher.text();
+    return true;
+}
+
+std::string WhisperCliService::handleServiceResponse(const json& response) {
+    if (response.contains("success") && response["success"].get<bool>()) {
+        if (response.contains("transcription")) {
+            std::string transcription = response["transcription"].get<std::string>();
+            
+            // Log detailed info for debugging
+            if (response.contains("timing")) {
+                auto timing = response["timing"];
+                std::cout << "Transcription completed in " 
+                          << timing["total_processing_ms"].get<int>() << "ms" << std::endl;
+            }
+            
+            return transcription;
+        } else {
+            setError("JSON response missing transcription field");
+            return "ERROR: Invalid response format";
+        }
+    } else {
+        std::string error_msg = "Transcription failed";
+        if (response.contains("error")) {
+            error_msg = response["error"].get<std::string>();
+        }
+        setError(error_msg);
+        return "ERROR: " + error_msg;
+    }
+}
+
 void WhisperCliService::setError(const std::string& error) const {
     last_error_ = error;
     std::cerr << "WhisperCliService Error: " << error << std::endl;
@@ -4,20 +4,32 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <vector>
+#include <cstdint>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include "TranscriptSegment.h"
+#include "TranscriptionBackend.h"
 
 using json = nlohmann::json;
 
+class WhisperDaemonClient;
+class CancellationToken;
+class SharedAudioBuffer;
+
 /**
  * @brief WhisperCliService - Command Line Interface service for Whisper transcription
  * 
  * This class provides a simple interface to call an external whisper_service executable
  * for audio transcription. It consolidates both client and service functionality.
+ *
+ * As a TranscriptionBackend it is the default engine behind its own cache and queue;
+ * setBackend() / setDefaultBackend() put another engine there instead.
  */
-class WhisperCliService {
+class WhisperCliService : public TranscriptionBackend {
 public:
     WhisperCliService();
-    ~WhisperCliService();
+    ~WhisperCliService() override;
     
     /**
      * @brief Initialize the service with paths to the executable and model
@@ -27,25 +39,128 @@ public:
      */
     bool initialize(const std::string& whisper_executable_path, const std::string& model_path);
     
+    /**
+     * @brief Executable and model used by components that do not pick their own
+     *
+     * Set once at server start from wt_config.xml (whisper-service, whisper-model);
+     * default to ./whisper_service and WhisperModelFile::DEFAULT_PATH.
+     */
+    static void setDefaultPaths(const std::string& whisper_executable_path, const std::string& model_path);
+    static std::string defaultExecutablePath();
+    static std::string defaultModelPath();
+    
+    /**
+     * @brief Engine that services created from now on hand their scheduled recordings to
+     * @param backend nullptr (the default) for the whisper_service daemon / pool / CLI path
+     *
+     * Set once at server start from wt_config.xml (whisper-backend); the cache, the
+     * scheduler and the listeners stay in front of whichever engine is chosen.
+     */
+    static void setDefaultBackend(std::shared_ptr<TranscriptionBackend> backend);
+    static std::shared_ptr<TranscriptionBackend> defaultBackend();
+    
+    /**
+     * @brief Engine for this service's following transcriptions, overriding the default
+     * @param backend nullptr for the whisper_service path
+     */
+    void setBackend(std::shared_ptr<TranscriptionBackend> backend);
+    
+    /**
+     * @brief Route transcriptions through a persistent `whisper_service --daemon` process
+     * @param socket_path Unix domain socket of the daemon (spawned on demand if not running)
+     *
+     * Each calling thread keeps its own connection to the daemon so the model stays
+     * loaded between clips. Falls back to one-shot CLI execution if the daemon is unreachable.
+     * While the server runs a WhisperWorkerPool, requests go to its workers instead.
+     */
+    void enableDaemon(const std::string& socket_path);
+    
+    /**
+     * @brief Trim silence with whisper_service's VAD stage before inference
+     * @param enabled true to drop leading/trailing silence and shorten long pauses
+     *
+     * Segment timestamps are still reported relative to the untrimmed audio.
+     */
+    void setVadEnabled(bool enabled);
+    
+    /**
+     * @brief Identify the caller to TranscriptionScheduler for the following file transcriptions
+     * @param session_id Fairness domain, normally the Wt session id
+     * @param on_position Called from a scheduler thread with the place in line (0 = started)
+     */
+    void setQueueContext(const std::string& session_id, std::function<void(size_t)> on_position);
+    
+    /**
+     * @brief Abandon the following transcriptions when the token is cancelled
+     *
+     * Queued jobs leave the scheduler, a running daemon request is aborted through
+     * its connection and a CLI child process is killed. The call returns "ERROR: Cancelled".
+     */
+    void setCancellationToken(std::shared_ptr<CancellationToken> cancel_token);
+    
+    /**
+     * @brief Receive segments and progress while the following transcriptions decode
+     *
+     * Called from the thread running the request, before the result is returned. Results
+     * served by TranscriptionCache (or joined from another caller's inference) report
+     * nothing here. A retried request (restarted daemon, CLI fallback) only reports the
+     * segments past those already delivered.
+     */
+    void setTranscriptListener(TranscriptListener listener);
+    
     /**
      * @brief Synchronously transcribe an audio file
      * @param audio_file_path Path to the audio file to transcribe
      * @return Transcribed text or error message starting with "ERROR:"
+     *
+     * Results are cached by audio content (see TranscriptionCache), so re-uploads
+     * and concurrent retries of the same recording cost one inference. Misses wait
+     * their turn in TranscriptionScheduler; when its queue is full the call returns
+     * "ERROR: Server busy..." immediately.
      */
     std::string transcribeFile(const std::string& audio_file_path);
     
     /**
-     * @brief Asynchronously transcribe an audio file
-     * @param audio_file_path Path to the audio file to transcribe
-     * @return Future that will contain the transcribed text
+     * @brief Synchronously transcribe in-memory PCM through the daemon, or the backend when one is set
+     * @param samples 16kHz mono signed 16-bit samples
+     * @return Full whisper_service response (segments with timestamps included; a backend's
+     *         response has only success, transcription and segments); "success" is false and
+     *         "error" is set when neither daemon nor backend is available or they fail
+     *         (or the cancellation token fired)
      */
+    json transcribePcm(const std::vector<int16_t>& samples);
+    
+    using AsyncCallback = std::function<void(const std::string& result)>;
+    
     /**
-     * Transcribe an audio file asynchronously
+     * @brief transcribeFile() without blocking the caller
      * @param audio_file_path Path to the audio file to transcribe
-     * @param callback Callback function to be called with the transcription result
+     * @param callback Receives what transcribeFile() would have returned ("ERROR: ..." on failure)
+     * @return false if the scheduler queue is full; callback is then not called
+     *
+     * Returns once the WAV is hashed. The cache lookup happens here and a miss goes straight
+     * to TranscriptionScheduler as a job on a copy of this service's configuration, so the
+     * service may be destroyed before it finishes and no thread waits for the job's turn.
+     * The callback runs on the scheduler thread that ran the job (or the one finishing an
+     * identical in-flight request), or right here for a cached result, an error or a job
+     * dropped by the cancellation token: use WServer::post to get back into a session.
+     */
+    bool transcribeFileAsync(const std::string& audio_file_path, AsyncCallback callback);
+    
+    /**
+     * @brief Transcribe audio already decoded into a memfd
+     * @param audio Buffer from SharedAudioBuffer::fromWavFile
+     * @return Same as transcribeFile()
+     *
+     * The daemon receives the descriptor itself (SCM_RIGHTS) rather than a path, so
+     * nothing is written to or re-read from disk; the CLI fallback opens it through /proc.
      */
-    void transcribeFileAsync(const std::string& audio_file_path,
-                             std::function<void(const std::string&)> callback);
+    std::string transcribeAudio(const std::shared_ptr<SharedAudioBuffer>& audio);
+    
+    /**
+     * @brief transcribeAudio() without blocking the caller, like transcribeFileAsync()
+     */
+    bool transcribeAudioAsync(const std::shared_ptr<SharedAudioBuffer>& audio, AsyncCallback callback);
     
     /**
      * @brief Check if the service is properly initialized
@@ -58,14 +173,128 @@ public:
      * @return Last error message
      */
     std::string getLastError() const;
+    
+    std::string backendName() const override;
+    
+    /**
+     * @brief Run one recording through the whisper_service engine, bypassing cache and scheduler
+     *
+     * Long recordings in a memfd go out as AudioChunker windows to the idle pool workers
+     * first, then the whole recording to the daemon or pool, then to a one-shot CLI child.
+     * Cancelled by the request's token, or by setCancellationToken()'s when it has none.
+     */
+    std::string transcribe(const TranscriptionRequest& request) override;
 
 private:
+    /**
+     * @brief Cache key for the file's samples, model and options, and the clip duration
+     *
+     * Both are left empty/zero if the file is not a readable WAV.
+     */
+    void inspectAudio(const std::string& audio_file_path, std::string& cache_key, double& duration_seconds) const;
+    
+    /**
+     * @brief Cache key parameters: model and options that change the transcript
+     */
+    std::string cacheParams() const;
+    
+    /**
+     * @brief Queue transcribeUncached() on TranscriptionScheduler and wait for it
+     */
+    std::string transcribeScheduled(const std::string& audio_file_path,
+                                    const std::shared_ptr<SharedAudioBuffer>& audio, double duration_seconds);
+    
+    /**
+     * @brief Run the transcription on the backend (this service's own engine by default) without consulting the cache
+     *
+     * Holds a ThreadBudget lease for the duration; its grant becomes the service's n_threads.
+     */
+    std::string transcribeUncached(const std::string& audio_file_path, const std::shared_ptr<SharedAudioBuffer>& audio,
+                                   double duration_seconds);
+    
+    /**
+     * @brief transcribePcm() on backend_: the samples go in a SharedAudioBuffer, the segments
+     *        are collected from its listener calls
+     */
+    json transcribePcmOnBackend(const std::vector<int16_t>& samples);
+    
     /**
      * @brief Execute the whisper service with the given audio file
      * @param audio_file_path Path to the audio file
+     * @param threads Inference threads (ThreadBudget grant)
+     * @param cancel_token The child is killed if it fires while the child runs (may be null)
+     * @return Transcribed text or error message
+     *
+     * With a listener the child runs with --stream and its event lines are passed on as they arrive.
+     */
+    std::string executeWhisperService(const std::string& audio_file_path, int threads,
+                                      const TranscriptListener& listener, CancellationToken* cancel_token);
+    
+    /**
+     * @brief Send the audio file to the daemon over this thread's connection
+     * @param audio_file_path Path to the audio file
+     * @param audio Sent as a descriptor instead of the path when set
+     * @param threads Inference threads (ThreadBudget grant)
+     * @param listener Streams segment and progress events when set
+     * @param cancel_token Aborts the request when it fires (may be null)
+     * @param result Transcribed text or error message
+     * @return false if the daemon could not be reached (caller may fall back to the CLI)
+     */
+    bool executeDaemonRequest(const std::string& audio_file_path, const std::shared_ptr<SharedAudioBuffer>& audio,
+                              int threads, const TranscriptListener& listener, CancellationToken* cancel_token,
+                              std::string& result);
+    
+    /**
+     * @brief Transcribe a long recording as AudioChunker windows spread over the idle pool workers
+     * @param threads Inference threads of the window run on this job's own worker; the others
+     *        take their own ThreadBudget lease
+     * @param listener Receives the stitched segments in order, as each window completes
+     * @param result Stitched transcript, or "ERROR: Cancelled"
+     * @return false if a window failed (caller retries the recording as one request)
+     */
+    bool executeChunkedRequest(const std::shared_ptr<SharedAudioBuffer>& audio, int threads,
+                               const TranscriptListener& listener, CancellationToken* cancel_token,
+                               std::string& result);
+    
+    /**
+     * @brief True if requests go to a long-lived process: the daemon or the server's WhisperWorkerPool
+     */
+    bool persistentBackendEnabled() const;
+    
+    /**
+     * @brief Send one request to WhisperWorkerPool if it runs, else over this thread's daemon connection
+     */
+    bool sendRequest(const json& request, json& response, std::string& error,
+                     const void* payload, size_t payload_size, CancellationToken* cancel_token,
+                     int pass_fd = -1, const TranscriptListener* listener = nullptr);
+    
+    /**
+     * @brief Claim the cache key and schedule the transcription, or have the claim's owner report back
+     * @return false if the scheduler queue is full (callback not called)
+     */
+    static bool startAsync(const std::shared_ptr<WhisperCliService>& service, const std::string& cache_key,
+                           const std::string& audio_file_path, const std::shared_ptr<SharedAudioBuffer>& audio,
+                           double duration_seconds, AsyncCallback callback);
+    
+    /**
+     * @brief Queue transcribeUncached() on TranscriptionScheduler; the job itself calls back
+     * @return false if the queue is full (callback not called)
+     */
+    static bool scheduleAsync(const std::shared_ptr<WhisperCliService>& service, const std::string& audio_file_path,
+                              const std::shared_ptr<SharedAudioBuffer>& audio, double duration_seconds,
+                              AsyncCallback callback);
+    
+    /**
+     * @brief Daemon connection of the calling thread, created on first use
+     */
+    WhisperDaemonClient& daemonClient();
+    
+    /**
+     * @brief Extract the transcription from a whisper_service JSON response
+     * @param response Parsed response produced by the CLI or the daemon
      * @return Transcribed text or error message
      */
-    std::string executeWhisperService(const std::string& audio_file_path);
+    std::string handleServiceResponse(const json& response);
     
     /**
      * @brief Set error message
@@ -76,5 +305,12 @@ private:
     bool initialized_;
     std::string whisper_executable_path_;
     std::string model_path_;
+    std::string daemon_socket_path_;
+    bool vad_enabled_;
+    std::string queue_session_id_;
+    std::function<void(size_t)> on_queue_position_;
+    std::shared_ptr<CancellationToken> cancel_token_;
+    TranscriptListener listener_;
+    std::shared_ptr<TranscriptionBackend> backend_;
     mutable std::string last_error_;
 };
@@ -0,0 +1,200 @@
+#include "WhisperDaemonClient.h"
+#include "WhisperDaemonProtocol.h"
+#include "CancellationToken.h"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+std::mutex WhisperDaemonClient::spawn_mutex_;
+
+// Same budget the CLI path gets from `timeout 60s`
+static constexpr int RESPONSE_TIMEOUT_SECONDS = 60;
+// Loading ggml-base.en.bin on a cold cache takes a few seconds; leave generous room
+static constexpr int SPAWN_TIMEOUT_MS = 30000;
+
+WhisperDaemonClient::WhisperDaemonClient(const std::string& socket_path,
+                                         const std::string& whisper_executable_path,
+                                         const std::string& model_path)
+    : socket_path_(socket_path)
+    , whisper_executable_path_(whisper_executable_path)
+    , model_path_(model_path)
+    , fd_(-1)
+{
+}
+
+WhisperDaemonClient::~WhisperDaemonClient() {
+    disconnect();
+}
+
+bool WhisperDaemonClient::matches(const std::string& socket_path, const std::string& model_path) const {
+    return socket_path_ == socket_path && model_path_ == model_path;
+}
+
+bool WhisperDaemonClient::request(const json& request, json& response, std::string& error,
+                                  const void* payload, size_t payload_size,
+                                  CancellationToken* cancel_token, int pass_fd,
+                                  const TranscriptListener* listener) {
+    std::vector<char> response_payload;
+    
+    // Cancelling from another thread shuts the socket down, which unblocks readFrame below
+    uint64_t cancel_handler = cancel_token ? cancel_token->onCancel([this]() { interrupt(); }) : 0;
+    auto cancelled = [cancel_token, &error]() {
+        if (cancel_token && cancel_token->isCancelled()) {
+            error = "Cancelled";
+            return true;
+        }
+        return false;
+    };
+    bool received = false;
+
+    // Second attempt covers a daemon that died or was restarted since the last request
+    for (int attempt = 0; attempt < 2 && !cancelled(); ++attempt) {
+        if (!ensureConnected(error)) {
+            break;
+        }
+        if (cancelled()) {
+            break; // Cancelled while connecting, before interrupt() had a socket to shut down
+        }
+
+        if (!WhisperDaemonProtocol::writeFrame(fd_, request, payload, payload_size, pass_fd)) {
+            error = "Failed to send request to whisper daemon";
+            disconnect();
+            continue;
+        }
+
+        errno = 0;
+        if (WhisperDaemonProtocol::readResponse(fd_, response, response_payload, listener)) {
+            received = true;
+            break;
+        }
+
+        bool timed_out = errno == EAGAIN || errno == EWOULDBLOCK;
+        disconnect();
+        if (cancelled()) {
+            break;
+        }
+        if (timed_out) {
+            // The daemon is still working on it; resending would only queue the same job twice
+            error = "Timed out waiting for whisper daemon response";
+            break;
+        }
+        error = "Connection to whisper daemon lost";
+    }
+
+    if (cancel_token) {
+        cancel_token->removeHandler(cancel_handler);
+    }
+    return received;
+}
+
+bool WhisperDaemonClient::ensureConnected(std::string& error) {
+    if (fd_ >= 0) {
+        return true;
+    }
+    if (connectSocket()) {
+        return true;
+    }
+    return spawnDaemon(error);
+}
+
+bool WhisperDaemonClient::connectSocket() {
+    if (socket_path_.size() >= sizeof(sockaddr_un::sun_path)) {
+        return false;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path_.c_str(), sizeof(address.sun_path) - 1);
+
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return false;
+    }
+
+    timeval receive_timeout{RESPONSE_TIMEOUT_SECONDS, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+
+    std::lock_guard<std::mutex> lock(fd_mutex_);
+    fd_ = fd;
+    return true;
+}
+
+bool WhisperDaemonClient::spawnDaemon(std::string& error) {
+    std::lock_guard<std::mutex> lock(spawn_mutex_);
+
+    // Another worker may have started the daemon while we waited for the lock
+    if (connectSocket()) {
+        return true;
+    }
+
+    if (access(whisper_executable_path_.c_str(), X_OK) != 0) {
+        error = "whisper_service executable not found: " + whisper_executable_path_;
+        return false;
+    }
+
+    std::cout << "Starting whisper daemon on " << socket_path_ << std::endl;
+
+    // Double fork so the daemon is re-parented to init and never becomes our zombie
+    pid_t child = fork();
+    if (child < 0) {
+        error = "Failed to fork whisper daemon: " + std::string(std::strerror(errno));
+        return false;
+    }
+    if (child == 0) {
+        setsid();
+        if (fork() != 0) {
+            _exit(0);
+        }
+        int null_fd = open("/dev/null", O_RDWR);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+        }
+        execl(whisper_executable_path_.c_str(), whisper_executable_path_.c_str(),
+              "--daemon", socket_path_.c_str(), model_path_.c_str(), static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    waitpid(child, nullptr, 0);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(SPAWN_TIMEOUT_MS);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (connectSocket()) {
+            std::cout << "Whisper daemon is accepting connections on " << socket_path_ << std::endl;
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    error = "Whisper daemon did not start listening on " + socket_path_;
+    return false;
+}
+
+void WhisperDaemonClient::disconnect() {
+    std::lock_guard<std::mutex> lock(fd_mutex_);
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void WhisperDaemonClient::interrupt() {
+    std::lock_guard<std::mutex> lock(fd_mutex_);
+    if (fd_ >= 0) {
+        // Wakes up a blocked read; the descriptor itself is closed by the owning thread
+        shutdown(fd_, SHUT_RDWR);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <mutex>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+class CancellationToken;
+struct TranscriptListener;
+
+/**
+ * @brief WhisperDaemonClient - Persistent connection to a `whisper_service --daemon` process
+ *
+ * One client owns one socket connection and is meant to be used by a single worker thread.
+ * Broken connections are re-established transparently; if the daemon is not running
+ * (socket missing or refusing connections) the client starts a new one and waits
+ * for it to accept connections before retrying the request.
+ */
+class WhisperDaemonClient {
+public:
+    /**
+     * @param socket_path Unix domain socket the daemon listens on
+     * @param whisper_executable_path whisper_service executable used to (re)spawn the daemon
+     * @param model_path Model the daemon should load when spawned
+     */
+    WhisperDaemonClient(const std::string& socket_path,
+                        const std::string& whisper_executable_path,
+                        const std::string& model_path);
+    ~WhisperDaemonClient();
+
+    WhisperDaemonClient(const WhisperDaemonClient&) = delete;
+    WhisperDaemonClient& operator=(const WhisperDaemonClient&) = delete;
+
+    /**
+     * @brief Send a request frame and wait for the matching response
+     * @param request JSON request (see whisper_service_main.cpp for supported ops)
+     * @param response Parsed JSON response
+     * @param error Filled with a description when the call fails
+     * @param payload Optional binary payload sent with the request (e.g. PCM samples)
+     * @param payload_size Size of the payload in bytes
+     * @param cancel_token Cancelling it shuts the connection down; the daemon sees the
+     *        hangup and aborts the inference (error is then "Cancelled")
+     * @param pass_fd Descriptor sent with the request (SCM_RIGHTS), -1 for none; the caller keeps its copy
+     * @param listener Receives the event frames of a "stream": true request; the response
+     *        timeout then applies to the gap between frames rather than the whole request
+     * @return true if a response was received
+     */
+    bool request(const json& request, json& response, std::string& error,
+                 const void* payload = nullptr, size_t payload_size = 0,
+                 CancellationToken* cancel_token = nullptr, int pass_fd = -1,
+                 const TranscriptListener* listener = nullptr);
+
+    /**
+     * @brief Check whether this client targets the given daemon configuration
+     */
+    bool matches(const std::string& socket_path, const std::string& model_path) const;
+
+    const std::string& socketPath() const { return socket_path_; }
+
+private:
+    bool ensureConnected(std::string& error);
+    bool connectSocket();
+    bool spawnDaemon(std::string& error);
+    void disconnect();
+    void interrupt();
+
+    std::string socket_path_;
+    std::string whisper_executable_path_;
+    std::string model_path_;
+    int fd_;
+    // Guards fd_ against interrupt() from a cancelling thread
+    std::mutex fd_mutex_;
+
+    // Serializes daemon spawning across all clients of this process
+    static std::mutex spawn_mutex_;
+};
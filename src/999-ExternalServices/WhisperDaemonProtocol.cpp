@@ -0,0 +1,225 @@
+#include "WhisperDaemonProtocol.h"
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+bool WhisperDaemonProtocol::writeFrame(int fd, const json& header, const void* payload, size_t payload_size,
+                                       int pass_fd) {
+    std::string header_bytes = header.dump();
+    if (header_bytes.size() > MAX_HEADER_SIZE || payload_size > MAX_PAYLOAD_SIZE) {
+        return false;
+    }
+
+    uint32_t lengths[2] = {
+        htonl(static_cast<uint32_t>(header_bytes.size())),
+        htonl(static_cast<uint32_t>(payload_size))
+    };
+
+    bool prefix_written = pass_fd < 0 ? writeAll(fd, lengths, sizeof(lengths))
+                                      : sendWithDescriptor(fd, lengths, sizeof(lengths), pass_fd);
+    if (!prefix_written || !writeAll(fd, header_bytes.data(), header_bytes.size())) {
+        return false;
+    }
+    return payload_size == 0 || writeAll(fd, payload, payload_size);
+}
+
+bool WhisperDaemonProtocol::readFrame(int fd, json& header, std::vector<char>& payload, int* received_fd) {
+    uint32_t lengths[2];
+    if (received_fd) {
+        *received_fd = -1;
+        if (!receiveWithDescriptor(fd, lengths, sizeof(lengths), *received_fd)) {
+            return false;
+        }
+    } else if (!readAll(fd, lengths, sizeof(lengths))) {
+        return false;
+    }
+
+    uint32_t header_size = ntohl(lengths[0]);
+    uint32_t payload_size = ntohl(lengths[1]);
+    bool complete = header_size != 0 && header_size <= MAX_HEADER_SIZE && payload_size <= MAX_PAYLOAD_SIZE;
+
+    std::string header_bytes;
+    if (complete) {
+        header_bytes.resize(header_size);
+        payload.resize(payload_size);
+        complete = readAll(fd, header_bytes.data(), header_size) &&
+                   (payload_size == 0 || readAll(fd, payload.data(), payload_size));
+    }
+    if (complete) {
+        header = json::parse(header_bytes, nullptr, false);
+        complete = !header.is_discarded();
+    }
+
+    // A descriptor that came with a broken frame would otherwise leak
+    if (!complete && received_fd && *received_fd >= 0) {
+        close(*received_fd);
+        *received_fd = -1;
+    }
+    return complete;
+}
+
+bool WhisperDaemonProtocol::readResponse(int fd, json& response, std::vector<char>& payload,
+                                         const TranscriptListener* listener) {
+    while (readFrame(fd, response, payload)) {
+        if (!dispatchEvent(response, listener)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+json WhisperDaemonProtocol::segmentEvent(const TranscriptSegment& segment, size_t id) {
+    return {{"event", "segment"},
+            {"segment", {{"id", id}, {"text", segment.text},
+                         {"start_time", segment.start_seconds}, {"end_time", segment.end_seconds}}}};
+}
+
+json WhisperDaemonProtocol::progressEvent(int percent) {
+    return {{"event", "progress"}, {"progress", percent}};
+}
+
+bool WhisperDaemonProtocol::dispatchEvent(const json& message, const TranscriptListener* listener) {
+    if (!message.is_object() || !message.contains("event")) {
+        return false;
+    }
+    if (!listener) {
+        return true;
+    }
+    const std::string event = message.value("event", "");
+    if (event == "segment" && listener->on_segment && message.contains("segment")) {
+        const json& fields = message["segment"];
+        TranscriptSegment segment;
+        segment.text = fields.value("text", "");
+        segment.start_seconds = fields.value("start_time", 0.0);
+        segment.end_seconds = fields.value("end_time", 0.0);
+        listener->on_segment(segment);
+    } else if (event == "progress" && listener->on_progress) {
+        listener->on_progress(message.value("progress", 0));
+    }
+    return true;
+}
+
+std::string WhisperDaemonProtocol::defaultSocketPath() {
+    // $XDG_RUNTIME_DIR is private to the user already; otherwise a 0700 run/ in the working directory,
+    // never a shared path another local user could create or squat on first
+    const char* runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    struct stat info;
+    if (runtime_dir && *runtime_dir && stat(runtime_dir, &info) == 0 && S_ISDIR(info.st_mode) &&
+        info.st_uid == geteuid() && (info.st_mode & 0077) == 0) {
+        std::string path = std::string(runtime_dir) + "/whisper_service.sock";
+        if (path.size() < sizeof(sockaddr_un::sun_path)) {
+            return path;
+        }
+    }
+    // Relative, so a deep working directory cannot push the path past sun_path's 108 bytes;
+    // the app, its daemon and its workers all run from the same directory
+    static const char* const PRIVATE_DIR = "run";
+    if (mkdir(PRIVATE_DIR, 0700) != 0 && errno != EEXIST) {
+        return std::string(PRIVATE_DIR) + "/whisper_service.sock"; // bind reports the problem
+    }
+    if (lstat(PRIVATE_DIR, &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == geteuid() &&
+        (info.st_mode & 0077) != 0) {
+        chmod(PRIVATE_DIR, 0700);
+    }
+    return std::string(PRIVATE_DIR) + "/whisper_service.sock";
+}
+
+bool WhisperDaemonProtocol::writeAll(int fd, const void* data, size_t size) {
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+        // MSG_NOSIGNAL so a dead peer surfaces as EPIPE instead of killing the process
+        ssize_t written = send(fd, cursor, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        cursor += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool WhisperDaemonProtocol::readAll(int fd, void* data, size_t size) {
+    char* cursor = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = recv(fd, cursor, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (received == 0) {
+            return false; // Peer closed the connection
+        }
+        cursor += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool WhisperDaemonProtocol::sendWithDescriptor(int fd, const void* data, size_t size, int pass_fd) {
+    iovec io{const_cast<void*>(data), size};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    cmsghdr* rights = CMSG_FIRSTHDR(&message);
+    rights->cmsg_level = SOL_SOCKET;
+    rights->cmsg_type = SCM_RIGHTS;
+    rights->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(rights), &pass_fd, sizeof(int));
+
+    ssize_t written;
+    do {
+        written = sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (written < 0 && errno == EINTR);
+    if (written < 0) {
+        return false;
+    }
+    // The descriptor went with the first byte; the rest is plain data
+    return writeAll(fd, static_cast<const char*>(data) + written, size - static_cast<size_t>(written));
+}
+
+bool WhisperDaemonProtocol::receiveWithDescriptor(int fd, void* data, size_t size, int& received_fd) {
+    iovec io{data, size};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+    msghdr message{};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        return false;
+    }
+
+    for (cmsghdr* rights = CMSG_FIRSTHDR(&message); rights; rights = CMSG_NXTHDR(&message, rights)) {
+        if (rights->cmsg_level == SOL_SOCKET && rights->cmsg_type == SCM_RIGHTS &&
+            rights->cmsg_len == CMSG_LEN(sizeof(int))) {
+            std::memcpy(&received_fd, CMSG_DATA(rights), sizeof(int));
+        }
+    }
+    if (!readAll(fd, static_cast<char*>(data) + received, size - static_cast<size_t>(received))) {
+        if (received_fd >= 0) {
+            close(received_fd);
+            received_fd = -1;
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "TranscriptSegment.h"
+
+using json = nlohmann::json;
+
+/**
+ * @brief WhisperDaemonProtocol - Framing shared by whisper_service and its clients
+ *
+ * Every message on the daemon socket is one frame:
+ *   [uint32 header_length][uint32 payload_length][header JSON][payload bytes]
+ * Lengths are in network byte order. The header carries the request/response
+ * fields, the optional payload carries raw binary data (e.g. PCM samples).
+ * A frame may also carry one file descriptor (SCM_RIGHTS on the length prefix),
+ * used to hand over audio in a memfd instead of copying it through the socket.
+ *
+ * A transcribe request with "stream": true is answered with event frames while
+ * whisper decodes, {"event": "segment", "segment": {...}} and {"event": "progress",
+ * "progress": percent}, followed by the usual response frame. The one-shot CLI
+ * (--stream) prints the same events as newline-delimited JSON ahead of its result.
+ */
+class WhisperDaemonProtocol {
+public:
+    static constexpr uint32_t MAX_HEADER_SIZE = 1024 * 1024;        // 1MB of JSON
+    static constexpr uint32_t MAX_PAYLOAD_SIZE = 256 * 1024 * 1024; // 256MB of audio
+
+    /**
+     * @brief Write one frame to a socket, retrying on partial writes
+     * @param fd Connected socket
+     * @param header JSON header of the frame
+     * @param payload Optional binary payload (may be nullptr when size is 0)
+     * @param payload_size Size of the payload in bytes
+     * @param pass_fd Descriptor to send along with the frame, -1 for none
+     * @return true if the whole frame was written
+     */
+    static bool writeFrame(int fd, const json& header, const void* payload = nullptr, size_t payload_size = 0,
+                           int pass_fd = -1);
+
+    /**
+     * @brief Read one frame from a socket
+     * @param fd Connected socket
+     * @param header Parsed JSON header
+     * @param payload Binary payload (cleared when the frame has none)
+     * @param received_fd Set to a descriptor sent with the frame (close-on-exec, owned by
+     *        the caller) or -1; when nullptr, descriptors are refused and closed by the kernel
+     * @return true if a complete, well formed frame was read
+     */
+    static bool readFrame(int fd, json& header, std::vector<char>& payload, int* received_fd = nullptr);
+
+    /**
+     * @brief Read frames up to the response, handing the event frames before it to a listener
+     * @param listener Receives segment and progress events; may be nullptr to skip them
+     * @return Same as readFrame() for the response frame
+     */
+    static bool readResponse(int fd, json& response, std::vector<char>& payload, const TranscriptListener* listener);
+
+    /**
+     * @brief Event messages, with the segment fields of a transcribe response
+     */
+    static json segmentEvent(const TranscriptSegment& segment, size_t id);
+    static json progressEvent(int percent);
+
+    /**
+     * @brief Pass an event message to the listener
+     * @return false if the message is not an event (i.e. it is the response)
+     */
+    static bool dispatchEvent(const json& message, const TranscriptListener* listener);
+
+    /**
+     * @brief Default socket path used by the app and the daemon
+     *
+     * In $XDG_RUNTIME_DIR when it is a private directory of this user, else in run/ under
+     * the working directory, created 0700.
+     */
+    static std::string defaultSocketPath();
+
+private:
+    static bool writeAll(int fd, const void* data, size_t size);
+    static bool readAll(int fd, void* data, size_t size);
+    static bool sendWithDescriptor(int fd, const void* data, size_t size, int pass_fd);
+    static bool receiveWithDescriptor(int fd, void* data, size_t size, int& received_fd);
+};
@@ -0,0 +1,103 @@
+#include "WhisperModelFile.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// "ggml" as whisper.cpp writes it (GGML_FILE_MAGIC, little endian)
+static constexpr uint32_t GGML_FILE_MAGIC = 0x67676d6c;
+
+WhisperModelFile::WhisperModelFile()
+    : data_(nullptr)
+    , size_(0)
+{
+}
+
+WhisperModelFile::~WhisperModelFile() {
+    close();
+}
+
+bool WhisperModelFile::open(const std::string& path) {
+    close();
+    path_ = path;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        last_error_ = "Model file not found: " + path;
+        return false;
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(uint32_t))) {
+        ::close(fd);
+        last_error_ = "Model file is empty: " + path;
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file open
+    if (mapping == MAP_FAILED) {
+        last_error_ = "Failed to map model file: " + path + " (" + std::strerror(errno) + ")";
+        return false;
+    }
+    data_ = static_cast<const uint8_t*>(mapping);
+    size_ = static_cast<size_t>(info.st_size);
+
+    uint32_t magic = 0;
+    std::memcpy(&magic, data_, sizeof(magic));
+    if (magic != GGML_FILE_MAGIC) {
+        close();
+        last_error_ = "Not a ggml whisper model: " + path;
+        return false;
+    }
+
+    // whisper reads the file front to back exactly once
+    madvise(const_cast<uint8_t*>(data_), size_, MADV_SEQUENTIAL);
+    return true;
+}
+
+void WhisperModelFile::close() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+void WhisperModelFile::prefetch() const {
+    if (data_) {
+        madvise(const_cast<uint8_t*>(data_), size_, MADV_WILLNEED);
+    }
+}
+
+size_t WhisperModelFile::residentBytes() const {
+    if (!data_) {
+        return 0;
+    }
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    std::vector<unsigned char> pages((size_ + page - 1) / page);
+    if (mincore(const_cast<uint8_t*>(data_), size_, pages.data()) != 0) {
+        return 0;
+    }
+    size_t resident = 0;
+    for (unsigned char flags : pages) {
+        resident += (flags & 1) ? page : 0;
+    }
+    return std::min(resident, size_);
+}
+
+size_t WhisperModelFile::processRssKb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            return std::strtoul(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief WhisperModelFile - Read-only shared mapping of a ggml model file
+ *
+ * The mapping is MAP_SHARED and PROT_READ, so every process that maps the same
+ * model reads the same page-cache pages instead of pulling the file through its own
+ * stdio buffers. open() checks the ggml magic so a truncated download or a wrong
+ * path is reported before whisper tries to parse it.
+ */
+class WhisperModelFile {
+public:
+    static constexpr const char* DEFAULT_PATH = "/apps/cv/models/ggml-base.en.bin";
+
+    WhisperModelFile();
+    ~WhisperModelFile();
+
+    WhisperModelFile(const WhisperModelFile&) = delete;
+    WhisperModelFile& operator=(const WhisperModelFile&) = delete;
+
+    /**
+     * @brief Map the file and check that it is a ggml model
+     * @return false with getLastError() set if it cannot be used
+     */
+    bool open(const std::string& path);
+    void close();
+
+    /**
+     * @brief Start reading the whole file into the page cache in the background
+     */
+    void prefetch() const;
+
+    /**
+     * @brief Bytes of the file currently in the page cache (mincore)
+     */
+    size_t residentBytes() const;
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+    const std::string& path() const { return path_; }
+    const std::string& getLastError() const { return last_error_; }
+
+    /**
+     * @brief Resident set size of the calling process in KiB (VmRSS), 0 if unknown
+     */
+    static size_t processRssKb();
+
+private:
+    std::string path_;
+    const uint8_t* data_;
+    size_t size_;
+    std::string last_error_;
+};
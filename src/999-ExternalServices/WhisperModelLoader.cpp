@@ -0,0 +1,43 @@
+#include "WhisperModelLoader.h"
+#include "WhisperModelFile.h"
+#include "whisper.h"
+#include <algorithm>
+#include <cstring>
+
+// Read position in the mapping, the loader's context
+struct MappedReader {
+    const uint8_t* data;
+    size_t size;
+    size_t offset;
+};
+
+static size_t readMapped(void* context, void* output, size_t read_size) {
+    auto* reader = static_cast<MappedReader*>(context);
+    size_t count = std::min(read_size, reader->size - reader->offset);
+    std::memcpy(output, reader->data + reader->offset, count);
+    reader->offset += count;
+    return count;
+}
+
+static bool mappedEof(void* context) {
+    auto* reader = static_cast<MappedReader*>(context);
+    return reader->offset >= reader->size;
+}
+
+static void closeMapped(void*) {
+    // The mapping belongs to the WhisperModelFile
+}
+
+whisper_context* WhisperModelLoader::load(const WhisperModelFile& file, const whisper_context_params& params, bool with_state) {
+    if (!file.data()) {
+        return nullptr;
+    }
+    MappedReader reader{file.data(), file.size(), 0};
+    whisper_model_loader loader{};
+    loader.context = &reader;
+    loader.read = readMapped;
+    loader.eof = mappedEof;
+    loader.close = closeMapped;
+    return with_state ? whisper_init_with_params(&loader, params)
+                      : whisper_init_with_params_no_state(&loader, params);
+}
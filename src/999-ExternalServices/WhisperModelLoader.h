@@ -0,0 +1,23 @@
+#pragma once
+
+struct whisper_context;
+struct whisper_context_params;
+class WhisperModelFile;
+
+/**
+ * @brief WhisperModelLoader - Builds a whisper_context from a WhisperModelFile mapping
+ *
+ * whisper.cpp's file loader reads the model through an ifstream; this one hands it
+ * the mapped bytes instead, so the read comes straight out of the shared page cache
+ * (warm after the server's startup prefetch) without a second buffered copy. The
+ * weights are still copied into whisper's own tensor buffers: whisper.cpp 1.5 has no
+ * way to point them at the mapping.
+ */
+class WhisperModelLoader {
+public:
+    /**
+     * @param with_state false for whisper_init_*_no_state (states created per worker)
+     * @return nullptr if whisper rejects the model
+     */
+    static whisper_context* load(const WhisperModelFile& file, const whisper_context_params& params, bool with_state);
+};
@@ -0,0 +1,524 @@
+#include "WhisperWorkerPool.h"
+#include "WhisperDaemonProtocol.h"
+#include "CancellationToken.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+// How often the supervisor wakes up when nothing signals it
+static constexpr int SUPERVISOR_TICK_MS = 100;
+// /proc/<pid>/smaps_rollup walks every mapping, no need to read it on every tick
+static constexpr int RSS_SAMPLE_INTERVAL_MS = 1000;
+
+WhisperWorkerPool& WhisperWorkerPool::getInstance() {
+    static WhisperWorkerPool instance;
+    return instance;
+}
+
+WhisperWorkerPool::WhisperWorkerPool()
+    : running_(false)
+    , next_job_serial_(0)
+    , fresh_worker_rss_kb_(0)
+{
+}
+
+WhisperWorkerPool::~WhisperWorkerPool() {
+    stop();
+}
+
+bool WhisperWorkerPool::start(const std::string& whisper_executable_path, const std::string& model_path,
+                              const WhisperWorkerPoolOptions& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return false;
+    }
+    if (access(whisper_executable_path.c_str(), X_OK) != 0) {
+        std::cerr << "WhisperWorkerPool: whisper_service executable not found: " << whisper_executable_path << std::endl;
+        return false;
+    }
+
+    whisper_executable_path_ = whisper_executable_path;
+    model_path_ = model_path;
+    options_ = options;
+    options_.workers = std::max<size_t>(1, options.workers);
+    workers_.assign(options_.workers, Worker());
+    for (Worker& worker : workers_) {
+        worker.restart_at = Clock::now();
+    }
+    stats_ = WhisperWorkerPoolStats();
+    fresh_worker_rss_kb_ = 0;
+    running_ = true;
+
+    std::cout << "WhisperWorkerPool: starting " << options_.workers << " worker(s) for " << model_path_;
+    if (options_.max_total_rss_mb > 0) {
+        std::cout << ", RSS cap " << options_.max_total_rss_mb << " MiB";
+    }
+    std::cout << std::endl;
+
+    // Workers die with the thread that forked them (PR_SET_PDEATHSIG), so only this one forks
+    supervisor_ = std::thread(&WhisperWorkerPool::supervisorLoop, this);
+    return true;
+}
+
+void WhisperWorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    supervisor_cv_.notify_all();
+    idle_cv_.notify_all();
+    if (supervisor_.joinable()) {
+        supervisor_.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Worker& worker : workers_) {
+        if (worker.state == WorkerState::Busy) {
+            // The request thread owns the descriptor; it sees the hangup and retires the worker. The
+            // supervisor is gone by then, so the pid is reaped here and retireLocked() leaves it alone.
+            if (worker.pid > 0 && !worker.reaped) {
+                kill(worker.pid, SIGKILL);
+                waitpid(worker.pid, nullptr, 0);
+                worker.reaped = true;
+            }
+            continue;
+        }
+        if (worker.state != WorkerState::Stopped) {
+            retireLocked(worker, false, "stopped");
+        }
+    }
+    for (pid_t pid : exited_) {
+        waitpid(pid, nullptr, 0);
+    }
+    exited_.clear();
+}
+
+bool WhisperWorkerPool::isRunning() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return running_;
+}
+
+bool WhisperWorkerPool::waitUntilReady(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto any_idle = [this]() {
+        return std::any_of(workers_.begin(), workers_.end(),
+                           [](const Worker& worker) { return worker.state == WorkerState::Idle; });
+    };
+    idle_cv_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this, &any_idle]() {
+        return !running_ || any_idle();
+    });
+    return running_ && any_idle();
+}
+
+bool WhisperWorkerPool::request(const json& request, json& response, std::string& error,
+                                const void* payload, size_t payload_size,
+                                CancellationToken* cancel_token, int pass_fd,
+                                const TranscriptListener* listener) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // TranscriptionScheduler runs as many jobs as there are workers, so this wait is normally short
+    size_t index = workers_.size();
+    while (true) {
+        if (!running_) {
+            error = "Whisper worker pool is not running";
+            return false;
+        }
+        if (cancel_token && cancel_token->isCancelled()) {
+            error = "Cancelled";
+            return false;
+        }
+        bool any_alive = false;
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            if (workers_[i].state == WorkerState::Idle) {
+                index = i;
+                break;
+            }
+            any_alive = any_alive || workers_[i].state != WorkerState::Stopped;
+        }
+        if (index < workers_.size()) {
+            break;
+        }
+        if (!any_alive) {
+            error = "No whisper worker available (all stopped or restarting)";
+            return false;
+        }
+        idle_cv_.wait_for(lock, std::chrono::milliseconds(SUPERVISOR_TICK_MS));
+    }
+
+    Worker& worker = workers_[index];
+    worker.state = WorkerState::Busy;
+    const uint64_t serial = ++next_job_serial_;
+    worker.job_serial = serial;
+    const int fd = worker.fd;
+    lock.unlock();
+
+    // A worker cannot be told to stop mid-inference without a second channel; replacing it is cheap
+    uint64_t cancel_handler = 0;
+    if (cancel_token) {
+        cancel_handler = cancel_token->onCancel([this, index, serial]() {
+            std::lock_guard<std::mutex> guard(mutex_);
+            Worker& target = workers_[index];
+            if (target.state == WorkerState::Busy && target.job_serial == serial && target.pid > 0 &&
+                !target.reaped) {
+                kill(target.pid, SIGKILL);
+                ++stats_.cancel_kills;
+            }
+        });
+    }
+
+    std::vector<char> response_payload;
+    bool received = false;
+    bool timed_out = false;
+    if (WhisperDaemonProtocol::writeFrame(fd, request, payload, payload_size, pass_fd)) {
+        errno = 0;
+        received = WhisperDaemonProtocol::readResponse(fd, response, response_payload, listener);
+        timed_out = !received && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    if (cancel_token) {
+        cancel_token->removeHandler(cancel_handler);
+    }
+
+    lock.lock();
+    if (received) {
+        worker.state = WorkerState::Idle;
+        worker.consecutive_failures = 0;
+        worker.last_heartbeat = Clock::now();   // An answer is as good as a pong
+        ++stats_.jobs_completed;
+        lock.unlock();
+        idle_cv_.notify_all();
+        return true;
+    }
+
+    ++stats_.jobs_failed;
+    if (cancel_token && cancel_token->isCancelled()) {
+        error = "Cancelled";
+        retireLocked(worker, false, "killed to cancel its request");
+    } else if (timed_out) {
+        error = "Timed out waiting for whisper worker";
+        retireLocked(worker, true, "timed out");
+    } else {
+        error = "Whisper worker exited during the request";
+        ++stats_.crashes;
+        retireLocked(worker, true, "exited during a request");
+    }
+    lock.unlock();
+    supervisor_cv_.notify_all();
+    return false;
+}
+
+WhisperWorkerPoolStats WhisperWorkerPool::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WhisperWorkerPoolStats stats = stats_;
+    stats.running = running_;
+    stats.workers = workers_.size();
+    stats.max_total_rss_kb = static_cast<uint64_t>(options_.max_total_rss_mb) * 1024;
+    bool may_start = mayStartLocked();
+    Clock::time_point now = Clock::now();
+    for (const Worker& worker : workers_) {
+        switch (worker.state) {
+            case WorkerState::Idle: ++stats.idle; break;
+            case WorkerState::Busy: ++stats.busy; break;
+            case WorkerState::Starting: ++stats.starting; break;
+            case WorkerState::Stopped:
+                ++stats.stopped;
+                if (running_ && !may_start && worker.restart_at <= now) {
+                    ++stats.rss_held_back;
+                }
+                break;
+        }
+        stats.total_rss_kb += worker.rss_kb;
+    }
+    return stats;
+}
+
+void WhisperWorkerPool::supervisorLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Clock::time_point next_rss_sample = Clock::now();
+
+    while (running_) {
+        reapLocked();
+
+        Clock::time_point now = Clock::now();
+        for (size_t i = 0; i < workers_.size() && running_; ++i) {
+            Worker& worker = workers_[i];
+            switch (worker.state) {
+                case WorkerState::Stopped:
+                    if (now >= worker.restart_at && mayStartLocked()) {
+                        spawnLocked(worker);
+                    }
+                    break;
+                case WorkerState::Starting:
+                    checkStartupLocked(worker);
+                    break;
+                case WorkerState::Idle:
+                    if (now - worker.last_heartbeat >= std::chrono::milliseconds(options_.heartbeat_interval_ms)) {
+                        heartbeat(i, lock);
+                    }
+                    break;
+                case WorkerState::Busy:
+                    break; // Its request thread watches it
+            }
+        }
+
+        if (Clock::now() >= next_rss_sample) {
+            for (Worker& worker : workers_) {
+                if (worker.pid > 0 && !worker.reaped && worker.state != WorkerState::Starting) {
+                    worker.rss_kb = readPssKb(worker.pid);
+                }
+            }
+            enforceRssLimitLocked();
+            next_rss_sample = Clock::now() + std::chrono::milliseconds(RSS_SAMPLE_INTERVAL_MS);
+        }
+
+        supervisor_cv_.wait_for(lock, std::chrono::milliseconds(SUPERVISOR_TICK_MS));
+    }
+}
+
+void WhisperWorkerPool::spawnLocked(Worker& worker) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sockets) != 0) {
+        std::cerr << "WhisperWorkerPool: socketpair failed: " << std::strerror(errno) << std::endl;
+        ++worker.consecutive_failures;
+        worker.restart_at = Clock::now() + std::chrono::milliseconds(options_.restart_backoff_max_ms);
+        return;
+    }
+
+    // Everything the child touches is prepared before fork
+    std::vector<std::string> arguments = {whisper_executable_path_, "--worker", model_path_};
+    std::vector<char*> argv;
+    for (auto& argument : arguments) {
+        argv.push_back(argument.data());
+    }
+    argv.push_back(nullptr);
+    const pid_t parent = getpid();
+
+    pid_t child = fork();
+    if (child < 0) {
+        std::cerr << "WhisperWorkerPool: fork failed: " << std::strerror(errno) << std::endl;
+        close(sockets[0]);
+        close(sockets[1]);
+        ++worker.consecutive_failures;
+        worker.restart_at = Clock::now() + std::chrono::milliseconds(options_.restart_backoff_max_ms);
+        return;
+    }
+    if (child == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (getppid() != parent) {
+            _exit(1); // The server went away between fork and prctl
+        }
+        dup2(sockets[1], STDIN_FILENO);
+        int null_fd = open("/dev/null", O_WRONLY);
+        if (null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+        }
+        execv(argv[0], argv.data());
+        _exit(127);
+    }
+    close(sockets[1]);
+
+    // Bounds a request on a worker that hangs mid-inference
+    timeval receive_timeout{options_.response_timeout_ms / 1000, (options_.response_timeout_ms % 1000) * 1000};
+    setsockopt(sockets[0], SOL_SOCKET, SO_RCVTIMEO, &receive_timeout, sizeof(receive_timeout));
+
+    worker.pid = child;
+    worker.fd = sockets[0];
+    worker.state = WorkerState::Starting;
+    worker.started_at = Clock::now();
+    worker.rss_kb = 0;
+    ++stats_.spawned;
+}
+
+void WhisperWorkerPool::checkStartupLocked(Worker& worker) {
+    pollfd hello_poll{worker.fd, POLLIN, 0};
+    if (poll(&hello_poll, 1, 0) <= 0) {
+        if (Clock::now() - worker.started_at > std::chrono::milliseconds(options_.startup_timeout_ms)) {
+            ++stats_.crashes;
+            retireLocked(worker, true, "did not finish loading the model in time");
+        }
+        return;
+    }
+
+    // The hello frame is small and already there (or the worker is gone and this fails at once)
+    json hello;
+    std::vector<char> payload;
+    if (!WhisperDaemonProtocol::readFrame(worker.fd, hello, payload) || !hello.value("success", false)) {
+        ++stats_.crashes;
+        retireLocked(worker, true, "failed to start: " + hello.value("error", std::string("no hello frame")));
+        return;
+    }
+
+    auto load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - worker.started_at).count();
+    worker.state = WorkerState::Idle;
+    worker.last_heartbeat = Clock::now();
+    worker.rss_kb = readPssKb(worker.pid);
+    fresh_worker_rss_kb_ = std::max(fresh_worker_rss_kb_, worker.rss_kb);
+    std::cout << "WhisperWorkerPool: worker " << worker.pid << " ready in " << load_ms << " ms ("
+              << worker.rss_kb / 1024 << " MiB)" << std::endl;
+    idle_cv_.notify_all();
+}
+
+void WhisperWorkerPool::heartbeat(size_t index, std::unique_lock<std::mutex>& lock) {
+    Worker& worker = workers_[index];
+    worker.state = WorkerState::Busy;
+    worker.job_serial = ++next_job_serial_;
+    const int fd = worker.fd;
+    lock.unlock();
+
+    json response;
+    std::vector<char> payload;
+    pollfd pong_poll{fd, POLLIN, 0};
+    bool alive = WhisperDaemonProtocol::writeFrame(fd, json{{"op", "ping"}}) &&
+                 poll(&pong_poll, 1, options_.heartbeat_timeout_ms) > 0 &&
+                 WhisperDaemonProtocol::readFrame(fd, response, payload) &&
+                 response.value("pong", false);
+
+    lock.lock();
+    if (alive) {
+        worker.state = WorkerState::Idle;
+        worker.last_heartbeat = Clock::now();
+        idle_cv_.notify_all();
+        return;
+    }
+    ++stats_.heartbeat_failures;
+    retireLocked(worker, true, "missed its heartbeat");
+}
+
+void WhisperWorkerPool::enforceRssLimitLocked() {
+    if (options_.max_total_rss_mb == 0) {
+        return;
+    }
+    const uint64_t cap_kb = static_cast<uint64_t>(options_.max_total_rss_mb) * 1024;
+    uint64_t total_kb = 0;
+    size_t alive = 0;
+    for (const Worker& worker : workers_) {
+        total_kb += worker.rss_kb;
+        alive += worker.state != WorkerState::Stopped;
+    }
+    // Recycling the last worker would only reload the same model; keep at least one
+    if (total_kb <= cap_kb || alive <= 1) {
+        return;
+    }
+
+    // The largest idle worker has most likely grown (long clips leave big buffers behind)
+    Worker* largest = nullptr;
+    for (Worker& worker : workers_) {
+        if (worker.state == WorkerState::Idle && (!largest || worker.rss_kb > largest->rss_kb)) {
+            largest = &worker;
+        }
+    }
+    if (largest) {
+        ++stats_.rss_recycles;
+        retireLocked(*largest, false, "recycled, pool at " + std::to_string(total_kb / 1024) + " MiB of " +
+                                      std::to_string(options_.max_total_rss_mb) + " MiB");
+    }
+}
+
+void WhisperWorkerPool::reapLocked() {
+    exited_.erase(std::remove_if(exited_.begin(), exited_.end(), [](pid_t pid) {
+        return waitpid(pid, nullptr, WNOHANG) != 0;     // Reaped, or not our child any more
+    }), exited_.end());
+
+    for (Worker& worker : workers_) {
+        if (worker.pid <= 0 || worker.reaped) {
+            continue;
+        }
+        int status = 0;
+        if (waitpid(worker.pid, &status, WNOHANG) != worker.pid) {
+            continue;
+        }
+        std::string how = WIFSIGNALED(status) ? "killed by signal " + std::to_string(WTERMSIG(status))
+                                              : "exited with status " + std::to_string(WEXITSTATUS(status));
+        worker.reaped = true;
+        if (worker.state == WorkerState::Busy) {
+            continue;    // The request or heartbeat using it sees the hangup and retires it
+        }
+        ++stats_.crashes;
+        retireLocked(worker, true, how);
+    }
+}
+
+bool WhisperWorkerPool::mayStartLocked() const {
+    if (options_.max_total_rss_mb == 0) {
+        return true;
+    }
+    uint64_t total_kb = 0;
+    uint64_t alive_rss_kb = 0;
+    size_t alive = 0;
+    for (const Worker& worker : workers_) {
+        total_kb += worker.rss_kb;
+        if (worker.state != WorkerState::Stopped) {
+            ++alive;
+            alive_rss_kb += worker.rss_kb;
+        }
+    }
+    if (alive == 0) {
+        return true; // Always keep one worker, whatever the cap says
+    }
+    uint64_t estimate_kb = fresh_worker_rss_kb_ ? fresh_worker_rss_kb_ : alive_rss_kb / alive;
+    return total_kb + estimate_kb <= static_cast<uint64_t>(options_.max_total_rss_mb) * 1024;
+}
+
+void WhisperWorkerPool::retireLocked(Worker& worker, bool failure, const std::string& reason) {
+    std::cout << "WhisperWorkerPool: worker " << worker.pid << " " << reason;
+    if (worker.pid > 0 && !worker.reaped) {
+        kill(worker.pid, SIGKILL);
+        exited_.push_back(worker.pid);
+    }
+    if (worker.fd >= 0) {
+        close(worker.fd);
+    }
+    worker.state = WorkerState::Stopped;
+    worker.pid = -1;
+    worker.reaped = false;
+    worker.fd = -1;
+    worker.rss_kb = 0;
+
+    Clock::time_point now = Clock::now();
+    if (failure) {
+        // 0.5s, 1s, 2s, ... up to the maximum; reset once a worker serves a request
+        int shift = std::min(worker.consecutive_failures, 20);
+        int64_t delay_ms = std::min<int64_t>(static_cast<int64_t>(options_.restart_backoff_initial_ms) << shift,
+                                             options_.restart_backoff_max_ms);
+        ++worker.consecutive_failures;
+        worker.restart_at = now + std::chrono::milliseconds(delay_ms);
+        std::cout << ", restarting in " << delay_ms << " ms";
+    } else {
+        worker.restart_at = now;
+    }
+    std::cout << std::endl;
+}
+
+uint64_t WhisperWorkerPool::readPssKb(pid_t pid) {
+    // Pss splits pages shared between workers (page cache of the model, libraries) among them,
+    // so the sum over the pool is what the pool really costs
+    std::ifstream rollup("/proc/" + std::to_string(pid) + "/smaps_rollup");
+    std::string line;
+    while (std::getline(rollup, line)) {
+        if (line.compare(0, 4, "Pss:") == 0) {
+            return std::strtoull(line.c_str() + 4, nullptr, 10);
+        }
+    }
+    std::ifstream status("/proc/" + std::to_string(pid) + "/status");
+    while (std::getline(status, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) {
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+        }
+    }
+    return 0;
+}
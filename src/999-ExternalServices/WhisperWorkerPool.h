@@ -0,0 +1,165 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+class CancellationToken;
+struct TranscriptListener;
+
+/**
+ * @brief Limits and timings of WhisperWorkerPool
+ */
+struct WhisperWorkerPoolOptions {
+    size_t workers = 2;
+    size_t max_total_rss_mb = 0;            // 0 = no cap
+    int heartbeat_interval_ms = 5000;       // Idle workers are pinged this often
+    int heartbeat_timeout_ms = 2000;
+    int startup_timeout_ms = 30000;         // Model load on a cold page cache
+    int response_timeout_ms = 60000;        // Same budget the CLI path gets from `timeout 60s`
+    int restart_backoff_initial_ms = 500;
+    int restart_backoff_max_ms = 60000;
+};
+
+/**
+ * @brief Counters reported by WhisperWorkerPool::getStats()
+ */
+struct WhisperWorkerPoolStats {
+    bool running = false;
+    size_t workers = 0;             // Configured slots
+    size_t idle = 0;
+    size_t busy = 0;
+    size_t starting = 0;
+    size_t stopped = 0;             // Crashed or recycled, waiting for their restart
+    size_t rss_held_back = 0;       // Stopped slots not restarted because of max_total_rss_mb
+    uint64_t total_rss_kb = 0;      // Proportional set size of all workers
+    uint64_t max_total_rss_kb = 0;
+    uint64_t jobs_completed = 0;
+    uint64_t jobs_failed = 0;
+    uint64_t spawned = 0;
+    uint64_t crashes = 0;           // Exits, broken pipes and start-up failures
+    uint64_t heartbeat_failures = 0;
+    uint64_t rss_recycles = 0;
+    uint64_t cancel_kills = 0;
+};
+
+/**
+ * @brief WhisperWorkerPool - Supervised pool of persistent `whisper_service --worker` processes
+ *
+ * The single daemon runs one inference at a time, so on a large machine every clip but
+ * one waits while most cores idle. The pool pre-forks a fixed number of workers, each
+ * with the model loaded, and hands every request to an idle one. Each worker talks to
+ * the supervisor over its own socketpair on its stdin (a pipe in both directions that
+ * can also carry the audio memfd), with the same framing as the daemon socket.
+ *
+ * A supervisor thread
+ *  - starts workers and waits for their hello frame,
+ *  - pings idle workers every heartbeat_interval_ms and replaces any that do not answer,
+ *  - restarts crashed workers after an exponential backoff (reset once a worker served a job),
+ *  - sums the workers' proportional RSS; above max_total_rss_mb the largest idle worker is
+ *    recycled and stopped slots stay down until a fresh worker fits again, so the pool
+ *    shrinks to what the machine can hold rather than swapping.
+ *
+ * Workers are started from the supervisor thread with PR_SET_PDEATHSIG, so they do not
+ * outlive the server. A cancelled request kills its worker, which is replaced right away.
+ */
+class WhisperWorkerPool {
+public:
+    static WhisperWorkerPool& getInstance();
+
+    WhisperWorkerPool(const WhisperWorkerPool&) = delete;
+    WhisperWorkerPool& operator=(const WhisperWorkerPool&) = delete;
+
+    /**
+     * @brief Start the supervisor and the workers; returns without waiting for the models to load
+     * @return false if the executable is missing or the pool is already running
+     */
+    bool start(const std::string& whisper_executable_path, const std::string& model_path,
+               const WhisperWorkerPoolOptions& options);
+
+    /**
+     * @brief Stop the supervisor and terminate all workers
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief Block until at least one worker is idle
+     * @return false on timeout or if the pool is not running
+     */
+    bool waitUntilReady(int timeout_ms);
+
+    /**
+     * @brief Run one request on an idle worker; same contract as WhisperDaemonClient::request
+     * @return false if no worker is available (all stopped or backing off), the worker
+     *         died or timed out, or the request was cancelled
+     */
+    bool request(const json& request, json& response, std::string& error,
+                 const void* payload = nullptr, size_t payload_size = 0,
+                 CancellationToken* cancel_token = nullptr, int pass_fd = -1,
+                 const TranscriptListener* listener = nullptr);
+
+    WhisperWorkerPoolStats getStats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    enum class WorkerState { Stopped, Starting, Idle, Busy };
+
+    struct Worker {
+        WorkerState state = WorkerState::Stopped;
+        pid_t pid = -1;
+        bool reaped = false;            // pid already waited for: never signal it again
+        int fd = -1;
+        Clock::time_point started_at;
+        Clock::time_point last_heartbeat;
+        Clock::time_point restart_at;
+        int consecutive_failures = 0;
+        uint64_t rss_kb = 0;
+        uint64_t job_serial = 0;        // Identifies the request holding a Busy worker
+    };
+
+    WhisperWorkerPool();
+    ~WhisperWorkerPool();
+
+    void supervisorLoop();
+    void spawnLocked(Worker& worker);
+    void checkStartupLocked(Worker& worker);
+    void heartbeat(size_t index, std::unique_lock<std::mutex>& lock);
+    void enforceRssLimitLocked();
+    void reapLocked();
+    bool mayStartLocked() const;
+
+    /**
+     * @brief Kill and close a worker, schedule its restart
+     * @param failure Counts toward the exponential backoff (a crash, not a recycle or cancel)
+     */
+    void retireLocked(Worker& worker, bool failure, const std::string& reason);
+
+    static uint64_t readPssKb(pid_t pid);
+
+    mutable std::mutex mutex_;
+    std::condition_variable idle_cv_;
+    std::condition_variable supervisor_cv_;
+    std::thread supervisor_;
+    bool running_;
+
+    std::string whisper_executable_path_;
+    std::string model_path_;
+    WhisperWorkerPoolOptions options_;
+    std::vector<Worker> workers_;
+    std::vector<pid_t> exited_;         // Killed workers not reaped yet
+    uint64_t next_job_serial_;
+    uint64_t fresh_worker_rss_kb_;      // RSS of a worker right after start-up, learned
+
+    WhisperWorkerPoolStats stats_;
+};
@@ -7,20 +7,154 @@
 #include <vector>
 #include <chrono>
 #include <sstream>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <unordered_set>
+#include <list>
+#include <optional>
+#include <cctype>
+#include <cstdlib>
+#include <csignal>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include "whisper.h"
+#include "WhisperDaemonProtocol.h"
+#include "ClipBatcher.h"
+#include "DecodeProfile.h"
+#include "WhisperModelFile.h"
+#include "WhisperModelLoader.h"
+#include "Audio/VoiceActivityDetector.h"
+#include "Audio/PcmDecoder.h"
+#include "Audio/WavReader.h"
+#include "Audio/Resampler.h"
+#include "Audio/RiceCodec.h"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
 
+// Per-request options, set from CLI flags or daemon request fields
+struct TranscribeOptions {
+    bool vad = false;           // Trim silence before inference ("vad": true / --vad)
+    int sample_rate = 16000;    // Rate of inline PCM payloads ("sample_rate"); files carry their own
+    int threads = 0;            // whisper_full n_threads granted by the caller ("threads"); 0 = --threads default
+    std::function<bool()> should_abort;  // Polled during inference; true stops whisper_full early
+    TranscriptListener listener;         // Segments and progress while decoding ("stream": true / --stream)
+    size_t window_start = 0;    // Only samples [window_start, window_end) of the 16kHz audio ("window": [start, end])
+    size_t window_end = 0;      // 0 = to the end
+    whisper_state* state = nullptr;  // Decode on this state instead of the context's own (--batch jobs)
+    
+    static TranscribeOptions fromRequest(const json& request) {
+        TranscribeOptions options;
+        options.vad = request.value("vad", false);
+        options.sample_rate = request.value("sample_rate", 16000);
+        options.threads = request.value("threads", 0);
+        const json& window = request.contains("window") ? request["window"] : json();
+        if (window.is_array() && window.size() == 2 && window[0].is_number_unsigned() && window[1].is_number_unsigned()) {
+            options.window_start = window[0].get<size_t>();
+            options.window_end = window[1].get<size_t>();
+        }
+        return options;
+    }
+};
+
+// Polling the client socket on every ggml graph node would cost more than it saves
+static constexpr int ABORT_POLL_INTERVAL_MS = 50;
+
+struct AbortCheck {
+    const std::function<bool()>* should_abort;
+    std::chrono::steady_clock::time_point next_poll;
+    bool aborted = false;
+    
+    bool poll() {
+        if (aborted) {
+            return true;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_poll) {
+            return false;
+        }
+        next_poll = now + std::chrono::milliseconds(ABORT_POLL_INTERVAL_MS);
+        aborted = (*should_abort)();
+        return aborted;
+    }
+};
+
+// whisper's abort_callback: true stops the running graph computation
+static bool abortCallback(void* user_data) {
+    return static_cast<AbortCheck*>(user_data)->poll();
+}
+
+// whisper's encoder_begin_callback: false skips the next encoder pass
+static bool encoderBeginCallback(whisper_context*, whisper_state*, void* user_data) {
+    return !static_cast<AbortCheck*>(user_data)->poll();
+}
+
+// whisper's new_segment_callback: the last n_new segments of the state were just finished
+static void newSegmentCallback(whisper_context*, whisper_state* state, int n_new, void* user_data) {
+    const TranscriptListener& listener = *static_cast<const TranscriptListener*>(user_data);
+    const int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = std::max(0, n_segments - n_new); i < n_segments; ++i) {
+        const char* text = whisper_full_get_segment_text_from_state(state, i);
+        if (!text) {
+            continue;
+        }
+        TranscriptSegment segment;
+        segment.text = text;
+        segment.start_seconds = whisper_full_get_segment_t0_from_state(state, i) * 0.01;
+        segment.end_seconds = whisper_full_get_segment_t1_from_state(state, i) * 0.01;
+        listener.on_segment(segment);
+    }
+}
+
+// whisper's progress_callback: percent of the audio decoded
+static void progressCallback(whisper_context*, whisper_state*, int progress, void* user_data) {
+    static_cast<const TranscriptListener*>(user_data)->on_progress(progress);
+}
+
 class WhisperService {
 private:
     whisper_context* context_;
     std::string model_path_;
     
+    // whisper_context holds a single decoding state, daemon connections take turns
+    std::mutex inference_mutex_;
+    
+    // Packs short clips from concurrent connections into one whisper_full (window 0 = off)
+    std::unique_ptr<ClipBatcher> batcher_;
+    
+    // whisper_full n_threads (--threads)
+    int threads_;
+    
 public:
-    WhisperService() : context_(nullptr) {}
+    WhisperService() : context_(nullptr), threads_(std::min(4, (int)std::thread::hardware_concurrency())) {
+        ClipBatcherOptions no_batching;
+        no_batching.window_ms = 0;
+        setBatching(no_batching);
+    }
+    
+    void setBatching(const ClipBatcherOptions& options) {
+        batcher_ = std::make_unique<ClipBatcher>(options,
+            [this](const std::vector<float>& audio, size_t clip_count, int threads,
+                   const std::function<bool()>& should_abort, const TranscriptListener& listener,
+                   std::vector<TranscriptSegment>& segments, std::string& error) {
+                return runInference(audio, clip_count, threads, should_abort, listener, segments, error);
+            });
+    }
+    
+    ClipBatcher& batcher() {
+        return *batcher_;
+    }
+    
+    void setThreads(int threads) {
+        threads_ = std::max(1, threads);
+    }
     
     ~WhisperService() {
         if (context_) {
@@ -32,8 +166,10 @@ public:
         model_path_ = model_path;
         init_info["model_path"] = model_path;
         
-        if (!std::filesystem::exists(model_path)) {
-            init_info["error"] = "Model file not found: " + model_path;
+        // Read-only shared mapping: the page cache copy is shared with every other process using the model
+        WhisperModelFile model_file;
+        if (!model_file.open(model_path)) {
+            init_info["error"] = model_file.getLastError();
             return false;
         }
         
@@ -44,28 +180,33 @@ public:
         // For now, we'll let whisper output go to stderr and document it in our JSON
         init_info["note"] = "Whisper library outputs initialization details to stderr";
         
-        context_ = whisper_init_from_file_with_params(model_path.c_str(), ctx_params);
+        auto load_start = std::chrono::high_resolution_clock::now();
+        context_ = WhisperModelLoader::load(model_file, ctx_params, true);
+        auto load_end = std::chrono::high_resolution_clock::now();
         
         if (!context_) {
             init_info["error"] = "Failed to load model from " + model_path;
             return false;
         }
         
+        init_info["load_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(load_end - load_start).count();
+        init_info["loader"] = "mmap";
+        init_info["model_bytes"] = model_file.size();
+        init_info["page_cache_bytes"] = model_file.residentBytes();
+        
+        // The weights now live in whisper's buffers; drop the mapping so it does not count towards RSS
+        model_file.close();
+        init_info["rss_kb"] = WhisperModelFile::processRssKb();
         init_info["success"] = true;
         init_info["model_loaded"] = true;
         return true;
     }
     
-    std::string transcribeFile(const std::string& audio_file_path) {
+    std::string transcribeFile(const std::string& audio_file_path, const TranscribeOptions& options = TranscribeOptions()) {
         auto start_time = std::chrono::high_resolution_clock::now();
         
-        json response;
-        response["success"] = false;
+        json response = createResponse();
         response["audio_file"] = audio_file_path;
-        response["model_path"] = model_path_;
-        response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-            std::chrono::system_clock::now().time_since_epoch()
-        ).count();
         
         if (!context_) {
             response["error"] = "Whisper not initialized";
@@ -80,7 +221,8 @@ public:
         // Load audio file
         json audio_info;
         std::vector<float> audio_data;
-        if (!loadAudioFile(audio_file_path, audio_data, audio_info)) {
+        size_t first_sample = 0;
+        if (!loadAudioFile(audio_file_path, options, audio_data, first_sample, audio_info)) {
             response["error"] = "Failed to load audio file: " + audio_file_path;
             response["audio_info"] = audio_info;
             return response.dump();
@@ -89,51 +231,183 @@ public:
         // Add audio info to response
         response["audio_info"] = audio_info;
         
-        // Prepare parameters
-        whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
-        params.print_realtime = false;
-        params.print_progress = false;
-        params.print_timestamps = false;
-        params.print_special = false;
-        params.translate = false;
-        params.language = "en";
-        params.n_threads = std::min(4, (int)std::thread::hardware_concurrency());
+        return transcribeSamples(audio_data, first_sample, response, start_time, options);
+    }
+    
+    // Transcribe a WAV passed as a descriptor (memfd from the server, already 16kHz float) without touching the disk
+    std::string transcribeDescriptor(int audio_fd, const TranscribeOptions& options = TranscribeOptions()) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        json response = createResponse();
+        response["audio_source"] = "descriptor";
+        
+        if (!context_) {
+            response["error"] = "Whisper not initialized";
+            return response.dump();
+        }
+        
+        json audio_info;
+        std::vector<float> audio_data;
+        size_t first_sample = 0;
+        WavReader reader;
+        if (!reader.openDescriptor(audio_fd) || !loadAudio(reader, options, audio_data, first_sample, audio_info)) {
+            response["error"] = "Failed to load audio from descriptor: " + reader.getLastError();
+            return response.dump();
+        }
+        response["audio_info"] = audio_info;
+        
+        return transcribeSamples(audio_data, first_sample, response, start_time, options);
+    }
+    
+    // Transcribe mono signed 16-bit PCM received inline (daemon payload), resampled to 16kHz if needed
+    std::string transcribePcm(const int16_t* samples, size_t sample_count, const TranscribeOptions& options = TranscribeOptions()) {
+        auto start_time = std::chrono::high_resolution_clock::now();
+        
+        json response = createResponse();
+        response["audio_source"] = "pcm";
+        
+        if (!context_) {
+            response["error"] = "Whisper not initialized";
+            return response.dump();
+        }
+        
+        if (sample_count == 0) {
+            response["error"] = "No audio data found";
+            return response.dump();
+        }
+        
+        std::vector<float> audio_data(sample_count);
+        PcmDecoder::int16ToMono(samples, sample_count, 1, audio_data.data());
+        
+        if (!Resampler::toWhisperRate(audio_data, options.sample_rate)) {
+            response["error"] = "Invalid sample rate: " + std::to_string(options.sample_rate);
+            return response.dump();
+        }
+        
+        response["audio_info"] = {
+            {"samples", audio_data.size()},
+            {"duration_seconds", audio_data.size() / 16000.0}
+        };
+        if (options.sample_rate != 16000) {
+            response["audio_info"]["resampled_from"] = options.sample_rate;
+        }
+        
+        return transcribeSamples(audio_data, 0, response, start_time, options);
+    }
+    
+    /**
+     * @brief Another decoding state on the loaded model, for TranscribeOptions::state
+     *
+     * Shares the weights; only the KV caches and compute buffers are allocated again.
+     * @return nullptr if not initialized or out of memory; release with whisper_free_state
+     */
+    whisper_state* createState() {
+        return context_ ? whisper_init_state(context_) : nullptr;
+    }
+    
+private:
+    json createResponse() const {
+        json response;
+        response["success"] = false;
+        response["model_path"] = model_path_;
+        response["timestamp"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+        return response;
+    }
+    
+    // recording: 16kHz samples starting at first_sample of the whole audio (see loadAudio)
+    std::string transcribeSamples(const std::vector<float>& recording, size_t first_sample, json& response,
+                                  std::chrono::high_resolution_clock::time_point start_time,
+                                  const TranscribeOptions& options) {
+        // A window of a longer recording (AudioChunker): segment times stay relative to the recording
+        std::vector<float> window_audio;
+        size_t window_start = 0;
+        bool windowed = options.window_start > 0 || options.window_end > 0;
+        if (windowed) {
+            window_start = std::min(options.window_start - std::min(options.window_start, first_sample), recording.size());
+            size_t window_end = options.window_end > 0
+                ? std::min(options.window_end - std::min(options.window_end, first_sample), recording.size())
+                : recording.size();
+            window_audio.assign(recording.begin() + window_start, recording.begin() + std::max(window_start, window_end));
+            response["window"] = {first_sample + window_start, first_sample + window_start + window_audio.size()};
+            if (window_audio.empty()) {
+                response["error"] = "Empty window";
+                return response.dump();
+            }
+        }
+        const std::vector<float>& original_audio = windowed ? window_audio : recording;
+        const double window_offset_seconds = (first_sample + window_start) / 16000.0;
+        
+        // Drop silence before taking the inference lock; segment times are mapped back below
+        VadResult vad;
+        auto vad_start = std::chrono::high_resolution_clock::now();
+        if (options.vad) {
+            vad = VoiceActivityDetector().process(original_audio);
+        }
+        auto vad_end = std::chrono::high_resolution_clock::now();
+        const std::vector<float>& audio_data = options.vad ? vad.samples : original_audio;
+        auto to_recording_seconds = [&options, &vad, window_offset_seconds](double seconds) {
+            return (options.vad ? vad.time_map.toOriginalSeconds(seconds, 16000) : seconds) + window_offset_seconds;
+        };
         
-        // Add processing info
         response["processing_info"] = {
             {"language", "en"},
-            {"threads", params.n_threads},
+            {"threads", inferenceThreads(options.threads)},
             {"model_type", "base"}
         };
         
-        // Perform transcription
-        auto transcription_start = std::chrono::high_resolution_clock::now();
-        int result = whisper_full(context_, params, audio_data.data(), audio_data.size());
-        auto transcription_end = std::chrono::high_resolution_clock::now();
+        // Live segments are reported against the untrimmed audio, like the final ones
+        TranscriptListener listener;
+        if (options.listener.on_segment) {
+            listener.on_segment = [&options, &to_recording_seconds](const TranscriptSegment& segment) {
+                TranscriptSegment mapped = segment;
+                mapped.start_seconds = to_recording_seconds(segment.start_seconds);
+                mapped.end_seconds = to_recording_seconds(segment.end_seconds);
+                options.listener.on_segment(mapped);
+            };
+        }
+        listener.on_progress = options.listener.on_progress;
         
-        if (result != 0) {
-            response["error"] = "Transcription failed with code: " + std::to_string(result);
+        // Short clips may share one whisper_full run with clips from other connections
+        ClipBatchResult run;
+        if (options.state) {
+            // A batch job's own state: no lock to wait for and no other clips to pack with
+            auto inference_start = std::chrono::steady_clock::now();
+            run.success = runInference(audio_data, 1, options.threads, options.should_abort, listener,
+                                       run.segments, run.error, options.state);
+            run.aborted = !run.success && options.should_abort && options.should_abort();
+            run.inference_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inference_start).count();
+            run.batch_size = 1;
+            run.batch_audio_seconds = audio_data.size() / 16000.0;
+        } else {
+            run = batcher_->transcribe(audio_data, options.threads, options.should_abort, listener);
+        }
+        
+        if (run.aborted) {
+            return cancelledResponse(response, run.inference_ms);
+        }
+        
+        if (!run.success) {
+            response["error"] = run.error;
             return response.dump();
         }
         
         // Extract transcribed text and segments
         std::string transcription;
         json segments = json::array();
-        const int n_segments = whisper_full_n_segments(context_);
         
-        for (int i = 0; i < n_segments; ++i) {
-            const char* text = whisper_full_get_segment_text(context_, i);
-            if (text) {
-                transcription += text;
-                
-                // Add segment info
-                json segment;
-                segment["id"] = i;
-                segment["text"] = text;
-                segment["start_time"] = whisper_full_get_segment_t0(context_, i) * 0.01; // Convert to seconds
-                segment["end_time"] = whisper_full_get_segment_t1(context_, i) * 0.01;   // Convert to seconds
-                segments.push_back(segment);
-            }
+        for (size_t i = 0; i < run.segments.size(); ++i) {
+            const TranscriptSegment& piece = run.segments[i];
+            transcription += piece.text;
+            
+            // Add segment info
+            json segment;
+            segment["id"] = i;
+            segment["text"] = piece.text;
+            segment["start_time"] = to_recording_seconds(piece.start_seconds);
+            segment["end_time"] = to_recording_seconds(piece.end_seconds);
+            segments.push_back(segment);
         }
         
         // Trim whitespace from full transcription
@@ -142,7 +416,6 @@ public:
         
         auto end_time = std::chrono::high_resolution_clock::now();
         auto total_duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time);
-        auto transcription_duration = std::chrono::duration_cast<std::chrono::milliseconds>(transcription_end - transcription_start);
         
         // Build successful response
         response["success"] = true;
@@ -150,88 +423,207 @@ public:
         response["segments"] = segments;
         response["timing"] = {
             {"total_processing_ms", total_duration.count()},
-            {"transcription_ms", transcription_duration.count()},
-            {"real_time_factor", (audio_data.size() / 16000.0) / (total_duration.count() / 1000.0)}
+            {"transcription_ms", static_cast<long long>(run.inference_ms)},
+            {"real_time_factor", (original_audio.size() / 16000.0) / (total_duration.count() / 1000.0)}
         };
+        response["processing_info"]["decode_profile"] =
+            DecodeProfile::forAudio(run.batch_audio_seconds, run.batch_size).name();
+        if (run.batch_size > 1) {
+            response["timing"]["batch_size"] = run.batch_size;
+            response["timing"]["batch_audio_seconds"] = run.batch_audio_seconds;
+        }
+        if (options.vad) {
+            response["timing"]["vad_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(vad_end - vad_start).count();
+            response["timing"]["vad_dropped_samples"] = vad.dropped_samples;
+            response["timing"]["vad_kept_samples"] = audio_data.size();
+        }
         
         return response.dump();
     }
     
-private:
-    bool loadAudioFile(const std::string& file_path, std::vector<float>& audio_data, json& audio_info) {
-        // Simple WAV file loader for 16kHz mono format
-        std::ifstream file(file_path, std::ios::binary);
-        if (!file) {
-            audio_info["error"] = "Cannot open audio file: " + file_path;
+    // The caller's grant when it sent one, never more than the machine has
+    int inferenceThreads(int requested) const {
+        if (requested <= 0) {
+            return threads_;
+        }
+        return std::min(requested, std::max(1, (int)std::thread::hardware_concurrency()));
+    }
+    
+    // One whisper_full call; segment times in seconds relative to the start of audio.
+    // state: a state of the caller's own (createState) instead of the shared one behind inference_mutex_
+    bool runInference(const std::vector<float>& audio_data, size_t clip_count, int threads,
+                      const std::function<bool()>& should_abort, const TranscriptListener& listener,
+                      std::vector<TranscriptSegment>& segments, std::string& error,
+                      whisper_state* state = nullptr) {
+        std::unique_lock<std::mutex> lock(inference_mutex_, std::defer_lock);
+        if (!state) {
+            lock.lock();
+        }
+        
+        // The client may have given up while this request waited for the lock
+        AbortCheck abort_check{&should_abort, std::chrono::steady_clock::time_point()};
+        if (should_abort && abort_check.poll()) {
+            error = "Cancelled";
             return false;
         }
         
-        // Read WAV header (44 bytes)
-        char header[44];
-        file.read(header, 44);
-        if (!file || file.gcount() != 44) {
-            audio_info["error"] = "Invalid WAV header";
+        // Prepare parameters
+        whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+        params.print_realtime = false;
+        params.print_progress = false;
+        params.print_timestamps = false;
+        params.print_special = false;
+        params.translate = false;
+        params.language = "en";
+        params.n_threads = inferenceThreads(threads);
+        DecodeProfile::forAudio(audio_data.size() / 16000.0, clip_count).apply(params);
+        if (should_abort) {
+            params.abort_callback = abortCallback;
+            params.abort_callback_user_data = &abort_check;
+            params.encoder_begin_callback = encoderBeginCallback;
+            params.encoder_begin_callback_user_data = &abort_check;
+        }
+        if (listener.on_segment) {
+            params.new_segment_callback = newSegmentCallback;
+            params.new_segment_callback_user_data = const_cast<TranscriptListener*>(&listener);
+        }
+        if (listener.on_progress) {
+            params.progress_callback = progressCallback;
+            params.progress_callback_user_data = const_cast<TranscriptListener*>(&listener);
+        }
+        
+        // Perform transcription
+        int result = state ? whisper_full_with_state(context_, state, params, audio_data.data(), audio_data.size())
+                           : whisper_full(context_, params, audio_data.data(), audio_data.size());
+        
+        if (abort_check.aborted) {
+            error = "Cancelled";
             return false;
         }
         
-        // Check if it's a valid WAV file
-        if (std::memcmp(header, "RIFF", 4) != 0 || std::memcmp(header + 8, "WAVE", 4) != 0) {
-            audio_info["error"] = "Not a valid WAV file";
+        if (result != 0) {
+            error = "Transcription failed with code: " + std::to_string(result);
             return false;
         }
         
-        // Extract format information
-        uint16_t audio_format = *reinterpret_cast<uint16_t*>(header + 20);
-        uint16_t num_channels = *reinterpret_cast<uint16_t*>(header + 22);
-        uint32_t sample_rate = *reinterpret_cast<uint32_t*>(header + 24);
-        uint16_t bits_per_sample = *reinterpret_cast<uint16_t*>(header + 34);
+        const int n_segments = state ? whisper_full_n_segments_from_state(state) : whisper_full_n_segments(context_);
+        for (int i = 0; i < n_segments; ++i) {
+            const char* text = state ? whisper_full_get_segment_text_from_state(state, i)
+                                     : whisper_full_get_segment_text(context_, i);
+            if (text) {
+                TranscriptSegment segment;
+                segment.text = text;
+                // Convert to seconds
+                segment.start_seconds = (state ? whisper_full_get_segment_t0_from_state(state, i)
+                                               : whisper_full_get_segment_t0(context_, i)) * 0.01;
+                segment.end_seconds = (state ? whisper_full_get_segment_t1_from_state(state, i)
+                                             : whisper_full_get_segment_t1(context_, i)) * 0.01;
+                segments.push_back(std::move(segment));
+            }
+        }
+        return true;
+    }
+    
+    std::string cancelledResponse(json& response, double inference_ms) {
+        response["error"] = "Cancelled";
+        response["cancelled"] = true;
+        response["timing"] = {{"transcription_ms", inference_ms}};
+        return response.dump();
+    }
+    
+    bool loadAudioFile(const std::string& file_path, const TranscribeOptions& options, std::vector<float>& audio_data,
+                       size_t& first_sample, json& audio_info) {
+        // Archived uploads are RiceCodec streams (.wrc) unless the browser fell back to WAV
+        std::ifstream file(file_path, std::ios::binary);
+        char magic[RiceCodec::HEADER_BYTES];
+        if (file.read(magic, sizeof(magic)) && RiceCodec::isEncoded(magic, sizeof(magic))) {
+            file.seekg(0);
+            std::vector<char> encoded((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            return loadRiceAudio(encoded, options, audio_data, first_sample, audio_info);
+        }
+        file.close();
         
-        // Store audio format info
+        // Map the file and walk its RIFF chunks; samples are decoded straight from the mapping
+        WavReader reader;
+        if (!reader.open(file_path)) {
+            audio_info["error"] = reader.getLastError();
+            return false;
+        }
+        return loadAudio(reader, options, audio_data, first_sample, audio_info);
+    }
+    
+    bool loadRiceAudio(const std::vector<char>& encoded, const TranscribeOptions& options, std::vector<float>& audio_data,
+                       size_t& first_sample, json& audio_info) {
+        std::vector<int16_t> pcm;
+        uint32_t sample_rate = 0;
+        std::string error;
+        if (!RiceCodec::decode(encoded.data(), encoded.size(), pcm, sample_rate, error)) {
+            audio_info["error"] = error;
+            return false;
+        }
         audio_info["format"] = {
-            {"audio_format", audio_format},
-            {"channels", num_channels},
+            {"codec", "rice"},
+            {"channels", 1},
             {"sample_rate", sample_rate},
-            {"bits_per_sample", bits_per_sample}
+            {"bits_per_sample", 16}
         };
         
-        // Verify format (expecting 16-bit PCM)
-        if (audio_format != 1) {
-            audio_info["error"] = "Only PCM format supported";
-            return false;
+        // Same windowing as loadAudio: a 16kHz recording converts only the requested samples
+        first_sample = 0;
+        size_t end = pcm.size();
+        if (sample_rate == 16000 && options.window_end > options.window_start) {
+            first_sample = std::min(options.window_start, pcm.size());
+            end = std::min(options.window_end, pcm.size());
         }
+        audio_data.resize(end - std::min(end, first_sample));
+        PcmDecoder::int16ToMono(pcm.data() + first_sample, audio_data.size(), 1, audio_data.data());
         
-        if (bits_per_sample != 16) {
-            audio_info["error"] = "Only 16-bit audio supported";
-            return false;
+        if (sample_rate != 16000) {
+            if (!Resampler::toWhisperRate(audio_data, static_cast<int>(sample_rate))) {
+                audio_info["error"] = "Invalid sample rate: " + std::to_string(sample_rate);
+                return false;
+            }
+            audio_info["resampled_from"] = sample_rate;
         }
         
-        // Read audio data
-        std::vector<int16_t> raw_data;
-        int16_t sample;
-        while (file.read(reinterpret_cast<char*>(&sample), sizeof(sample))) {
-            raw_data.push_back(sample);
-        }
+        audio_info["samples"] = audio_data.size();
+        audio_info["duration_seconds"] = sample_rate > 0 ? static_cast<double>(pcm.size()) / sample_rate : 0.0;
+        audio_info["raw_samples"] = pcm.size();
+        return true;
+    }
+    
+    // first_sample: where audio_data starts in the recording, > 0 if only a window was decoded
+    bool loadAudio(const WavReader& reader, const TranscribeOptions& options, std::vector<float>& audio_data,
+                   size_t& first_sample, json& audio_info) {
+        const WavFormat& format = reader.format();
+        audio_info["format"] = {
+            {"audio_format", format.audio_format},
+            {"channels", format.channels},
+            {"sample_rate", format.sample_rate},
+            {"bits_per_sample", format.bits_per_sample}
+        };
         
-        if (raw_data.empty()) {
-            audio_info["error"] = "No audio data found";
-            return false;
+        // Convert to float and average the channels; a window of a 16kHz recording needs only its own samples
+        first_sample = 0;
+        if (format.sample_rate == 16000 && options.window_end > options.window_start) {
+            first_sample = options.window_start;
+            reader.decodeMono(audio_data, first_sample, options.window_end - first_sample);
+        } else {
+            reader.decodeMono(audio_data);
         }
         
-        // Convert to float and handle multi-channel by taking average
-        audio_data.clear();
-        audio_data.reserve(raw_data.size() / num_channels);
-        
-        for (size_t i = 0; i < raw_data.size(); i += num_channels) {
-            float sample_sum = 0.0f;
-            for (uint16_t ch = 0; ch < num_channels && i + ch < raw_data.size(); ++ch) {
-                sample_sum += static_cast<float>(raw_data[i + ch]) / 32768.0f;
+        // Whisper only understands 16kHz; uploads may come at the device's native rate
+        if (format.sample_rate != 16000) {
+            if (!Resampler::toWhisperRate(audio_data, static_cast<int>(format.sample_rate))) {
+                audio_info["error"] = "Invalid sample rate: " + std::to_string(format.sample_rate);
+                return false;
             }
-            audio_data.push_back(sample_sum / num_channels);
+            audio_info["resampled_from"] = format.sample_rate;
         }
         
         audio_info["samples"] = audio_data.size();
-        audio_info["duration_seconds"] = audio_data.size() / 16000.0;
-        audio_info["raw_samples"] = raw_data.size();
+        audio_info["duration_seconds"] = reader.durationSeconds();
+        audio_info["raw_samples"] = reader.frames() * format.channels;
         
         return true;
     }
@@ -240,30 +632,560 @@ private:
 void printUsage(const char* program_name) {
     json usage_response;
     usage_response["success"] = false;
-    usage_response["error"] = "Usage: " + std::string(program_name) + " <model_path> <audio_file_path>";
+    usage_response["error"] = "Usage: " + std::string(program_name) + " <model_path> <audio_file_path> [--vad] [--stream] [--threads <n>]"
+                              " | --daemon <socket_path> <model_path> [--threads <n>] [--batch-window-ms <ms>] [--batch-max-seconds <s>]"
+                              " | --worker <model_path> [--threads <n>]"
+                              " | --batch <model_path> <directory|manifest> --output <results.ndjson> [--jobs <n>] [--threads <n>] [--vad] [--retry-failed]";
     usage_response["example"] = std::string(program_name) + " models/ggml-base.en.bin audio.wav";
     std::cout << usage_response.dump() << std::endl;
 }
 
+// Set by SIGTERM/SIGINT so the accept loop can exit and remove the socket file, or a batch stop after its current files
+static std::atomic<bool> stop_requested{false};
+
+static void onStopSignal(int) {
+    stop_requested = true;
+}
+
+/**
+ * Serve framed requests from one client until it disconnects.
+ * Requests: {"op": "ping"}, {"op": "transcribe", "audio_file": "<path>"}
+ * or {"op": "transcribe", "pcm": "s16le"} with mono samples as the frame payload
+ * (16kHz unless "sample_rate" says otherwise), or {"op": "transcribe", "audio_fd": "wav"}
+ * with a WAV memfd attached to the frame (SCM_RIGHTS).
+ * Transcribe requests accept "vad": true to trim silence before inference,
+ * "window": [start, end] to decode only those 16kHz samples (times stay relative to the whole audio),
+ * "threads": N to run on the caller's thread budget instead of --threads and
+ * "stream": true to receive segment and progress event frames before the response.
+ * A client that hangs up mid-request (cancellation) aborts its inference.
+ * The caller closes client_fd once this returns.
+ */
+void serveDaemonConnection(int client_fd, WhisperService& service, const json& init_info) {
+    json request;
+    std::vector<char> payload;
+    int received_fd = -1;
+    
+    // Clients send one request and wait, so anything but silence on the socket means they left
+    auto client_gone = [client_fd]() {
+        pollfd client_poll{client_fd, POLLRDHUP, 0};
+        return poll(&client_poll, 1, 0) > 0 && (client_poll.revents & (POLLRDHUP | POLLHUP | POLLERR));
+    };
+    
+    // Events are written from whichever thread runs the inference (a batch leader may be
+    // another connection's thread); this connection's own thread is blocked meanwhile
+    auto request_options = [client_fd, &client_gone](const json& request) {
+        TranscribeOptions options = TranscribeOptions::fromRequest(request);
+        options.should_abort = client_gone;
+        if (request.value("stream", false)) {
+            auto next_id = std::make_shared<size_t>(0);
+            options.listener.on_segment = [client_fd, next_id](const TranscriptSegment& segment) {
+                WhisperDaemonProtocol::writeFrame(client_fd, WhisperDaemonProtocol::segmentEvent(segment, (*next_id)++));
+            };
+            options.listener.on_progress = [client_fd](int percent) {
+                WhisperDaemonProtocol::writeFrame(client_fd, WhisperDaemonProtocol::progressEvent(percent));
+            };
+        }
+        return options;
+    };
+    
+    while (!stop_requested && WhisperDaemonProtocol::readFrame(client_fd, request, payload, &received_fd)) {
+        json response;
+        std::string op = request.value("op", "transcribe");
+        // Counted until answered, so a batch leader only waits for company while there can be some
+        std::optional<ClipBatcher::InFlight> in_flight;
+        if (op == "transcribe") {
+            in_flight.emplace(service.batcher());
+        }
+        
+        if (op == "ping") {
+            response["success"] = true;
+            response["pong"] = true;
+            response["initialization"] = init_info;
+        } else if (op == "transcribe" && request.contains("audio_file") && request["audio_file"].is_string()) {
+            TranscribeOptions options = request_options(request);
+            response = json::parse(service.transcribeFile(request["audio_file"].get<std::string>(), options));
+            response["initialization"] = init_info;
+        } else if (op == "transcribe" && request.value("audio_fd", "") == "wav" && received_fd >= 0) {
+            TranscribeOptions options = request_options(request);
+            response = json::parse(service.transcribeDescriptor(received_fd, options));
+            response["initialization"] = init_info;
+        } else if (op == "transcribe" && request.value("pcm", "") == "s16le") {
+            TranscribeOptions options = request_options(request);
+            response = json::parse(service.transcribePcm(reinterpret_cast<const int16_t*>(payload.data()),
+                                                         payload.size() / sizeof(int16_t), options));
+            response["initialization"] = init_info;
+        } else {
+            response["success"] = false;
+            response["error"] = "Unsupported request: " + op;
+        }
+        
+        if (request.contains("id")) {
+            response["id"] = request["id"];
+        }
+        if (received_fd >= 0) {
+            close(received_fd);
+            received_fd = -1;
+        }
+        
+        if (!WhisperDaemonProtocol::writeFrame(client_fd, response)) {
+            break;
+        }
+    }
+}
+
+/**
+ * One accepted daemon client and the thread serving it. The accept loop owns the
+ * descriptor: it is only closed after the thread is joined, so a shutdown() at exit
+ * can never hit a descriptor number that was reused in the meantime.
+ */
+struct DaemonConnection {
+    int fd = -1;
+    std::thread thread;
+    std::atomic<bool> finished{false};
+};
+
+/**
+ * Keep the model loaded and accept connections on a Unix domain socket.
+ * Each connection gets its own thread; inference itself is serialized by WhisperService.
+ * On exit every connection is shut down (aborting its inference) and joined before
+ * the caller destroys the service.
+ */
+int runDaemon(const std::string& socket_path, WhisperService& service, const json& init_info) {
+    if (socket_path.size() >= sizeof(sockaddr_un::sun_path)) {
+        std::cout << json{{"success", false}, {"error", "Socket path too long: " + socket_path}}.dump() << std::endl;
+        return 1;
+    }
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        std::cout << json{{"success", false}, {"error", "Failed to create daemon socket"}}.dump() << std::endl;
+        return 1;
+    }
+    
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+    
+    // A leftover socket file from a crashed daemon blocks bind; only remove it if nobody answers
+    if (connect(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        std::cout << json{{"success", false}, {"error", "Daemon already running on " + socket_path}}.dump() << std::endl;
+        close(listen_fd);
+        return 1;
+    }
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    
+    // The socket file is created 0600 by bind itself, not opened up until a later chmod
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    mode_t previous_umask = umask(0077);
+    bool bound = listen_fd >= 0 && bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    umask(previous_umask);
+    if (!bound || listen(listen_fd, 16) != 0) {
+        std::cout << json{{"success", false}, {"error", "Failed to listen on " + socket_path}}.dump() << std::endl;
+        if (listen_fd >= 0) {
+            close(listen_fd);
+        }
+        return 1;
+    }
+    // Build the resampler filter banks now rather than on the first 44.1k/48k upload
+    Resampler::prewarm();
+    
+    struct sigaction stop_action{};
+    stop_action.sa_handler = onStopSignal;
+    sigaction(SIGTERM, &stop_action, nullptr);
+    sigaction(SIGINT, &stop_action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+    
+    std::cout << json{{"success", true}, {"daemon", socket_path}, {"initialization", init_info}}.dump() << std::endl;
+    
+    std::list<std::unique_ptr<DaemonConnection>> connections;
+    auto reap_finished = [&connections]() {
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (!(*it)->finished) {
+                ++it;
+                continue;
+            }
+            (*it)->thread.join();
+            close((*it)->fd);
+            it = connections.erase(it);
+        }
+    };
+    
+    while (!stop_requested) {
+        reap_finished();
+        // Wake up periodically so a stop signal delivered to another thread is noticed
+        pollfd listen_poll{listen_fd, POLLIN, 0};
+        if (poll(&listen_poll, 1, 1000) <= 0) {
+            continue;
+        }
+        int client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            continue; // EINTR from the stop signal or a transient accept error
+        }
+        auto connection = std::make_unique<DaemonConnection>();
+        connection->fd = client_fd;
+        DaemonConnection* served = connection.get();
+        connection->thread = std::thread([served, &service, &init_info]() {
+            serveDaemonConnection(served->fd, service, init_info);
+            served->finished = true;
+        });
+        connections.push_back(std::move(connection));
+    }
+    
+    close(listen_fd);
+    unlink(socket_path.c_str());
+    
+    // Hanging up makes a running inference abort (its should_abort sees the hangup) and
+    // the read loop end; the service must outlive every thread still using it
+    for (auto& connection : connections) {
+        shutdown(connection->fd, SHUT_RDWR);
+    }
+    for (auto& connection : connections) {
+        connection->thread.join();
+        close(connection->fd);
+    }
+    return 0;
+}
+
+/**
+ * Pool worker (see WhisperWorkerPool): the supervisor's end of a socketpair is on stdin.
+ * Announces itself with one frame once the model is loaded ({"worker": true} plus the
+ * initialization info, or success false and the error), then serves the same requests
+ * as a daemon connection, one at a time, until the supervisor closes its end.
+ */
+int runWorker(WhisperService& service, const json& init_info, bool initialized) {
+    signal(SIGPIPE, SIG_IGN);
+    json hello;
+    hello["success"] = initialized;
+    hello["worker"] = true;
+    hello["pid"] = getpid();
+    hello["initialization"] = init_info;
+    if (!initialized) {
+        hello["error"] = "Failed to initialize Whisper service";
+    }
+    if (!WhisperDaemonProtocol::writeFrame(STDIN_FILENO, hello) || !initialized) {
+        return 1;
+    }
+    
+    // Build the resampler filter banks now rather than on the first 44.1k/48k upload
+    Resampler::prewarm();
+    serveDaemonConnection(STDIN_FILENO, service, init_info);
+    close(STDIN_FILENO);
+    return 0;
+}
+
+// --batch settings
+struct BatchOptions {
+    std::string source;         // Directory searched recursively for .wav/.wrc, or a manifest with one path per line
+    std::string output_path;    // Newline-delimited JSON, one transcribeFile response per file; appended to
+    size_t jobs = 1;            // Files decoded at once, each on its own whisper_state
+    bool vad = false;
+    bool retry_failed = false;  // Transcribe files again whose earlier result was a failure (their last line counts)
+};
+
+static std::string batchPath(const std::filesystem::path& path) {
+    std::error_code error;
+    std::filesystem::path absolute = std::filesystem::absolute(path, error);
+    return (error ? path : absolute).lexically_normal().string();
+}
+
+static bool isBatchAudioFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".wav" || extension == ".wrc";
+}
+
+// Absolute paths of the files to transcribe, each once
+static bool listBatchFiles(const std::string& source, std::vector<std::string>& files, std::string& error) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (fs::is_directory(source, ec)) {
+        // Other uploads (.webm from browsers without the Rice encoder) are not something whisper_service reads
+        fs::recursive_directory_iterator it(source, fs::directory_options::skip_permission_denied, ec);
+        for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (it->is_regular_file(ec) && isBatchAudioFile(it->path())) {
+                files.push_back(batchPath(it->path()));
+            }
+        }
+        if (ec) {
+            error = "Failed to read directory " + source + ": " + ec.message();
+            return false;
+        }
+        std::sort(files.begin(), files.end());
+        return true;
+    }
+    
+    // Manifest: blank lines and lines starting with # are skipped, relative paths are relative to the manifest
+    std::ifstream manifest(source);
+    if (!manifest) {
+        error = "Failed to read " + source;
+        return false;
+    }
+    const fs::path base = fs::path(source).parent_path();
+    std::unordered_set<std::string> listed;
+    std::string line;
+    while (std::getline(manifest, line)) {
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        fs::path path(line);
+        std::string file = batchPath(path.is_relative() ? base / path : path);
+        if (listed.insert(file).second) {
+            files.push_back(file);
+        }
+    }
+    return true;
+}
+
+/**
+ * Files an earlier run already wrote a result for (failed ones only without retry_failed).
+ * A line cut short by a kill or power loss is not valid JSON; it is cut off the file so
+ * the results appended after it start on a line of their own.
+ */
+static bool readBatchResults(const std::string& output_path, bool retry_failed,
+                             std::unordered_set<std::string>& finished, std::string& error) {
+    std::ifstream output(output_path, std::ios::binary);
+    if (!output) {
+        return true; // First run
+    }
+    std::string line;
+    std::streamoff complete_bytes = 0;
+    while (std::getline(output, line)) {
+        if (output.eof()) {
+            break; // No newline: the write was interrupted
+        }
+        complete_bytes = output.tellg();
+        json result = json::parse(line, nullptr, false);
+        if (result.is_object() && result.contains("audio_file") && result["audio_file"].is_string() &&
+            (!retry_failed || result.value("success", false))) {
+            finished.insert(result["audio_file"].get<std::string>());
+        }
+    }
+    output.close();
+    
+    std::error_code ec;
+    if (static_cast<std::uintmax_t>(complete_bytes) != std::filesystem::file_size(output_path, ec) && !ec) {
+        std::filesystem::resize_file(output_path, static_cast<std::uintmax_t>(complete_bytes), ec);
+    }
+    if (ec) {
+        error = "Failed to resume " + output_path + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Transcribe many files with one model load: back-filling the audio-files/ archive one
+ * whisper_service run per file would load the model thousands of times.
+ *
+ * Each of the jobs decodes on its own whisper_state (the first on the context's), so
+ * their whisper_full runs overlap; the weights are shared. Files are taken largest first,
+ * so one long recording does not run alone at the end. Every result is appended to the
+ * output as one JSON line as soon as it is done, which makes the run resumable: files
+ * the output already has a line for are skipped. SIGINT/SIGTERM abort the files being
+ * decoded (they are redone on the next run) and end the run.
+ *
+ * Prints one JSON line per finished file and a summary line last.
+ */
+int runBatch(WhisperService& service, const json& init_info, const BatchOptions& options) {
+    auto fail = [&init_info](const std::string& error) {
+        std::cout << json{{"success", false}, {"error", error}, {"initialization", init_info}}.dump() << std::endl;
+        return 1;
+    };
+    
+    std::vector<std::string> listed;
+    std::unordered_set<std::string> finished;
+    std::string error;
+    if (!listBatchFiles(options.source, listed, error) ||
+        !readBatchResults(options.output_path, options.retry_failed, finished, error)) {
+        return fail(error);
+    }
+    
+    std::vector<std::pair<std::uintmax_t, std::string>> pending;
+    for (const std::string& file : listed) {
+        if (!finished.count(file)) {
+            std::error_code ec;
+            std::uintmax_t size = std::filesystem::file_size(file, ec);
+            pending.emplace_back(ec ? 0 : size, file);
+        }
+    }
+    std::stable_sort(pending.begin(), pending.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+    
+    int output_fd = open(options.output_path.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (output_fd < 0) {
+        return fail("Failed to open " + options.output_path + ": " + std::strerror(errno));
+    }
+    
+    const size_t jobs = std::max<size_t>(1, std::min(options.jobs, pending.size()));
+    std::vector<whisper_state*> states(jobs, nullptr);
+    for (size_t job = 1; job < jobs; ++job) {
+        if (!(states[job] = service.createState())) {
+            for (whisper_state* state : states) {
+                if (state) {
+                    whisper_free_state(state);
+                }
+            }
+            close(output_fd);
+            return fail("Failed to create decoding state " + std::to_string(job));
+        }
+    }
+    
+    struct sigaction stop_action{};
+    stop_action.sa_handler = onStopSignal;
+    sigaction(SIGTERM, &stop_action, nullptr);
+    sigaction(SIGINT, &stop_action, nullptr);
+    
+    std::mutex output_mutex;
+    std::atomic<size_t> next{0};
+    size_t succeeded = 0, failed = 0, write_errors = 0;
+    double audio_seconds = 0.0;
+    auto batch_start = std::chrono::steady_clock::now();
+    
+    auto run_job = [&](size_t job) {
+        TranscribeOptions file_options;
+        file_options.vad = options.vad;
+        file_options.state = states[job];
+        file_options.should_abort = []() { return stop_requested.load(); };
+        for (size_t i = next++; i < pending.size() && !stop_requested; i = next++) {
+            json result = json::parse(service.transcribeFile(pending[i].second, file_options));
+            if (result.value("cancelled", false)) {
+                break;
+            }
+            
+            // One write per line: O_APPEND keeps lines whole, and a kill mid-run loses at most the files in flight
+            std::string line = result.dump() + "\n";
+            std::lock_guard<std::mutex> lock(output_mutex);
+            bool written = write(output_fd, line.data(), line.size()) == static_cast<ssize_t>(line.size()) &&
+                           fdatasync(output_fd) == 0;
+            bool success = result.value("success", false);
+            ++(success ? succeeded : failed);
+            write_errors += written ? 0 : 1;
+            if (success && result.contains("audio_info")) {
+                audio_seconds += result["audio_info"].value("duration_seconds", 0.0);
+            }
+            std::cout << json{{"done", succeeded + failed}, {"total", pending.size()},
+                              {"audio_file", pending[i].second}, {"success", success}}.dump() << std::endl;
+        }
+    };
+    
+    std::vector<std::thread> workers;
+    for (size_t job = 1; job < jobs; ++job) {
+        workers.emplace_back(run_job, job);
+    }
+    run_job(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (whisper_state* state : states) {
+        if (state) {
+            whisper_free_state(state);
+        }
+    }
+    close(output_fd);
+    
+    double wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batch_start).count();
+    bool interrupted = stop_requested && succeeded + failed < pending.size();
+    json summary;
+    summary["success"] = !interrupted && write_errors == 0;
+    summary["batch"] = {
+        {"output", options.output_path},
+        {"files", listed.size()},
+        {"skipped", listed.size() - pending.size()},
+        {"transcribed", succeeded},
+        {"failed", failed},
+        {"remaining", pending.size() - succeeded - failed},
+        {"interrupted", interrupted},
+        {"jobs", jobs},
+        {"audio_seconds", audio_seconds},
+        {"wall_seconds", wall_seconds},
+        {"real_time_factor", wall_seconds > 0 ? audio_seconds / wall_seconds : 0.0}
+    };
+    if (write_errors > 0) {
+        summary["error"] = "Failed to write " + std::to_string(write_errors) + " results to " + options.output_path;
+    }
+    summary["initialization"] = init_info;
+    std::cout << summary.dump() << std::endl;
+    return summary["success"].get<bool>() ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
     // Redirect stderr to /dev/null to suppress whisper debug output
     freopen("/dev/null", "w", stderr);
     
-    if (argc != 3) {
-        json error_response;
-        error_response["success"] = false;
-        error_response["error"] = "Usage: " + std::string(argv[0]) + " <model_path> <audio_file_path>";
-        std::cout << error_response.dump() << std::endl;
+    bool daemon_mode = argc >= 4 && std::string(argv[1]) == "--daemon";
+    bool worker_mode = argc >= 3 && std::string(argv[1]) == "--worker";
+    bool batch_mode = argc >= 4 && std::string(argv[1]) == "--batch";
+    if (argc < 3 || (!daemon_mode && !worker_mode && !batch_mode && std::string(argv[1]).rfind("--", 0) == 0)) {
+        printUsage(argv[0]);
         return 1;
     }
     
-    std::string model_path = argv[1];
-    std::string audio_file_path = argv[2];
+    // The daemon batches short clips by default; --batch-window-ms 0 turns it off
+    bool vad_flag = false;
+    bool stream_flag = false;
+    int threads = 0;
+    ClipBatcherOptions batch_options;
+    BatchOptions bulk_options;
+    for (int i = daemon_mode || batch_mode ? 4 : 3; i < argc; ++i) {
+        std::string flag = argv[i];
+        if (flag == "--vad" && !daemon_mode && !worker_mode) {
+            vad_flag = true;
+            continue;
+        }
+        if (flag == "--stream" && !daemon_mode && !worker_mode && !batch_mode) {
+            stream_flag = true;
+            continue;
+        }
+        if (flag == "--retry-failed" && batch_mode) {
+            bulk_options.retry_failed = true;
+            continue;
+        }
+        bool known = flag == "--threads" ||
+                     (daemon_mode && (flag == "--batch-window-ms" || flag == "--batch-max-seconds")) ||
+                     (batch_mode && (flag == "--output" || flag == "--jobs"));
+        if (!known || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (flag == "--threads") {
+            threads = std::atoi(value);
+        } else if (flag == "--batch-window-ms") {
+            batch_options.window_ms = std::max(0, std::atoi(value));
+        } else if (flag == "--batch-max-seconds") {
+            batch_options.max_packed_seconds = std::clamp(std::atof(value), 1.0, 30.0);
+        } else if (flag == "--output") {
+            bulk_options.output_path = value;
+        } else {
+            bulk_options.jobs = static_cast<size_t>(std::max(1, std::atoi(value)));
+        }
+    }
+    if (batch_mode && bulk_options.output_path.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    std::string model_path = daemon_mode ? argv[3] : worker_mode || batch_mode ? argv[2] : argv[1];
     
     WhisperService service;
+    if (threads > 0) {
+        service.setThreads(threads);
+    } else if (batch_mode) {
+        // Batch jobs split the machine between them rather than each taking the one-shot default
+        service.setThreads(std::max(1, (int)std::thread::hardware_concurrency() / (int)bulk_options.jobs));
+    }
     
     // Initialize with model and capture initialization info
     json init_info;
+    if (worker_mode) {
+        // The supervisor batches nothing: it hands each worker one clip at a time
+        bool initialized = service.initialize(model_path, init_info);
+        return runWorker(service, init_info, initialized);
+    }
     if (!service.initialize(model_path, init_info)) {
         json error_response;
         error_response["success"] = false;
@@ -273,8 +1195,39 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    if (daemon_mode) {
+        service.setBatching(batch_options);
+        init_info["batching"] = {
+            {"window_ms", batch_options.window_ms},
+            {"max_packed_seconds", batch_options.max_packed_seconds}
+        };
+        return runDaemon(argv[2], service, init_info);
+    }
+    
+    if (batch_mode) {
+        bulk_options.source = argv[3];
+        bulk_options.vad = vad_flag;
+        return runBatch(service, init_info, bulk_options);
+    }
+    
+    std::string audio_file_path = argv[2];
+    
+    TranscribeOptions options;
+    options.vad = vad_flag;
+    
+    // One JSON event per line while decoding; the response stays the last line
+    size_t next_segment_id = 0;
+    if (stream_flag) {
+        options.listener.on_segment = [&next_segment_id](const TranscriptSegment& segment) {
+            std::cout << WhisperDaemonProtocol::segmentEvent(segment, next_segment_id++).dump() << std::endl;
+        };
+        options.listener.on_progress = [](int percent) {
+            std::cout << WhisperDaemonProtocol::progressEvent(percent).dump() << std::endl;
+        };
+    }
+    
     // Transcribe audio file
-    std::string result = service.transcribeFile(audio_file_path);
+    std::string result = service.transcribeFile(audio_file_path, options);
     
     // Parse the result to add initialization info
     json final_response = json::parse(result);